@@ -20,18 +20,23 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstring>
 #include <filesystem>
 #include <fmt/std.h> 
+#include <limits>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 
 #include "stb_image.h"
 
 #include "application.h"
+#include "bvh.h"
 #include "helpers.h"
+#include "input.hxx"
+#include "loader.h"
 #include "logger.h"
-#include "tiny_obj_loader.h"
 #include "utils.hxx"
 
 //----------------------------------------------------------------------------
@@ -76,43 +81,8 @@ void OttApplication::initWindow()
 
     appwindow.OnFileDropped = [&](int count, const char** paths)
     {
-        vkDeviceWaitIdle(device);
-        cleanupModelObjects();
-        
-        if (!uniformBuffers.empty())
-        {
-            for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-            {
-                vkDestroyBuffer (device, uniformBuffers[i],       nullptr);
-                vkFreeMemory    (device, uniformBuffersMemory[i], nullptr);
-            }
-        }
-        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-        for (int i = 0; i < count; i++)
-        {
-            loadModel(paths[i]);
-            for (const auto& texPath : sceneMaterials.imageTexture_path)
-            {
-                createTextureImage(texPath);
-                createTextureImageView();
-            }
-            createVertexBuffer();
-            createIndexBuffer(indices, indexBuffer, indexBufferMemory);
-            createIndexBuffer(edges, edgesBuffer, edgesBufferMemory);
-            edgesBufferAddressInfo.buffer = edgesBuffer;
-            createUniformBuffers();
-            
-            OttDescriptor::createDescriptorPool(device, descriptorPool);
-            bindlessDescriptorSet = OttDescriptor::createDescriptorSet(device, 1, bindlessDescSetLayout, descriptorPool);
-            OttDescriptor::updateDescriptorSet (
-                device, appDevice,
-                bindlessDescriptorSet,
-                uniformBuffers[0],
-                textureImages,
-                textureSampler,
-                textureImageViews
-             );
-        }
+        std::vector<std::filesystem::path> modelPaths(paths, paths + count);
+        OttAsync::spawn(loadModelsAsync(std::move(modelPaths), importStop.get_token()));
     };
 
     appwindow.interactorKeyCallback = [&](int key, int scancode, int action, int mods)
@@ -131,6 +101,9 @@ void OttApplication::initWindow()
             case GLFW_KEY_3:
                 appPipeline.setDisplayMode(OttPipeline::DISPLAY_MODE_TEXTURE);
                 break;
+            case GLFW_KEY_ESCAPE:
+                cancelModelLoads();
+                break;
             }
         }
     };
@@ -144,9 +117,20 @@ void OttApplication::initWindow()
 void OttApplication::initVulkan(const std::filesystem::path& resource_dir)
 {
     // Pipeline Initilization.    
-    auto bindingDescription     = OttModel::Vertex::getBindingDescription();
-    auto attributeDescriptions  = OttModel::Vertex::getAttributeDescriptions();
-    VkPipelineVertexInputStateCreateInfo modelVertexInputInfo = appPipeline.initVertexInputInfo(1, &bindingDescription, static_cast<uint32_t>(attributeDescriptions.size()), attributeDescriptions.data());
+    const bool packed           = vertexFormat == OttModel::VertexFormat::Packed;
+    auto bindingDescriptions    = packed ? OttModel::PackedVertex::getBindingDescriptions() : OttModel::Vertex::getBindingDescriptions();
+    auto attributeDescriptions  = packed ? OttModel::PackedVertex::getAttributeDescriptions() : OttModel::Vertex::getAttributeDescriptions();
+    VkPipelineVertexInputStateCreateInfo modelVertexInputInfo = appPipeline.initVertexInputInfo(static_cast<uint32_t>(bindingDescriptions.size()), bindingDescriptions.data(), static_cast<uint32_t>(attributeDescriptions.size()), attributeDescriptions.data());
+    // The position stream alone: the first binding and attribute.
+    VkPipelineVertexInputStateCreateInfo positionVertexInputInfo = appPipeline.initVertexInputInfo(1, bindingDescriptions.data(), 1, attributeDescriptions.data());
+    const VkBool32 packedVertices = packed ? VK_TRUE : VK_FALSE;
+    const VkSpecializationMapEntry packedEntry { .constantID = 0, .offset = 0, .size = sizeof(VkBool32) };
+    const VkSpecializationInfo objectSpecialization {
+        .mapEntryCount = 1,
+        .pMapEntries   = &packedEntry,
+        .dataSize      = sizeof(packedVertices),
+        .pData         = &packedVertices,
+    };
     VkPipelineVertexInputStateCreateInfo gridVertexInputInfo  = appPipeline.initVertexInputInfo(0, VK_NULL_HANDLE, 0, VK_NULL_HANDLE);
 
     const auto shader_dir = resource_dir / "shaders";
@@ -154,15 +138,15 @@ void OttApplication::initVulkan(const std::filesystem::path& resource_dir)
     appPipeline.createPipelineLayout    (VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, &bindlessDescSetLayout);
     appPipeline.createGraphicsPipeline  (shader_dir / "object.vert.spv", shader_dir / "solid_shading.frag.spv",
                                         appPipeline.graphicsPipelines.solid, modelVertexInputInfo, VK_POLYGON_MODE_FILL,
-                                        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+                                        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, &objectSpecialization
                                         );
     appPipeline.createGraphicsPipeline  (shader_dir / "object.vert.spv", shader_dir / "texture.frag.spv",
                                         appPipeline.graphicsPipelines.texture, modelVertexInputInfo, VK_POLYGON_MODE_FILL,
-                                        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST
+                                        VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, &objectSpecialization
                                         );
-    appPipeline.createGraphicsPipeline  (shader_dir / "object.vert.spv", shader_dir / "wireframe.frag.spv",
-                                        appPipeline.graphicsPipelines.wireframe, modelVertexInputInfo, VK_POLYGON_MODE_LINE,
-                                        VK_PRIMITIVE_TOPOLOGY_LINE_LIST
+    appPipeline.createGraphicsPipeline  (shader_dir / "position.vert.spv", shader_dir / "wireframe.frag.spv",
+                                        appPipeline.graphicsPipelines.wireframe, positionVertexInputInfo, VK_POLYGON_MODE_LINE,
+                                        VK_PRIMITIVE_TOPOLOGY_LINE_LIST, &objectSpecialization
                                         );
     appPipeline.createGraphicsPipeline  (shader_dir / "grid.vert.spv", shader_dir / "grid.frag.spv",
                                         appPipeline.graphicsPipelines.grid, gridVertexInputInfo, VK_POLYGON_MODE_FILL,
@@ -170,6 +154,35 @@ void OttApplication::initVulkan(const std::filesystem::path& resource_dir)
                                         );
     // endof Pipeline initialization.
 
+    // Scene geometry arenas, sized for a typical building model so most drops append without growing.
+    geometryUploader.reserve(1'000'000, 1'000'000, 2'000'000, 2'000'000);
+    // The edge kernels read float positions; packed scenes keep their edges on the CPU.
+    if (vertexFormat == OttModel::VertexFormat::Packed)
+        modelLoadOptions.gpuEdgesAbove = 0;
+    else
+    {
+        try
+        {
+            geometryUploader.enableGpuEdges(shader_dir, modelLoadOptions.gpuEdgesAbove, modelLoadOptions.creases);
+        }
+        catch (const std::exception& e)
+        {
+            log_t<warning>("GPU edge extraction unavailable, edges stay on the CPU: {}", e.what());
+            modelLoadOptions.gpuEdgesAbove = 0;
+        }
+    }
+    try
+    {
+        if (appDevice.hasIndirectCount())
+            clusterCuller = std::make_unique<OttClusterCuller>(OttClusterCuller::Context { device, physicalDevice }, shader_dir);
+    }
+    catch (const std::exception& e)
+    {
+        log_t<warning>("GPU meshlet culling unavailable: {}", e.what());
+    }
+    if (!clusterCuller)
+        modelLoadOptions.meshlets.reset();
+
     // Textures initilization.
     VkHelpers::create1x1BlankImage(textureImage, mipLevels, appDevice, textureImages, textureImageMemory[0]);
     createTextureImageView();
@@ -199,13 +212,28 @@ void OttApplication::initVulkan(const std::filesystem::path& resource_dir)
 }
     
 //----------------------------------------------------------------------------
+/** Model loads resume here between frames: first the coroutines posted by the workers,
+ *  then the geometry uploads that completed on the GPU. On exit the loads still running
+ *  are cancelled and drained before the device goes idle. **/
 void OttApplication::mainLoop()
 {
     while (!appwindow.windowShouldClose())
     {
         OttWindow::update();
+        mainThreadQueue.drain();
+        geometryUploader.update(recordedFrames);
+        pickObject();
+        updateLoadProgress();
         drawFrame();
     }
+
+    cancelModelLoads();
+    while (!activeImports.empty())
+    {
+        mainThreadQueue.drain();
+        geometryUploader.update(recordedFrames);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
     vkDeviceWaitIdle(device);
 }
 
@@ -216,12 +244,17 @@ void OttApplication::drawFrame()
     {
         const auto startTime { std::chrono::high_resolution_clock::now() };
         if (const VkCommandBuffer commandBuffer = ottRenderer.beginFrame())
-        {        
-            ottRenderer.beginSwapChainRenderPass(commandBuffer);
+        {
+            recordedFrames++;
             const auto deltaTime { std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startTime).count() * 0.001f * 0.001f * 0.001f };
-            
-            drawScene(commandBuffer);
+
+            // The camera moves first, so culling, level selection and the shaders agree on the view.
+            // Culling is a compute pass and has to be recorded before the render pass begins.
             updateUniformBufferCamera(appSwapChain.getCurrentFrame(), deltaTime, static_cast<float>(appSwapChain.width()), static_cast<float>(appSwapChain.height()));
+            cullObjects();
+            cullMeshlets(commandBuffer);
+            ottRenderer.beginSwapChainRenderPass(commandBuffer);
+            drawScene(commandBuffer);
             
             ottRenderer.endSwapChainRenderPass(commandBuffer);
             ottRenderer.endFrame();
@@ -241,47 +274,75 @@ void OttApplication::drawScene(VkCommandBuffer command_buffer)
         0, 1, &bindlessDescriptorSet, 0, nullptr
     );
     
-    if (!vertices.empty() && !indices.empty())
+    if (!models.empty())
     {
-        const VkBuffer vertexBuffers[] = { vertexBuffer };
-        const VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(command_buffer, 0, 1, vertexBuffers, offsets);
+        const VkBuffer vertexBuffers[] = { geometryUploader.getPositionBuffer(), geometryUploader.getAttributeBuffer() };
+        const VkDeviceSize offsets[] = {0, 0};
+        vkCmdBindVertexBuffers(command_buffer, 0, 2, vertexBuffers, offsets);
         
         /** TODO: Eliminate switch case with an unordered_map **/
         switch (appPipeline.getDisplayMode())
         {
             case OttPipeline::DISPLAY_MODE_WIREFRAME:
                 vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, appPipeline.graphicsPipelines.wireframe);
-                vkCmdBindIndexBuffer(command_buffer, edgesBuffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdBindIndexBuffer(command_buffer, geometryUploader.getEdgesBuffer(), 0, VK_INDEX_TYPE_UINT32);
                 break;
             case OttPipeline::DISPLAY_MODE_SOLID:
                 vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, appPipeline.graphicsPipelines.solid);
-                vkCmdBindIndexBuffer(command_buffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdBindIndexBuffer(command_buffer, geometryUploader.getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
                 break;
             case OttPipeline::DISPLAY_MODE_TEXTURE:
                 vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, appPipeline.graphicsPipelines.texture);
-                vkCmdBindIndexBuffer(command_buffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdBindIndexBuffer(command_buffer, geometryUploader.getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
                 break;
         }
 
+        // Both passes draw the runs of instances cullObjects found in view.
         /** TODO: general cleanup for draft shading **/
-        for (auto& m : models)
+        for (const OttFrustumCuller::Run& run : frustumCuller.visibleRuns())
         {
-            push.offset     = m.offset;
-            push.color      = m.pushColorID;
-            push.textureID  = m.textureID;
+            const DrawBatch& batch = drawBatches[run.batch];
+            push.offset     = batch.offset;
+            push.color      = batch.color;
+            push.textureID  = batch.textureID;
+            push.quantOffset = batch.quantOffset;
+            push.quantScale  = batch.quantScale;
             vkCmdPushConstants(command_buffer, appPipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &push);
-            vkCmdDrawIndexed(command_buffer, m.edgeCount, 1, m.startEdge, 0, 0);
+            vkCmdDrawIndexed(command_buffer, batch.edgeCount, run.instanceCount, batch.firstEdge, batch.vertexOffset, run.firstInstance);
         }
         vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, appPipeline.graphicsPipelines.texture);
-        vkCmdBindIndexBuffer(command_buffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-        for (auto& m : models)
+        const auto width  = static_cast<float>(appSwapChain.width());
+        const auto height = static_cast<float>(appSwapChain.height());
+        std::optional<VkIndexType> boundIndexType;
+        uint32_t clusterDrawn = NO_CULL_BATCH;
+        for (const OttFrustumCuller::Run& run : frustumCuller.visibleRuns())
         {
-            push.offset     = m.offset;
-            push.color      = m.pushColorID;
-            push.textureID  = m.textureID;
+            const DrawBatch& batch = drawBatches[run.batch];
+            if (boundIndexType != batch.indexType)
+            {
+                const VkBuffer indexBuffer = batch.indexType == VK_INDEX_TYPE_UINT16 ? geometryUploader.getShortIndexBuffer()
+                                                                                     : geometryUploader.getIndexBuffer();
+                vkCmdBindIndexBuffer(command_buffer, indexBuffer, 0, batch.indexType);
+                boundIndexType = batch.indexType;
+            }
+            push.offset     = batch.offset;
+            push.color      = batch.color;
+            push.textureID  = batch.textureID;
+            push.quantOffset = batch.quantOffset;
+            push.quantScale  = batch.quantScale;
             vkCmdPushConstants(command_buffer, appPipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstantData), &push);
-            vkCmdDrawIndexed(command_buffer, m.indexCount, 1, m.startIndex, 0, 0);
+            const auto [firstIndex, indexCount] = selectLod(batch, run, width, height);
+            if (batch.cullBatch != NO_CULL_BATCH && firstIndex == batch.firstIndex)
+            {
+                // The cluster culler draws every instance of the batch, so once for all its runs.
+                if (clusterDrawn != batch.cullBatch)
+                    clusterCuller->drawBatch(command_buffer, appSwapChain.getCurrentFrame(), batch.cullBatch);
+                clusterDrawn = batch.cullBatch;
+            }
+            else
+            {
+                vkCmdDrawIndexed(command_buffer, indexCount, run.instanceCount, firstIndex, batch.vertexOffset, run.firstInstance);
+            }
         }
 
     }
@@ -289,6 +350,64 @@ void OttApplication::drawScene(VkCommandBuffer command_buffer)
     vkCmdDraw(command_buffer, 6, 1, 0, 0);
 }
 
+//----------------------------------------------------------------------------
+/** The view projection the uniform buffer got this frame, y flipped for Vulkan. **/
+glm::mat4 OttApplication::viewProjection() const
+{
+    glm::mat4 projection = viewportCamera->projection(static_cast<float>(appSwapChain.height()), static_cast<float>(appSwapChain.width()));
+    projection[1][1] *= -1;
+    return projection * viewportCamera->getViewMatrix();
+}
+
+//----------------------------------------------------------------------------
+/** Finds the instances of drawBatches in the view frustum, by their world space boxes. **/
+void OttApplication::cullObjects()
+{
+    frustumCuller.cull(OttClusterCuller::frustumPlanes(viewProjection()));
+}
+
+//----------------------------------------------------------------------------
+/** Records the meshlet culling of the current frame, with the view the uniform buffer got. **/
+void OttApplication::cullMeshlets(VkCommandBuffer command_buffer)
+{
+    if (!clusterCuller || clusterCuller->clusterCount() == 0)
+        return;
+    clusterCuller->record(command_buffer, appSwapChain.getCurrentFrame(), viewProjection(),
+                          viewportCamera->getEyePosition(), instanceBufferAddress);
+}
+
+//----------------------------------------------------------------------------
+/** Index range of the coarsest level whose error covers at most LOD_PIXEL_ERROR pixels on
+ *  screen. The error is relative to the bounding radius, so it scales with the projected
+ *  sphere. A run of instances in view is drawn in one call and takes the finest level any
+ *  of them needs. **/
+std::pair<uint32_t, uint32_t> OttApplication::selectLod(const DrawBatch& batch, const OttFrustumCuller::Run& run,
+                                                        const float width, const float height) const
+{
+    if (batch.lodCount == 0)
+        return { batch.firstIndex, batch.indexCount };
+
+    float pixels = 0.0f;
+    for (uint32_t i = 0; i < run.instanceCount && pixels < std::numeric_limits<float>::infinity(); i++)
+    {
+        const glm::mat4& transform = instanceTransforms[run.firstInstance + i];
+        const float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                                       glm::length(glm::vec3(transform[2])) });
+        const glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(batch.boundingSphere), 1.0f));
+        pixels = std::max(pixels, viewportCamera->projectedRadius(center, batch.boundingSphere.w * scale, height, width));
+    }
+
+    std::pair<uint32_t, uint32_t> range { batch.firstIndex, batch.indexCount };
+    for (uint32_t level = 0; level < batch.lodCount; level++)
+    {
+        const OttModel::LodRange& lod = batch.lods[level];
+        if (lod.error * pixels > LOD_PIXEL_ERROR)
+            break;
+        range = { lod.startIndex, lod.indexCount };
+    }
+    return range;
+}
+
 //-----------------------------------------------------------------------------
 void OttApplication::cleanupTextureObjects()
 {
@@ -321,19 +440,6 @@ void OttApplication::cleanupUBO() const
     vkDestroyDescriptorSetLayout(device, bindlessDescSetLayout, nullptr);
 }
 
-//-----------------------------------------------------------------------------
-void OttApplication::cleanupModelObjects() const
-{
-    if (edgesBuffer != VK_NULL_HANDLE)       { vkDestroyBuffer  (device, edgesBuffer,       nullptr); }
-    if (edgesBufferMemory != VK_NULL_HANDLE) { vkFreeMemory     (device, edgesBufferMemory, nullptr); }
-    
-    if (indexBuffer != VK_NULL_HANDLE)       { vkDestroyBuffer  (device, indexBuffer,       nullptr); }
-    if (indexBufferMemory != VK_NULL_HANDLE) { vkFreeMemory     (device, indexBufferMemory, nullptr); }
-    
-    if (vertexBuffer != VK_NULL_HANDLE)       { vkDestroyBuffer  (device, vertexBuffer,       nullptr); }
-    if (vertexBufferMemory != VK_NULL_HANDLE) { vkFreeMemory     (device, vertexBufferMemory, nullptr); }
-}
-    
 //----------------------------------------------------------------------------
 /** Cleanup function to destroy all Vulkan allocated resources **/
 void OttApplication::cleanupVulkanResources()
@@ -341,7 +447,12 @@ void OttApplication::cleanupVulkanResources()
     cleanupTextureObjects();
     if (textureSampler != VK_NULL_HANDLE)   { vkDestroySampler   (device, textureSampler,   nullptr); }
     cleanupUBO();
-    cleanupModelObjects();
+    clusterCuller.reset();
+    if (instanceBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer (device, instanceBuffer,       nullptr);
+        vkFreeMemory    (device, instanceBufferMemory, nullptr);
+    }
 }
     
 //----------------------------------------------------------------------------
@@ -368,191 +479,446 @@ VkImageView OttApplication::createImageView(VkImage image, VkFormat format, VkIm
 }
 
 //----------------------------------------------------------------------------
-void OttApplication::loadModel(std::filesystem::path const& modelPath)
+/** Loads the files of one drop without blocking the frame loop:
+ *  1. every file is parsed, welded and edge-extracted on the pool at the same time
+ *     (OttLoader::loadMeshAsync + whenAll);
+ *  2. on the worker that finished last, the meshes are staged back to back into one set of
+ *     staging buffers and their textures decoded;
+ *  3. back on the main thread the batch is queued for upload, and the coroutine resumes at
+ *     the frame boundary where the grown scene buffers become current;
+ *  4. the objects and textures are added and the descriptor set rebuilt once per drop.
+ *  Cancellation is honoured until the GPU copy is submitted. **/
+OttTask<void> OttApplication::loadModelsAsync(std::vector<std::filesystem::path> modelPaths, std::stop_token stop)
 {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-    auto baseDir = modelPath.parent_path();
-            
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath.string().c_str(), baseDir.string().c_str()))
+    using Stage = OttLoader::LoadProgress::Stage;
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::shared_ptr<OttLoader::LoadProgress>> progress;
+    std::vector<OttTask<std::optional<OttModel::MeshData>>> loads;
+    for (const auto& modelPath : modelPaths)
     {
-        log_t<error>("{}, {}", warn, err);
-        return;
+        progress.push_back(std::make_shared<OttLoader::LoadProgress>());
+        activeImports.push_back({ .path = modelPath, .progress = progress.back() });
+        loads.push_back(OttLoader::loadMeshAsync(modelPath, modelLoadOptions, stop, progress.back().get()));
     }
 
-    log_t<info>(DASHED_SEPARATOR);
-    log_t<info>("Loading Wavefront {}\n", modelPath);
-    log_t<info>("BaseDir {}\n", baseDir);
-
-    std::unordered_map<OttModel::Vertex, uint32_t> uniqueVertices{};
-
-    if (!materials.empty())
+    std::vector<OttModel::MeshData> meshes;
+    std::vector<size_t> loaded;
+    std::vector<std::vector<DecodedTexture>> textures;
+    std::optional<OttGeometryUploader::Staging> staging;
+    try
     {
-        materials.push_back(tinyobj::material_t());
-        for (size_t i = 0; i < materials.size() - 1; i++)
+        auto results = co_await OttAsync::whenAll(std::move(loads));
+        for (size_t i = 0; i < results.size(); i++)
         {
-          log_t<info>("material[{}].diffuse_texname = {}\n", i, materials[i].diffuse_texname);
-          sceneMaterials.imageTexture_path.clear();
-          auto material_path = baseDir.append(materials[i].diffuse_texname);
-          sceneMaterials.imageTexture_path.push_back(material_path.string().c_str());
+            if (!results[i])
+                continue;
+            meshes.push_back(std::move(*results[i]));
+            loaded.push_back(i);
+            progress[i]->report(Stage::Uploading, 0.9f);
+        }
+
+        if (!meshes.empty() && !stop.stop_requested())
+        {
+            textures.resize(meshes.size());
+            OttThreadPool::shared().parallelFor(meshes.size(), [&](const size_t m)
+            {
+                for (const std::string& texturePath : meshes[m].materialPaths)
+                    textures[m].push_back(decodeTexture(texturePath));
+                if (vertexFormat == OttModel::VertexFormat::Packed)
+                    OttModel::quantize(meshes[m]);
+                OttModel::splitShortIndices(meshes[m]);
+            });
+            staging = geometryUploader.stage(meshes);
         }
     }
-    
-    OttModel::modelObject model
-    {
-        .startIndex  = static_cast<uint32_t>(indices.size()),
-        .startVertex = static_cast<uint32_t>(vertices.size()),
-        .startEdge   = static_cast<uint32_t>(edges.size()),
-        .indexCount = 0,
-        .edgeCount = 0,
-    };
-    
-    for (const auto& shape : shapes)
+    catch (const std::exception& e)
     {
-        for (const auto& index : shape.mesh.indices)
-        {
-            OttModel::Vertex vertex{};
+        log_t<error>("Loading dropped models failed: {}", e.what());
+    }
 
-            if (index.vertex_index >= 0)
-            {
-                vertex.pos =
-                {
-                    attrib.vertices[3 * static_cast<size_t>(index.vertex_index) + 0],
-                    attrib.vertices[3 * static_cast<size_t>(index.vertex_index) + 1],
-                    attrib.vertices[3 * static_cast<size_t>(index.vertex_index) + 2]
-                };
+    co_await mainThreadQueue.schedule();
+    std::optional<OttGeometryUploader::Placement> placement;
+    if (staging)
+        placement = co_await geometryUploader.upload(*staging, stop);
 
-                vertex.color =
-                {
-                    attrib.colors[3 * static_cast<size_t>(index.vertex_index) + 0],
-                    attrib.colors[3 * static_cast<size_t>(index.vertex_index) + 1],
-                    attrib.colors[3 * static_cast<size_t>(index.vertex_index) + 2]
-                };
-            }
-            if (index.texcoord_index >= 0)
-            {
-                vertex.texCoord =
-                {
-                    attrib.texcoords[2 * static_cast<size_t>(index.texcoord_index) + 0],
-                    1.0f - attrib.texcoords[2 * static_cast<size_t>(index.texcoord_index) + 1]
-                };
-            }
-            if (index.normal_index >= 0)
+    if (placement)
+    {
+        try
+        {
+            bool texturesAdded = false;
+            for (size_t m = 0; m < meshes.size(); m++)
             {
-                vertex.normal =
+                const auto firstModel = static_cast<uint32_t>(models.size());
+                appendMesh(meshes[m], *placement);
+                for (const DecodedTexture& texture : textures[m])
                 {
-                    attrib.normals[3 * static_cast<size_t>(index.normal_index) + 0],
-                    attrib.normals[3 * static_cast<size_t>(index.normal_index) + 1],
-                    attrib.normals[3 * static_cast<size_t>(index.normal_index) + 2],
-                };
+                    createTextureImage(texture);
+                    createTextureImageView();
+                    texturesAdded = true;
+                }
+                placement->firstVertex += static_cast<uint32_t>(meshes[m].vertices.size());
+                placement->firstIndex  += static_cast<uint32_t>(meshes[m].indices.size());
+                placement->firstShortIndex += static_cast<uint32_t>(meshes[m].shortIndices.size());
+                placement->firstEdge   += static_cast<uint32_t>(meshes[m].edges.size());
+                keepForPicking(std::move(meshes[m]), firstModel);
+                progress[loaded[m]]->report(Stage::Done, 1.0f);
             }
-            if (uniqueVertices.count(vertex) == 0)
+            rebuildDrawBatches();
+            if (texturesAdded)
+                rebuildDescriptorSet();
+        }
+        catch (const std::exception& e)
+        {
+            log_t<error>("Adding dropped models to the scene failed: {}", e.what());
+        }
+    }
+
+    for (size_t i = 0; i < modelPaths.size(); i++)
+    {
+        if (progress[i]->stage == Stage::Done)
+            continue;
+        progress[i]->report(stop.stop_requested() ? Stage::Cancelled : Stage::Failed, 0.0f);
+        log_t<info>("{} was not added to the scene ({})", modelPaths[i], OttLoader::stageName(progress[i]->stage));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    log_t<info>("Added {} of {} dropped models in {:.3f}s with one upload", placement ? meshes.size() : 0, modelPaths.size(), seconds);
+
+    std::erase_if(activeImports, [&progress](const ModelImport& import)
+    {
+        return std::ranges::find(progress, import.progress) != progress.end();
+    });
+}
+
+//----------------------------------------------------------------------------
+/** Registers the objects of a resident mesh. Index and edge ranges are relative to the
+ *  object's startVertex, which the draw passes as vertexOffset. Objects the loader left
+ *  without edges take the range the GPU extracted for their indices, if any. **/
+void OttApplication::appendMesh(const OttModel::MeshData& mesh, const OttGeometryUploader::Placement& placement)
+{
+    const auto textureBase = static_cast<uint32_t>(textureImages.size());
+    const auto meshletBase = static_cast<uint32_t>(meshlets.size());
+    for (OttModel::Meshlet meshlet : mesh.meshlets)
+    {
+        meshlet.startIndex += placement.firstIndex;
+        meshlets.push_back(meshlet);
+    }
+
+    for (size_t i = 0; i < mesh.objects.size(); i++)
+    {
+        OttModel::modelObject model = mesh.objects[i];
+        const uint32_t firstIndex = model.shortIndices ? placement.firstShortIndex : placement.firstIndex;
+        model.startIndex  += firstIndex;
+        model.startVertex += placement.firstVertex;
+        model.startEdge   += placement.firstEdge;
+        if (model.meshletCount > 0)
+            model.firstMeshlet += meshletBase;
+        for (uint32_t level = 0; level < model.lodCount; level++)
+            model.lods[level].startIndex += firstIndex;
+        for (const OttGeometryUploader::EdgeRange& range : placement.gpuEdges)
+        {
+            if (model.edgeCount == 0 && !model.shortIndices && range.firstIndex == model.startIndex)
             {
-                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-                vertices.push_back(vertex);
+                model.startEdge = range.firstEdge;
+                model.edgeCount = range.edgeCount;
             }
-            indices.push_back(uniqueVertices[vertex]);
         }
+        model.pushColorID  = {Utils::random_nr(0, 1),  Utils::random_nr(0, 1), Utils::random_nr(0, 1)};
+        model.textureID    = (mesh.materialPaths.empty()) ?  0 : textureBase + model.textureID;
+        models.push_back(model);
+        modelIds.push_back(i < mesh.objectIds.size() ? mesh.objectIds[i] : std::string());
+        if (i < mesh.bounds.size())
+            sceneBounds.append(mesh.bounds.low(i), mesh.bounds.high(i), mesh.bounds.sphere(i), model.transform);
+        else
+            sceneBounds.append(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()), glm::vec4(0.0f));
+
+        log_t<info>(DASHED_SEPARATOR);
+        log_t<info>("VERTEX COUNT: {}", geometryUploader.vertexCount());
+        log_t<info>("model.startVertex: {}", model.startVertex);
+        log_t<info>("model.startIndex: {}",  model.startIndex);
+        log_t<info>("model.startEdge: {}",  model.startEdge);
+        log_t<info>("model.edgeCount: {}",  model.edgeCount);
+        log_t<info>("model.indexCount: {}",  model.indexCount);
+        log_t<info>("model.textureID {}",    model.textureID);
+        log_t<info>(DASHED_SEPARATOR);
     }
-    edges = OttModel::extractBoundaryEdges(indices);
-    log_t<info>("Edges Size == {}", edges.size());
-    model.indexCount  = static_cast<uint32_t>(indices.size()) - model.startIndex;
-    model.edgeCount   = (static_cast<uint32_t>(edges.size()) - model.startEdge);
-    model.pushColorID = {Utils::random_nr(0, 1),  Utils::random_nr(0, 1), Utils::random_nr(0, 1)};
-    model.textureID   = (materials.empty()) ?  0 : static_cast<uint32_t>(textureImages.size());
-    models.push_back(model);
-    
-    log_t<info>(DASHED_SEPARATOR);
-    log_t<info>("VERTEX COUNT: {}", vertices.size());
-    log_t<info>("model.startVertex: {}", model.startVertex);
-    log_t<info>("model.startIndex: {}",  model.startIndex);
-    log_t<info>("model.startEdge: {}",  model.startEdge);
-    log_t<info>("model.edgeCount: {}",  model.edgeCount);
-    log_t<info>("model.indexCount: {}",  model.indexCount);
-    log_t<info>("model.textureID {}",    model.textureID);
-    log_t<info>(DASHED_SEPARATOR);
+    sceneMaterials.imageTexture_path.insert(sceneMaterials.imageTexture_path.end(), mesh.materialPaths.begin(), mesh.materialPaths.end());
 }
 
 //----------------------------------------------------------------------------
-/** Buffers in Vulkan are regions of memory used for
- *  storing arbitrary data that can be read by the graphics card. **/
-void OttApplication::createVertexBuffer()
+/** Keeps what raycasts against mesh read, once its GPU copy is made. Edges, meshlets,
+ *  levels of detail and materials are only drawn, so they are dropped. **/
+void OttApplication::keepForPicking(OttModel::MeshData&& mesh, const uint32_t first_model)
 {
-    if (!vertices.empty())
+    if (mesh.bvh.objects.empty())
+        return;
+    mesh.edges         = {};
+    mesh.meshlets      = {};
+    mesh.materialPaths = {};
+    mesh.objectIds     = {};
+    mesh.links         = {};
+    mesh.bounds        = {};
+    pickMeshes.push_back({ .mesh = std::move(mesh), .firstModel = first_model });
+}
+
+//----------------------------------------------------------------------------
+/** When the left button goes down, casts a ray from the cursor into the scene and picks
+ *  the nearest object it hits, or none. Every kept mesh is searched through its BVH, the
+ *  nearest hit so far bounding the rays into the next. **/
+void OttApplication::pickObject()
+{
+    const bool down = Input::isMouseButtonDown(getWindowhandle(), GLFW_MOUSE_BUTTON_LEFT);
+    const bool pressed = down && !pickButtonDown;
+    pickButtonDown = down;
+    int windowWidth = 0, windowHeight = 0;
+    glfwGetWindowSize(getWindowhandle(), &windowWidth, &windowHeight);
+    if (!pressed || windowWidth == 0 || windowHeight == 0)
+        return;
+
+    // The cursor on the near and far planes. viewProjection() flips y, like the cursor.
+    const glm::vec2 cursor = Input::getMousePosition(getWindowhandle());
+    const glm::vec2 clip   = cursor / glm::vec2(windowWidth, windowHeight) * 2.0f - 1.0f;
+    const glm::mat4 toWorld  = glm::inverse(viewProjection());
+    const glm::vec4 nearSide = toWorld * glm::vec4(clip, 0.0f, 1.0f);
+    const glm::vec4 farSide  = toWorld * glm::vec4(clip, 1.0f, 1.0f);
+    const glm::vec3 origin    = glm::vec3(nearSide) / nearSide.w;
+    const glm::vec3 direction = glm::vec3(farSide) / farSide.w - origin;
+
+    OttBvh::Hit nearest;
+    pickedModel = OttBvh::NONE;
+    for (const PickMesh& pick : pickMeshes)
     {
-        using enum fmt::color;
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
-    
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        appDevice.createBuffer (bufferSize,
-                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                stagingBuffer, stagingBufferMemory
-                                );
-        void* data;
-        vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(device, stagingBufferMemory);
-
-        appDevice.createBuffer (bufferSize,
-                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                vertexBuffer, vertexBufferMemory);
-        appDevice.debugUtilsObjectNameInfoEXT (VK_OBJECT_TYPE_DEVICE_MEMORY, reinterpret_cast<uint64_t>(vertexBufferMemory), color_str<red>("application::VkDeviceMemory:vertexBufferMemory"));
-        appDevice.debugUtilsObjectNameInfoEXT (VK_OBJECT_TYPE_BUFFER, reinterpret_cast<uint64_t>(vertexBuffer), color_str<red>("application::VkBuffer:vertexBuffer"));
-        appDevice.copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
-
-        vkDestroyBuffer(device, stagingBuffer, nullptr);
-        vkFreeMemory(device, stagingBufferMemory, nullptr);
+        const OttBvh::Hit hit = OttBvh::raycast(pick.mesh.bvh, pick.mesh, origin, direction, nearest.distance);
+        if (hit.object != OttBvh::NONE)
+        {
+            nearest     = hit;
+            pickedModel = pick.firstModel + hit.object;
+        }
     }
 }
 
 //----------------------------------------------------------------------------
-void OttApplication::createIndexBuffer(std::vector<uint32_t>& index, VkBuffer& index_buffer, VkDeviceMemory& index_buffer_memory)
+/** Requests every running load to stop. Loads started afterwards get a fresh token. **/
+void OttApplication::cancelModelLoads()
 {
-    if (!vertices.empty())
-    {
-        using enum fmt::color;
-
-        VkDeviceSize bufferSize = sizeof(index[0]) * index.size();
-        VkBuffer stagingBuffer;
-        VkDeviceMemory stagingBufferMemory;
-        appDevice.createBuffer (bufferSize,
-                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                stagingBuffer,
-                                stagingBufferMemory);
-        void* data;
-        vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, index.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(device, stagingBufferMemory);
-
-        appDevice.createBuffer (bufferSize,
-                                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                index_buffer,
-                                index_buffer_memory);
-        appDevice.debugUtilsObjectNameInfoEXT(VK_OBJECT_TYPE_DEVICE_MEMORY, reinterpret_cast<uint64_t>(index_buffer_memory), color_str<red>("application::VkDeviceMemory:indexBufferMemory"));
-        appDevice.copyBuffer(stagingBuffer, index_buffer, bufferSize);
-    
-        vkDestroyBuffer(device, stagingBuffer, nullptr);
-        vkFreeMemory(device, stagingBufferMemory, nullptr);
+    if (activeImports.empty())
+        return;
+    importStop.request_stop();
+    importStop = std::stop_source();
+    log_t<info>("Cancelling {} model load(s)", activeImports.size());
+}
+
+//----------------------------------------------------------------------------
+/** Shows the objects in view of the last frame and the state of the running loads in the
+ *  window title; only touches GLFW when the text changes. **/
+void OttApplication::updateLoadProgress()
+{
+    std::string title = "Ottocento Engine";
+    if (frustumCuller.totalCount() > 0)
+        title += fmt::format(" | {} of {} objects in view", frustumCuller.visibleCount(), frustumCuller.totalCount());
+    if (pickedModel < modelIds.size())
+        title += modelIds[pickedModel].empty() ? fmt::format(" | object {} picked", pickedModel)
+                                               : fmt::format(" | {} picked", modelIds[pickedModel]);
+    for (const ModelImport& import : activeImports)
+    {
+        title += fmt::format(" | {} {} {:.0f}%", import.path.filename(), OttLoader::stageName(import.progress->stage),
+                             import.progress->fraction * 100.0f);
+    }
+    if (title != windowTitle)
+    {
+        windowTitle = std::move(title);
+        appwindow.setTitle(windowTitle.c_str());
     }
 }
-    
+
+//----------------------------------------------------------------------------
+/** Groups models that share geometry, texture and offset into instanced draws and writes
+ *  their transforms, batch by batch, into a new host visible instance buffer. The previous
+ *  buffer may still be read by frames in flight, so it is retired through the uploader.
+ *  The world space boxes of the instances go to frustumCuller, in the same order. The
+ *  meshlets of every batch go to the cluster culler, which draws the batch at full detail. **/
+void OttApplication::rebuildDrawBatches()
+{
+    struct BatchKey
+    {
+        uint32_t  firstIndex, indexCount, firstEdge, edgeCount, vertexOffset, textureID;
+        glm::vec3 offset;
+        uint32_t  shortIndices;
+
+        bool operator==(const BatchKey&) const = default;
+    };
+    struct BatchKeyHash
+    {
+        size_t operator()(const BatchKey& key) const { return Utils::hash64(&key, sizeof(key)); }
+    };
+
+    std::unordered_map<BatchKey, uint32_t, BatchKeyHash> batchOf;
+    std::vector<std::vector<uint32_t>> members;
+    drawBatches.clear();
+    for (uint32_t i = 0; i < models.size(); i++)
+    {
+        const OttModel::modelObject& m = models[i];
+        const BatchKey key { m.startIndex, m.indexCount, m.startEdge, m.edgeCount, m.startVertex, m.textureID, m.offset, m.shortIndices };
+        const auto [found, inserted] = batchOf.try_emplace(key, static_cast<uint32_t>(drawBatches.size()));
+        if (inserted)
+        {
+            drawBatches.push_back({
+                .firstIndex    = m.startIndex,
+                .indexCount    = m.indexCount,
+                .firstEdge     = m.startEdge,
+                .edgeCount     = m.edgeCount,
+                .vertexOffset  = static_cast<int32_t>(m.startVertex),
+                .indexType     = m.shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32,
+                .textureID     = m.textureID,
+                .offset        = m.offset,
+                .color         = m.pushColorID,
+                .quantOffset   = m.quantOffset,
+                .quantScale    = m.quantScale,
+                .firstInstance  = 0,
+                .instanceCount  = 0,
+                .lods           = m.lods,
+                .lodCount       = m.lodCount,
+                .boundingSphere = m.boundingSphere,
+                .firstMeshlet   = m.firstMeshlet,
+                .meshletCount   = m.meshletCount,
+                .cullBatch      = NO_CULL_BATCH,
+            });
+            members.emplace_back();
+        }
+        members[found->second].push_back(i);
+    }
+
+    std::vector<glm::mat4>& transforms = instanceTransforms;
+    transforms.clear();
+    transforms.reserve(models.size());
+    std::vector<OttFrustumCuller::Instance> cullInstances;
+    cullInstances.reserve(models.size());
+    for (size_t b = 0; b < drawBatches.size(); b++)
+    {
+        drawBatches[b].firstInstance = static_cast<uint32_t>(transforms.size());
+        drawBatches[b].instanceCount = static_cast<uint32_t>(members[b].size());
+        for (const uint32_t i : members[b])
+        {
+            transforms.push_back(models[i].transform);
+            cullInstances.push_back({ .low = sceneBounds.low(i), .high = sceneBounds.high(i), .transform = models[i].transform,
+                                      .batch = static_cast<uint32_t>(b) });
+        }
+    }
+    frustumCuller.setInstances(cullInstances);
+
+    if (instanceBuffer != VK_NULL_HANDLE)
+    {
+        geometryUploader.deferDestroy([device = device, buffer = instanceBuffer, memory = instanceBufferMemory]()
+        {
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+        });
+    }
+    const VkDeviceSize bufferSize = std::max<size_t>(transforms.size(), 1) * sizeof(glm::mat4);
+    appDevice.createBuffer(bufferSize,
+                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           instanceBuffer,
+                           instanceBufferMemory);
+    void* mapped;
+    vkMapMemory(device, instanceBufferMemory, 0, bufferSize, 0, &mapped);
+    std::memcpy(mapped, transforms.data(), transforms.size() * sizeof(glm::mat4));
+    vkUnmapMemory(device, instanceBufferMemory);
+
+    const VkBufferDeviceAddressInfo addressInfo {
+        .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = instanceBuffer,
+    };
+    instanceBufferAddress = vkGetBufferDeviceAddress(device, &addressInfo);
+    log_t<info>("{} models drawn in {} instanced batches", models.size(), drawBatches.size());
+
+    if (!clusterCuller)
+        return;
+    std::vector<OttClusterCuller::Cluster> clusters;
+    std::vector<OttClusterCuller::Batch>   cullBatches;
+    for (DrawBatch& batch : drawBatches)
+    {
+        if (batch.meshletCount == 0)
+            continue;
+        batch.cullBatch = static_cast<uint32_t>(cullBatches.size());
+        cullBatches.push_back({
+            .firstInstance = batch.firstInstance,
+            .instanceCount = batch.instanceCount,
+            .firstCommand  = static_cast<uint32_t>(clusters.size()),
+            .vertexOffset  = batch.vertexOffset,
+        });
+        for (uint32_t i = 0; i < batch.meshletCount; i++)
+        {
+            const OttModel::Meshlet& meshlet = meshlets[batch.firstMeshlet + i];
+            clusters.push_back({
+                .sphere     = meshlet.boundingSphere,
+                .cone       = meshlet.cone,
+                .firstIndex = meshlet.startIndex,
+                .indexCount = meshlet.indexCount,
+                .batch      = batch.cullBatch,
+            });
+        }
+    }
+    clusterCuller->setClusters(clusters, cullBatches, [this](std::function<void()> destroy) { geometryUploader.deferDestroy(std::move(destroy)); });
+    log_t<info>("{} meshlets of {} batches culled on the GPU", clusters.size(), cullBatches.size());
+}
+
+//----------------------------------------------------------------------------
+/** Writes the current texture list into a new descriptor set. The old pool may still be
+ *  bound by frames in flight, so it is destroyed through the uploader's deferred queue. **/
+void OttApplication::rebuildDescriptorSet()
+{
+    geometryUploader.deferDestroy([device = device, retiredPool = descriptorPool]()
+    {
+        vkDestroyDescriptorPool(device, retiredPool, nullptr);
+    });
+    OttDescriptor::createDescriptorPool(device, descriptorPool);
+    bindlessDescriptorSet = OttDescriptor::createDescriptorSet(device, 1, bindlessDescSetLayout, descriptorPool);
+    OttDescriptor::updateDescriptorSet (
+        device, appDevice,
+        bindlessDescriptorSet,
+        uniformBuffers[0],
+        textureImages,
+        textureSampler,
+        textureImageViews
+    );
+}
+
+//----------------------------------------------------------------------------
+/** Reads an image into RGBA8 pixels. Thread safe, so loads decode their textures on the
+ *  worker. A file that can't be read becomes a 1x1 white texture and keeps the texture
+ *  ids of the model in step. **/
+OttApplication::DecodedTexture OttApplication::decodeTexture(const std::filesystem::path& imagePath)
+{
+    DecodedTexture texture { .path = imagePath };
+    int texChannels;
+    stbi_uc* pixels = stbi_load(imagePath.string().c_str(), &texture.width, &texture.height, &texChannels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        log_t<warning>("Failed to load texture {}: {}", imagePath, stbi_failure_reason());
+        return DecodedTexture { .path = imagePath };
+    }
+    texture.pixels.assign(pixels, pixels + static_cast<size_t>(texture.width) * static_cast<size_t>(texture.height) * 4);
+    stbi_image_free(pixels);
+    return texture;
+}
+
 //----------------------------------------------------------------------------
 void OttApplication::createTextureImage(const std::filesystem::path& imagePath)
 {
-    int texWidth, texHeight, texChannels;
+    createTextureImage(decodeTexture(imagePath));
+}
+
+//----------------------------------------------------------------------------
+void OttApplication::createTextureImage(const DecodedTexture& texture)
+{
+    const int texWidth  = texture.width;
+    const int texHeight = texture.height;
 
     log_t<info>(DASHED_SEPARATOR);
-    log_t<info>("Image path: {}", imagePath.string());
+    log_t<info>("Image path: {}", texture.path.string());
 
-    stbi_uc* pixels = stbi_load(imagePath.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize { static_cast<VkDeviceSize>(texWidth * texHeight * 4) };
+    VkDeviceSize imageSize { static_cast<VkDeviceSize>(texture.pixels.size()) };
     mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
     VkBuffer stagingBuffer;
@@ -566,9 +932,8 @@ void OttApplication::createTextureImage(const std::filesystem::path& imagePath)
 
     void* data;
     vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
+    memcpy(data, texture.pixels.data(), static_cast<size_t>(imageSize));
     vkUnmapMemory(device, stagingBufferMemory);
-    stbi_image_free(pixels);
 
     VkDeviceMemory textureImageMemoryBuffer{};
     textureImageMemory.push_back(textureImageMemoryBuffer);
@@ -675,7 +1040,8 @@ void OttApplication::updateUniformBufferCamera(const uint32_t currentImage, cons
         .cameraPos             = viewportCamera->getEyePosition(),
     };
 
-    if (!vertices.empty()) { ubo.edgesBuffer = vkGetBufferDeviceAddress(device, &edgesBufferAddressInfo); }
+    ubo.edgesBuffer    = geometryUploader.getEdgesBufferAddress();
+    ubo.instanceBuffer = instanceBufferAddress;
     ubo.proj[1][1] *= -1;
     memcpy(uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
 }
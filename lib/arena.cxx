@@ -0,0 +1,123 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "arena.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+namespace
+{
+    // Smallest allocation, so tiny models don't trigger a chain of growth steps.
+    constexpr VkDeviceSize MIN_CAPACITY = 64 * 1024;
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttGeometryArena::OttGeometryArena(OttDevice* device_reference, const VkBufferUsageFlags usage, std::string name)
+    : deviceRef(device_reference), usage(usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT), name(std::move(name))
+{
+}
+
+//----------------------------------------------------------------------------
+/** Expects the device to be idle. **/
+OttGeometryArena::~OttGeometryArena()
+{
+    release(grown);
+    release(current);
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryArena::reserve(const VkDeviceSize bytes)
+{
+    if (bytes <= current.capacity || hasPendingGrowth())
+        return;
+
+    // Nothing has been appended yet in the common case, so there is nothing to carry over.
+    Allocation larger = allocate(bytes);
+    if (used > 0)
+    {
+        VkBuffer source = current.buffer;
+        deviceRef->copyBuffer(source, larger.buffer, used);
+    }
+    release(current);
+    current = larger;
+}
+
+//----------------------------------------------------------------------------
+VkDeviceSize OttGeometryArena::recordAppend(VkCommandBuffer command_buffer, VkBuffer source, const VkDeviceSize size,
+                                            const VkDeviceSize reserve)
+{
+    const VkDeviceSize offset   = used;
+    const VkDeviceSize required = used + size + reserve;
+    pendingUsed = required;
+    if (required == used)
+        return offset;
+
+    VkBuffer target = current.buffer;
+    if (required > current.capacity)
+    {
+        const VkDeviceSize capacity = std::max({ required, current.capacity * GROWTH_FACTOR, MIN_CAPACITY });
+        grown  = allocate(capacity);
+        target = grown.buffer;
+        if (used > 0)
+        {
+            const VkBufferCopy carry { .srcOffset = 0, .dstOffset = 0, .size = used };
+            vkCmdCopyBuffer(command_buffer, current.buffer, target, 1, &carry);
+        }
+        log_t<info>("{} arena grows from {:.1f} to {:.1f} MB", name,
+                    static_cast<double>(current.capacity) / (1024.0 * 1024.0), static_cast<double>(capacity) / (1024.0 * 1024.0));
+    }
+
+    if (size > 0)
+    {
+        const VkBufferCopy append { .srcOffset = 0, .dstOffset = offset, .size = size };
+        vkCmdCopyBuffer(command_buffer, source, target, 1, &append);
+    }
+    return offset;
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryArena::commit(const std::function<void(std::function<void()>)>& retire)
+{
+    if (hasPendingGrowth())
+    {
+        if (current.buffer != VK_NULL_HANDLE)
+            retire([this, old = current]() mutable { release(old); });
+        current = std::exchange(grown, {});
+    }
+    used = pendingUsed;
+}
+
+//----------------------------------------------------------------------------
+OttGeometryArena::Allocation OttGeometryArena::allocate(const VkDeviceSize capacity) const
+{
+    using enum fmt::color;
+
+    Allocation allocation { .capacity = capacity };
+    deviceRef->createBuffer(capacity, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocation.buffer, allocation.memory);
+    deviceRef->debugUtilsObjectNameInfoEXT(VK_OBJECT_TYPE_BUFFER, reinterpret_cast<uint64_t>(allocation.buffer), fmt::format(fg(red), " OttGeometryArena::{} ", name));
+    return allocation;
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryArena::release(Allocation& allocation) const
+{
+    const VkDevice device = deviceRef->getDevice();
+    if (allocation.buffer != VK_NULL_HANDLE) { vkDestroyBuffer (device, allocation.buffer, nullptr); }
+    if (allocation.memory != VK_NULL_HANDLE) { vkFreeMemory    (device, allocation.memory, nullptr); }
+    allocation = {};
+}
@@ -0,0 +1,351 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "bvh.h"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <map>
+#include <tuple>
+
+#include "model.h"
+#include "radixsort.h"
+#include "threadpool.h"
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = 1 << 14;
+    constexpr int    AXIS_BITS  = 10;   // Morton codes interleave 3 x 10 bits.
+
+    //----------------------------------------------------------------------------
+    /** Runs fn(block, first, last) over count items in blocks on the shared pool. **/
+    template<typename F>
+    void forBlocks(const size_t count, F&& fn)
+    {
+        OttThreadPool::shared().parallelFor((count + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](const size_t block)
+        {
+            fn(block, block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE));
+        });
+    }
+
+    //----------------------------------------------------------------------------
+    /** Spreads the low 10 bits of value two bits apart. **/
+    uint32_t spreadBits(uint32_t value)
+    {
+        value = (value | (value << 16)) & 0x030000FF;
+        value = (value | (value << 8))  & 0x0300F00F;
+        value = (value | (value << 4))  & 0x030C30C3;
+        value = (value | (value << 2))  & 0x09249249;
+        return value;
+    }
+
+    uint32_t mortonCode(const glm::vec3& fraction)
+    {
+        constexpr float CELLS = float(1 << AXIS_BITS);
+        const glm::vec3 cell = glm::clamp(fraction * CELLS, glm::vec3(0.0f), glm::vec3(CELLS - 1.0f));
+        return (spreadBits(static_cast<uint32_t>(cell.x)) << 2) | (spreadBits(static_cast<uint32_t>(cell.y)) << 1)
+             | spreadBits(static_cast<uint32_t>(cell.z));
+    }
+
+    struct Coded
+    {
+        uint32_t code;
+        uint32_t item;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Length of the common prefix of the codes at i and j, extended by the one of i and j
+     *  where the codes are equal; -1 outside of the array. **/
+    int commonPrefix(const std::vector<Coded>& sorted, const int64_t i, const int64_t j)
+    {
+        if (j < 0 || j >= static_cast<int64_t>(sorted.size()))
+            return -1;
+        const uint32_t a = sorted[i].code, b = sorted[j].code;
+        if (a != b)
+            return std::countl_zero(a ^ b);
+        return 32 + std::countl_zero(static_cast<uint32_t>(i) ^ static_cast<uint32_t>(j));
+    }
+
+    //----------------------------------------------------------------------------
+    /** Children of inner node i: the direction of its range from the prefixes on either
+     *  side, the far end by exponential then binary search, the split by binary search for
+     *  the last item sharing more than the range's prefix. **/
+    std::pair<uint32_t, uint32_t> children(const std::vector<Coded>& sorted, const int64_t i)
+    {
+        const auto leaves = static_cast<int64_t>(sorted.size()) - 1;   // Leaf k is node leaves + k.
+        const int64_t direction = commonPrefix(sorted, i, i + 1) > commonPrefix(sorted, i, i - 1) ? 1 : -1;
+        const int minPrefix = commonPrefix(sorted, i, i - direction);
+
+        int64_t maxLength = 2;
+        while (commonPrefix(sorted, i, i + maxLength * direction) > minPrefix)
+            maxLength *= 2;
+        int64_t length = 0;
+        for (int64_t step = maxLength / 2; step >= 1; step /= 2)
+        {
+            if (commonPrefix(sorted, i, i + (length + step) * direction) > minPrefix)
+                length += step;
+        }
+        const int64_t j = i + length * direction;
+
+        const int nodePrefix = commonPrefix(sorted, i, j);
+        int64_t split = 0;
+        for (int64_t step = length; step > 1;)
+        {
+            step = (step + 1) / 2;
+            if (commonPrefix(sorted, i, i + (split + step) * direction) > nodePrefix)
+                split += step;
+        }
+        const int64_t gamma = i + split * direction + std::min<int64_t>(direction, 0);
+        const int64_t left  = std::min(i, j) == gamma     ? leaves + gamma     : gamma;
+        const int64_t right = std::max(i, j) == gamma + 1 ? leaves + gamma + 1 : gamma + 1;
+        return { static_cast<uint32_t>(left), static_cast<uint32_t>(right) };
+    }
+
+    //----------------------------------------------------------------------------
+    /** The index range an object draws, from indices or shortIndices. **/
+    template<typename Visit>
+    void withIndices(const OttModel::MeshData& mesh, const OttModel::modelObject& object, Visit&& visit)
+    {
+        if (object.shortIndices)
+            visit(std::span(mesh.shortIndices).subspan(object.startIndex, object.indexCount / 3 * 3));
+        else
+            visit(std::span(mesh.indices).subspan(object.startIndex, object.indexCount / 3 * 3));
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttBvh::Tree OttBvh::build(const std::span<const Box> boxes)
+{
+    Tree tree;
+    const size_t count = boxes.size();
+    if (count == 0)
+        return tree;
+
+    // Bounds of the box centers, which the codes are relative to.
+    const size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<Box> blockCenters(blocks);
+    forBlocks(count, [&](const size_t block, const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            if (boxes[i].low.x > boxes[i].high.x)
+                continue;
+            const glm::vec3 center = 0.5f * (boxes[i].low + boxes[i].high);
+            blockCenters[block].low  = glm::min(blockCenters[block].low, center);
+            blockCenters[block].high = glm::max(blockCenters[block].high, center);
+        }
+    });
+    Box centers;
+    for (const Box& block : blockCenters)
+    {
+        centers.low  = glm::min(centers.low, block.low);
+        centers.high = glm::max(centers.high, block.high);
+    }
+    const glm::vec3 extent = centers.high - centers.low;
+    const glm::vec3 scale(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                          extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+    std::vector<Coded> sorted(count);
+    forBlocks(count, [&](size_t, const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            const bool empty = boxes[i].low.x > boxes[i].high.x;
+            const glm::vec3 center = empty ? centers.low : 0.5f * (boxes[i].low + boxes[i].high);
+            sorted[i] = { mortonCode((center - centers.low) * scale), static_cast<uint32_t>(i) };
+        }
+    });
+    OttRadix::sort(sorted, 3 * AXIS_BITS, [](const Coded& coded) { return uint64_t(coded.code); });
+
+    const size_t inner = count - 1;
+    tree.nodes.resize(inner + count);
+    std::vector<uint32_t> parent(inner + count, NONE);
+    forBlocks(count, [&](size_t, const size_t first, const size_t last)
+    {
+        for (size_t k = first; k < last; k++)
+        {
+            const Box& box = boxes[sorted[k].item];
+            tree.nodes[inner + k] = { .low = box.low, .left = sorted[k].item, .high = box.high, .right = NONE };
+        }
+    });
+    forBlocks(inner, [&](size_t, const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            const auto [left, right] = children(sorted, static_cast<int64_t>(i));
+            tree.nodes[i].left  = left;
+            tree.nodes[i].right = right;
+            parent[left]  = static_cast<uint32_t>(i);
+            parent[right] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // Every leaf walks up until it reaches a parent its sibling hasn't finished yet.
+    std::vector<std::atomic<uint32_t>> arrivals(inner);
+    forBlocks(count, [&](size_t, const size_t first, const size_t last)
+    {
+        for (size_t k = first; k < last; k++)
+        {
+            for (uint32_t node = parent[inner + k]; node != NONE; node = parent[node])
+            {
+                if (arrivals[node].fetch_add(1, std::memory_order_acq_rel) == 0)
+                    break;
+                Node& merged = tree.nodes[node];
+                merged.low  = glm::min(tree.nodes[merged.left].low, tree.nodes[merged.right].low);
+                merged.high = glm::max(tree.nodes[merged.left].high, tree.nodes[merged.right].high);
+            }
+        }
+    });
+    return tree;
+}
+
+//----------------------------------------------------------------------------
+float OttBvh::intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b,
+                                const glm::vec3& c)
+{
+    constexpr float MISS = std::numeric_limits<float>::infinity();
+    const glm::vec3 ab = b - a, ac = c - a;
+    const glm::vec3 p = glm::cross(direction, ac);
+    const float determinant = glm::dot(ab, p);
+    if (determinant == 0.0f)
+        return MISS;
+    const float inverse = 1.0f / determinant;
+    const glm::vec3 s = origin - a;
+    const float u = glm::dot(s, p) * inverse;
+    if (u < 0.0f || u > 1.0f)
+        return MISS;
+    const glm::vec3 q = glm::cross(s, ab);
+    const float v = glm::dot(direction, q) * inverse;
+    if (v < 0.0f || u + v > 1.0f)
+        return MISS;
+    const float distance = glm::dot(ac, q) * inverse;
+    return distance >= 0.0f ? distance : MISS;
+}
+
+//----------------------------------------------------------------------------
+size_t OttBvh::SceneBvh::bytes() const
+{
+    size_t total = objects.nodes.size() * sizeof(Node) + rangeOf.size() * sizeof(uint32_t) + toObject.size() * sizeof(glm::mat4);
+    for (const Tree& range : ranges)
+        total += range.nodes.size() * sizeof(Node);
+    return total;
+}
+
+//----------------------------------------------------------------------------
+/** Objects drawing the same indices from the same buffer and base vertex share a range,
+ *  numbered in order of first use. **/
+OttBvh::SceneBvh OttBvh::build(const OttModel::MeshData& mesh, BvhStats* stats)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    SceneBvh bvh;
+    bvh.rangeOf.assign(mesh.objects.size(), NONE);
+    bvh.toObject.resize(mesh.objects.size());
+
+    std::map<std::tuple<bool, uint32_t, uint32_t, uint32_t>, uint32_t> rangeAt;
+    std::vector<uint32_t> firstObject;
+    for (uint32_t i = 0; i < mesh.objects.size(); i++)
+    {
+        const OttModel::modelObject& object = mesh.objects[i];
+        bvh.toObject[i] = glm::inverse(object.transform);
+        if (object.indexCount < 3)
+            continue;
+        const auto key = std::make_tuple(object.shortIndices, object.startIndex, object.indexCount / 3, object.startVertex);
+        const auto [found, inserted] = rangeAt.try_emplace(key, static_cast<uint32_t>(firstObject.size()));
+        if (inserted)
+            firstObject.push_back(i);
+        bvh.rangeOf[i] = found->second;
+    }
+
+    bvh.ranges.resize(firstObject.size());
+    OttThreadPool::shared().parallelFor(firstObject.size(), [&](const size_t r)
+    {
+        const OttModel::modelObject& object = mesh.objects[firstObject[r]];
+        withIndices(mesh, object, [&](const auto indices)
+        {
+            std::vector<Box> boxes(indices.size() / 3);
+            forBlocks(boxes.size(), [&](size_t, const size_t first, const size_t last)
+            {
+                for (size_t t = first; t < last; t++)
+                {
+                    const glm::vec3& a = mesh.vertices[object.startVertex + indices[3 * t]].pos;
+                    const glm::vec3& b = mesh.vertices[object.startVertex + indices[3 * t + 1]].pos;
+                    const glm::vec3& c = mesh.vertices[object.startVertex + indices[3 * t + 2]].pos;
+                    boxes[t] = { glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c)) };
+                }
+            });
+            bvh.ranges[r] = build(boxes);
+        });
+    });
+
+    std::vector<Box> objectBoxes(mesh.objects.size());
+    for (size_t i = 0; i < mesh.objects.size(); i++)
+    {
+        if (bvh.rangeOf[i] == NONE)
+            continue;
+        const Node& root = bvh.ranges[bvh.rangeOf[i]].nodes[0];
+        glm::vec3 center, extent;
+        OttModel::transformBox(mesh.objects[i].transform, root.low, root.high, center, extent);
+        objectBoxes[i] = { center - extent, center + extent };
+    }
+    bvh.objects = build(objectBoxes);
+
+    if (stats)
+    {
+        *stats = { .objects = mesh.objects.size(), .ranges = bvh.ranges.size(), .nodes = bvh.objects.nodes.size(), .bytes = bvh.bytes() };
+        for (const Tree& range : bvh.ranges)
+        {
+            stats->triangles += range.itemCount();
+            stats->nodes     += range.nodes.size();
+        }
+        stats->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    }
+    return bvh;
+}
+
+//----------------------------------------------------------------------------
+/** The ray keeps its parameter in object space, since direction is transformed without
+ *  being normalized. **/
+OttBvh::Hit OttBvh::raycast(const SceneBvh& bvh, const OttModel::MeshData& mesh, const glm::vec3& origin,
+                            const glm::vec3& direction, const float maxDistance)
+{
+    Hit hit;
+    float limit = maxDistance;
+    raycast(bvh.objects, origin, direction, limit, [&](const uint32_t object, float& objectLimit)
+    {
+        if (bvh.rangeOf[object] == NONE)
+            return;
+        const OttModel::modelObject& model = mesh.objects[object];
+        const glm::vec3 localOrigin    = glm::vec3(bvh.toObject[object] * glm::vec4(origin, 1.0f));
+        const glm::vec3 localDirection = glm::vec3(bvh.toObject[object] * glm::vec4(direction, 0.0f));
+        withIndices(mesh, model, [&](const auto indices)
+        {
+            raycast(bvh.ranges[bvh.rangeOf[object]], localOrigin, localDirection, objectLimit, [&](const uint32_t triangle, float& triangleLimit)
+            {
+                const float distance = intersectTriangle(localOrigin, localDirection,
+                                                         mesh.vertices[model.startVertex + indices[3 * triangle]].pos,
+                                                         mesh.vertices[model.startVertex + indices[3 * triangle + 1]].pos,
+                                                         mesh.vertices[model.startVertex + indices[3 * triangle + 2]].pos);
+                if (distance < triangleLimit)
+                {
+                    triangleLimit = distance;
+                    hit = { .object = object, .triangle = triangle, .distance = distance };
+                }
+            });
+        });
+    });
+    return hit;
+}
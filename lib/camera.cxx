@@ -26,6 +26,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <cmath>
+#include <limits>
 
 
 //----------------------------------------------------------------------------
@@ -247,6 +249,19 @@ glm::mat4 OttCamera::inverseProjection(glm::mat4 perspectiveProjection, glm::mat
 {
     return glm::inverse(perspectiveProjection * view);
 }
+
+//----------------------------------------------------------------------------
+// Radius in pixels of a world space sphere on screen, for picking levels of detail.
+// Spheres reaching behind the near plane are treated as infinitely large.
+float OttCamera::projectedRadius(const glm::vec3& center, float radius, float height, float width) const
+{
+    const glm::vec4 view = ViewMatrix * glm::vec4(center, 1.0f);
+    if (perspective && -view.z - radius <= NearClip)
+        return std::numeric_limits<float>::infinity();
+    const glm::mat4 clip = projection(height, width);
+    const float w = perspective ? -view.z : 1.0f;
+    return radius * std::abs(clip[1][1]) * 0.5f * height / w;
+}
     
 // ----------------------------------------------------------------------------
 // This function uses the same formula principles as the viewportInputHandle function
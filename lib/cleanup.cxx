@@ -0,0 +1,374 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "cleanup.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+#include "radixsort.h"
+#include "threadpool.h"
+#include "utils.hxx"
+
+namespace
+{
+    constexpr size_t   BLOCK_SIZE     = 1 << 14;   // Triangles or vertices per chunk.
+    constexpr size_t   PARTITION_SIZE = 1 << 12;   // Keys per partition, so its table stays in cache.
+    constexpr uint32_t EMPTY          = UINT32_MAX;
+
+    // Index range to clean, its values relative to startVertex.
+    struct Range
+    {
+        uint32_t startIndex  = 0;
+        uint32_t indexCount  = 0;
+        uint32_t startVertex = 0;
+    };
+
+    // Up to BLOCK_SIZE triangles of one range. Ordinals number the triangles of every range in turn.
+    struct Chunk
+    {
+        uint32_t range      = 0;
+        uint32_t first      = 0;   // Triangle within the range.
+        uint32_t count      = 0;
+        uint32_t ordinal    = 0;   // Of the first triangle.
+        size_t   candidates = 0;   // Triangles that may be duplicates, and where their keys go.
+        size_t   keyed      = 0;
+        size_t   kept       = 0;   // Triangles that stay, and where their indices go.
+        size_t   output     = 0;
+        size_t   collapsed  = 0;
+        size_t   zeroArea   = 0;
+        size_t   duplicate  = 0;
+        size_t   reversed   = 0;
+    };
+
+    // Range, then the three position ids of a triangle in ascending order. odd when sorting
+    // them took an odd number of swaps, so equal keys of different parity are wound apart.
+    struct TriangleKey
+    {
+        std::array<uint32_t, 4> ids;
+        bool odd = false;
+    };
+
+    enum class Status : uint8_t { Removed, Kept, Candidate };
+
+    struct Keyed
+    {
+        uint64_t hash;
+        uint32_t id;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Runs body(first, last) over count items in blocks on the shared pool. **/
+    template<typename Body>
+    void forEachBlock(const size_t count, Body&& body)
+    {
+        OttThreadPool::shared().parallelFor((count + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](const size_t block)
+        {
+            body(block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE));
+        });
+    }
+
+    //----------------------------------------------------------------------------
+    /** Sets first[id] of every entry to the lowest id with an equal key. Entries come in
+     *  ascending id order and are radix sorted by the top bits of their hash into partitions
+     *  of about PARTITION_SIZE, which the stable sort keeps in id order and which are then
+     *  deduplicated in parallel. same(a, b) compares the keys of two ids of equal hash. **/
+    template<typename Same>
+    void firstEqual(std::vector<Keyed>& entries, std::vector<uint32_t>& first, Same&& same)
+    {
+        const int bits = std::min(16, static_cast<int>(std::bit_width(entries.size() / PARTITION_SIZE)));
+        auto partitionOf = [bits](const Keyed& entry) { return bits > 0 ? entry.hash >> (64 - bits) : 0; };
+        OttRadix::sort(entries, bits, partitionOf);
+
+        OttThreadPool::shared().parallelFor(size_t(1) << bits, [&](const size_t p)
+        {
+            const auto begin = std::ranges::lower_bound(entries, uint64_t(p), {}, partitionOf);
+            const auto end   = std::ranges::lower_bound(begin, entries.end(), uint64_t(p + 1), {}, partitionOf);
+            const size_t mask = std::bit_ceil(std::max<size_t>(2 * static_cast<size_t>(end - begin), 16)) - 1;
+            std::vector<uint32_t> table(mask + 1, EMPTY);
+            for (auto entry = begin; entry != end; entry++)
+            {
+                for (size_t slot = entry->hash & mask; ; slot = (slot + 1) & mask)
+                {
+                    if (table[slot] == EMPTY)
+                    {
+                        table[slot] = static_cast<uint32_t>(entry - begin);
+                        first[entry->id] = entry->id;
+                        break;
+                    }
+                    const Keyed& other = begin[table[slot]];
+                    if (other.hash == entry->hash && same(other.id, entry->id))
+                    {
+                        first[entry->id] = other.id;
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    //----------------------------------------------------------------------------
+    TriangleKey sortedKey(const uint32_t range, const uint32_t a, const uint32_t b, const uint32_t c)
+    {
+        TriangleKey key { .ids = { range, a, b, c } };
+        auto order = [&key](uint32_t& x, uint32_t& y)
+        {
+            if (y < x)
+            {
+                std::swap(x, y);
+                key.odd = !key.odd;
+            }
+        };
+        order(key.ids[1], key.ids[2]);
+        order(key.ids[2], key.ids[3]);
+        order(key.ids[1], key.ids[2]);
+        return key;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Cleans ranges of indices and vertices, rebuilding indices from the ranges in order
+     *  and updating each range to its new place. **/
+    OttCleanup::CleanupStats cleanRanges(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                                         std::vector<Range>& ranges, const OttCleanup::CleanupOptions& options)
+    {
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        OttCleanup::CleanupStats stats;
+
+        std::vector<Chunk> chunks;
+        for (uint32_t r = 0; r < ranges.size(); r++)
+        {
+            const uint32_t triangles = ranges[r].indexCount / 3;
+            for (uint32_t first = 0; first < triangles; first += BLOCK_SIZE)
+            {
+                chunks.push_back({ .range   = r, .first = first, .count = std::min<uint32_t>(BLOCK_SIZE, triangles - first),
+                                   .ordinal = static_cast<uint32_t>(stats.triangles + first) });
+            }
+            stats.triangles += triangles;
+        }
+
+        // Every vertex maps to the lowest vertex at its position; adding zero turns -0 into +0.
+        std::vector<uint32_t> positionOf(vertices.size());
+        {
+            std::vector<Keyed> entries(vertices.size());
+            forEachBlock(vertices.size(), [&](const size_t first, const size_t last)
+            {
+                for (size_t v = first; v < last; v++)
+                {
+                    const glm::vec3 key = vertices[v].pos + glm::vec3(0.0f);
+                    entries[v] = { Utils::hash64(&key, sizeof(key)), static_cast<uint32_t>(v) };
+                }
+            });
+            firstEqual(entries, positionOf, [&](const uint32_t a, const uint32_t b) { return vertices[a].pos == vertices[b].pos; });
+        }
+
+        auto cornersOf = [&](const Chunk& chunk, const uint32_t t) -> std::array<uint32_t, 3>
+        {
+            const Range& range = ranges[chunk.range];
+            const uint32_t* corner = indices.data() + range.startIndex + 3 * size_t(chunk.first + t);
+            return { positionOf[range.startVertex + corner[0]], positionOf[range.startVertex + corner[1]],
+                     positionOf[range.startVertex + corner[2]] };
+        };
+        auto keyOf = [&](const uint32_t ordinal)
+        {
+            const Chunk& chunk = *std::prev(std::ranges::upper_bound(chunks, ordinal, {}, &Chunk::ordinal));
+            const std::array<uint32_t, 3> p = cornersOf(chunk, ordinal - chunk.ordinal);
+            return sortedKey(chunk.range, p[0], p[1], p[2]);
+        };
+
+        // Collapsed and zero-area triangles go; the others may be duplicates.
+        std::vector<Status> status(stats.triangles, Status::Removed);
+        OttThreadPool::shared().parallelFor(chunks.size(), [&](const size_t c)
+        {
+            Chunk& chunk = chunks[c];
+            for (uint32_t t = 0; t < chunk.count; t++)
+            {
+                const std::array<uint32_t, 3> p = cornersOf(chunk, t);
+                if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2])
+                {
+                    chunk.collapsed++;
+                    continue;
+                }
+                const glm::vec3& a = vertices[p[0]].pos;
+                const glm::vec3& b = vertices[p[1]].pos;
+                const glm::vec3& d = vertices[p[2]].pos;
+                const float longest = std::max({ glm::dot(b - a, b - a), glm::dot(d - b, d - b), glm::dot(a - d, a - d) });
+                if (glm::length(glm::cross(b - a, d - a)) <= 2.0f * options.areaRatio * longest)
+                {
+                    chunk.zeroArea++;
+                    continue;
+                }
+                status[chunk.ordinal + t] = options.duplicates ? Status::Candidate : Status::Kept;
+                chunk.candidates++;
+            }
+        });
+
+        // The first triangle over each key stays; the same parity means the same winding.
+        std::vector<uint32_t> firstOf;
+        if (options.duplicates)
+        {
+            size_t candidates = 0;
+            for (Chunk& chunk : chunks)
+                candidates += std::exchange(chunk.candidates, candidates);
+            std::vector<Keyed> entries(candidates);
+            OttThreadPool::shared().parallelFor(chunks.size(), [&](const size_t c)
+            {
+                const Chunk& chunk = chunks[c];
+                Keyed* out = entries.data() + chunk.candidates;
+                for (uint32_t t = 0; t < chunk.count; t++)
+                {
+                    if (status[chunk.ordinal + t] != Status::Candidate)
+                        continue;
+                    const std::array<uint32_t, 3> p = cornersOf(chunk, t);
+                    const TriangleKey key = sortedKey(chunk.range, p[0], p[1], p[2]);
+                    *out++ = { Utils::hash64(key.ids.data(), sizeof(key.ids)), chunk.ordinal + t };
+                }
+            });
+            firstOf.resize(stats.triangles);
+            firstEqual(entries, firstOf, [&](const uint32_t a, const uint32_t b) { return keyOf(a).ids == keyOf(b).ids; });
+        }
+        OttThreadPool::shared().parallelFor(chunks.size(), [&](const size_t c)
+        {
+            Chunk& chunk = chunks[c];
+            for (uint32_t ordinal = chunk.ordinal; ordinal < chunk.ordinal + chunk.count; ordinal++)
+            {
+                if (status[ordinal] == Status::Candidate && firstOf[ordinal] != ordinal)
+                {
+                    chunk.duplicate++;
+                    chunk.reversed += keyOf(firstOf[ordinal]).odd != keyOf(ordinal).odd;
+                    status[ordinal] = Status::Removed;
+                }
+                chunk.kept += status[ordinal] != Status::Removed;
+            }
+        });
+        for (const Chunk& chunk : chunks)
+        {
+            stats.collapsedTriangles += chunk.collapsed;
+            stats.zeroAreaTriangles  += chunk.zeroArea;
+            stats.duplicateTriangles += chunk.duplicate;
+            stats.reversedDuplicates += chunk.reversed;
+        }
+
+        size_t output = 0;
+        std::vector<size_t> rangeStart(ranges.size() + 1, 0);
+        for (size_t r = 0, c = 0; r < ranges.size(); r++)
+        {
+            rangeStart[r] = output;
+            for (; c < chunks.size() && chunks[c].range == r; c++)
+            {
+                chunks[c].output = output;
+                output += 3 * chunks[c].kept;
+            }
+        }
+        rangeStart[ranges.size()] = output;
+
+        std::vector<uint32_t> cleaned(output);
+        std::vector<std::atomic<uint8_t>> referenced(options.unreferenced ? vertices.size() : 0);
+        OttThreadPool::shared().parallelFor(chunks.size(), [&](const size_t c)
+        {
+            const Chunk& chunk = chunks[c];
+            const Range& range = ranges[chunk.range];
+            uint32_t* out = cleaned.data() + chunk.output;
+            for (uint32_t t = 0; t < chunk.count; t++)
+            {
+                if (status[chunk.ordinal + t] == Status::Removed)
+                    continue;
+                const uint32_t* corner = indices.data() + range.startIndex + 3 * size_t(chunk.first + t);
+                for (int k = 0; k < 3; k++)
+                {
+                    *out++ = corner[k];
+                    if (!referenced.empty())
+                        referenced[range.startVertex + corner[k]].store(1, std::memory_order_relaxed);
+                }
+            }
+        });
+        indices = std::move(cleaned);
+
+        for (size_t r = 0; r < ranges.size(); r++)
+        {
+            ranges[r].startIndex = static_cast<uint32_t>(rangeStart[r]);
+            ranges[r].indexCount = static_cast<uint32_t>(rangeStart[r + 1] - rangeStart[r]);
+        }
+
+        if (options.unreferenced)
+        {
+            // Vertices move down past the dropped ones; index values are relative to their range's start.
+            std::vector<uint32_t> moved(vertices.size() + 1, 0);
+            for (size_t v = 0; v < vertices.size(); v++)
+                moved[v + 1] = moved[v] + referenced[v].load(std::memory_order_relaxed);
+            stats.unreferencedVertices = vertices.size() - moved.back();
+
+            std::vector<OttModel::Vertex> kept(moved.back());
+            forEachBlock(vertices.size(), [&](const size_t first, const size_t last)
+            {
+                for (size_t v = first; v < last; v++)
+                {
+                    if (moved[v + 1] != moved[v])
+                        kept[moved[v]] = vertices[v];
+                }
+            });
+            vertices = std::move(kept);
+
+            OttThreadPool::shared().parallelFor(chunks.size(), [&](const size_t c)
+            {
+                const uint32_t startVertex = ranges[chunks[c].range].startVertex;
+                for (uint32_t& index : std::span(indices).subspan(chunks[c].output, 3 * chunks[c].kept))
+                    index = moved[startVertex + index] - moved[startVertex];
+            });
+            for (Range& range : ranges)
+                range.startVertex = moved[range.startVertex];
+        }
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+        return stats;
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttCleanup::CleanupStats OttCleanup::cleanup(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                                             const CleanupOptions& options)
+{
+    std::vector<Range> ranges { { .indexCount = static_cast<uint32_t>(indices.size()) } };
+    return cleanRanges(vertices, indices, ranges, options);
+}
+
+//----------------------------------------------------------------------------
+OttCleanup::CleanupStats OttCleanup::cleanup(OttModel::MeshData& mesh, const CleanupOptions& options)
+{
+    // Objects sharing a startIndex are instances of one range.
+    std::unordered_map<uint32_t, uint32_t> rangeOf;
+    std::vector<Range> ranges;
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        if (rangeOf.try_emplace(object.startIndex, static_cast<uint32_t>(ranges.size())).second)
+            ranges.push_back({ .startIndex = object.startIndex, .indexCount = object.indexCount, .startVertex = object.startVertex });
+    }
+
+    const CleanupStats stats = cleanRanges(mesh.vertices, mesh.indices, ranges, options);
+    for (OttModel::modelObject& object : mesh.objects)
+    {
+        const Range& range = ranges[rangeOf[object.startIndex]];
+        object.startIndex  = range.startIndex;
+        object.indexCount  = range.indexCount;
+        object.startVertex = range.startVertex;
+    }
+    return stats;
+}
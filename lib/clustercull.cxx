@@ -0,0 +1,311 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "clustercull.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.h"
+#include "utils.hxx"
+
+namespace
+{
+    constexpr uint32_t     GROUP_SIZE      = 64;      // local_size_x of cluster_cull.comp.
+    constexpr uint32_t     MAX_GROUPS_X    = 65535;   // Larger dispatches wrap into y.
+    constexpr VkDeviceSize MIN_BUFFER_SIZE = 16;
+
+    // Push constant block and view buffer, laid out like their counterparts in the shader.
+    struct CullData { VkDeviceAddress view, clusters, batches, instances, counts, commands; uint32_t count; };
+    struct ViewData { std::array<glm::vec4, 6> planes; glm::vec4 eye; };
+
+    static_assert(sizeof(OttClusterCuller::Cluster) == 48, "cluster_cull.comp reads 48 byte clusters");
+    static_assert(sizeof(OttClusterCuller::Batch) == 16, "cluster_cull.comp reads 16 byte batches");
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Loads cluster_cull.comp.spv from shader_dir and builds its pipeline, with a single
+ *  push constant range and no descriptors, and the per frame view buffers. **/
+OttClusterCuller::OttClusterCuller(const Context& context, const std::filesystem::path& shader_dir)
+    : context(context)
+{
+    const VkPushConstantRange pushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof(CullData),
+    };
+    const VkPipelineLayoutCreateInfo layoutInfo {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create the cluster culling pipeline layout!");
+
+    const std::vector<char> code = Utils::readFile((shader_dir / "cluster_cull.comp.spv").string());
+    const VkShaderModuleCreateInfo moduleInfo {
+        .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = code.size(),
+        .pCode    = reinterpret_cast<const uint32_t*>(code.data()),
+    };
+    VkShaderModule module;
+    if (vkCreateShaderModule(context.device, &moduleInfo, nullptr, &module) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create the cluster culling shader module!");
+
+    const VkComputePipelineCreateInfo pipelineInfo {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = {
+            .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage  = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = module,
+            .pName  = "main",
+        },
+        .layout = pipelineLayout,
+    };
+    const VkResult result = vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(context.device, module, nullptr);
+    if (result != VK_SUCCESS)
+    {
+        log_t<error>("vkCreateComputePipelines returned {} for cluster_cull", static_cast<int>(result));
+        throw std::runtime_error("Failed to create the cluster culling pipeline!");
+    }
+
+    for (FrameBuffers& frame : frames)
+    {
+        frame.view = createBuffer(sizeof(ViewData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+}
+
+//----------------------------------------------------------------------------
+/** Expects no recorded frame to be pending. **/
+OttClusterCuller::~OttClusterCuller()
+{
+    for (FrameBuffers& frame : frames)
+    {
+        for (Buffer* buffer : { &frame.view, &frame.counts, &frame.commands })
+            destroyBuffer(*buffer);
+    }
+    destroyBuffer(clusterBuffer);
+    destroyBuffer(batchBuffer);
+    vkDestroyPipeline(context.device, pipeline, nullptr);
+    vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+}
+
+//----------------------------------------------------------------------------
+/** Clusters and batches live in host visible memory, rewritten only when the batches
+ *  change. The commands and counts are written by the GPU only, so they stay device
+ *  local, one set per frame in flight. **/
+void OttClusterCuller::setClusters(const std::span<const Cluster> clusters, const std::span<const Batch> batches,
+                                   const std::function<void(std::function<void()>)>& retire)
+{
+    std::vector<Buffer> old { clusterBuffer, batchBuffer };
+    for (FrameBuffers& frame : frames)
+    {
+        old.insert(old.end(), { frame.counts, frame.commands });
+        frame.counts = frame.commands = {};
+    }
+    clusterBuffer = batchBuffer = {};
+    retire([device = context.device, old]()
+    {
+        for (const Buffer& buffer : old)
+        {
+            if (buffer.buffer != VK_NULL_HANDLE) { vkDestroyBuffer (device, buffer.buffer, nullptr); }
+            if (buffer.memory != VK_NULL_HANDLE) { vkFreeMemory    (device, buffer.memory, nullptr); }
+        }
+    });
+
+    clusterTotal = static_cast<uint32_t>(clusters.size());
+    batchList.assign(batches.begin(), batches.end());
+    batchClusters.assign(batches.size(), 0);
+    for (const Cluster& cluster : clusters)
+        batchClusters[cluster.batch]++;
+    if (clusterTotal == 0)
+        return;
+
+    constexpr VkBufferUsageFlags    storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    constexpr VkMemoryPropertyFlags host    = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    clusterBuffer = createBuffer(clusters.size_bytes(), storage, host);
+    batchBuffer   = createBuffer(batches.size_bytes(), storage, host);
+    std::memcpy(clusterBuffer.mapped, clusters.data(), clusters.size_bytes());
+    std::memcpy(batchBuffer.mapped, batches.data(), batches.size_bytes());
+    for (FrameBuffers& frame : frames)
+    {
+        frame.counts   = createBuffer(batches.size() * sizeof(uint32_t),
+                                      storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.commands = createBuffer(clusters.size() * COMMAND_STRIDE, storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+}
+
+//----------------------------------------------------------------------------
+void OttClusterCuller::record(VkCommandBuffer command_buffer, const uint32_t frame, const glm::mat4& view_projection,
+                              const glm::vec3& eye, const VkDeviceAddress instances)
+{
+    if (clusterTotal == 0)
+        return;
+    FrameBuffers& buffers = frames[frame % FRAMES];
+    const ViewData view { .planes = frustumPlanes(view_projection), .eye = glm::vec4(eye, 1.0f) };
+    std::memcpy(buffers.view.mapped, &view, sizeof(view));
+
+    vkCmdFillBuffer(command_buffer, buffers.counts.buffer, 0, VK_WHOLE_SIZE, 0);
+    const VkMemoryBarrier cleared {
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &cleared, 0, nullptr, 0, nullptr);
+
+    const CullData push {
+        .view      = buffers.view.address,
+        .clusters  = clusterBuffer.address,
+        .batches   = batchBuffer.address,
+        .instances = instances,
+        .counts    = buffers.counts.address,
+        .commands  = buffers.commands.address,
+        .count     = clusterTotal,
+    };
+    const uint32_t groups  = (clusterTotal + GROUP_SIZE - 1) / GROUP_SIZE;
+    const uint32_t groupsX = std::min(groups, MAX_GROUPS_X);
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdPushConstants(command_buffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdDispatch(command_buffer, groupsX, (groups + groupsX - 1) / groupsX, 1);
+
+    const VkMemoryBarrier culled {
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0, 1, &culled, 0, nullptr, 0, nullptr);
+}
+
+//----------------------------------------------------------------------------
+void OttClusterCuller::drawBatch(VkCommandBuffer command_buffer, const uint32_t frame, const uint32_t batch) const
+{
+    const FrameBuffers& buffers = frames[frame % FRAMES];
+    vkCmdDrawIndexedIndirectCount(command_buffer, buffers.commands.buffer, batchList[batch].firstCommand * COMMAND_STRIDE,
+                                  buffers.counts.buffer, batch * sizeof(uint32_t), batchClusters[batch],
+                                  static_cast<uint32_t>(COMMAND_STRIDE));
+}
+
+//----------------------------------------------------------------------------
+/** Gribb and Hartmann: the planes are sums and differences of the matrix rows, for a
+ *  depth range of 0 to 1. Normalized, so distances compare against sphere radii. **/
+std::array<glm::vec4, 6> OttClusterCuller::frustumPlanes(const glm::mat4& view_projection)
+{
+    auto row = [&view_projection](const int r)
+    {
+        return glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r], view_projection[3][r]);
+    };
+    std::array<glm::vec4, 6> planes {
+        row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(2), row(3) - row(2),
+    };
+    for (glm::vec4& plane : planes)
+    {
+        const float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f)
+            plane /= length;
+    }
+    return planes;
+}
+
+//----------------------------------------------------------------------------
+/** A cluster is hidden when its sphere lies wholly outside one plane, or when every face
+ *  in its cone is turned away from every point of the sphere: the angle between the cone
+ *  axis and the direction from the eye leaves more than the cone's half angle to 90
+ *  degrees, with the radius as margin. **/
+bool OttClusterCuller::isVisible(const Cluster& cluster, const glm::mat4& transform, const std::array<glm::vec4, 6>& planes,
+                                 const glm::vec3& eye)
+{
+    const glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(cluster.sphere), 1.0f));
+    const glm::vec3 x(transform[0]), y(transform[1]), z(transform[2]);
+    const float radius = cluster.sphere.w * std::max({ glm::length(x), glm::length(y), glm::length(z) });
+    for (const glm::vec4& plane : planes)
+    {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+            return false;
+    }
+
+    const bool mirrored = glm::dot(glm::cross(x, y), z) < 0.0f;
+    if (glm::vec3(cluster.cone) == glm::vec3(0.0f) || mirrored)
+        return true;
+    const glm::vec3 axis     = glm::normalize(glm::mat3(transform) * glm::vec3(cluster.cone));
+    const glm::vec3 toCenter = center - eye;
+    return glm::dot(toCenter, axis) < cluster.cone.w * glm::length(toCenter) + radius;
+}
+
+//----------------------------------------------------------------------------
+OttClusterCuller::Buffer OttClusterCuller::createBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage,
+                                                        const VkMemoryPropertyFlags properties) const
+{
+    Buffer buffer { .size = std::max(size, MIN_BUFFER_SIZE) };
+    const VkBufferCreateInfo bufferInfo {
+        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size        = buffer.size,
+        .usage       = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    if (vkCreateBuffer(context.device, &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create a cluster culling buffer!");
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(context.device, buffer.buffer, &requirements);
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(context.physicalDevice, &memoryProperties);
+    uint32_t memoryType = UINT32_MAX;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && memoryType == UINT32_MAX; i++)
+    {
+        if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            memoryType = i;
+    }
+    if (memoryType == UINT32_MAX)
+        throw std::runtime_error("No memory type for a cluster culling buffer!");
+
+    const VkMemoryAllocateFlagsInfo flagsInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    };
+    const VkMemoryAllocateInfo allocInfo {
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = &flagsInfo,
+        .allocationSize  = requirements.size,
+        .memoryTypeIndex = memoryType,
+    };
+    if (vkAllocateMemory(context.device, &allocInfo, nullptr, &buffer.memory) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate cluster culling memory!");
+    vkBindBufferMemory(context.device, buffer.buffer, buffer.memory, 0);
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        vkMapMemory(context.device, buffer.memory, 0, VK_WHOLE_SIZE, 0, &buffer.mapped);
+
+    const VkBufferDeviceAddressInfo addressInfo {
+        .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = buffer.buffer,
+    };
+    buffer.address = vkGetBufferDeviceAddress(context.device, &addressInfo);
+    return buffer;
+}
+
+//----------------------------------------------------------------------------
+void OttClusterCuller::destroyBuffer(Buffer& buffer) const
+{
+    if (buffer.buffer != VK_NULL_HANDLE) { vkDestroyBuffer (context.device, buffer.buffer, nullptr); }
+    if (buffer.memory != VK_NULL_HANDLE) { vkFreeMemory    (context.device, buffer.memory, nullptr); }
+    buffer = {};
+}
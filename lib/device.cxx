@@ -176,8 +176,14 @@ void OttDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemo
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
+    // Buffers read through a device address need their memory allocated for it.
+    const VkMemoryAllocateFlagsInfo allocFlags {
+                               .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+                               .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    };
     const VkMemoryAllocateInfo allocInfo {
                                .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                               .pNext           = (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) ? &allocFlags : nullptr,
                                .allocationSize  = memRequirements.size,
                                .memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, propertiesFlags),
     };
@@ -394,8 +400,15 @@ void OttDevice::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // Optional: GPU meshlet culling draws through indirect commands counted on the GPU.
+    VkPhysicalDeviceVulkan12Features supported12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    VkPhysicalDeviceFeatures2 supported { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &supported12 };
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+    indirectCount = supported.features.multiDrawIndirect && supported.features.drawIndirectFirstInstance && supported12.drawIndirectCount;
+
     VkPhysicalDeviceVulkan12Features physicalDeviceVulkan12Features {
                                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                                .drawIndirectCount                             = indirectCount,
                                 .shaderSampledImageArrayNonUniformIndexing     = VK_TRUE,
                                 .descriptorBindingUniformBufferUpdateAfterBind = VK_TRUE,
                                 .descriptorBindingSampledImageUpdateAfterBind  = VK_TRUE,
@@ -409,9 +422,12 @@ void OttDevice::createLogicalDevice()
                                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
                                 .pNext = &physicalDeviceVulkan12Features,
                                 .features = {
-                                                .sampleRateShading = VK_TRUE,
-                                                .fillModeNonSolid  = VK_TRUE,
-                                                .samplerAnisotropy = VK_TRUE,
+                                                .sampleRateShading         = VK_TRUE,
+                                                .multiDrawIndirect         = indirectCount,
+                                                .drawIndirectFirstInstance = indirectCount,
+                                                .fillModeNonSolid          = VK_TRUE,
+                                                .samplerAnisotropy         = VK_TRUE,
+                                                .shaderInt64               = VK_TRUE,
                                 }
     };
 
@@ -0,0 +1,120 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "edges.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "threadpool.h"
+#include "topology.h"
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = 1 << 16;
+
+    //----------------------------------------------------------------------------
+    /** Calls fn(block, first, last) for every block of count items in parallel. **/
+    template<typename F>
+    void forBlocks(const size_t count, F&& fn)
+    {
+        OttThreadPool::shared().parallelFor((count + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](const size_t block)
+        {
+            fn(block, block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE));
+        });
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Walks the sides of the OttTopology adjacency, each edge drawn by its lowest side. An
+ *  edge with two faces is a crease when the angle between their normals exceeds the
+ *  threshold; with one face it is a boundary, with more it is non-manifold. Degenerate
+ *  triangles have no normal and take no part. **/
+std::vector<uint32_t> OttEdges::extractCreaseEdges(const std::span<const OttModel::Vertex> vertices,
+                                                   const std::span<const uint32_t> indices, const CreaseOptions& options)
+{
+    const size_t count = indices.size() / 3 * 3;
+    if (count == 0)
+        return {};
+
+    const OttTopology::Adjacency adjacency = OttTopology::build(vertices, indices.first(count));
+    const std::vector<uint32_t>& links = adjacency.links;
+
+    const size_t triangles = count / 3;
+    std::vector<glm::vec3> normals(triangles);
+    forBlocks(triangles, [&](size_t, const size_t first, const size_t last)
+    {
+        for (size_t t = first; t < last; t++)
+        {
+            const glm::vec3& a = vertices[indices[3 * t + 0]].pos;
+            const glm::vec3 n = glm::cross(vertices[indices[3 * t + 1]].pos - a, vertices[indices[3 * t + 2]].pos - a);
+            normals[t] = links[3 * t] == OttTopology::NONE ? glm::vec3(0.0f) : n / glm::length(n);
+        }
+    });
+
+    const float minimumCos = std::cos(glm::radians(options.angleDegrees));
+    auto sameSide = [&indices](const uint32_t a, const uint32_t b)
+    {
+        return std::minmax(indices[a], indices[OttTopology::nextCorner(a)]) == std::minmax(indices[b], indices[OttTopology::nextCorner(b)]);
+    };
+    auto drawn = [&](const uint32_t side)
+    {
+        const uint32_t other = links[side];
+        if (other == OttTopology::NONE)
+            return false;
+        if (other == side)
+            return options.boundaries;
+        if (links[other] != side)
+        {
+            for (uint32_t next = other; next != side; next = links[next])
+            {
+                if (next < side)
+                    return false;
+            }
+            return options.boundaries;
+        }
+        if (other < side)
+            return false;
+        if (glm::dot(normals[side / 3], normals[other / 3]) < minimumCos)
+            return true;
+        return !options.suppressSeams && !sameSide(side, other);
+    };
+
+    const size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<size_t> firsts(blocks + 1, 0);
+    forBlocks(count, [&](const size_t block, const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+            firsts[block + 1] += drawn(static_cast<uint32_t>(i));
+    });
+    for (size_t block = 0; block < blocks; block++)
+        firsts[block + 1] += firsts[block];
+
+    std::vector<uint32_t> edges(2 * firsts[blocks]);
+    forBlocks(count, [&](const size_t block, const size_t first, const size_t last)
+    {
+        uint32_t* out = edges.data() + 2 * firsts[block];
+        for (size_t i = first; i < last; i++)
+        {
+            if (!drawn(static_cast<uint32_t>(i)))
+                continue;
+            *out++ = indices[i];
+            *out++ = indices[OttTopology::nextCorner(static_cast<uint32_t>(i))];
+        }
+    });
+    return edges;
+}
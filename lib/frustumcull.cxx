@@ -0,0 +1,157 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "frustumcull.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define OTT_X86_SIMD 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #define OTT_TARGET_AVX2
+    #else
+        #define OTT_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+namespace
+{
+    struct Columns
+    {
+        const float* centerX;
+        const float* centerY;
+        const float* centerZ;
+        const float* extentX;
+        const float* extentY;
+        const float* extentZ;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Signed distance of the box corner furthest along the plane normal. Both kernels
+     *  add the terms in this order, so they agree bit for bit. **/
+    float furthestDistance(const glm::vec4& plane, const Columns& boxes, const size_t i)
+    {
+        const float center = plane.x * boxes.centerX[i] + plane.y * boxes.centerY[i] + plane.z * boxes.centerZ[i] + plane.w;
+        const float extent = std::abs(plane.x) * boxes.extentX[i] + std::abs(plane.y) * boxes.extentY[i]
+                           + std::abs(plane.z) * boxes.extentZ[i];
+        return center + extent;
+    }
+
+    void cullScalar(const Columns& boxes, const size_t blocks, const std::array<glm::vec4, 6>& planes, uint8_t* masks)
+    {
+        for (size_t b = 0; b < blocks; b++)
+        {
+            uint8_t mask = 0;
+            for (size_t lane = 0; lane < OttFrustumCuller::BLOCK; lane++)
+            {
+                const size_t i = b * OttFrustumCuller::BLOCK + lane;
+                // NaN distances, from the -inf extents of empty boxes, fail the test too.
+                const bool inside = std::ranges::all_of(planes, [&](const glm::vec4& plane) { return furthestDistance(plane, boxes, i) >= 0.0f; });
+                mask |= static_cast<uint8_t>(inside << lane);
+            }
+            masks[b] = mask;
+        }
+    }
+
+#ifdef OTT_X86_SIMD
+    OTT_TARGET_AVX2 void cullAvx2(const Columns& boxes, const size_t blocks, const std::array<glm::vec4, 6>& planes, uint8_t* masks)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        for (size_t b = 0; b < blocks; b++)
+        {
+            const size_t i = b * OttFrustumCuller::BLOCK;
+            const __m256 cx = _mm256_loadu_ps(boxes.centerX + i), cy = _mm256_loadu_ps(boxes.centerY + i);
+            const __m256 cz = _mm256_loadu_ps(boxes.centerZ + i), ex = _mm256_loadu_ps(boxes.extentX + i);
+            const __m256 ey = _mm256_loadu_ps(boxes.extentY + i), ez = _mm256_loadu_ps(boxes.extentZ + i);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const glm::vec4& plane : planes)
+            {
+                const __m256 nx = _mm256_set1_ps(plane.x), ny = _mm256_set1_ps(plane.y), nz = _mm256_set1_ps(plane.z);
+                const __m256 ax = _mm256_set1_ps(std::abs(plane.x)), ay = _mm256_set1_ps(std::abs(plane.y));
+                const __m256 az = _mm256_set1_ps(std::abs(plane.z));
+                const __m256 center = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)),
+                                                                  _mm256_mul_ps(nz, cz)), _mm256_set1_ps(plane.w));
+                const __m256 extent = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ex), _mm256_mul_ps(ay, ey)), _mm256_mul_ps(az, ez));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(center, extent), zero, _CMP_GE_OQ));
+            }
+            masks[b] = static_cast<uint8_t>(_mm256_movemask_ps(inside));
+        }
+    }
+#endif
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Padding and empty boxes get -inf extents, which put them behind every plane. **/
+void OttFrustumCuller::setInstances(const std::span<const Instance> instances)
+{
+    const size_t padded = (instances.size() + BLOCK - 1) / BLOCK * BLOCK;
+    for (std::vector<float>* column : { &centerX, &centerY, &centerZ })
+        column->assign(padded, 0.0f);
+    for (std::vector<float>* column : { &extentX, &extentY, &extentZ })
+        column->assign(padded, -std::numeric_limits<float>::infinity());
+    batchOf.resize(instances.size());
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        const Instance& instance = instances[i];
+        batchOf[i] = instance.batch;
+        if (instance.low.x > instance.high.x)
+            continue;
+        glm::vec3 center, extent;
+        OttModel::transformBox(instance.transform, instance.low, instance.high, center, extent);
+        centerX[i] = center.x;
+        centerY[i] = center.y;
+        centerZ[i] = center.z;
+        extentX[i] = extent.x;
+        extentY[i] = extent.y;
+        extentZ[i] = extent.z;
+    }
+    masks.assign(padded / BLOCK, 0);
+    runs.clear();
+    visible = 0;
+}
+
+//----------------------------------------------------------------------------
+std::span<const OttFrustumCuller::Run> OttFrustumCuller::cull(const std::array<glm::vec4, 6>& planes, OttModel::SimdPath path)
+{
+    const Columns boxes { centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data() };
+    path = std::min(path, OttModel::simdPath());
+#ifdef OTT_X86_SIMD
+    if (path == OttModel::SimdPath::Avx2)
+        cullAvx2(boxes, masks.size(), planes, masks.data());
+    else
+#endif
+        cullScalar(boxes, masks.size(), planes, masks.data());
+
+    runs.clear();
+    visible = 0;
+    for (size_t b = 0; b < masks.size(); b++)
+    {
+        for (uint32_t mask = masks[b]; mask != 0; mask &= mask - 1)
+        {
+            const auto i = static_cast<uint32_t>(b * BLOCK + std::countr_zero(mask));
+            if (!runs.empty() && runs.back().batch == batchOf[i] && runs.back().firstInstance + runs.back().instanceCount == i)
+                runs.back().instanceCount++;
+            else
+                runs.push_back({ .batch = batchOf[i], .firstInstance = i, .instanceCount = 1 });
+            visible++;
+        }
+    }
+    return runs;
+}
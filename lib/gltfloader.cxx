@@ -0,0 +1,1072 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gltfloader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+#include "mappedfile.h"
+
+namespace
+{
+    //----------------------------------------------------------------------------
+    /** Just enough JSON for glTF documents: a DOM of numbers, strings, arrays and objects.
+     *  Lookups on missing keys or out of range elements return a shared null value, so
+     *  optional glTF properties can be read without checking every level. **/
+    struct JsonValue
+    {
+        enum class Type : uint8_t { Null, Bool, Number, String, Array, Object };
+
+        Type                                           type    = Type::Null;
+        bool                                           boolean = false;
+        double                                         number  = 0.0;
+        std::string                                    string;
+        std::vector<JsonValue>                         array;
+        std::vector<std::pair<std::string, JsonValue>> members;
+
+        [[nodiscard]] bool isNull()   const { return type == Type::Null; }
+        [[nodiscard]] bool isNumber() const { return type == Type::Number; }
+        [[nodiscard]] bool isString() const { return type == Type::String; }
+        [[nodiscard]] size_t size()   const { return array.size(); }
+
+        [[nodiscard]] const JsonValue& operator[](std::string_view key) const
+        {
+            for (const auto& [name, value] : members)
+                if (name == key)
+                    return value;
+            return null();
+        }
+
+        [[nodiscard]] const JsonValue& operator[](const size_t index) const
+        {
+            return index < array.size() ? array[index] : null();
+        }
+
+        [[nodiscard]] double asNumber(const double fallback = 0.0) const
+        {
+            return isNumber() ? number : fallback;
+        }
+
+        // glTF indices and counts; anything that isn't a non-negative integer becomes fallback.
+        [[nodiscard]] int64_t asIndex(const int64_t fallback = -1) const
+        {
+            if (!isNumber() || number < 0.0 || number != std::floor(number) || number > 9.0e15)
+                return fallback;
+            return static_cast<int64_t>(number);
+        }
+
+        static const JsonValue& null()
+        {
+            static const JsonValue value;
+            return value;
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string_view text) : first(text.data()), cursor(text.data()), end(text.data() + text.size()) {}
+
+        bool parse(JsonValue& root, std::string& error)
+        {
+            if (!parseValue(root, 0) || (skipBlanks(), cursor != end))
+            {
+                error = fmt::format("Invalid JSON near byte {}", static_cast<size_t>(cursor - first));
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr int MAX_DEPTH = 128;
+
+        const char* first;
+        const char* cursor;
+        const char* end;
+
+        void skipBlanks()
+        {
+            while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r'))
+                cursor++;
+        }
+
+        bool consume(const std::string_view literal)
+        {
+            if (static_cast<size_t>(end - cursor) < literal.size() || std::string_view(cursor, literal.size()) != literal)
+                return false;
+            cursor += literal.size();
+            return true;
+        }
+
+        bool parseValue(JsonValue& value, const int depth)
+        {
+            skipBlanks();
+            if (cursor == end || depth > MAX_DEPTH)
+                return false;
+
+            switch (*cursor)
+            {
+                case '{': return parseObject(value, depth);
+                case '[': return parseArray(value, depth);
+                case '"': value.type = JsonValue::Type::String; return parseString(value.string);
+                case 't': value.type = JsonValue::Type::Bool; value.boolean = true;  return consume("true");
+                case 'f': value.type = JsonValue::Type::Bool; value.boolean = false; return consume("false");
+                case 'n': value.type = JsonValue::Type::Null; return consume("null");
+                default:  return parseNumber(value);
+            }
+        }
+
+        bool parseNumber(JsonValue& value)
+        {
+            const auto [next, status] = std::from_chars(cursor, end, value.number);
+            if (status != std::errc() || next == cursor)
+                return false;
+            value.type = JsonValue::Type::Number;
+            cursor     = next;
+            return true;
+        }
+
+        bool parseObject(JsonValue& value, const int depth)
+        {
+            value.type = JsonValue::Type::Object;
+            cursor++;
+            skipBlanks();
+            if (cursor < end && *cursor == '}')
+            {
+                cursor++;
+                return true;
+            }
+            while (true)
+            {
+                skipBlanks();
+                std::string key;
+                if (cursor == end || *cursor != '"' || !parseString(key))
+                    return false;
+                skipBlanks();
+                if (cursor == end || *cursor++ != ':')
+                    return false;
+                value.members.emplace_back(std::move(key), JsonValue{});
+                if (!parseValue(value.members.back().second, depth + 1))
+                    return false;
+                skipBlanks();
+                if (cursor == end)
+                    return false;
+                if (*cursor == '}')
+                {
+                    cursor++;
+                    return true;
+                }
+                if (*cursor++ != ',')
+                    return false;
+            }
+        }
+
+        bool parseArray(JsonValue& value, const int depth)
+        {
+            value.type = JsonValue::Type::Array;
+            cursor++;
+            skipBlanks();
+            if (cursor < end && *cursor == ']')
+            {
+                cursor++;
+                return true;
+            }
+            while (true)
+            {
+                if (!parseValue(value.array.emplace_back(), depth + 1))
+                    return false;
+                skipBlanks();
+                if (cursor == end)
+                    return false;
+                if (*cursor == ']')
+                {
+                    cursor++;
+                    return true;
+                }
+                if (*cursor++ != ',')
+                    return false;
+            }
+        }
+
+        static void appendUtf8(std::string& out, const uint32_t codepoint)
+        {
+            if (codepoint < 0x80)
+                out += static_cast<char>(codepoint);
+            else if (codepoint < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+            else if (codepoint < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+        }
+
+        bool parseHex4(uint32_t& codepoint)
+        {
+            if (end - cursor < 4)
+                return false;
+            const auto [next, status] = std::from_chars(cursor, cursor + 4, codepoint, 16);
+            if (status != std::errc() || next != cursor + 4)
+                return false;
+            cursor = next;
+            return true;
+        }
+
+        bool parseString(std::string& out)
+        {
+            cursor++;
+            while (cursor < end)
+            {
+                const char c = *cursor++;
+                if (c == '"')
+                    return true;
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+                if (cursor == end)
+                    return false;
+                switch (*cursor++)
+                {
+                    case '"':  out += '"';  break;
+                    case '\\': out += '\\'; break;
+                    case '/':  out += '/';  break;
+                    case 'b':  out += '\b'; break;
+                    case 'f':  out += '\f'; break;
+                    case 'n':  out += '\n'; break;
+                    case 'r':  out += '\r'; break;
+                    case 't':  out += '\t'; break;
+                    case 'u':
+                    {
+                        uint32_t codepoint;
+                        if (!parseHex4(codepoint))
+                            return false;
+                        // Surrogate pair: the low half follows as a second escape.
+                        if (codepoint >= 0xD800 && codepoint < 0xDC00)
+                        {
+                            uint32_t low;
+                            if (!consume("\\u") || !parseHex4(low) || low < 0xDC00 || low > 0xDFFF)
+                                return false;
+                            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, codepoint);
+                        break;
+                    }
+                    default: return false;
+                }
+            }
+            return false;
+        }
+    };
+
+    constexpr uint32_t GLB_MAGIC      = 0x46546C67; // "glTF"
+    constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+    constexpr uint32_t GLB_CHUNK_BIN  = 0x004E4942; // "BIN\0"
+
+    enum ComponentType : int64_t
+    {
+        BYTE           = 5120,
+        UNSIGNED_BYTE  = 5121,
+        SHORT          = 5122,
+        UNSIGNED_SHORT = 5123,
+        UNSIGNED_INT   = 5125,
+        FLOAT          = 5126,
+    };
+
+    enum PrimitiveMode : int64_t
+    {
+        POINTS         = 0,
+        LINES          = 1,
+        LINE_LOOP      = 2,
+        LINE_STRIP     = 3,
+        TRIANGLES      = 4,
+        TRIANGLE_STRIP = 5,
+        TRIANGLE_FAN   = 6,
+    };
+
+    //----------------------------------------------------------------------------
+    uint32_t readU32(const char* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    //----------------------------------------------------------------------------
+    size_t componentSize(const int64_t component_type)
+    {
+        switch (component_type)
+        {
+            case BYTE: case UNSIGNED_BYTE:   return 1;
+            case SHORT: case UNSIGNED_SHORT: return 2;
+            case UNSIGNED_INT: case FLOAT:   return 4;
+            default:                         return 0;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    size_t componentCount(const std::string_view type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2")   return 2;
+        if (type == "VEC3")   return 3;
+        if (type == "VEC4")   return 4;
+        return 0;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Reads one component and applies the normalization rules of the glTF spec. **/
+    float readComponent(const char* data, const int64_t component_type, const bool normalized)
+    {
+        switch (component_type)
+        {
+            case FLOAT:
+            {
+                float value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+            case UNSIGNED_BYTE:
+            {
+                const auto value = static_cast<uint8_t>(*data);
+                return normalized ? static_cast<float>(value) / 255.0f : static_cast<float>(value);
+            }
+            case BYTE:
+            {
+                const auto value = static_cast<int8_t>(*data);
+                return normalized ? std::max(static_cast<float>(value) / 127.0f, -1.0f) : static_cast<float>(value);
+            }
+            case UNSIGNED_SHORT:
+            {
+                uint16_t value;
+                std::memcpy(&value, data, sizeof(value));
+                return normalized ? static_cast<float>(value) / 65535.0f : static_cast<float>(value);
+            }
+            case SHORT:
+            {
+                int16_t value;
+                std::memcpy(&value, data, sizeof(value));
+                return normalized ? std::max(static_cast<float>(value) / 32767.0f, -1.0f) : static_cast<float>(value);
+            }
+            case UNSIGNED_INT:
+                return static_cast<float>(readU32(data));
+            default:
+                return 0.0f;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Accessor resolved to a pointer into a mapped buffer. A missing bufferView means all
+     *  zeros, which the spec allows; data is null then. **/
+    struct Accessor
+    {
+        const char* data          = nullptr;
+        size_t      stride        = 0;
+        size_t      count         = 0;
+        size_t      components    = 0;
+        int64_t     componentType = 0;
+        bool        normalized    = false;
+        int64_t     bufferView    = -1;
+        size_t      viewOffset    = 0;
+
+        [[nodiscard]] size_t elementSize() const { return components * componentSize(componentType); }
+        [[nodiscard]] bool   tightlyPacked() const { return stride == elementSize(); }
+
+        void read(const size_t index, float* out, const size_t wanted) const
+        {
+            const size_t available = std::min(components, wanted);
+            for (size_t c = 0; c < available; c++)
+                out[c] = data ? readComponent(data + index * stride + c * componentSize(componentType), componentType, normalized) : 0.0f;
+        }
+
+        [[nodiscard]] uint32_t readIndex(const size_t index) const
+        {
+            if (!data)
+                return 0;
+            const char* element = data + index * stride;
+            switch (componentType)
+            {
+                case UNSIGNED_BYTE:  return static_cast<uint8_t>(*element);
+                case UNSIGNED_SHORT: { uint16_t value; std::memcpy(&value, element, sizeof(value)); return value; }
+                default:             return readU32(element);
+            }
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Vertex and index ranges of one primitive in the output mesh. **/
+    struct PrimitiveRange
+    {
+        uint32_t startVertex;
+        uint32_t startIndex;
+        uint32_t indexCount;
+        uint32_t textureID;
+    };
+
+    //----------------------------------------------------------------------------
+    class GltfImporter
+    {
+    public:
+        GltfImporter(const std::filesystem::path& base_dir, OttModel::MeshData& mesh, OttGltf::ImportStats& stats)
+            : baseDir(base_dir), mesh(mesh), stats(stats) {}
+
+        bool import(std::string_view data);
+
+        std::string warnings;
+        std::string error;
+
+    private:
+        const std::filesystem::path& baseDir;
+        OttModel::MeshData&          mesh;
+        OttGltf::ImportStats&        stats;
+
+        JsonValue                      document;
+        std::vector<std::string_view>  buffers;
+        std::vector<OttMappedFile>     mappedBuffers;
+        std::vector<std::string>       decodedBuffers;
+        std::string_view               binaryChunk;
+
+        std::unordered_map<int64_t, std::vector<PrimitiveRange>> meshRanges;
+        std::unordered_map<int64_t, uint32_t>                    imageSlots;
+
+        void warn(const std::string& message) { warnings += message + "\n"; }
+
+        bool splitGlb(std::string_view data, std::string_view& json);
+        bool loadBuffers();
+        bool resolveAccessor(const JsonValue& index, Accessor& accessor);
+        bool loadMesh(int64_t mesh_index);
+        bool loadPrimitive(const JsonValue& primitive, PrimitiveRange& range);
+        bool loadVertices(const JsonValue& attributes, size_t& vertex_count);
+        bool loadIndices(const JsonValue& primitive, size_t vertex_count, size_t& index_count);
+        uint32_t materialTexture(const JsonValue& material);
+        bool instantiate();
+    };
+
+    //----------------------------------------------------------------------------
+    std::string percentDecode(const std::string_view uri)
+    {
+        std::string decoded;
+        decoded.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); i++)
+        {
+            unsigned value;
+            if (uri[i] == '%' && i + 2 < uri.size() &&
+                std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3)
+            {
+                decoded += static_cast<char>(value);
+                i += 2;
+            }
+            else
+                decoded += uri[i];
+        }
+        return decoded;
+    }
+
+    //----------------------------------------------------------------------------
+    bool decodeBase64(const std::string_view text, std::string& out)
+    {
+        auto sextet = [](const char c) -> int
+        {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        };
+
+        out.clear();
+        out.reserve(text.size() / 4 * 3);
+        uint32_t bits  = 0;
+        int      count = 0;
+        for (const char c : text)
+        {
+            if (c == '=')
+                break;
+            const int value = sextet(c);
+            if (value < 0)
+                return false;
+            bits = (bits << 6) | static_cast<uint32_t>(value);
+            if (++count == 4)
+            {
+                out += static_cast<char>((bits >> 16) & 0xFF);
+                out += static_cast<char>((bits >> 8) & 0xFF);
+                out += static_cast<char>(bits & 0xFF);
+                bits  = 0;
+                count = 0;
+            }
+        }
+        if (count == 2)
+            out += static_cast<char>((bits >> 4) & 0xFF);
+        else if (count == 3)
+        {
+            out += static_cast<char>((bits >> 10) & 0xFF);
+            out += static_cast<char>((bits >> 2) & 0xFF);
+        }
+        return count != 1;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Column-major node transform, from "matrix" or from translation * rotation * scale. **/
+    glm::mat4 nodeTransform(const JsonValue& node)
+    {
+        const JsonValue& matrix = node["matrix"];
+        if (matrix.size() == 16)
+        {
+            glm::mat4 result(1.0f);
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    result[column][row] = static_cast<float>(matrix[static_cast<size_t>(column * 4 + row)].asNumber());
+            return result;
+        }
+
+        const JsonValue& t = node["translation"];
+        const JsonValue& r = node["rotation"];
+        const JsonValue& s = node["scale"];
+        const float x = static_cast<float>(r[0].asNumber(0.0));
+        const float y = static_cast<float>(r[1].asNumber(0.0));
+        const float z = static_cast<float>(r[2].asNumber(0.0));
+        const float w = static_cast<float>(r[3].asNumber(1.0));
+        const glm::vec3 scale(static_cast<float>(s[0].asNumber(1.0)), static_cast<float>(s[1].asNumber(1.0)), static_cast<float>(s[2].asNumber(1.0)));
+
+        glm::mat4 result(1.0f);
+        result[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w),        2.0f * (x * z - y * w),        0.0f) * scale.x;
+        result[1] = glm::vec4(2.0f * (x * y - z * w),        1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w),        0.0f) * scale.y;
+        result[2] = glm::vec4(2.0f * (x * z + y * w),        2.0f * (y * z - x * w),        1.0f - 2.0f * (x * x + y * y), 0.0f) * scale.z;
+        result[3] = glm::vec4(static_cast<float>(t[0].asNumber()), static_cast<float>(t[1].asNumber()), static_cast<float>(t[2].asNumber()), 1.0f);
+        return result;
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+bool GltfImporter::splitGlb(std::string_view data, std::string_view& json)
+{
+    if (data.size() < 20 || readU32(data.data() + 4) != 2)
+    {
+        error = "Unsupported GLB container version";
+        return false;
+    }
+    const size_t length = std::min<size_t>(readU32(data.data() + 8), data.size());
+    size_t offset = 12;
+    while (offset + 8 <= length)
+    {
+        const size_t   chunkLength = readU32(data.data() + offset);
+        const uint32_t chunkType   = readU32(data.data() + offset + 4);
+        offset += 8;
+        if (chunkLength > length - offset)
+        {
+            error = "Truncated GLB chunk";
+            return false;
+        }
+        const std::string_view chunk = data.substr(offset, chunkLength);
+        if (chunkType == GLB_CHUNK_JSON && json.empty())
+            json = chunk;
+        else if (chunkType == GLB_CHUNK_BIN && binaryChunk.empty())
+            binaryChunk = chunk;
+        offset += (chunkLength + 3) & ~size_t(3);
+    }
+    if (json.empty())
+    {
+        error = "GLB file has no JSON chunk";
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Maps external buffers, decodes data URIs and binds the GLB BIN chunk to the buffer
+ *  without a URI. **/
+bool GltfImporter::loadBuffers()
+{
+    const JsonValue& list = document["buffers"];
+    buffers.resize(list.size());
+    mappedBuffers.resize(list.size());
+    decodedBuffers.resize(list.size());
+
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        const JsonValue& buffer = list[i];
+        const auto byteLength = static_cast<size_t>(buffer["byteLength"].asIndex(0));
+        const JsonValue& uri = buffer["uri"];
+
+        std::string_view contents;
+        if (!uri.isString())
+        {
+            if (i != 0 || binaryChunk.empty())
+            {
+                error = fmt::format("Buffer {} has no data", i);
+                return false;
+            }
+            contents = binaryChunk;
+        }
+        else if (uri.string.starts_with("data:"))
+        {
+            const size_t comma = uri.string.find(',');
+            if (comma == std::string::npos || uri.string.rfind(";base64", comma) == std::string::npos ||
+                !decodeBase64(std::string_view(uri.string).substr(comma + 1), decodedBuffers[i]))
+            {
+                error = fmt::format("Buffer {} has an unsupported data URI", i);
+                return false;
+            }
+            contents = decodedBuffers[i];
+        }
+        else
+        {
+            const auto path = baseDir / std::filesystem::u8path(percentDecode(uri.string));
+            if (!mappedBuffers[i].open(path))
+            {
+                error = fmt::format("Cannot open buffer {}", path.string());
+                return false;
+            }
+            contents = mappedBuffers[i].view();
+        }
+
+        if (contents.size() < byteLength)
+        {
+            error = fmt::format("Buffer {} is shorter than its byteLength", i);
+            return false;
+        }
+        buffers[i] = contents.substr(0, byteLength);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Resolves an accessor and checks that every element lies inside its buffer view. **/
+bool GltfImporter::resolveAccessor(const JsonValue& index, Accessor& accessor)
+{
+    const JsonValue& json = document["accessors"][static_cast<size_t>(index.asIndex())];
+    if (json.isNull())
+    {
+        error = "Accessor index out of range";
+        return false;
+    }
+    if (!json["sparse"].isNull())
+        warn("Sparse accessors are not supported; using the base values");
+
+    accessor = {
+        .count         = static_cast<size_t>(json["count"].asIndex(0)),
+        .components    = componentCount(json["type"].string),
+        .componentType = json["componentType"].asIndex(0),
+        .normalized    = json["normalized"].boolean,
+        .bufferView    = json["bufferView"].asIndex(),
+    };
+    if (accessor.components == 0 || componentSize(accessor.componentType) == 0)
+    {
+        error = "Accessor has an unsupported type";
+        return false;
+    }
+    accessor.stride = accessor.elementSize();
+    if (accessor.bufferView < 0)
+        return true;
+
+    const JsonValue& view = document["bufferViews"][static_cast<size_t>(accessor.bufferView)];
+    const int64_t bufferIndex = view["buffer"].asIndex();
+    if (view.isNull() || bufferIndex < 0 || static_cast<size_t>(bufferIndex) >= buffers.size())
+    {
+        error = "Accessor references a missing buffer view";
+        return false;
+    }
+
+    const std::string_view buffer = buffers[static_cast<size_t>(bufferIndex)];
+    const auto viewStart  = static_cast<size_t>(view["byteOffset"].asIndex(0));
+    const auto viewLength = static_cast<size_t>(view["byteLength"].asIndex(0));
+    accessor.viewOffset   = static_cast<size_t>(json["byteOffset"].asIndex(0));
+    if (const int64_t stride = view["byteStride"].asIndex(0); stride > 0)
+        accessor.stride = static_cast<size_t>(stride);
+
+    const size_t span = accessor.count == 0 ? 0 : (accessor.count - 1) * accessor.stride + accessor.elementSize();
+    if (viewStart > buffer.size() || viewLength > buffer.size() - viewStart ||
+        accessor.viewOffset > viewLength || span > viewLength - accessor.viewOffset)
+    {
+        error = "Accessor reads past the end of its buffer view";
+        return false;
+    }
+    accessor.data = buffer.data() + viewStart + accessor.viewOffset;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Appends the vertices of a primitive. When POSITION, COLOR_0, TEXCOORD_0 and NORMAL are
+ *  float attributes interleaved in one view exactly like OttModel::Vertex, the whole range
+ *  is one memcpy; otherwise each attribute is gathered with its own stride. **/
+bool GltfImporter::loadVertices(const JsonValue& attributes, size_t& vertex_count)
+{
+    Accessor position, color, texCoord, normal;
+    const bool hasColor    = !attributes["COLOR_0"].isNull();
+    const bool hasTexCoord = !attributes["TEXCOORD_0"].isNull();
+    const bool hasNormal   = !attributes["NORMAL"].isNull();
+    if (attributes["POSITION"].isNull())
+    {
+        error = "Primitive has no POSITION attribute";
+        return false;
+    }
+    if (!resolveAccessor(attributes["POSITION"], position) ||
+        (hasColor    && !resolveAccessor(attributes["COLOR_0"],    color))    ||
+        (hasTexCoord && !resolveAccessor(attributes["TEXCOORD_0"], texCoord)) ||
+        (hasNormal   && !resolveAccessor(attributes["NORMAL"],     normal)))
+        return false;
+
+    vertex_count = position.count;
+    for (const Accessor* attribute : { &color, &texCoord, &normal })
+    {
+        if (attribute->components != 0 && attribute->count != vertex_count)
+        {
+            error = "Primitive attributes have different counts";
+            return false;
+        }
+    }
+
+    const size_t first = mesh.vertices.size();
+    mesh.vertices.resize(first + vertex_count);
+    OttModel::Vertex* out = mesh.vertices.data() + first;
+
+    auto matches = [&position](const Accessor& attribute, const size_t components, const size_t offset)
+    {
+        return attribute.data && attribute.componentType == FLOAT && attribute.components == components &&
+               attribute.bufferView == position.bufferView && attribute.stride == sizeof(OttModel::Vertex) &&
+               attribute.viewOffset == position.viewOffset + offset;
+    };
+    if (position.data && position.componentType == FLOAT && position.components == 3 && position.stride == sizeof(OttModel::Vertex) &&
+        matches(color, 3, offsetof(OttModel::Vertex, color)) && matches(texCoord, 2, offsetof(OttModel::Vertex, texCoord)) &&
+        matches(normal, 3, offsetof(OttModel::Vertex, normal)))
+    {
+        std::memcpy(out, position.data, vertex_count * sizeof(OttModel::Vertex));
+        stats.blockCopies++;
+        return true;
+    }
+
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        OttModel::Vertex& vertex = out[i];
+        vertex.color = glm::vec3(1.0f);
+        position.read(i, &vertex.pos.x, 3);
+        if (hasColor)    color.read(i, &vertex.color.x, 3);
+        if (hasTexCoord) texCoord.read(i, &vertex.texCoord.x, 2);
+        if (hasNormal)   normal.read(i, &vertex.normal.x, 3);
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Appends the triangle list of a primitive, relative to its first vertex. Strips and fans
+ *  are unrolled into lists. **/
+bool GltfImporter::loadIndices(const JsonValue& primitive, const size_t vertex_count, size_t& index_count)
+{
+    const int64_t mode = primitive["mode"].asIndex(TRIANGLES);
+
+    std::vector<uint32_t> source;
+    const uint32_t* sourceIndices = nullptr;
+    size_t sourceCount = vertex_count;
+    Accessor indices;
+    if (!primitive["indices"].isNull())
+    {
+        if (!resolveAccessor(primitive["indices"], indices))
+            return false;
+        if (indices.components != 1 || (indices.componentType != UNSIGNED_BYTE &&
+            indices.componentType != UNSIGNED_SHORT && indices.componentType != UNSIGNED_INT))
+        {
+            error = "Index accessor must hold unsigned scalars";
+            return false;
+        }
+        sourceCount = indices.count;
+    }
+
+    const size_t first = mesh.indices.size();
+    if (mode == TRIANGLES && indices.data && indices.componentType == UNSIGNED_INT && indices.tightlyPacked())
+    {
+        mesh.indices.resize(first + sourceCount - sourceCount % 3);
+        std::memcpy(mesh.indices.data() + first, indices.data, (mesh.indices.size() - first) * sizeof(uint32_t));
+        stats.blockCopies++;
+    }
+    else
+    {
+        source.resize(sourceCount);
+        for (size_t i = 0; i < sourceCount; i++)
+            source[i] = primitive["indices"].isNull() ? static_cast<uint32_t>(i) : indices.readIndex(i);
+        sourceIndices = source.data();
+
+        if (mode == TRIANGLES)
+            mesh.indices.insert(mesh.indices.end(), sourceIndices, sourceIndices + sourceCount - sourceCount % 3);
+        else if (mode == TRIANGLE_STRIP)
+        {
+            for (size_t i = 2; i < sourceCount; i++)
+            {
+                // Every other triangle of a strip is flipped to keep the winding consistent.
+                const bool odd = (i % 2) != 0;
+                mesh.indices.insert(mesh.indices.end(), {
+                    sourceIndices[i - 2], sourceIndices[odd ? i : i - 1], sourceIndices[odd ? i - 1 : i] });
+            }
+        }
+        else
+        {
+            for (size_t i = 2; i < sourceCount; i++)
+                mesh.indices.insert(mesh.indices.end(), { sourceIndices[0], sourceIndices[i - 1], sourceIndices[i] });
+        }
+    }
+
+    index_count = mesh.indices.size() - first;
+    for (size_t i = first; i < mesh.indices.size(); i++)
+    {
+        if (mesh.indices[i] >= vertex_count)
+        {
+            error = "Index out of range of the primitive's vertices";
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Slot in mesh.materialPaths of the material's base color image, registered on first use.
+ *  Materials without a usable image get slot 0. **/
+uint32_t GltfImporter::materialTexture(const JsonValue& material)
+{
+    const int64_t textureIndex = material["pbrMetallicRoughness"]["baseColorTexture"]["index"].asIndex();
+    if (textureIndex < 0)
+        return 0;
+    const int64_t imageIndex = document["textures"][static_cast<size_t>(textureIndex)]["source"].asIndex();
+    if (imageIndex < 0)
+        return 0;
+    if (const auto found = imageSlots.find(imageIndex); found != imageSlots.end())
+        return found->second;
+
+    uint32_t slot = 0;
+    const JsonValue& uri = document["images"][static_cast<size_t>(imageIndex)]["uri"];
+    if (!uri.isString() || uri.string.starts_with("data:"))
+        warn(fmt::format("Image {} is embedded; only images referenced by file are loaded", imageIndex));
+    else
+    {
+        slot = static_cast<uint32_t>(mesh.materialPaths.size());
+        mesh.materialPaths.push_back((baseDir / std::filesystem::u8path(percentDecode(uri.string))).string());
+    }
+    imageSlots.emplace(imageIndex, slot);
+    return slot;
+}
+
+//----------------------------------------------------------------------------
+bool GltfImporter::loadPrimitive(const JsonValue& primitive, PrimitiveRange& range)
+{
+    range = {
+        .startVertex = static_cast<uint32_t>(mesh.vertices.size()),
+        .startIndex  = static_cast<uint32_t>(mesh.indices.size()),
+        .indexCount  = 0,
+        .textureID   = 0,
+    };
+
+    size_t vertexCount = 0;
+    size_t indexCount  = 0;
+    if (!loadVertices(primitive["attributes"], vertexCount) || !loadIndices(primitive, vertexCount, indexCount))
+        return false;
+
+    const int64_t material = primitive["material"].asIndex();
+    if (material >= 0)
+        range.textureID = materialTexture(document["materials"][static_cast<size_t>(material)]);
+    range.indexCount = static_cast<uint32_t>(indexCount);
+    stats.primitives++;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Loads the triangle primitives of a mesh the first time a node references it. **/
+bool GltfImporter::loadMesh(const int64_t mesh_index)
+{
+    if (meshRanges.contains(mesh_index))
+        return true;
+
+    const JsonValue& json = document["meshes"][static_cast<size_t>(mesh_index)];
+    if (json.isNull())
+    {
+        error = fmt::format("Node references missing mesh {}", mesh_index);
+        return false;
+    }
+
+    std::vector<PrimitiveRange>& ranges = meshRanges[mesh_index];
+    for (const JsonValue& primitive : json["primitives"].array)
+    {
+        const int64_t mode = primitive["mode"].asIndex(TRIANGLES);
+        if (mode != TRIANGLES && mode != TRIANGLE_STRIP && mode != TRIANGLE_FAN)
+        {
+            warn(fmt::format("Skipping point or line primitive of mesh {}", mesh_index));
+            continue;
+        }
+        if (!loadPrimitive(primitive, ranges.emplace_back()))
+            return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Walks the scene graph and adds one object per primitive of every mesh node, with the
+ *  accumulated world transform. **/
+bool GltfImporter::instantiate()
+{
+    const JsonValue& nodes = document["nodes"];
+    std::vector<int64_t> roots;
+    const JsonValue& scene = document["scenes"][static_cast<size_t>(document["scene"].asIndex(0))];
+    if (!scene.isNull())
+    {
+        for (const JsonValue& node : scene["nodes"].array)
+            roots.push_back(node.asIndex());
+    }
+    else
+    {
+        // No scene: every node that isn't somebody's child is a root.
+        std::vector<bool> isChild(nodes.size(), false);
+        for (const JsonValue& node : nodes.array)
+            for (const JsonValue& child : node["children"].array)
+                if (const int64_t index = child.asIndex(); index >= 0 && static_cast<size_t>(index) < nodes.size())
+                    isChild[static_cast<size_t>(index)] = true;
+        for (size_t i = 0; i < nodes.size(); i++)
+            if (!isChild[i])
+                roots.push_back(static_cast<int64_t>(i));
+    }
+
+    struct Visit
+    {
+        int64_t   node;
+        glm::mat4 parent;
+        size_t    depth;
+    };
+    std::vector<Visit> pending;
+    for (auto root = roots.rbegin(); root != roots.rend(); ++root)
+        pending.push_back({ .node = *root, .parent = glm::mat4(1.0f), .depth = 0 });
+
+    while (!pending.empty())
+    {
+        const Visit visit = pending.back();
+        pending.pop_back();
+        const JsonValue& node = nodes[static_cast<size_t>(visit.node)];
+        if (node.isNull() || visit.depth > nodes.size())
+        {
+            error = "Scene graph references a missing node or contains a cycle";
+            return false;
+        }
+
+        const glm::mat4 world = visit.parent * nodeTransform(node);
+        if (const int64_t meshIndex = node["mesh"].asIndex(); meshIndex >= 0)
+        {
+            if (!loadMesh(meshIndex))
+                return false;
+            for (const PrimitiveRange& range : meshRanges[meshIndex])
+            {
+                mesh.objects.push_back({
+                    .startIndex  = range.startIndex,
+                    .startVertex = range.startVertex,
+                    .startEdge   = 0,
+                    .indexCount  = range.indexCount,
+                    .edgeCount   = 0,
+                    .textureID   = range.textureID,
+                    .pushColorID = glm::vec3(0.0f),
+                    .transform   = world,
+                });
+                stats.instances++;
+            }
+        }
+
+        const JsonValue& children = node["children"];
+        for (size_t c = children.size(); c-- > 0;)
+            pending.push_back({ .node = children[c].asIndex(), .parent = world, .depth = visit.depth + 1 });
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool GltfImporter::import(std::string_view data)
+{
+    std::string_view json = data;
+    if (data.size() >= 4 && readU32(data.data()) == GLB_MAGIC)
+    {
+        json = {};
+        if (!splitGlb(data, json))
+            return false;
+    }
+
+    JsonParser parser(json);
+    if (!parser.parse(document, error))
+        return false;
+
+    const JsonValue& asset = document["asset"];
+    if (!asset["version"].isString() || !asset["version"].string.starts_with("2."))
+    {
+        error = "Only glTF 2.0 assets are supported";
+        return false;
+    }
+    if (!loadBuffers() || !instantiate())
+        return false;
+    if (mesh.objects.empty())
+        warn("The default scene contains no triangle meshes");
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttGltf::Parse(const std::string_view data, const std::filesystem::path& base_dir, OttModel::MeshData& mesh,
+                    std::string* warn, std::string* err, ImportStats* stats)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    ImportStats localStats;
+    ImportStats& counters = stats ? *stats : localStats;
+    counters = { .bytes = data.size() };
+
+    mesh = {};
+    GltfImporter importer(base_dir, mesh, counters);
+    const bool ok = importer.import(data);
+    if (warn)
+        *warn += importer.warnings;
+    if (!ok)
+    {
+        if (err)
+            *err += importer.error;
+        mesh = {};
+    }
+    counters.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+bool OttGltf::Load(const std::filesystem::path& path, OttModel::MeshData& mesh,
+                   std::string* warn, std::string* err, ImportStats* stats)
+{
+    const OttMappedFile file(path);
+    if (!file.isOpen())
+    {
+        if (err)
+            *err += fmt::format("Cannot open file {}", path.string());
+        return false;
+    }
+    return Parse(file.view(), path.parent_path(), mesh, warn, err, stats);
+}
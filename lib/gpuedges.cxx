@@ -0,0 +1,516 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gpuedges.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.h"
+#include "utils.hxx"
+
+namespace
+{
+    constexpr uint32_t     GROUP_SIZE         = 256;     // local_size_x of every kernel.
+    constexpr uint32_t     SCAN_TILE          = 4 * GROUP_SIZE;   // Values per workgroup of scan and scan_add.
+    constexpr uint32_t     MAX_GROUPS_X       = 65535;   // Larger dispatches wrap into y.
+    constexpr uint32_t     PUSH_CONSTANT_SIZE = 128;
+    constexpr VkDeviceSize MIN_BUFFER_SIZE    = 16;
+
+    constexpr uint32_t MODE_CREASE     = 1;
+    constexpr uint32_t MODE_BOUNDARIES = 2;
+    constexpr uint32_t MODE_SEAMS      = 4;
+
+    constexpr const char* KERNEL_NAMES[] = {
+        "edges_hash", "edges_weld", "edges_sides", "edges_mark", "edges_emit", "radix_count", "radix_scatter", "scan", "scan_add",
+    };
+
+    // Push constant blocks, laid out like their counterparts in the shaders.
+    struct HashData    { VkDeviceAddress vertices, keys, values; uint32_t vertexCount, vertexStride; };
+    struct WeldData    { VkDeviceAddress vertices, keys, values, positionIds, status; uint32_t vertexCount, vertexStride; };
+    struct SidesData   { VkDeviceAddress vertices, indices, positionIds, keys, values, normals; uint32_t triangleCount, vertexStride, sentinel, crease; };
+    struct MarkData    { VkDeviceAddress indices, keys, values, normals, flags; uint32_t count, sentinel; float minimumCos; uint32_t mode; };
+    struct EmitData    { VkDeviceAddress indices, values, offsets, counts, edges; uint32_t count, job, crease; };
+    struct CountData   { VkDeviceAddress keys, counts; uint32_t count, shift, tiles; };
+    struct ScatterData { VkDeviceAddress keys, values, outKeys, outValues, offsets; uint32_t count, shift, tiles; };
+    struct ScanData    { VkDeviceAddress values, sums; uint32_t count; };
+
+    // The kernels read the float position stream of the scene, see OttModel::positionStride.
+    constexpr uint32_t VERTEX_STRIDE = OttModel::positionStride(OttModel::VertexFormat::Float) / sizeof(float);
+
+    uint32_t groupsFor(const uint32_t items) { return (items + GROUP_SIZE - 1) / GROUP_SIZE; }
+    uint32_t tilesFor(const uint32_t items)  { return (items + SCAN_TILE - 1) / SCAN_TILE; }
+
+    //----------------------------------------------------------------------------
+    /** Tile sums a scan of count values keeps, over all its levels. **/
+    VkDeviceSize scanSumsFor(uint32_t count)
+    {
+        VkDeviceSize total = 0;
+        while (count > SCAN_TILE)
+        {
+            count = tilesFor(count);
+            total += count;
+        }
+        return total;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Makes compute and transfer writes visible to the compute work recorded next. **/
+    void computeBarrier(VkCommandBuffer command_buffer)
+    {
+        const VkMemoryBarrier barrier {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        };
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    VkDeviceAddress addressOf(const VkDevice device, const VkBuffer buffer)
+    {
+        const VkBufferDeviceAddressInfo addressInfo {
+            .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = buffer,
+        };
+        return vkGetBufferDeviceAddress(device, &addressInfo);
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Loads the <kernel>.comp.spv binaries from shader_dir and builds one compute pipeline per
+ *  kernel; they share a layout with a single push constant range and no descriptors. **/
+OttGpuEdges::OttGpuEdges(const Context& context, const std::filesystem::path& shader_dir)
+    : context(context)
+{
+    const VkPushConstantRange pushConstantRange {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = PUSH_CONSTANT_SIZE,
+    };
+    const VkPipelineLayoutCreateInfo layoutInfo {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &pushConstantRange,
+    };
+    if (vkCreatePipelineLayout(context.device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create the edge extraction pipeline layout!");
+
+    for (size_t kernel = 0; kernel < KERNEL_COUNT; kernel++)
+    {
+        const std::vector<char> code = Utils::readFile((shader_dir / (std::string(KERNEL_NAMES[kernel]) + ".comp.spv")).string());
+        const VkShaderModuleCreateInfo moduleInfo {
+            .sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+            .codeSize = code.size(),
+            .pCode    = reinterpret_cast<const uint32_t*>(code.data()),
+        };
+        VkShaderModule module;
+        if (vkCreateShaderModule(context.device, &moduleInfo, nullptr, &module) != VK_SUCCESS)
+            throw std::runtime_error("Failed to create an edge extraction shader module!");
+
+        const VkComputePipelineCreateInfo pipelineInfo {
+            .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage  = {
+                .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                .stage  = VK_SHADER_STAGE_COMPUTE_BIT,
+                .module = module,
+                .pName  = "main",
+            },
+            .layout = pipelineLayout,
+        };
+        const VkResult result = vkCreateComputePipelines(context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipelines[kernel]);
+        vkDestroyShaderModule(context.device, module, nullptr);
+        if (result != VK_SUCCESS)
+        {
+            log_t<error>("vkCreateComputePipelines returned {} for {}", static_cast<int>(result), KERNEL_NAMES[kernel]);
+            throw std::runtime_error("Failed to create an edge extraction pipeline!");
+        }
+    }
+
+    const VkCommandPoolCreateInfo poolInfo {
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+        .queueFamilyIndex = context.queueFamily,
+    };
+    if (vkCreateCommandPool(context.device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create the edge extraction command pool!");
+}
+
+//----------------------------------------------------------------------------
+/** Expects no recorded extraction to be pending. **/
+OttGpuEdges::~OttGpuEdges()
+{
+    for (Buffer* buffer : { &keys[0], &keys[1], &values[0], &values[1], &radixCounts, &scanSums, &positionIds, &normals, &flags })
+        destroyBuffer(*buffer);
+    for (VkPipeline pipeline : pipelines)
+        vkDestroyPipeline(context.device, pipeline, nullptr);
+    vkDestroyPipelineLayout(context.device, pipelineLayout, nullptr);
+    vkDestroyCommandPool(context.device, commandPool, nullptr);
+}
+
+//----------------------------------------------------------------------------
+void OttGpuEdges::record(VkCommandBuffer command_buffer, const std::span<const Job> jobs, const Output& output,
+                         const std::optional<OttEdges::CreaseOptions>& creases)
+{
+    uint32_t largest = 0;
+    for (const Job& job : jobs)
+        largest = std::max({ largest, job.vertexCount, job.indexCount });
+    reserveScratch(largest);
+
+    const VkDeviceAddress counts = addressOf(context.device, output.counts);
+    const VkDeviceAddress status = counts + jobs.size() * sizeof(uint32_t);
+    vkCmdFillBuffer(command_buffer, output.counts, 0, (jobs.size() + 1) * sizeof(uint32_t), 0);
+    computeBarrier(command_buffer);
+
+    const uint32_t crease = creases ? 1 : 0;
+    uint32_t mode = 0;
+    if (creases)
+        mode = MODE_CREASE | (creases->boundaries ? MODE_BOUNDARIES : 0) | (creases->suppressSeams ? 0 : MODE_SEAMS);
+    const float minimumCos = creases ? std::cos(creases->angleDegrees * 3.14159265358979f / 180.0f) : 0.0f;
+
+    std::vector<uint32_t> hashShifts;
+    for (uint32_t shift = 0; shift < 64; shift += 4)
+        hashShifts.push_back(shift);
+
+    for (size_t k = 0; k < jobs.size(); k++)
+    {
+        const Job&     job       = jobs[k];
+        const uint32_t triangles = job.indexCount / 3;
+        const uint32_t count     = triangles * 3;
+        if (count == 0)
+            continue;
+
+        if (creases)
+        {
+            const HashData hash {
+                .vertices = job.vertices, .keys = keys[0].address, .values = values[0].address,
+                .vertexCount = job.vertexCount, .vertexStride = VERTEX_STRIDE,
+            };
+            dispatch(command_buffer, Hash, &hash, sizeof(hash), job.vertexCount);
+            radixSort(command_buffer, job.vertexCount, hashShifts);
+
+            const WeldData weld {
+                .vertices = job.vertices, .keys = keys[0].address, .values = values[0].address,
+                .positionIds = positionIds.address, .status = status,
+                .vertexCount = job.vertexCount, .vertexStride = VERTEX_STRIDE,
+            };
+            dispatch(command_buffer, Weld, &weld, sizeof(weld), job.vertexCount);
+        }
+
+        // Vertex ids stay below vertexCount, which is therefore free as the sentinel. Only the
+        // digits that can differ are sorted: bit_width(vertexCount) bits of each word.
+        const SidesData sides {
+            .vertices = job.vertices, .indices = job.indices, .positionIds = positionIds.address,
+            .keys = keys[0].address, .values = values[0].address, .normals = normals.address,
+            .triangleCount = triangles, .vertexStride = VERTEX_STRIDE, .sentinel = job.vertexCount, .crease = crease,
+        };
+        dispatch(command_buffer, Sides, &sides, sizeof(sides), triangles);
+
+        std::vector<uint32_t> sideShifts;
+        for (uint32_t shift = 0; shift < static_cast<uint32_t>(std::bit_width(job.vertexCount)); shift += 4)
+            sideShifts.push_back(shift);
+        const size_t lowPasses = sideShifts.size();
+        for (size_t pass = 0; pass < lowPasses; pass++)
+            sideShifts.push_back(32 + sideShifts[pass]);
+        radixSort(command_buffer, count, sideShifts);
+
+        const MarkData mark {
+            .indices = job.indices, .keys = keys[0].address, .values = values[0].address,
+            .normals = normals.address, .flags = flags.address,
+            .count = count, .sentinel = job.vertexCount, .minimumCos = minimumCos, .mode = mode,
+        };
+        dispatch(command_buffer, Mark, &mark, sizeof(mark), count);
+
+        scan(command_buffer, flags.address, count, counts + k * sizeof(uint32_t));
+
+        const EmitData emit {
+            .indices = job.indices, .values = values[0].address, .offsets = flags.address, .counts = counts,
+            .edges = output.edges, .count = count, .job = static_cast<uint32_t>(k), .crease = crease,
+        };
+        dispatch(command_buffer, Emit, &emit, sizeof(emit), count);
+    }
+
+    const VkMemoryBarrier done {
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_HOST_READ_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 1, &done, 0, nullptr, 0, nullptr);
+}
+
+//----------------------------------------------------------------------------
+std::vector<uint32_t> OttGpuEdges::extract(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices,
+                                           const std::optional<OttEdges::CreaseOptions>& creases)
+{
+    constexpr VkBufferUsageFlags    usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    constexpr VkMemoryPropertyFlags host  = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    auto upload = [this](Buffer& buffer, const void* data, const size_t size)
+    {
+        if (size == 0)
+            return;
+        void* mapped;
+        vkMapMemory(context.device, buffer.memory, 0, size, 0, &mapped);
+        std::memcpy(mapped, data, size);
+        vkUnmapMemory(context.device, buffer.memory);
+    };
+
+    std::vector<glm::vec3> positions(vertices.size());
+    std::ranges::transform(vertices, positions.begin(), &OttModel::Vertex::pos);
+    const size_t positionBytes = positions.size() * sizeof(glm::vec3);
+
+    Buffer vertexBuffer = createBuffer(positionBytes, usage, host);
+    Buffer indexBuffer  = createBuffer(indices.size_bytes(), usage, host);
+    Buffer edgeBuffer   = createBuffer(maxEdgeBytes(static_cast<uint32_t>(indices.size())), usage, host);
+    Buffer countBuffer  = createBuffer(2 * sizeof(uint32_t), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, host);
+    upload(vertexBuffer, positions.data(), positionBytes);
+    upload(indexBuffer,  indices.data(),  indices.size_bytes());
+
+    const VkCommandBufferAllocateInfo allocInfo {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = commandPool,
+        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    VkCommandBuffer commandBuffer;
+    vkAllocateCommandBuffers(context.device, &allocInfo, &commandBuffer);
+    const VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    const Job job {
+        .vertices    = vertexBuffer.address,
+        .indices     = indexBuffer.address,
+        .vertexCount = static_cast<uint32_t>(vertices.size()),
+        .indexCount  = static_cast<uint32_t>(indices.size()),
+    };
+    record(commandBuffer, std::span(&job, 1), { .edges = edgeBuffer.address, .counts = countBuffer.buffer }, creases);
+    vkEndCommandBuffer(commandBuffer);
+
+    const VkFenceCreateInfo fenceInfo { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    VkFence fence;
+    if (vkCreateFence(context.device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create the edge extraction fence!");
+    const VkSubmitInfo submitInfo {
+        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers    = &commandBuffer,
+    };
+    if (vkQueueSubmit(context.queue, 1, &submitInfo, fence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit the edge extraction!");
+    vkWaitForFences(context.device, 1, &fence, VK_TRUE, UINT64_MAX);
+    vkDestroyFence(context.device, fence, nullptr);
+    vkFreeCommandBuffers(context.device, commandPool, 1, &commandBuffer);
+
+    uint32_t counts[2];
+    void* mapped;
+    vkMapMemory(context.device, countBuffer.memory, 0, sizeof(counts), 0, &mapped);
+    std::memcpy(counts, mapped, sizeof(counts));
+    vkUnmapMemory(context.device, countBuffer.memory);
+    if (counts[1] > 0)
+        log_t<warning>("{} position hash collisions during GPU edge extraction", counts[1]);
+
+    std::vector<uint32_t> edges(2 * size_t(counts[0]));
+    if (!edges.empty())
+    {
+        vkMapMemory(context.device, edgeBuffer.memory, 0, edges.size() * sizeof(uint32_t), 0, &mapped);
+        std::memcpy(edges.data(), mapped, edges.size() * sizeof(uint32_t));
+        vkUnmapMemory(context.device, edgeBuffer.memory);
+    }
+
+    for (Buffer* buffer : { &vertexBuffer, &indexBuffer, &edgeBuffer, &countBuffer })
+        destroyBuffer(*buffer);
+    return edges;
+}
+
+//----------------------------------------------------------------------------
+OttGpuEdges::Buffer OttGpuEdges::createBuffer(const VkDeviceSize size, const VkBufferUsageFlags usage,
+                                              const VkMemoryPropertyFlags properties) const
+{
+    Buffer buffer { .size = std::max(size, MIN_BUFFER_SIZE) };
+    const VkBufferCreateInfo bufferInfo {
+        .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+        .size        = buffer.size,
+        .usage       = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+    };
+    if (vkCreateBuffer(context.device, &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create an edge extraction buffer!");
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(context.device, buffer.buffer, &requirements);
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(context.physicalDevice, &memoryProperties);
+    uint32_t memoryType = UINT32_MAX;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && memoryType == UINT32_MAX; i++)
+    {
+        if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            memoryType = i;
+    }
+    if (memoryType == UINT32_MAX)
+        throw std::runtime_error("No memory type for an edge extraction buffer!");
+
+    const VkMemoryAllocateFlagsInfo flagsInfo {
+        .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+        .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    };
+    const VkMemoryAllocateInfo allocInfo {
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .pNext           = &flagsInfo,
+        .allocationSize  = requirements.size,
+        .memoryTypeIndex = memoryType,
+    };
+    if (vkAllocateMemory(context.device, &allocInfo, nullptr, &buffer.memory) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate edge extraction memory!");
+    vkBindBufferMemory(context.device, buffer.buffer, buffer.memory, 0);
+    buffer.address = addressOf(context.device, buffer.buffer);
+    return buffer;
+}
+
+//----------------------------------------------------------------------------
+void OttGpuEdges::destroyBuffer(Buffer& buffer) const
+{
+    if (buffer.buffer != VK_NULL_HANDLE) { vkDestroyBuffer (context.device, buffer.buffer, nullptr); }
+    if (buffer.memory != VK_NULL_HANDLE) { vkFreeMemory    (context.device, buffer.memory, nullptr); }
+    buffer = {};
+}
+
+//----------------------------------------------------------------------------
+/** Scratch for jobs of up to items sides or vertices: two key/value buffers for the radix
+ *  ping-pong, the per tile digit counts, the tile sums of the scans, position ids, face
+ *  normals and the drawn flags. **/
+void OttGpuEdges::reserveScratch(const uint32_t items)
+{
+    if (items <= scratchItems)
+        return;
+    for (Buffer* buffer : { &keys[0], &keys[1], &values[0], &values[1], &radixCounts, &scanSums, &positionIds, &normals, &flags })
+        destroyBuffer(*buffer);
+
+    constexpr VkBufferUsageFlags    usage  = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    constexpr VkMemoryPropertyFlags device = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    scratchItems = std::bit_ceil(items);
+    const VkDeviceSize n = scratchItems;
+    for (size_t i = 0; i < 2; i++)
+    {
+        keys[i]   = createBuffer(n * 2 * sizeof(uint32_t), usage, device);
+        values[i] = createBuffer(n * sizeof(uint32_t), usage, device);
+    }
+    const uint32_t digitCounts = 16 * groupsFor(scratchItems);
+    radixCounts = createBuffer(VkDeviceSize(digitCounts) * sizeof(uint32_t), usage, device);
+    scanSums    = createBuffer(scanSumsFor(std::max(scratchItems, digitCounts)) * sizeof(uint32_t), usage, device);
+    positionIds = createBuffer(n * sizeof(uint32_t), usage, device);
+    normals     = createBuffer((n / 3 + 1) * 4 * sizeof(float), usage, device);
+    flags       = createBuffer(n * sizeof(uint32_t), usage, device);
+}
+
+//----------------------------------------------------------------------------
+/** One invocation per item, 256 to a workgroup. **/
+void OttGpuEdges::dispatch(VkCommandBuffer command_buffer, const Kernel kernel, const void* push, const uint32_t push_size,
+                           const uint32_t items) const
+{
+    dispatchGroups(command_buffer, kernel, push, push_size, groupsFor(items));
+}
+
+//----------------------------------------------------------------------------
+/** Grids wider than the guaranteed 65535 groups wrap into y, which the kernels fold back
+ *  into a flat index; they skip the groups past the end of the last row. **/
+void OttGpuEdges::dispatchGroups(VkCommandBuffer command_buffer, const Kernel kernel, const void* push, const uint32_t push_size,
+                                 const uint32_t groups) const
+{
+    if (groups == 0)
+        return;
+    const uint32_t groupsX = std::min(groups, MAX_GROUPS_X);
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelines[kernel]);
+    vkCmdPushConstants(command_buffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, push_size, push);
+    vkCmdDispatch(command_buffer, groupsX, (groups + groupsX - 1) / groupsX, 1);
+    computeBarrier(command_buffer);
+}
+
+//----------------------------------------------------------------------------
+/** Sorts keys[0]/values[0] by the 4-bit digits at shifts, least significant first. Each
+ *  pass counts digits per tile, scans the counts into offsets and scatters into the other
+ *  buffer pair. shifts must have an even size so the result ends up back in keys[0]. **/
+void OttGpuEdges::radixSort(VkCommandBuffer command_buffer, const uint32_t count, const std::span<const uint32_t> shifts) const
+{
+    if (shifts.size() % 2 != 0)
+        throw std::logic_error("OttGpuEdges::radixSort needs an even number of passes");
+
+    const uint32_t tiles = groupsFor(count);
+    for (size_t pass = 0; pass < shifts.size(); pass++)
+    {
+        const Buffer& keysIn    = keys[pass % 2];
+        const Buffer& valuesIn  = values[pass % 2];
+        const Buffer& keysOut   = keys[(pass + 1) % 2];
+        const Buffer& valuesOut = values[(pass + 1) % 2];
+
+        const CountData countData {
+            .keys = keysIn.address, .counts = radixCounts.address, .count = count, .shift = shifts[pass], .tiles = tiles,
+        };
+        dispatch(command_buffer, RadixCount, &countData, sizeof(countData), count);
+
+        scan(command_buffer, radixCounts.address, 16 * tiles, 0);
+
+        const ScatterData scatter {
+            .keys = keysIn.address, .values = valuesIn.address, .outKeys = keysOut.address, .outValues = valuesOut.address,
+            .offsets = radixCounts.address, .count = count, .shift = shifts[pass], .tiles = tiles,
+        };
+        dispatch(command_buffer, RadixScatter, &scatter, sizeof(scatter), count);
+    }
+}
+
+//----------------------------------------------------------------------------
+/** Exclusive prefix sum of count values in place, with the grand total written to total
+ *  unless it is 0. Every level scans its tiles and keeps their totals in scanSums, until
+ *  one tile is left; scan_add then carries the scanned totals back down level by level.
+ *  Each pass spreads over the whole GPU, so no single workgroup walks all the values. **/
+void OttGpuEdges::scan(VkCommandBuffer command_buffer, const VkDeviceAddress values, const uint32_t count,
+                       const VkDeviceAddress total) const
+{
+    struct Level
+    {
+        VkDeviceAddress values;
+        uint32_t        count;
+    };
+    std::vector<Level> levels { { values, count } };
+    VkDeviceAddress sums = scanSums.address;
+    while (levels.back().count > SCAN_TILE)
+    {
+        const uint32_t tiles = tilesFor(levels.back().count);
+        levels.push_back({ sums, tiles });
+        sums += VkDeviceSize(tiles) * sizeof(uint32_t);
+    }
+
+    for (size_t level = 0; level < levels.size(); level++)
+    {
+        const ScanData data {
+            .values = levels[level].values,
+            .sums   = level + 1 < levels.size() ? levels[level + 1].values : total,
+            .count  = levels[level].count,
+        };
+        dispatchGroups(command_buffer, Scan, &data, sizeof(data), tilesFor(data.count));
+    }
+    for (size_t level = levels.size() - 1; level-- > 0;)
+    {
+        const ScanData data { .values = levels[level].values, .sums = levels[level + 1].values, .count = levels[level].count };
+        dispatchGroups(command_buffer, ScanAdd, &data, sizeof(data), tilesFor(data.count));
+    }
+}
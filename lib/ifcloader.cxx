@@ -0,0 +1,1310 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ifcloader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include <fmt/format.h>
+
+#include "mappedfile.h"
+#include "threadpool.h"
+
+namespace
+{
+    // Below this size a chunk costs more to schedule than to index.
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    // Products handed to a worker at once; also how often a stop request is checked.
+    constexpr size_t PRODUCT_BLOCK = 32;
+
+    // Segments used for circular profiles.
+    constexpr int CIRCLE_SEGMENTS = 24;
+
+    // Guards placement chains and nested items against reference cycles.
+    constexpr int MAX_NESTING = 64;
+
+    constexpr size_t GLOBAL_ID_LENGTH = 22;
+
+    //----------------------------------------------------------------------------
+    /** One parsed STEP parameter. Typed values such as IFCLENGTHMEASURE(1.) keep their type
+     *  in text and their arguments in list. Out of range lookups return a shared null. **/
+    struct StepValue
+    {
+        enum class Kind : uint8_t { Null, Number, String, Enum, Ref, List, Typed };
+
+        Kind                   kind   = Kind::Null;
+        double                 number = 0.0;
+        uint64_t               ref    = 0;
+        std::string_view       text;
+        std::vector<StepValue> list;
+
+        [[nodiscard]] bool   isNull()  const { return kind == Kind::Null; }
+        [[nodiscard]] size_t size()    const { return list.size(); }
+        [[nodiscard]] uint64_t asRef() const { return kind == Kind::Ref ? ref : 0; }
+
+        [[nodiscard]] double asNumber(const double fallback = 0.0) const
+        {
+            if (kind == Kind::Number)
+                return number;
+            if (kind == Kind::Typed && list.size() == 1 && list[0].kind == Kind::Number)
+                return list[0].number;
+            return fallback;
+        }
+
+        [[nodiscard]] bool isEnum(const std::string_view name) const { return kind == Kind::Enum && text == name; }
+
+        [[nodiscard]] const StepValue& operator[](const size_t index) const
+        {
+            return index < list.size() ? list[index] : null();
+        }
+
+        static const StepValue& null()
+        {
+            static const StepValue value;
+            return value;
+        }
+    };
+
+    using Arguments = std::vector<StepValue>;
+
+    //----------------------------------------------------------------------------
+    bool isTypeChar(const char c)
+    {
+        return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || (c >= 'a' && c <= 'z');
+    }
+
+    bool isBlank(const char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    //----------------------------------------------------------------------------
+    /** Skips blanks and comments. **/
+    const char* skipBlanks(const char* cursor, const char* end)
+    {
+        while (cursor < end)
+        {
+            if (isBlank(*cursor))
+                cursor++;
+            else if (*cursor == '/' && cursor + 1 < end && cursor[1] == '*')
+            {
+                const char* close = std::search(cursor + 2, end, "*/", "*/" + 2);
+                cursor = close == end ? end : close + 2;
+            }
+            else
+                break;
+        }
+        return cursor;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Returns the ';' ending the statement that cursor is in, or end. Strings may contain
+     *  ';' and use '' as an escaped quote. **/
+    const char* findStatementEnd(const char* cursor, const char* end)
+    {
+        bool inString = false;
+        for (; cursor < end; cursor++)
+        {
+            if (*cursor == '\'')
+                inString = !inString;
+            else if (!inString && *cursor == ';')
+                return cursor;
+            else if (!inString && *cursor == '/' && cursor + 1 < end && cursor[1] == '*')
+            {
+                const char* close = std::search(cursor + 2, end, "*/", "*/" + 2);
+                cursor = close == end ? end - 1 : close + 1;
+            }
+        }
+        return end;
+    }
+
+    //----------------------------------------------------------------------------
+    class ArgumentParser
+    {
+    public:
+        ArgumentParser(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+        // Parses "( ... )" into its parameters.
+        bool parse(Arguments& out) { return parseList(out, 0); }
+
+    private:
+        const char* cursor;
+        const char* end;
+
+        bool parseList(Arguments& out, const int depth)
+        {
+            cursor = skipBlanks(cursor, end);
+            if (cursor == end || *cursor != '(' || depth > MAX_NESTING)
+                return false;
+            cursor++;
+            cursor = skipBlanks(cursor, end);
+            if (cursor < end && *cursor == ')')
+            {
+                cursor++;
+                return true;
+            }
+            while (true)
+            {
+                if (!parseValue(out.emplace_back(), depth))
+                    return false;
+                cursor = skipBlanks(cursor, end);
+                if (cursor == end)
+                    return false;
+                if (*cursor == ')')
+                {
+                    cursor++;
+                    return true;
+                }
+                if (*cursor++ != ',')
+                    return false;
+            }
+        }
+
+        bool parseValue(StepValue& value, const int depth)
+        {
+            cursor = skipBlanks(cursor, end);
+            if (cursor == end)
+                return false;
+
+            const char c = *cursor;
+            if (c == '$' || c == '*')
+            {
+                cursor++;
+                return true;
+            }
+            if (c == '(')
+            {
+                value.kind = StepValue::Kind::List;
+                return parseList(value.list, depth + 1);
+            }
+            if (c == '#')
+            {
+                const auto [next, status] = std::from_chars(cursor + 1, end, value.ref);
+                value.kind = StepValue::Kind::Ref;
+                cursor     = next;
+                return status == std::errc();
+            }
+            if (c == '\'')
+            {
+                const char* start = ++cursor;
+                while (cursor < end && (*cursor != '\'' || (cursor + 1 < end && cursor[1] == '\'')))
+                    cursor += (*cursor == '\'') ? 2 : 1;
+                if (cursor == end)
+                    return false;
+                value.kind = StepValue::Kind::String;
+                value.text = std::string_view(start, static_cast<size_t>(cursor - start));
+                cursor++;
+                return true;
+            }
+            if (c == '"')
+            {
+                const char* close = std::find(cursor + 1, end, '"');
+                value.kind = StepValue::Kind::String;
+                value.text = std::string_view(cursor + 1, static_cast<size_t>(close - cursor - 1));
+                cursor     = close == end ? end : close + 1;
+                return close != end;
+            }
+            if (c == '.')
+            {
+                const char* close = std::find(cursor + 1, end, '.');
+                value.kind = StepValue::Kind::Enum;
+                value.text = std::string_view(cursor + 1, static_cast<size_t>(close - cursor - 1));
+                cursor     = close == end ? end : close + 1;
+                return close != end;
+            }
+            if (isTypeChar(c) && !(c >= '0' && c <= '9'))
+            {
+                const char* start = cursor;
+                while (cursor < end && isTypeChar(*cursor))
+                    cursor++;
+                value.kind = StepValue::Kind::Typed;
+                value.text = std::string_view(start, static_cast<size_t>(cursor - start));
+                return parseList(value.list, depth + 1);
+            }
+
+            // STEP reals may lack digits after the point ("1.", "1.E-3"), which from_chars accepts.
+            const char* start = cursor + ((c == '+') ? 1 : 0);
+            const auto [next, status] = std::from_chars(start, end, value.number);
+            value.kind = StepValue::Kind::Number;
+            cursor     = next;
+            return status == std::errc();
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    struct EntityRecord
+    {
+        uint64_t id;
+        uint64_t offset;    // Offset of the type name in the file.
+    };
+
+    struct Chunk
+    {
+        std::vector<EntityRecord> entities;
+        std::vector<uint64_t>     products;
+        std::vector<uint64_t>     unitAssignments;
+        size_t                    complexInstances = 0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Types with a GlobalId, placement and representation that are not drawn as elements. **/
+    bool isSkippedProduct(const std::string_view type)
+    {
+        return type == "IFCOPENINGELEMENT" || type == "IFCOPENINGSTANDARDCASE" || type == "IFCSPACE" ||
+               type == "IFCVIRTUALELEMENT" || type == "IFCANNOTATION" || type == "IFCGRID";
+    }
+
+    //----------------------------------------------------------------------------
+    /** Cheap test for entities that may be products: rooted (GlobalId string first) and
+     *  not one of the numerous rooted types that never carry geometry. The attribute
+     *  check happens once the product is visited. **/
+    bool mayBeProduct(const std::string_view type, const std::string_view args)
+    {
+        if (type.starts_with("IFCREL") || type.starts_with("IFCPROPERTY") || type.starts_with("IFCELEMENTQUANTITY") ||
+            type.ends_with("TYPE") || type.ends_with("STYLE") || isSkippedProduct(type))
+            return false;
+        return args.size() > GLOBAL_ID_LENGTH + 3 && args[1] == '\'' && args[GLOBAL_ID_LENGTH + 2] == '\'';
+    }
+
+    //----------------------------------------------------------------------------
+    /** Indexes every "#id=TYPE(...);" statement that starts inside [begin, end). A chunk
+     *  owns the statements starting in it even if they run past its end. **/
+    void indexChunk(const char* begin, const char* end, const char* fileEnd, Chunk& chunk)
+    {
+        const char* cursor = begin;
+        while (true)
+        {
+            cursor = skipBlanks(cursor, end);
+            if (cursor >= end)
+                return;
+            if (*cursor != '#')
+            {
+                cursor = findStatementEnd(cursor, fileEnd) + 1;
+                continue;
+            }
+
+            uint64_t id = 0;
+            const auto [next, status] = std::from_chars(cursor + 1, fileEnd, id);
+            const char* statementEnd = findStatementEnd(next, fileEnd);
+            cursor = skipBlanks(next, statementEnd);
+            if (status != std::errc() || cursor == statementEnd || *cursor != '=')
+            {
+                cursor = statementEnd + 1;
+                continue;
+            }
+            cursor = skipBlanks(cursor + 1, statementEnd);
+
+            const char* typeStart = cursor;
+            while (cursor < statementEnd && isTypeChar(*cursor))
+                cursor++;
+            const std::string_view type(typeStart, static_cast<size_t>(cursor - typeStart));
+            if (type.empty())
+            {
+                chunk.complexInstances++;
+                cursor = statementEnd + 1;
+                continue;
+            }
+
+            chunk.entities.push_back({ .id = id, .offset = 0 });
+            chunk.entities.back().offset = reinterpret_cast<uintptr_t>(typeStart);
+
+            const char* argsStart = skipBlanks(cursor, statementEnd);
+            const std::string_view args(argsStart, static_cast<size_t>(statementEnd - argsStart));
+            if (mayBeProduct(type, args))
+                chunk.products.push_back(id);
+            else if (type == "IFCUNITASSIGNMENT")
+                chunk.unitAssignments.push_back(id);
+            cursor = statementEnd + 1;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** The indexed DATA section. Entities are parsed from the mapping on every visit. **/
+    class StepFile
+    {
+    public:
+        bool index(std::string_view text, OttIfc::ImportStats& stats, std::string& warnings, std::string& error);
+
+        //----------------------------------------------------------------------------
+        /** Parses entity id. Returns false for dangling references. **/
+        bool entity(const uint64_t id, std::string_view& type, Arguments& args) const
+        {
+            args.clear();
+            const auto found = std::lower_bound(records.begin(), records.end(), id,
+                                                [](const EntityRecord& record, const uint64_t key) { return record.id < key; });
+            if (found == records.end() || found->id != id)
+                return false;
+
+            const char* cursor = data.data() + found->offset;
+            const char* end    = data.data() + data.size();
+            const char* start  = cursor;
+            while (cursor < end && isTypeChar(*cursor))
+                cursor++;
+            type = std::string_view(start, static_cast<size_t>(cursor - start));
+            ArgumentParser parser(cursor, findStatementEnd(cursor, end));
+            return parser.parse(args);
+        }
+
+        std::vector<uint64_t> products;
+        std::vector<uint64_t> unitAssignments;
+
+    private:
+        std::string_view          data;
+        std::vector<EntityRecord> records;
+    };
+
+    //----------------------------------------------------------------------------
+    bool StepFile::index(const std::string_view text, OttIfc::ImportStats& stats, std::string& warnings, std::string& error)
+    {
+        data = text;
+        const size_t header = text.find("ISO-10303-21");
+        const size_t dataStart = text.find("DATA;");
+        if (header == std::string_view::npos || dataStart == std::string_view::npos)
+        {
+            error = "Not an ISO 10303-21 (STEP) file";
+            return false;
+        }
+        if (const size_t schema = text.find("FILE_SCHEMA"); schema == std::string_view::npos || text.find("IFC", schema) > dataStart)
+            warnings += "FILE_SCHEMA does not name an IFC schema\n";
+
+        const char* begin = text.data() + dataStart + 5;
+        const char* end   = text.data() + text.size();
+
+        OttThreadPool& pool = OttThreadPool::shared();
+        const size_t maxChunks  = (pool.size() + 1) * 4;
+        const size_t chunkCount = std::clamp<size_t>(static_cast<size_t>(end - begin) / MIN_CHUNK_BYTES, 1, maxChunks);
+
+        // Cut after a line break that is followed by '#', so every chunk starts on a statement.
+        std::vector<const char*> bounds(chunkCount + 1);
+        bounds.front() = begin;
+        bounds.back()  = end;
+        for (size_t i = 1; i < chunkCount; i++)
+        {
+            const char* cut = std::max(bounds[i - 1], begin + static_cast<size_t>(end - begin) * i / chunkCount);
+            const char* line = cut;
+            while (true)
+            {
+                line = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+                if (!line || line + 1 >= end || line[1] == '#')
+                    break;
+                line++;
+            }
+            bounds[i] = line ? line + 1 : end;
+        }
+
+        std::vector<Chunk> chunks(chunkCount);
+        pool.parallelFor(chunkCount, [&](const size_t i) { indexChunk(bounds[i], bounds[i + 1], end, chunks[i]); });
+
+        size_t entityCount = 0;
+        size_t complexInstances = 0;
+        for (const Chunk& chunk : chunks)
+        {
+            entityCount      += chunk.entities.size();
+            complexInstances += chunk.complexInstances;
+        }
+        records.reserve(entityCount);
+        for (Chunk& chunk : chunks)
+        {
+            for (EntityRecord record : chunk.entities)
+            {
+                record.offset -= reinterpret_cast<uintptr_t>(text.data());
+                records.push_back(record);
+            }
+            products.insert(products.end(), chunk.products.begin(), chunk.products.end());
+            unitAssignments.insert(unitAssignments.end(), chunk.unitAssignments.begin(), chunk.unitAssignments.end());
+            chunk = {};
+        }
+
+        // Exporters write ids in ascending order almost always, which makes this a linear check.
+        if (!std::ranges::is_sorted(records, {}, &EntityRecord::id))
+            std::ranges::sort(records, {}, &EntityRecord::id);
+
+        if (complexInstances > 0)
+            warnings += fmt::format("Skipped {} complex entity instances\n", complexInstances);
+        stats.chunks   = chunkCount;
+        stats.entities = records.size();
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    glm::dvec3 orthogonalTo(const glm::dvec3& axis)
+    {
+        return std::abs(axis.x) < 0.9 ? glm::dvec3(1.0, 0.0, 0.0) : glm::dvec3(0.0, 1.0, 0.0);
+    }
+
+    //----------------------------------------------------------------------------
+    /** Matrix whose columns are the right handed axes built from z and an approximate x. **/
+    glm::dmat4 frame(glm::dvec3 z, glm::dvec3 x, const glm::dvec3& origin)
+    {
+        z = glm::length(z) > 0.0 ? glm::normalize(z) : glm::dvec3(0.0, 0.0, 1.0);
+        x = x - z * glm::dot(x, z);
+        if (glm::length(x) < 1e-12)
+            x = orthogonalTo(z) - z * glm::dot(orthogonalTo(z), z);
+        x = glm::normalize(x);
+        const glm::dvec3 y = glm::cross(z, x);
+        return glm::dmat4(glm::dvec4(x, 0.0), glm::dvec4(y, 0.0), glm::dvec4(z, 0.0), glm::dvec4(origin, 1.0));
+    }
+
+    //----------------------------------------------------------------------------
+    glm::dvec3 transformPoint(const glm::dmat4& transform, const glm::dvec3& point)
+    {
+        return glm::dvec3(transform * glm::dvec4(point, 1.0));
+    }
+
+    //----------------------------------------------------------------------------
+    double signedArea(const std::vector<glm::dvec2>& points, const std::vector<uint32_t>& loop)
+    {
+        double area = 0.0;
+        for (size_t i = 0, j = loop.size() - 1; i < loop.size(); j = i++)
+            area += points[loop[j]].x * points[loop[i]].y - points[loop[i]].x * points[loop[j]].y;
+        return area * 0.5;
+    }
+
+    double cross2(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+    {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    //----------------------------------------------------------------------------
+    bool segmentsCross(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d)
+    {
+        const double d1 = cross2(a, b, c);
+        const double d2 = cross2(a, b, d);
+        const double d3 = cross2(c, d, a);
+        const double d4 = cross2(c, d, b);
+        return ((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0));
+    }
+
+    //----------------------------------------------------------------------------
+    bool insideTriangle(const glm::dvec2& p, const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+    {
+        return cross2(a, b, p) >= 0.0 && cross2(b, c, p) >= 0.0 && cross2(c, a, p) >= 0.0;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Ear clipping of a polygon with holes. loops index into points, outer loop first.
+     *  Holes are joined to the outer ring through a bridge to the nearest vertex that can
+     *  see them, then the ring is clipped ear by ear. Degenerate input falls back to a fan
+     *  of whatever is left, so no face is dropped entirely. **/
+    void triangulate(const std::vector<glm::dvec2>& points, std::vector<std::vector<uint32_t>> loops, std::vector<uint32_t>& triangles)
+    {
+        if (loops.empty() || loops[0].size() < 3)
+            return;
+
+        std::vector<uint32_t> ring = std::move(loops[0]);
+        if (signedArea(points, ring) < 0.0)
+            std::ranges::reverse(ring);
+
+        std::vector<std::vector<uint32_t>> holes;
+        for (size_t h = 1; h < loops.size(); h++)
+        {
+            if (loops[h].size() < 3)
+                continue;
+            if (signedArea(points, loops[h]) > 0.0)
+                std::ranges::reverse(loops[h]);
+            holes.push_back(std::move(loops[h]));
+        }
+        auto maxX = [&points](const std::vector<uint32_t>& loop)
+        {
+            return std::ranges::max(loop, {}, [&points](const uint32_t i) { return points[i].x; });
+        };
+        std::ranges::sort(holes, [&](const auto& a, const auto& b) { return points[maxX(a)].x > points[maxX(b)].x; });
+
+        for (const std::vector<uint32_t>& hole : holes)
+        {
+            const uint32_t m = maxX(hole);
+            const glm::dvec2 mp = points[m];
+            auto blocked = [&](const uint32_t candidate)
+            {
+                const glm::dvec2 cp = points[candidate];
+                for (const std::vector<uint32_t>* loop : { static_cast<const std::vector<uint32_t>*>(&ring), &hole })
+                {
+                    for (size_t i = 0, j = loop->size() - 1; i < loop->size(); j = i++)
+                    {
+                        if (segmentsCross(mp, cp, points[(*loop)[j]], points[(*loop)[i]]))
+                            return true;
+                    }
+                }
+                return false;
+            };
+
+            std::vector<size_t> order(ring.size());
+            for (size_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            std::ranges::sort(order, {}, [&](const size_t i) { return glm::length(points[ring[i]] - mp); });
+            size_t bridge = order.front();
+            for (const size_t i : order)
+            {
+                if (!blocked(ring[i]))
+                {
+                    bridge = i;
+                    break;
+                }
+            }
+
+            std::vector<uint32_t> spliced(ring.begin(), ring.begin() + static_cast<ptrdiff_t>(bridge) + 1);
+            const auto start = std::ranges::find(hole, m) - hole.begin();
+            for (size_t k = 0; k <= hole.size(); k++)
+                spliced.push_back(hole[(static_cast<size_t>(start) + k) % hole.size()]);
+            spliced.push_back(ring[bridge]);
+            spliced.insert(spliced.end(), ring.begin() + static_cast<ptrdiff_t>(bridge) + 1, ring.end());
+            ring = std::move(spliced);
+        }
+
+        const size_t count = ring.size();
+        std::vector<size_t> prev(count), next(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            prev[i] = (i + count - 1) % count;
+            next[i] = (i + 1) % count;
+        }
+
+        auto isEar = [&](const size_t i)
+        {
+            const glm::dvec2& a = points[ring[prev[i]]];
+            const glm::dvec2& b = points[ring[i]];
+            const glm::dvec2& c = points[ring[next[i]]];
+            if (cross2(a, b, c) <= 0.0)
+                return false;
+            for (size_t k = next[next[i]]; k != prev[i]; k = next[k])
+            {
+                const glm::dvec2& p = points[ring[k]];
+                if (p == a || p == b || p == c)
+                    continue;
+                if (insideTriangle(p, a, b, c))
+                    return false;
+            }
+            return true;
+        };
+
+        size_t remaining = count;
+        size_t current   = 0;
+        size_t stalled   = 0;
+        while (remaining > 3)
+        {
+            if (isEar(current))
+            {
+                triangles.insert(triangles.end(), { ring[prev[current]], ring[current], ring[next[current]] });
+            }
+            else if (stalled < remaining)
+            {
+                stalled++;
+                current = next[current];
+                continue;
+            }
+            else if (cross2(points[ring[prev[current]]], points[ring[current]], points[ring[next[current]]]) > 0.0)
+            {
+                // No ear anywhere: self touching input. Clip anyway rather than loop forever.
+                triangles.insert(triangles.end(), { ring[prev[current]], ring[current], ring[next[current]] });
+            }
+
+            next[prev[current]] = next[current];
+            prev[next[current]] = prev[current];
+            current = prev[current];
+            remaining--;
+            stalled = 0;
+        }
+        if (cross2(points[ring[prev[current]]], points[ring[current]], points[ring[next[current]]]) > 0.0)
+            triangles.insert(triangles.end(), { ring[prev[current]], ring[current], ring[next[current]] });
+    }
+
+    //----------------------------------------------------------------------------
+    struct ProductMesh
+    {
+        std::string                   globalId;
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t>         indices;
+        size_t                        skippedItems = 0;
+    };
+
+    using Loop2D = std::vector<glm::dvec2>;
+    using Loop3D = std::vector<glm::dvec3>;
+
+    //----------------------------------------------------------------------------
+    /** Turns the body representation of one product into triangles. Every method takes the
+     *  transform from item coordinates to world metres. **/
+    class Tessellator
+    {
+    public:
+        Tessellator(const StepFile& file, const double length_scale, ProductMesh& out)
+            : file(file), lengthScale(length_scale), out(out) {}
+
+        bool product(uint64_t id);
+
+    private:
+        const StepFile& file;
+        double          lengthScale;
+        ProductMesh&    out;
+
+        bool fetch(const uint64_t id, std::string_view& type, Arguments& args) const { return file.entity(id, type, args); }
+
+        glm::dvec3 point(uint64_t id) const;
+        glm::dvec3 direction(uint64_t id, const glm::dvec3& fallback) const;
+        glm::dmat4 axisPlacement(uint64_t id) const;
+        glm::dmat4 localPlacement(uint64_t id, int depth) const;
+        glm::dmat4 transformationOperator(uint64_t id) const;
+
+        void item(uint64_t id, const glm::dmat4& transform, int depth);
+        void extrusion(const Arguments& args, const glm::dmat4& transform);
+        bool profile(uint64_t id, std::vector<Loop2D>& loops) const;
+        bool curve(uint64_t id, Loop2D& points) const;
+        void faces(const StepValue& faceList, const glm::dmat4& transform);
+        void shell(uint64_t id, const glm::dmat4& transform);
+        void triangulatedFaceSet(const Arguments& args, const glm::dmat4& transform);
+        void polygonalFaceSet(const Arguments& args, const glm::dmat4& transform);
+
+        void emitPolygon(const std::vector<Loop3D>& loops);
+        void emitTriangle(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c);
+    };
+
+    //----------------------------------------------------------------------------
+    glm::dvec3 Tessellator::point(const uint64_t id) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (!fetch(id, type, args))
+            return glm::dvec3(0.0);
+        const StepValue& coordinates = args[0];
+        return { coordinates[0].asNumber(), coordinates[1].asNumber(), coordinates[2].asNumber() };
+    }
+
+    //----------------------------------------------------------------------------
+    glm::dvec3 Tessellator::direction(const uint64_t id, const glm::dvec3& fallback) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (id == 0 || !fetch(id, type, args))
+            return fallback;
+        const StepValue& ratios = args[0];
+        const glm::dvec3 value(ratios[0].asNumber(), ratios[1].asNumber(), ratios[2].asNumber());
+        return glm::length(value) > 0.0 ? glm::normalize(value) : fallback;
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcAxis2Placement3D or IfcAxis2Placement2D (Location, Axis, RefDirection). **/
+    glm::dmat4 Tessellator::axisPlacement(const uint64_t id) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (id == 0 || !fetch(id, type, args))
+            return glm::dmat4(1.0);
+        const glm::dvec3 location = point(args[0].asRef());
+        if (type == "IFCAXIS2PLACEMENT2D")
+            return frame(glm::dvec3(0.0, 0.0, 1.0), direction(args[1].asRef(), glm::dvec3(1.0, 0.0, 0.0)), location);
+        return frame(direction(args[1].asRef(), glm::dvec3(0.0, 0.0, 1.0)), direction(args[2].asRef(), glm::dvec3(1.0, 0.0, 0.0)), location);
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcLocalPlacement (PlacementRelTo, RelativePlacement), resolved up to the root. **/
+    glm::dmat4 Tessellator::localPlacement(const uint64_t id, const int depth) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (id == 0 || depth > MAX_NESTING || !fetch(id, type, args) || type != "IFCLOCALPLACEMENT")
+            return glm::dmat4(1.0);
+        return localPlacement(args[0].asRef(), depth + 1) * axisPlacement(args[1].asRef());
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcCartesianTransformationOperator3D (Axis1, Axis2, LocalOrigin, Scale, Axis3) and its
+     *  non uniform variant (..., Scale2, Scale3). **/
+    glm::dmat4 Tessellator::transformationOperator(const uint64_t id) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (id == 0 || !fetch(id, type, args))
+            return glm::dmat4(1.0);
+        glm::dmat4 result = frame(direction(args[4].asRef(), glm::dvec3(0.0, 0.0, 1.0)),
+                                  direction(args[0].asRef(), glm::dvec3(1.0, 0.0, 0.0)), point(args[2].asRef()));
+        const double scale = args[3].asNumber(1.0);
+        const double scaleY = type == "IFCCARTESIANTRANSFORMATIONOPERATOR3DNONUNIFORM" ? args[5].asNumber(scale) : scale;
+        const double scaleZ = type == "IFCCARTESIANTRANSFORMATIONOPERATOR3DNONUNIFORM" ? args[6].asNumber(scale) : scale;
+        result[0] *= scale;
+        result[1] *= scaleY;
+        result[2] *= scaleZ;
+        return result;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Open polylines and indexed poly curves in profile coordinates. Arc segments of an
+     *  indexed poly curve keep their three defining points only. **/
+    bool Tessellator::curve(const uint64_t id, Loop2D& points) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (!fetch(id, type, args))
+            return false;
+
+        if (type == "IFCPOLYLINE")
+        {
+            for (const StepValue& ref : args[0].list)
+            {
+                const glm::dvec3 p = point(ref.asRef());
+                points.emplace_back(p.x, p.y);
+            }
+        }
+        else if (type == "IFCINDEXEDPOLYCURVE")
+        {
+            std::string_view listType;
+            Arguments list;
+            if (!fetch(args[0].asRef(), listType, list))
+                return false;
+            const StepValue& coordinates = list[0];
+            auto add = [&](const double index)
+            {
+                const StepValue& p = coordinates[static_cast<size_t>(index) - 1];
+                const glm::dvec2 value(p[0].asNumber(), p[1].asNumber());
+                if (points.empty() || points.back() != value)
+                    points.push_back(value);
+            };
+            if (args[1].isNull())
+            {
+                for (size_t i = 1; i <= coordinates.size(); i++)
+                    add(static_cast<double>(i));
+            }
+            for (const StepValue& segment : args[1].list)
+                for (const StepValue& index : segment[0].list)
+                    add(index.asNumber(1.0));
+        }
+        else
+            return false;
+
+        if (points.size() > 1 && points.front() == points.back())
+            points.pop_back();
+        return points.size() >= 3;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Profile outline(s), outer loop first, in the coordinates of the extrusion. **/
+    bool Tessellator::profile(const uint64_t id, std::vector<Loop2D>& loops) const
+    {
+        std::string_view type;
+        Arguments args;
+        if (!fetch(id, type, args))
+            return false;
+
+        auto placed = [&](Loop2D loop)
+        {
+            const glm::dmat4 position = axisPlacement(args[2].asRef());
+            for (glm::dvec2& p : loop)
+            {
+                const glm::dvec3 moved = transformPoint(position, glm::dvec3(p.x, p.y, 0.0));
+                p = glm::dvec2(moved.x, moved.y);
+            }
+            loops.push_back(std::move(loop));
+        };
+        auto rectangle = [](const double x, const double y) -> Loop2D
+        {
+            return { { -x / 2, -y / 2 }, { x / 2, -y / 2 }, { x / 2, y / 2 }, { -x / 2, y / 2 } };
+        };
+        auto circle = [](const double radius) -> Loop2D
+        {
+            Loop2D loop;
+            for (int i = 0; i < CIRCLE_SEGMENTS; i++)
+            {
+                const double angle = 2.0 * std::numbers::pi * i / CIRCLE_SEGMENTS;
+                loop.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+            }
+            return loop;
+        };
+
+        if (type == "IFCRECTANGLEPROFILEDEF")
+            placed(rectangle(args[3].asNumber(), args[4].asNumber()));
+        else if (type == "IFCRECTANGLEHOLLOWPROFILEDEF")
+        {
+            const double wall = args[5].asNumber();
+            placed(rectangle(args[3].asNumber(), args[4].asNumber()));
+            placed(rectangle(args[3].asNumber() - 2 * wall, args[4].asNumber() - 2 * wall));
+        }
+        else if (type == "IFCCIRCLEPROFILEDEF")
+            placed(circle(args[3].asNumber()));
+        else if (type == "IFCCIRCLEHOLLOWPROFILEDEF")
+        {
+            placed(circle(args[3].asNumber()));
+            placed(circle(args[3].asNumber() - args[4].asNumber()));
+        }
+        else if (type == "IFCISHAPEPROFILEDEF")
+        {
+            const double w = args[3].asNumber() / 2, d = args[4].asNumber() / 2;
+            const double t = args[5].asNumber() / 2, f = args[6].asNumber();
+            placed({ { -w, -d }, { w, -d }, { w, -d + f }, { t, -d + f }, { t, d - f }, { w, d - f },
+                     { w, d }, { -w, d }, { -w, d - f }, { -t, d - f }, { -t, -d + f }, { -w, -d + f } });
+        }
+        else if (type == "IFCARBITRARYCLOSEDPROFILEDEF" || type == "IFCARBITRARYPROFILEDEFWITHVOIDS")
+        {
+            Loop2D outer;
+            if (!curve(args[2].asRef(), outer))
+                return false;
+            loops.push_back(std::move(outer));
+            for (const StepValue& inner : args[3].list)
+            {
+                Loop2D hole;
+                if (curve(inner.asRef(), hole))
+                    loops.push_back(std::move(hole));
+            }
+        }
+        else
+            return false;
+        return !loops.empty() && loops[0].size() >= 3;
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcExtrudedAreaSolid (SweptArea, Position, ExtrudedDirection, Depth): both caps and
+     *  one quad per profile edge. **/
+    void Tessellator::extrusion(const Arguments& args, const glm::dmat4& transform)
+    {
+        std::vector<Loop2D> loops;
+        if (!profile(args[0].asRef(), loops))
+        {
+            out.skippedItems++;
+            return;
+        }
+
+        const glm::dmat4 solid  = transform * axisPlacement(args[1].asRef());
+        const glm::dvec3 offset = direction(args[2].asRef(), glm::dvec3(0.0, 0.0, 1.0)) * args[3].asNumber();
+        // Caps and sides are wound for an outer loop counter-clockwise seen from +offset.
+        const bool flip = offset.z < 0.0;
+
+        std::vector<Loop3D> bottom, top;
+        for (Loop2D& loop : loops)
+        {
+            std::vector<uint32_t> order(loop.size());
+            for (uint32_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            const bool outer = bottom.empty();
+            if ((signedArea(loop, order) > 0.0) != (outer != flip))
+                std::ranges::reverse(loop);
+
+            Loop3D& low  = bottom.emplace_back();
+            Loop3D& high = top.emplace_back();
+            for (const glm::dvec2& p : loop)
+            {
+                low.push_back(transformPoint(solid, glm::dvec3(p.x, p.y, 0.0)));
+                high.push_back(transformPoint(solid, glm::dvec3(p.x, p.y, 0.0) + offset));
+            }
+        }
+
+        emitPolygon(top);
+        for (Loop3D& loop : bottom)
+            std::ranges::reverse(loop);
+        emitPolygon(bottom);
+        for (Loop3D& loop : bottom)
+            std::ranges::reverse(loop);
+
+        for (size_t l = 0; l < bottom.size(); l++)
+        {
+            const Loop3D& low  = bottom[l];
+            const Loop3D& high = top[l];
+            for (size_t i = 0; i < low.size(); i++)
+            {
+                const size_t j = (i + 1) % low.size();
+                emitPolygon({ { low[i], low[j], high[j], high[i] } });
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcFace lists: every face bound is an IfcPolyLoop, IfcFaceOuterBound first. **/
+    void Tessellator::faces(const StepValue& faceList, const glm::dmat4& transform)
+    {
+        std::string_view type;
+        Arguments face, bound, loop;
+        for (const StepValue& faceRef : faceList.list)
+        {
+            if (!fetch(faceRef.asRef(), type, face))
+                continue;
+            std::vector<Loop3D> loops;
+            for (const StepValue& boundRef : face[0].list)
+            {
+                if (!fetch(boundRef.asRef(), type, bound))
+                    continue;
+                const bool outer    = type == "IFCFACEOUTERBOUND";
+                const bool reversed = bound[1].isEnum("F");
+                std::string_view loopType;
+                if (!fetch(bound[0].asRef(), loopType, loop) || loopType != "IFCPOLYLOOP")
+                {
+                    out.skippedItems++;
+                    continue;
+                }
+                Loop3D points;
+                for (const StepValue& p : loop[0].list)
+                    points.push_back(transformPoint(transform, point(p.asRef())));
+                if (reversed)
+                    std::ranges::reverse(points);
+                if (outer)
+                    loops.insert(loops.begin(), std::move(points));
+                else
+                    loops.push_back(std::move(points));
+            }
+            emitPolygon(loops);
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    void Tessellator::shell(const uint64_t id, const glm::dmat4& transform)
+    {
+        std::string_view type;
+        Arguments args;
+        if (fetch(id, type, args))
+            faces(args[0], transform);
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcTriangulatedFaceSet (Coordinates, Normals, Closed, CoordIndex, PnIndex). **/
+    void Tessellator::triangulatedFaceSet(const Arguments& args, const glm::dmat4& transform)
+    {
+        std::string_view type;
+        Arguments coordinates;
+        if (!fetch(args[0].asRef(), type, coordinates))
+            return;
+        const StepValue& list    = coordinates[0];
+        const StepValue& pnIndex = args[4];
+        auto vertex = [&](const StepValue& index)
+        {
+            auto i = static_cast<size_t>(index.asNumber(1.0)) - 1;
+            if (!pnIndex.list.empty())
+                i = static_cast<size_t>(pnIndex[i].asNumber(1.0)) - 1;
+            const StepValue& p = list[i];
+            return transformPoint(transform, glm::dvec3(p[0].asNumber(), p[1].asNumber(), p[2].asNumber()));
+        };
+        for (const StepValue& triangle : args[3].list)
+            emitTriangle(vertex(triangle[0]), vertex(triangle[1]), vertex(triangle[2]));
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcPolygonalFaceSet (Coordinates, Closed, Faces, PnIndex); faces are
+     *  IfcIndexedPolygonalFace (CoordIndex) or ...WithVoids (CoordIndex, InnerCoordIndices). **/
+    void Tessellator::polygonalFaceSet(const Arguments& args, const glm::dmat4& transform)
+    {
+        std::string_view type;
+        Arguments coordinates, face;
+        if (!fetch(args[0].asRef(), type, coordinates))
+            return;
+        const StepValue& list    = coordinates[0];
+        const StepValue& pnIndex = args[3];
+        auto loopOf = [&](const StepValue& indices)
+        {
+            Loop3D loop;
+            for (const StepValue& index : indices.list)
+            {
+                auto i = static_cast<size_t>(index.asNumber(1.0)) - 1;
+                if (!pnIndex.list.empty())
+                    i = static_cast<size_t>(pnIndex[i].asNumber(1.0)) - 1;
+                const StepValue& p = list[i];
+                loop.push_back(transformPoint(transform, glm::dvec3(p[0].asNumber(), p[1].asNumber(), p[2].asNumber())));
+            }
+            return loop;
+        };
+        for (const StepValue& faceRef : args[2].list)
+        {
+            if (!fetch(faceRef.asRef(), type, face))
+                continue;
+            std::vector<Loop3D> loops { loopOf(face[0]) };
+            for (const StepValue& inner : face[1].list)
+                loops.push_back(loopOf(inner));
+            emitPolygon(loops);
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    void Tessellator::item(const uint64_t id, const glm::dmat4& transform, const int depth)
+    {
+        std::string_view type;
+        Arguments args;
+        if (depth > MAX_NESTING || !fetch(id, type, args))
+            return;
+
+        if (type == "IFCEXTRUDEDAREASOLID")
+            extrusion(args, transform);
+        else if (type == "IFCFACETEDBREP" || type == "IFCFACETEDBREPWITHVOIDS")
+            shell(args[0].asRef(), transform);
+        else if (type == "IFCSHELLBASEDSURFACEMODEL" || type == "IFCFACEBASEDSURFACEMODEL")
+        {
+            for (const StepValue& shellRef : args[0].list)
+                shell(shellRef.asRef(), transform);
+        }
+        else if (type == "IFCTRIANGULATEDFACESET")
+            triangulatedFaceSet(args, transform);
+        else if (type == "IFCPOLYGONALFACESET")
+            polygonalFaceSet(args, transform);
+        else if (type == "IFCBOOLEANRESULT" || type == "IFCBOOLEANCLIPPINGRESULT")
+        {
+            // Without a CSG kernel the first operand stands in for the result.
+            item(args[1].asRef(), transform, depth + 1);
+            if (args[0].isEnum("UNION"))
+                item(args[2].asRef(), transform, depth + 1);
+        }
+        else if (type == "IFCMAPPEDITEM")
+        {
+            std::string_view mapType, representationType;
+            Arguments map, representation;
+            if (!fetch(args[0].asRef(), mapType, map) || !fetch(map[1].asRef(), representationType, representation))
+                return;
+            const glm::dmat4 mapped = transform * transformationOperator(args[1].asRef()) * axisPlacement(map[0].asRef());
+            for (const StepValue& inner : representation[3].list)
+                item(inner.asRef(), mapped, depth + 1);
+        }
+        else
+            out.skippedItems++;
+    }
+
+    //----------------------------------------------------------------------------
+    /** IfcProduct (GlobalId, OwnerHistory, Name, Description, ObjectType, ObjectPlacement,
+     *  Representation, ...). Returns false when the entity turns out not to be a product. **/
+    bool Tessellator::product(const uint64_t id)
+    {
+        std::string_view type, shapeType;
+        Arguments args, shape;
+        if (!fetch(id, type, args) || args[0].text.size() != GLOBAL_ID_LENGTH ||
+            !fetch(args[6].asRef(), shapeType, shape) || shapeType != "IFCPRODUCTDEFINITIONSHAPE")
+            return false;
+        out.globalId = std::string(args[0].text);
+
+        const glm::dmat4 scale(glm::dvec4(lengthScale, 0, 0, 0), glm::dvec4(0, lengthScale, 0, 0),
+                               glm::dvec4(0, 0, lengthScale, 0), glm::dvec4(0, 0, 0, 1));
+        const glm::dmat4 world = scale * localPlacement(args[5].asRef(), 0);
+
+        // Body representations; products without one fall back to any solid or surface representation.
+        std::vector<Arguments> representations;
+        std::vector<Arguments> fallbacks;
+        std::string_view representationType;
+        for (const StepValue& ref : shape[2].list)
+        {
+            Arguments representation;
+            if (!fetch(ref.asRef(), representationType, representation))
+                continue;
+            const std::string_view identifier = representation[1].text;
+            const std::string_view kind       = representation[2].text;
+            if (identifier == "Body")
+                representations.push_back(std::move(representation));
+            else if (kind == "SweptSolid" || kind == "Brep" || kind == "SurfaceModel" || kind == "Tessellation" ||
+                     kind == "MappedRepresentation" || kind == "Clipping" || kind == "CSG")
+                fallbacks.push_back(std::move(representation));
+        }
+        for (const Arguments& representation : representations.empty() ? fallbacks : representations)
+            for (const StepValue& itemRef : representation[3].list)
+                item(itemRef.asRef(), world, 0);
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Triangulates a planar polygon given in world coordinates. The Newell normal of the
+     *  outer loop defines the face orientation. **/
+    void Tessellator::emitPolygon(const std::vector<Loop3D>& loops)
+    {
+        if (loops.empty() || loops[0].size() < 3)
+            return;
+
+        const Loop3D& outer = loops[0];
+        glm::dvec3 normal(0.0);
+        for (size_t i = 0, j = outer.size() - 1; i < outer.size(); j = i++)
+            normal += glm::cross(outer[j], outer[i]);
+        if (glm::length(normal) < 1e-18)
+            return;
+        normal = glm::normalize(normal);
+
+        if (outer.size() == 3 && loops.size() == 1)
+        {
+            emitTriangle(outer[0], outer[1], outer[2]);
+            return;
+        }
+
+        const glm::dvec3 u = glm::normalize(orthogonalTo(normal) - normal * glm::dot(orthogonalTo(normal), normal));
+        const glm::dvec3 v = glm::cross(normal, u);
+        const glm::dvec3 origin = outer[0];
+
+        std::vector<glm::dvec2> points;
+        std::vector<std::vector<uint32_t>> indexLoops;
+        for (const Loop3D& loop : loops)
+        {
+            std::vector<uint32_t>& indices = indexLoops.emplace_back();
+            for (const glm::dvec3& p : loop)
+            {
+                indices.push_back(static_cast<uint32_t>(points.size()));
+                points.emplace_back(glm::dot(p - origin, u), glm::dot(p - origin, v));
+            }
+        }
+
+        std::vector<uint32_t> triangles;
+        triangulate(points, std::move(indexLoops), triangles);
+
+        const auto base = static_cast<uint32_t>(out.vertices.size());
+        const glm::vec3 faceNormal(normal);
+        for (const Loop3D& loop : loops)
+            for (const glm::dvec3& p : loop)
+                out.vertices.push_back({ .pos = glm::vec3(p), .color = glm::vec3(1.0f), .texCoord = glm::vec2(0.0f), .normal = faceNormal });
+        for (const uint32_t index : triangles)
+            out.indices.push_back(base + index);
+    }
+
+    //----------------------------------------------------------------------------
+    void Tessellator::emitTriangle(const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c)
+    {
+        const glm::dvec3 normal = glm::cross(b - a, c - a);
+        if (glm::length(normal) < 1e-18)
+            return;
+        const glm::vec3 faceNormal(glm::normalize(normal));
+        const auto base = static_cast<uint32_t>(out.vertices.size());
+        for (const glm::dvec3* p : { &a, &b, &c })
+            out.vertices.push_back({ .pos = glm::vec3(*p), .color = glm::vec3(1.0f), .texCoord = glm::vec2(0.0f), .normal = faceNormal });
+        out.indices.insert(out.indices.end(), { base, base + 1, base + 2 });
+    }
+
+    //----------------------------------------------------------------------------
+    /** Metres per file length unit, from the first IfcUnitAssignment: an IfcSIUnit with an
+     *  optional prefix or an IfcConversionBasedUnit such as feet. **/
+    double lengthUnitScale(const StepFile& file)
+    {
+        auto siScale = [](const Arguments& unit)
+        {
+            const std::string_view prefix = unit[2].kind == StepValue::Kind::Enum ? unit[2].text : std::string_view();
+            if (prefix == "MILLI") return 1e-3;
+            if (prefix == "CENTI") return 1e-2;
+            if (prefix == "DECI")  return 1e-1;
+            if (prefix == "KILO")  return 1e3;
+            return 1.0;
+        };
+
+        std::string_view type;
+        Arguments assignment, unit, measure;
+        for (const uint64_t id : file.unitAssignments)
+        {
+            if (!file.entity(id, type, assignment))
+                continue;
+            for (const StepValue& ref : assignment[0].list)
+            {
+                if (!file.entity(ref.asRef(), type, unit) || !unit[1].isEnum("LENGTHUNIT"))
+                    continue;
+                if (type == "IFCSIUNIT")
+                    return siScale(unit);
+                if (type == "IFCCONVERSIONBASEDUNIT" && file.entity(unit[3].asRef(), type, measure))
+                {
+                    const double factor = measure[0].asNumber(1.0);
+                    Arguments base;
+                    return file.entity(measure[1].asRef(), type, base) && type == "IFCSIUNIT" ? factor * siScale(base) : factor;
+                }
+            }
+        }
+        return 1.0;
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+bool OttIfc::Parse(const std::string_view text, OttModel::MeshData& mesh,
+                   std::string* warn, std::string* err, ImportStats* stats, const std::stop_token stop)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    ImportStats localStats;
+    ImportStats& counters = stats ? *stats : localStats;
+    counters = { .bytes = text.size() };
+    mesh = {};
+
+    StepFile file;
+    std::string warnings, error;
+    if (!file.index(text, counters, warnings, error))
+    {
+        if (err)
+            *err += error;
+        return false;
+    }
+    const double lengthScale = lengthUnitScale(file);
+
+    // Products are tessellated in blocks on the pool and stitched together in file order.
+    std::vector<ProductMesh> products(file.products.size());
+    std::vector<uint8_t>     valid(file.products.size(), 0);
+    const size_t blocks = (products.size() + PRODUCT_BLOCK - 1) / PRODUCT_BLOCK;
+    std::atomic<bool> cancelled = false;
+    OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+    {
+        if (stop.stop_requested())
+        {
+            cancelled = true;
+            return;
+        }
+        const size_t last = std::min(products.size(), (block + 1) * PRODUCT_BLOCK);
+        for (size_t i = block * PRODUCT_BLOCK; i < last; i++)
+        {
+            Tessellator tessellator(file, lengthScale, products[i]);
+            valid[i] = tessellator.product(file.products[i]);
+        }
+    });
+    if (cancelled)
+    {
+        if (err)
+            *err += "Cancelled";
+        return false;
+    }
+
+    size_t vertexCount = 0, indexCount = 0;
+    for (size_t i = 0; i < products.size(); i++)
+    {
+        counters.skippedItems += products[i].skippedItems;
+        if (!valid[i] || products[i].indices.empty())
+            continue;
+        vertexCount += products[i].vertices.size();
+        indexCount  += products[i].indices.size();
+    }
+    mesh.vertices.reserve(vertexCount);
+    mesh.indices.reserve(indexCount);
+    for (size_t i = 0; i < products.size(); i++)
+    {
+        ProductMesh& product = products[i];
+        if (!valid[i] || product.indices.empty())
+            continue;
+        mesh.objects.push_back({
+            .startIndex  = static_cast<uint32_t>(mesh.indices.size()),
+            .startVertex = static_cast<uint32_t>(mesh.vertices.size()),
+            .startEdge   = 0,
+            .indexCount  = static_cast<uint32_t>(product.indices.size()),
+            .edgeCount   = 0,
+            .textureID   = 0,
+            .pushColorID = glm::vec3(0.0f),
+        });
+        mesh.objectIds.push_back(std::move(product.globalId));
+        mesh.vertices.insert(mesh.vertices.end(), product.vertices.begin(), product.vertices.end());
+        mesh.indices.insert(mesh.indices.end(), product.indices.begin(), product.indices.end());
+        product = {};
+    }
+
+    counters.products = mesh.objects.size();
+    if (counters.skippedItems > 0)
+        warnings += fmt::format("{} representation items use unsupported geometry and were skipped\n", counters.skippedItems);
+    if (warn)
+        *warn += warnings;
+    counters.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttIfc::Load(const std::filesystem::path& path, OttModel::MeshData& mesh,
+                  std::string* warn, std::string* err, ImportStats* stats, const std::stop_token stop)
+{
+    const OttMappedFile file(path);
+    if (!file.isOpen())
+    {
+        if (err)
+            *err += fmt::format("Cannot open file {}", path.string());
+        return false;
+    }
+    return Parse(file.view(), mesh, warn, err, stats, stop);
+}
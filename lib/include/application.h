@@ -24,17 +24,26 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/hash.hpp>
 
+#include <array>
 #include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <stop_token>
+#include <utility>
 #include <vector>
 
 #include "camera.h"
+#include "clustercull.h"
 #include "device.h"
 #include "descriptor.h"
+#include "frustumcull.h"
+#include "loader.h"
 #include "swapchain.h"
 #include "model.h"
 #include "pipeline.h"
 #include "renderer.h"
+#include "task.h"
+#include "upload.h"
 #include "window.h"
 
 const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
@@ -64,6 +73,68 @@ private:
 
     PushConstantData push;
     std::vector<OttModel::modelObject> models;
+    std::vector<std::string>           modelIds;   // Source identifier per entry of models, empty if none.
+    OttModel::BoundsTable              sceneBounds; // Box and sphere per entry of models, scene box after transforms.
+    // Cleans up CAD/BIM exports and adds the creases, levels, meshlets and BVH drawing and picking use.
+    OttLoader::LoadOptions modelLoadOptions { .weld          = OttWeld::WeldOptions{},
+                                              .cleanup       = OttCleanup::CleanupOptions{},
+                                              .normals       = OttNormals::NormalOptions{},
+                                              .instancing    = OttInstancing::InstancingOptions{},
+                                              .creases       = OttEdges::CreaseOptions{},
+                                              .gpuEdgesAbove = 1'000'000,
+                                              .lods          = OttSimplify::LodOptions{},
+                                              .optimize      = OttOptimize::OptimizeOptions{},
+                                              .meshlets      = OttMeshlets::MeshletOptions{},
+                                              .bvh           = true };
+    static constexpr float LOD_PIXEL_ERROR = 1.0f;   // Deviation a simplified level may show on screen.
+    // Packed quantizes vertices to 20 bytes instead of 44, at the cost of GPU edges; see OttModel::VertexFormat.
+    OttModel::VertexFormat vertexFormat = OttModel::VertexFormat::Float;
+
+    // Models sharing geometry, texture and offset are drawn with one instanced call per run
+    // of them in view. Their transforms are laid out batch by batch in instanceBuffer, read
+    // by object.vert.
+    struct DrawBatch
+    {
+        uint32_t  firstIndex;
+        uint32_t  indexCount;
+        uint32_t  firstEdge;
+        uint32_t  edgeCount;
+        int32_t   vertexOffset;
+        VkIndexType indexType;  // VK_INDEX_TYPE_UINT16 for ranges in the uploader's short index buffer.
+        uint32_t  textureID;
+        glm::vec3 offset;
+        glm::vec3 color;
+        glm::vec3 quantOffset;
+        glm::vec3 quantScale;
+        uint32_t  firstInstance;
+        uint32_t  instanceCount;
+        std::array<OttModel::LodRange, OttModel::MAX_LODS> lods;
+        uint32_t  lodCount;
+        glm::vec4 boundingSphere;
+        uint32_t  firstMeshlet;
+        uint32_t  meshletCount;
+        uint32_t  cullBatch;    // Batch of clusterCuller drawing the full level, NO_CULL_BATCH if none.
+    };
+    static constexpr uint32_t NO_CULL_BATCH = UINT32_MAX;
+    std::vector<DrawBatch> drawBatches;
+    std::vector<glm::mat4> instanceTransforms;   // CPU copy of instanceBuffer, for picking levels of detail.
+    std::vector<OttModel::Meshlet>    meshlets;       // Of every model, startIndex in the scene index buffer.
+    std::unique_ptr<OttClusterCuller> clusterCuller;  // Empty without indirect count support.
+    OttFrustumCuller       frustumCuller;        // Instances of drawBatches in view, refreshed every frame.
+
+    // CPU copy of every mesh with a BVH, reduced to what raycasts read: vertices, index
+    // ranges, objects and the trees. Object i of a mesh is models[firstModel + i].
+    struct PickMesh
+    {
+        OttModel::MeshData mesh;
+        uint32_t           firstModel;
+    };
+    std::vector<PickMesh>  pickMeshes;
+    uint32_t               pickedModel    = OttBvh::NONE;   // Entry of models last clicked on.
+    bool                   pickButtonDown = false;
+    VkBuffer               instanceBuffer        = VK_NULL_HANDLE;
+    VkDeviceMemory         instanceBufferMemory  = VK_NULL_HANDLE;
+    VkDeviceAddress        instanceBufferAddress = 0;
     
     VkDescriptorSetLayout bindlessDescSetLayout = OttDescriptor::createBindlessDescriptorSetLayout(device, appDevice);
     VkDescriptorSet  bindlessDescriptorSet;
@@ -78,22 +149,9 @@ private:
     VkSampler                       textureSampler      = VK_NULL_HANDLE;
     std::vector<VkImage>            textureImages;
     std::vector<VkImageView>        textureImageViews;
-        
-    std::vector<OttModel::Vertex>   vertices;
-    std::vector<uint32_t>           indices;
-    std::vector<uint32_t>           edges;
-    
-    VkBuffer                        vertexBuffer        = VK_NULL_HANDLE;
-    VkDeviceMemory                  vertexBufferMemory  = VK_NULL_HANDLE;
-    VkBuffer                        indexBuffer         = VK_NULL_HANDLE;
-    VkDeviceMemory                  indexBufferMemory   = VK_NULL_HANDLE;
-    VkBuffer                        edgesBuffer         = VK_NULL_HANDLE;
-    VkDeviceMemory                  edgesBufferMemory   = VK_NULL_HANDLE;
-    VkBufferDeviceAddressInfo       edgesBufferAddressInfo = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-        .pNext = nullptr,
-        .buffer = edgesBuffer,
-    };
+
+    // Scene vertex, index and edge buffers, grown in the background as models arrive.
+    OttGeometryUploader             geometryUploader    = OttGeometryUploader(&appDevice, vertexFormat);
 
     std::vector<VkBuffer>           uniformBuffers;
     std::vector<VkDeviceMemory>     uniformBuffersMemory;
@@ -107,6 +165,25 @@ private:
     OttCamera  objectCamera;
     OttCamera* viewportCamera = &objectCamera;
     int windowMidPos_X, windowMidPos_Y;
+
+    // Asynchronous model loading.
+    struct DecodedTexture
+    {
+        std::filesystem::path      path;
+        int                        width  = 1;
+        int                        height = 1;
+        std::vector<unsigned char> pixels = { 255, 255, 255, 255 };
+    };
+    struct ModelImport
+    {
+        std::filesystem::path                     path;
+        std::shared_ptr<OttLoader::LoadProgress>  progress;
+    };
+    OttMainThreadQueue       mainThreadQueue;
+    std::stop_source         importStop;
+    std::vector<ModelImport> activeImports;
+    std::string              windowTitle;
+    uint64_t                 recordedFrames = 0;
     
     
     //----------------------------------------------------------------------------
@@ -120,18 +197,27 @@ private:
     void drawScene(VkCommandBuffer command_buffer);
     void cleanupTextureObjects();
     void cleanupUBO() const;
-    void cleanupModelObjects() const;
     void cleanupVulkanResources();
     
     VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevelCount);
     
-    void loadModel(std::filesystem::path const& modelPath);
-    
-    void createVertexBuffer();
-    void createIndexBuffer(std::vector<uint32_t>& indices, VkBuffer& index_buffer, VkDeviceMemory& index_buffer_memory);
+    OttTask<void> loadModelsAsync(std::vector<std::filesystem::path> modelPaths, std::stop_token stop);
+    void appendMesh(const OttModel::MeshData& mesh, const OttGeometryUploader::Placement& placement);
+    void keepForPicking(OttModel::MeshData&& mesh, uint32_t first_model);
+    void pickObject();
+    void cancelModelLoads();
+    void updateLoadProgress();
+    void rebuildDescriptorSet();
+    void rebuildDrawBatches();
+    [[nodiscard]] std::pair<uint32_t, uint32_t> selectLod(const DrawBatch& batch, const OttFrustumCuller::Run& run, float width, float height) const;
+    void cullObjects();
+    void cullMeshlets(VkCommandBuffer command_buffer);
+    [[nodiscard]] glm::mat4 viewProjection() const;
 
     // TODO: Pass these functions to a proper texel class.
+    static DecodedTexture decodeTexture(const std::filesystem::path& imagePath);
     void createTextureImage(const std::filesystem::path& imagePath);
+    void createTextureImage(const DecodedTexture& texture);
     void createTextureImageView();
     void createTextureSampler();
     
@@ -0,0 +1,100 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include "device.h"
+
+//----------------------------------------------------------------------------
+/** Append-only device local buffer with reserved capacity.
+ *
+ *  New data is copied into the free tail, so adding a model transfers only that model's
+ *  bytes. When the tail is too small the arena grows geometrically: a larger buffer is
+ *  allocated and the used range is copied into it on the GPU, without going through the
+ *  host again.
+ *
+ *  Appends are two-phase, to fit a fenced upload. recordAppend() records the copies and
+ *  returns the offset the data will land at; commit() makes the result current once the
+ *  copies completed. Frames recorded in between keep drawing from the current buffer,
+ *  whose used range the copies never overwrite. **/
+class OttGeometryArena
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    // Capacity multiplier applied when an append doesn't fit.
+    static constexpr VkDeviceSize GROWTH_FACTOR = 2;
+
+    OttGeometryArena(OttDevice* device_reference, VkBufferUsageFlags usage, std::string name);
+    ~OttGeometryArena();
+
+    OttGeometryArena(const OttGeometryArena&) = delete;
+    OttGeometryArena& operator=(const OttGeometryArena&) = delete;
+
+    //----------------------------------------------------------------------------
+    /** Makes sure at least bytes fit without growing. Main thread, no append pending. **/
+    void reserve(VkDeviceSize bytes);
+
+    //----------------------------------------------------------------------------
+    /** Records the copy of size bytes from source into the free tail, growing first when
+     *  needed. reserve more bytes after them are claimed for the GPU to write into, see
+     *  releaseTail(). Returns the byte offset of the appended data. **/
+    VkDeviceSize recordAppend(VkCommandBuffer command_buffer, VkBuffer source, VkDeviceSize size, VkDeviceSize reserve = 0);
+
+    //----------------------------------------------------------------------------
+    /** Gives the last bytes of the pending append back to the free tail, before commit(). **/
+    void releaseTail(VkDeviceSize bytes) { pendingUsed -= std::min(bytes, pendingUsed - used); }
+
+    //----------------------------------------------------------------------------
+    /** Publishes the pending append. A buffer replaced by growth is passed to retire, which
+     *  must keep it alive until no recorded frame can reference it. **/
+    void commit(const std::function<void(std::function<void()>)>& retire);
+
+    [[nodiscard]] VkBuffer     getBuffer()   const { return current.buffer; }
+    // The buffer the pending append is recorded into.
+    [[nodiscard]] VkBuffer     getPendingBuffer() const { return hasPendingGrowth() ? grown.buffer : current.buffer; }
+    [[nodiscard]] VkDeviceSize getUsed()     const { return used; }
+    [[nodiscard]] VkDeviceSize getCapacity() const { return current.capacity; }
+    [[nodiscard]] bool         hasPendingGrowth() const { return grown.buffer != VK_NULL_HANDLE; }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    struct Allocation
+    {
+        VkBuffer       buffer   = VK_NULL_HANDLE;
+        VkDeviceMemory memory   = VK_NULL_HANDLE;
+        VkDeviceSize   capacity = 0;
+    };
+
+    OttDevice*         deviceRef;
+    VkBufferUsageFlags usage;
+    std::string        name;
+
+    Allocation   current;
+    Allocation   grown;
+    VkDeviceSize used        = 0;
+    VkDeviceSize pendingUsed = 0;
+
+    Allocation allocate(VkDeviceSize capacity) const;
+    void       release(Allocation& allocation) const;
+}; // class OttGeometryArena
@@ -0,0 +1,229 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+// model.h keeps a SceneBvh in every MeshData.
+namespace OttModel
+{
+    struct MeshData;
+}
+
+//----------------------------------------------------------------------------
+/** Linear bounding volume hierarchies (LBVH) for the spatial queries of picking, culling,
+ *  clash checks and snapping.
+ *
+ *  Items are sorted along a Morton curve through the centers of their boxes, and the
+ *  hierarchy follows from the sorted codes: every inner node splits its range where the
+ *  highest differing bit changes (Karras 2012), so all nodes are built at once. Nodes sit
+ *  in one flat array, the n - 1 inner nodes first with the root at 0, then one leaf per
+ *  item in curve order. Nodes are numbered by where their range splits, so nearby nodes
+ *  cover nearby space.
+ *
+ *  A scene has two levels: one tree per index range over its triangles, in the space of
+ *  the range and shared by its instances, and a tree over the world boxes of the objects. **/
+namespace OttBvh
+{
+    constexpr uint32_t NONE       = UINT32_MAX;
+    constexpr size_t   STACK_SIZE = 96;   // Deeper than any tree: 30 code bits, then 32 index bits split ties.
+
+    struct Box
+    {
+        glm::vec3 low  { std::numeric_limits<float>::max() };
+        glm::vec3 high { std::numeric_limits<float>::lowest() };
+
+        [[nodiscard]] bool overlaps(const Box& other) const
+        {
+            return low.x <= other.high.x && low.y <= other.high.y && low.z <= other.high.z
+                && other.low.x <= high.x && other.low.y <= high.y && other.low.z <= high.z;
+        }
+    };
+
+    // 32 bytes. An inner node holds its two children, a leaf its item and NONE.
+    struct Node
+    {
+        glm::vec3 low;
+        uint32_t  left;
+        glm::vec3 high;
+        uint32_t  right;
+
+        [[nodiscard]] bool isLeaf() const { return right == NONE; }
+        [[nodiscard]] Box  box()    const { return { low, high }; }
+    };
+
+    struct Tree
+    {
+        std::vector<Node> nodes;
+
+        [[nodiscard]] bool   empty()     const { return nodes.empty(); }
+        [[nodiscard]] size_t itemCount() const { return (nodes.size() + 1) / 2; }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Tree over boxes, item i being boxes[i]. Codes, sort, nodes and bounds are computed
+     *  in parallel on the shared OttThreadPool; the bounds go bottom-up, the second child
+     *  to finish merging its parent. Inverted boxes are kept but never found. **/
+    Tree build(std::span<const Box> boxes);
+
+    //----------------------------------------------------------------------------
+    /** Parametric distance along direction at which the ray enters the box, clamped to 0,
+     *  or infinity if it misses. inverse is 1 / direction. **/
+    inline float entryDistance(const glm::vec3& low, const glm::vec3& high, const glm::vec3& origin, const glm::vec3& inverse)
+    {
+        float enter = 0.0f, leave = std::numeric_limits<float>::infinity();
+        for (int axis = 0; axis < 3; axis++)
+        {
+            // std::min and std::max keep their first argument against NaN, from 0 * inf on a slab.
+            const float t0 = (low[axis] - origin[axis]) * inverse[axis];
+            const float t1 = (high[axis] - origin[axis]) * inverse[axis];
+            enter = std::max(enter, std::min(t0, t1));
+            leave = std::min(leave, std::max(t0, t1));
+        }
+        return enter <= leave ? enter : std::numeric_limits<float>::infinity();
+    }
+
+    //----------------------------------------------------------------------------
+    /** Calls visit(item) for every item whose box overlaps box. **/
+    template<typename Visit>
+    void overlapping(const Tree& tree, const Box& box, Visit&& visit)
+    {
+        if (tree.empty() || !tree.nodes[0].box().overlaps(box))
+            return;
+        uint32_t stack[STACK_SIZE];
+        size_t top = 0;
+        stack[top++] = 0;
+        while (top > 0)
+        {
+            const Node& node = tree.nodes[stack[--top]];
+            if (node.isLeaf())
+            {
+                visit(node.left);
+                continue;
+            }
+            for (const uint32_t child : { node.right, node.left })
+            {
+                if (tree.nodes[child].box().overlaps(box))
+                    stack[top++] = child;
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Calls hit(item, maxDistance) for the items whose box the ray enters before
+     *  maxDistance, nearer boxes first; hit shortens the ray by lowering maxDistance.
+     *  Distances are in multiples of direction. **/
+    template<typename Hit>
+    void raycast(const Tree& tree, const glm::vec3& origin, const glm::vec3& direction, float& maxDistance, Hit&& hit)
+    {
+        if (tree.empty())
+            return;
+        const glm::vec3 inverse = glm::vec3(1.0f) / direction;
+        struct Entry
+        {
+            uint32_t node;
+            float    distance;
+        };
+        Entry stack[STACK_SIZE];
+        size_t top = 0;
+        stack[top++] = { 0, entryDistance(tree.nodes[0].low, tree.nodes[0].high, origin, inverse) };
+        while (top > 0)
+        {
+            const Entry entry = stack[--top];
+            if (!(entry.distance < maxDistance))   // Missed boxes are at infinity, past an unlimited ray too.
+                continue;
+            const Node& node = tree.nodes[entry.node];
+            if (node.isLeaf())
+            {
+                hit(node.left, maxDistance);
+                continue;
+            }
+            Entry left  { node.left,  entryDistance(tree.nodes[node.left].low,  tree.nodes[node.left].high,  origin, inverse) };
+            Entry right { node.right, entryDistance(tree.nodes[node.right].low, tree.nodes[node.right].high, origin, inverse) };
+            if (left.distance < right.distance)
+                std::swap(left, right);
+            for (const Entry& child : { left, right })
+            {
+                if (child.distance < maxDistance)
+                    stack[top++] = child;
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Distance along direction to the triangle (a, b, c), either side, or infinity if the
+     *  ray misses it (Moeller-Trumbore). **/
+    float intersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b,
+                            const glm::vec3& c);
+
+    //----------------------------------------------------------------------------
+    /** Both levels of a mesh's hierarchy. rangeOf and toObject are per object; objects
+     *  without triangles have no range, and an inverted box in the object tree. **/
+    struct SceneBvh
+    {
+        Tree                   objects;    // Over the world boxes of the objects' triangles.
+        std::vector<Tree>      ranges;     // Triangles of each distinct index range, before transform.
+        std::vector<uint32_t>  rangeOf;    // Tree in ranges of each object, NONE if it has no triangles.
+        std::vector<glm::mat4> toObject;   // Inverse transform of each object.
+
+        [[nodiscard]] size_t bytes() const;
+    };
+
+    struct BvhStats
+    {
+        size_t objects   = 0;
+        size_t ranges    = 0;
+        size_t triangles = 0;
+        size_t nodes     = 0;
+        size_t bytes     = 0;
+        double seconds   = 0.0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Hierarchy of mesh's objects and of their full index ranges, reading shortIndices for
+     *  objects with the flag set. Ranges shared by instances are built once, in parallel.
+     *  The trees address triangles by their number in the range, so the index order must
+     *  not change afterwards; moving whole ranges, as OttModel::splitShortIndices does, is
+     *  fine. **/
+    SceneBvh build(const OttModel::MeshData& mesh, BvhStats* stats = nullptr);
+
+    struct Hit
+    {
+        uint32_t object   = NONE;
+        uint32_t triangle = NONE;   // Number in the object's index range.
+        float    distance = std::numeric_limits<float>::infinity();
+    };
+
+    //----------------------------------------------------------------------------
+    /** Nearest triangle of any object the ray hits before maxDistance, the ray being in
+     *  world space; an empty hit if none. Objects are descended in the order the ray
+     *  enters their boxes, and their triangles tested in object space. **/
+    Hit raycast(const SceneBvh& bvh, const OttModel::MeshData& mesh, const glm::vec3& origin, const glm::vec3& direction,
+                float maxDistance = std::numeric_limits<float>::infinity());
+
+} // namespace OttBvh
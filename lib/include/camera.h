@@ -39,6 +39,7 @@ public:
     
     glm::mat4 projection(float height, float width) const;
     glm::mat4 inverseProjection(glm::mat4 perspectiveProjection, glm::mat4 view);
+    float projectedRadius(const glm::vec3& center, float radius, float height, float width) const;
 
 //----------------------------------------------------------------------------
 // Getters
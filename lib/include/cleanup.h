@@ -0,0 +1,74 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Geometry cleanup before edges are extracted: removes the triangles that cost raster and
+ *  vertex work without covering anything, and the coincident faces overlapping families
+ *  leave behind, which would z-fight.
+ *
+ *  - collapsed triangles, with two corners at the same position;
+ *  - zero-area triangles, whose corners lie on a line;
+ *  - duplicate triangles over the same three positions as an earlier one of the same index
+ *    range, in either winding. The first one is kept.
+ *
+ *  Positions are compared exactly, so corners split at UV seams or hard edges still match.
+ *  Triangles are classified in chunks on the shared OttThreadPool, and duplicates are found
+ *  in hash partitions from a radix sort, so the result doesn't depend on the thread count. **/
+namespace OttCleanup
+{
+    struct CleanupOptions
+    {
+        // Triangles with less area than this times the square of their longest edge count as zero-area.
+        float areaRatio    = 1e-6f;
+        bool  duplicates   = true;   // Removes duplicate triangles.
+        bool  unreferenced = true;   // Drops the vertices no remaining triangle uses.
+    };
+
+    struct CleanupStats
+    {
+        size_t triangles            = 0;   // Before cleanup.
+        size_t collapsedTriangles   = 0;
+        size_t zeroAreaTriangles    = 0;
+        size_t duplicateTriangles   = 0;
+        size_t reversedDuplicates   = 0;   // Of duplicateTriangles, those wound the other way.
+        size_t unreferencedVertices = 0;
+        double seconds              = 0.0;
+
+        [[nodiscard]] size_t removedTriangles() const { return collapsedTriangles + zeroAreaTriangles + duplicateTriangles; }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Cleans one indexed mesh in place; the remaining triangles keep their order. **/
+    CleanupStats cleanup(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                         const CleanupOptions& options = {});
+
+    //----------------------------------------------------------------------------
+    /** Cleans every distinct index range of mesh, ranges shared by instances once, and
+     *  updates the objects' ranges. Duplicates are only looked for within a range, since
+     *  coincident faces of different objects belong to different elements.
+     *  Expects a mesh without edges, levels or meshlets, as the loaders have it before edge
+     *  extraction; the index buffer is rebuilt from the objects' ranges. **/
+    CleanupStats cleanup(OttModel::MeshData& mesh, const CleanupOptions& options = {});
+
+} // namespace OttCleanup
@@ -0,0 +1,138 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include <volk.h>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Per frame GPU culling of meshlets, without mesh shaders: a compute pass tests every
+ *  cluster against the view frustum and its backface cone, for every instance of its
+ *  draw batch, and appends an indexed draw command for each cluster that survives.
+ *  Batches then draw their slice of the commands with vkCmdDrawIndexedIndirectCount
+ *  through the regular graphics pipelines, reading the scene's index buffer as it is.
+ *
+ *  Needs the multiDrawIndirect, drawIndirectFirstInstance and drawIndirectCount features.
+ *  Only raw Vulkan handles are needed, so the class also runs headless. **/
+class OttClusterCuller
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    static constexpr uint32_t FRAMES = 2;   // Frames in flight, each with its own commands.
+
+    struct Context
+    {
+        VkDevice         device;
+        VkPhysicalDevice physicalDevice;
+    };
+
+    // A meshlet of one culled batch, laid out like its counterpart in cluster_cull.comp.
+    struct Cluster
+    {
+        glm::vec4 sphere;
+        glm::vec4 cone;
+        uint32_t  firstIndex;   // In the scene index buffer.
+        uint32_t  indexCount;
+        uint32_t  batch;
+        uint32_t  padding = 0;
+    };
+
+    // A culled draw batch. Its commands start at firstCommand, one slot per cluster.
+    struct Batch
+    {
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+        uint32_t firstCommand;
+        int32_t  vertexOffset;
+    };
+
+    OttClusterCuller(const Context& context, const std::filesystem::path& shader_dir);
+    ~OttClusterCuller();
+
+    OttClusterCuller(const OttClusterCuller&) = delete;
+    OttClusterCuller& operator=(const OttClusterCuller&) = delete;
+
+    static constexpr VkDeviceSize COMMAND_STRIDE = sizeof(VkDrawIndexedIndirectCommand);
+
+    //----------------------------------------------------------------------------
+    /** Replaces the clusters and batches to cull. Clusters of a batch must be contiguous,
+     *  the batch's firstCommand being the index of its first cluster. Buffers recorded
+     *  frames may still read are handed to retire for deferred destruction. **/
+    void setClusters(std::span<const Cluster> clusters, std::span<const Batch> batches,
+                     const std::function<void(std::function<void()>)>& retire);
+
+    //----------------------------------------------------------------------------
+    /** Records, outside of a render pass, the reset of frame's counts, the culling pass
+     *  and the barrier to the indirect draws. instances holds the transforms the batches'
+     *  firstInstance refers to. **/
+    void record(VkCommandBuffer command_buffer, uint32_t frame, const glm::mat4& view_projection, const glm::vec3& eye,
+                VkDeviceAddress instances);
+
+    //----------------------------------------------------------------------------
+    /** Draws batch from the commands culled for frame. **/
+    void drawBatch(VkCommandBuffer command_buffer, uint32_t frame, uint32_t batch) const;
+
+    // World space frustum planes (xyz inward normal, w offset) of a view projection.
+    static std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& view_projection);
+
+    // The test cluster_cull.comp runs, for one instance.
+    static bool isVisible(const Cluster& cluster, const glm::mat4& transform, const std::array<glm::vec4, 6>& planes,
+                          const glm::vec3& eye);
+
+    [[nodiscard]] uint32_t clusterCount() const { return clusterTotal; }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    struct Buffer
+    {
+        VkBuffer        buffer  = VK_NULL_HANDLE;
+        VkDeviceMemory  memory  = VK_NULL_HANDLE;
+        VkDeviceSize    size    = 0;
+        VkDeviceAddress address = 0;
+        void*           mapped  = nullptr;
+    };
+
+    // Per frame: the view planes written each frame, the command counts and the commands.
+    struct FrameBuffers
+    {
+        Buffer view, counts, commands;
+    };
+
+    Context                             context;
+    VkPipelineLayout                    pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline                          pipeline       = VK_NULL_HANDLE;
+    Buffer                              clusterBuffer, batchBuffer;
+    std::array<FrameBuffers, FRAMES>    frames;
+    std::vector<Batch>                  batchList;
+    std::vector<uint32_t>               batchClusters;   // Clusters, so the most commands, per batch.
+    uint32_t                            clusterTotal = 0;
+
+    Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) const;
+    void   destroyBuffer(Buffer& buffer) const;
+}; // class OttClusterCuller
@@ -20,6 +20,7 @@ struct UniformBufferObject {
     alignas(16) glm::mat4 viewProjectionInverse;
     alignas(16) glm::vec3 cameraPos;
     alignas(8) VkDeviceAddress edgesBuffer;
+    alignas(8) VkDeviceAddress instanceBuffer;
 };
 
 /** Wrapper for helper functions related to Vulkan Descriptors. **/
@@ -74,6 +74,7 @@ public:
     VkQueue               getPresentQueue()   const { return presentQueue; }
     VkSampleCountFlagBits getMSAASamples()    const { return msaaSamples; }
     uint32_t              getMaxDescCount()   const { return physical_maxDescriptorSampledImageCount; }
+    bool                  hasIndirectCount()  const { return indirectCount; }
     
     SwapChainSupportDetails  querySwapChainSupport   (VkPhysicalDevice physical_device);
     QueueFamilyIndices       findQueueFamilies       (VkPhysicalDevice physical_device) const;
@@ -102,6 +103,7 @@ private:
     VkPhysicalDevice         physicalDevice = VK_NULL_HANDLE;
     VkSampleCountFlagBits    msaaSamples    = VK_SAMPLE_COUNT_1_BIT;
     uint32_t                 physical_maxDescriptorSampledImageCount = 0;
+    bool                     indirectCount  = false;   // Indirect draws with GPU counts and instance offsets enabled.
     VkDevice                 device;
 
     VkQueue                  graphicsQueue;
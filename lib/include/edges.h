@@ -0,0 +1,47 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Feature lines for architectural drawings: the creases where two faces meet at an angle,
+ *  found from the OttTopology adjacency over position-welded vertices. Split vertices (flat
+ *  shading, UV seams) therefore do not hide a crease, and shared vertices do not hide one
+ *  either. The output is an edge list for MeshData::edges, computed once at load time. **/
+namespace OttEdges
+{
+    struct CreaseOptions
+    {
+        float angleDegrees  = 30.0f;   // Faces meeting at a larger dihedral angle draw their shared edge.
+        bool  boundaries    = true;    // Also draws open boundaries and non-manifold edges.
+        bool  suppressSeams = true;    // Hides attribute seams between faces below the angle.
+    };
+
+    //----------------------------------------------------------------------------
+    /** Crease edges (pairs of vertex indices) of the triangles in indices, which index into
+     *  vertices, in order of the triangle side that draws them, so the output is
+     *  deterministic. Large ranges are extracted in parallel on the shared OttThreadPool. **/
+    std::vector<uint32_t> extractCreaseEdges(std::span<const OttModel::Vertex> vertices, std::span<const uint32_t> indices,
+                                             const CreaseOptions& options = {});
+
+} // namespace OttEdges
@@ -0,0 +1,84 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** CPU culling of draw instances against the view frustum, ahead of recording the draws.
+ *  The world space box of every instance is kept as columns of centers and half extents,
+ *  padded to blocks of eight. cull() tests a block at a time against the six planes with
+ *  AVX2, or one instance at a time without it, and compacts the survivors into runs of
+ *  consecutive instances of one batch, each drawn with one call. **/
+class OttFrustumCuller
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    static constexpr size_t BLOCK = 8;   // Instances per AVX2 test.
+
+    // An instance to cull: its box before transform, as in OttModel::BoundsTable.
+    struct Instance
+    {
+        glm::vec3 low;
+        glm::vec3 high;
+        glm::mat4 transform;
+        uint32_t  batch;
+    };
+
+    // Consecutive visible instances of one batch, numbered in the order they were set.
+    struct Run
+    {
+        uint32_t batch;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Replaces the instances. Those of a batch should be contiguous, as in the instance
+     *  buffer, to come out as one run. Inverted boxes (objects without vertices) are never
+     *  visible. **/
+    void setInstances(std::span<const Instance> instances);
+
+    //----------------------------------------------------------------------------
+    /** Tests every instance against planes, as OttClusterCuller::frustumPlanes gives them,
+     *  and returns the runs of visible instances in order. A box is hidden when it lies
+     *  wholly outside one plane. path is capped at OttModel::simdPath(); anything below
+     *  AVX2 takes the scalar loop. **/
+    std::span<const Run> cull(const std::array<glm::vec4, 6>& planes, OttModel::SimdPath path = OttModel::simdPath());
+
+    [[nodiscard]] std::span<const Run> visibleRuns() const { return runs; }
+    [[nodiscard]] size_t visibleCount() const { return visible; }
+    [[nodiscard]] size_t totalCount()   const { return batchOf.size(); }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    std::vector<float>    centerX, centerY, centerZ;   // World space, padded to a multiple of BLOCK.
+    std::vector<float>    extentX, extentY, extentZ;
+    std::vector<uint32_t> batchOf;
+    std::vector<uint8_t>  masks;                       // Visible instances of each block, one bit each.
+    std::vector<Run>      runs;
+    size_t                visible = 0;
+};
@@ -0,0 +1,65 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** glTF 2.0 reader for binary (.glb) and JSON (.gltf) files.
+ *
+ *  The file and its external buffers are memory mapped and accessors are read straight out
+ *  of the mapping. A primitive whose attributes are interleaved exactly like
+ *  OttModel::Vertex is copied as one block, and so are 32-bit index accessors; everything
+ *  else goes through a strided conversion. glTF vertices are already unique, so nothing is
+ *  deduplicated.
+ *
+ *  Every primitive is stored once. Each node that references its mesh adds an
+ *  OttModel::modelObject over the same ranges, carrying the node's world transform, so
+ *  repeated meshes are instanced instead of duplicated.
+ *
+ *  Supported: triangle lists, strips and fans; float, normalized integer and integer
+ *  components; base64 data URIs; baseColorTexture images referenced by URI.
+ *  Skipped with a warning: points and lines, sparse accessors, embedded images. **/
+namespace OttGltf
+{
+    struct ImportStats
+    {
+        size_t bytes          = 0;
+        size_t primitives     = 0;
+        size_t instances      = 0;
+        size_t blockCopies    = 0;   // Vertex or index accessors copied without conversion.
+        double seconds        = 0.0;
+    };
+
+    bool Load (
+        const std::filesystem::path& path, OttModel::MeshData& mesh,
+        std::string* warn, std::string* err, ImportStats* stats = nullptr
+    );
+
+    //----------------------------------------------------------------------------
+    /** Parses an in-memory .glb or .gltf document. External URIs are resolved against
+     *  base_dir and must stay valid only for the duration of the call. **/
+    bool Parse (
+        std::string_view data, const std::filesystem::path& base_dir, OttModel::MeshData& mesh,
+        std::string* warn, std::string* err, ImportStats* stats = nullptr
+    );
+
+} // namespace OttGltf
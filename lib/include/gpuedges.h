@@ -0,0 +1,144 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <volk.h>
+
+#include "edges.h"
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Compute shader edge extraction for meshes too large for a quick CPU pass, working on
+ *  geometry already resident on the GPU through buffer device addresses.
+ *
+ *  Every triangle side becomes a 64-bit key of its (min, max) vertex ids, the keys are radix
+ *  sorted four bits per pass, and the first side of every run of equal keys decides whether
+ *  the edge is drawn. A scan of those flags compacts the edges straight into the output.
+ *  Boundary mode gives the same edges, in the same order, as OttModel::extractBoundaryEdges.
+ *  Crease mode first welds the positions by sorting their hashes and then applies the rules
+ *  of OttEdges::extractCreaseEdges; the edges match, their order differs.
+ *
+ *  Only raw Vulkan handles are needed, so the class also runs headless, e.g. under a
+ *  software driver to check the shaders against the CPU kernels. **/
+class OttGpuEdges
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    struct Context
+    {
+        VkDevice         device;
+        VkPhysicalDevice physicalDevice;
+        VkQueue          queue;         // Only used by extract().
+        uint32_t         queueFamily;
+    };
+
+    // One index range to extract edges from. Indices are relative to vertices, a tightly
+    // packed float position stream.
+    struct Job
+    {
+        VkDeviceAddress vertices;
+        VkDeviceAddress indices;
+        uint32_t        vertexCount;    // Vertices the indices reach.
+        uint32_t        indexCount;
+    };
+
+    struct Output
+    {
+        // The edges of every job follow those of the previous ones. Needs room for
+        // maxEdgeBytes() of every job.
+        VkDeviceAddress edges;
+        // jobs + 1 uint32_t, created with TRANSFER_DST and SHADER_DEVICE_ADDRESS usage: the
+        // edge count (pairs) of every job, then the number of position hash collisions.
+        VkBuffer        counts;
+    };
+
+    OttGpuEdges(const Context& context, const std::filesystem::path& shader_dir);
+    ~OttGpuEdges();
+
+    OttGpuEdges(const OttGpuEdges&) = delete;
+    OttGpuEdges& operator=(const OttGpuEdges&) = delete;
+
+    // Every triangle side is drawn at most once.
+    static VkDeviceSize maxEdgeBytes(const uint32_t index_count) { return VkDeviceSize(index_count) * 2 * sizeof(uint32_t); }
+
+    //----------------------------------------------------------------------------
+    /** Records the extraction of every job into command_buffer, after a barrier for earlier
+     *  compute and transfer writes. Boundary edges when creases is empty. Scratch memory is
+     *  owned by this object, so at most one recorded command buffer may be pending. **/
+    void record(VkCommandBuffer command_buffer, std::span<const Job> jobs, const Output& output,
+                const std::optional<OttEdges::CreaseOptions>& creases);
+
+    //----------------------------------------------------------------------------
+    /** Uploads a mesh, runs record() on the context queue and reads the edges back. Blocks
+     *  until the GPU is done; meant for tools and tests. **/
+    std::vector<uint32_t> extract(std::span<const OttModel::Vertex> vertices, std::span<const uint32_t> indices,
+                                  const std::optional<OttEdges::CreaseOptions>& creases);
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    struct Buffer
+    {
+        VkBuffer        buffer  = VK_NULL_HANDLE;
+        VkDeviceMemory  memory  = VK_NULL_HANDLE;
+        VkDeviceSize    size    = 0;
+        VkDeviceAddress address = 0;
+    };
+
+    enum Kernel
+    {
+        Hash,
+        Weld,
+        Sides,
+        Mark,
+        Emit,
+        RadixCount,
+        RadixScatter,
+        Scan,
+        ScanAdd,
+        KERNEL_COUNT
+    };
+
+    Context                               context;
+    VkPipelineLayout                      pipelineLayout = VK_NULL_HANDLE;
+    std::array<VkPipeline, KERNEL_COUNT>  pipelines {};
+    VkCommandPool                         commandPool    = VK_NULL_HANDLE;
+
+    // Scratch, grown to the largest job recorded so far.
+    std::array<Buffer, 2> keys, values;
+    Buffer                radixCounts, scanSums, positionIds, normals, flags;
+    uint32_t              scratchItems = 0;
+
+    Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) const;
+    void   destroyBuffer(Buffer& buffer) const;
+    void   reserveScratch(uint32_t items);
+
+    void dispatch(VkCommandBuffer command_buffer, Kernel kernel, const void* push, uint32_t push_size, uint32_t items) const;
+    void dispatchGroups(VkCommandBuffer command_buffer, Kernel kernel, const void* push, uint32_t push_size, uint32_t groups) const;
+    void scan(VkCommandBuffer command_buffer, VkDeviceAddress values, uint32_t count, VkDeviceAddress total) const;
+    void radixSort(VkCommandBuffer command_buffer, uint32_t count, std::span<const uint32_t> shifts) const;
+}; // class OttGpuEdges
@@ -0,0 +1,68 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <filesystem>
+#include <stop_token>
+#include <string>
+#include <string_view>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Streaming IFC (ISO 10303-21, IFC2x3 and IFC4) reader.
+ *
+ *  The file is memory mapped and the DATA section is split into chunks that are indexed on
+ *  the shared OttThreadPool. The index only keeps the id and file offset of every entity;
+ *  arguments are parsed from the mapping when an entity is actually visited, so memory
+ *  stays close to the size of the output geometry.
+ *
+ *  Every IfcProduct with a body representation becomes one OttModel::modelObject, and its
+ *  GlobalId goes to the matching entry of MeshData::objectIds. Products are tessellated in
+ *  parallel, in world coordinates and metres, with flat normals.
+ *
+ *  Geometry: extruded area solids (rectangle, circle, I-shape and arbitrary profiles, with
+ *  voids), faceted breps, shell and face based surface models, triangulated and polygonal
+ *  face sets, mapped items. Boolean results keep their first operand only, so openings are
+ *  not cut. Openings and spaces are skipped, and so are curved geometry and complex
+ *  entity instances.
+ *
+ *  Chunks start at a line beginning with '#', which assumes no string literal holds a line
+ *  break followed by '#'. **/
+namespace OttIfc
+{
+    struct ImportStats
+    {
+        size_t bytes        = 0;
+        size_t chunks       = 0;
+        size_t entities     = 0;
+        size_t products     = 0;
+        size_t skippedItems = 0;   // Representation items with unsupported geometry.
+        double seconds      = 0.0;
+    };
+
+    bool Load (
+        const std::filesystem::path& path, OttModel::MeshData& mesh,
+        std::string* warn, std::string* err, ImportStats* stats = nullptr, std::stop_token stop = {}
+    );
+
+    bool Parse (
+        std::string_view text, OttModel::MeshData& mesh,
+        std::string* warn, std::string* err, ImportStats* stats = nullptr, std::stop_token stop = {}
+    );
+
+} // namespace OttIfc
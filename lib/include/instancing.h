@@ -0,0 +1,61 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Automatic instancing: finds objects whose geometry is a rigidly moved copy of another
+ *  object's and keeps a single prototype of it.
+ *
+ *  Every distinct geometry is canonicalized: its vertices are renumbered in order of first
+ *  use, moved to their centroid and rotated into a frame anchored on the first vertices
+ *  that are far enough from the centroid. The canonical positions, quantized to the
+ *  tolerance, are hashed together with the topology and the other attributes. Hash matches
+ *  are compared vertex by vertex before they count.
+ *
+ *  A duplicate object then points at the prototype's index and edge ranges, and its
+ *  transform takes over the rigid motion from the prototype to the copy. Geometry that no
+ *  object references anymore is compacted away. Copies must list their vertices and
+ *  triangles in the same order, as exporters write repeated elements. **/
+namespace OttInstancing
+{
+    struct InstancingOptions
+    {
+        float tolerance = 1e-4f;   // Relative to the radius of the geometry.
+    };
+
+    struct InstancingStats
+    {
+        size_t objects        = 0;
+        size_t geometries     = 0;   // Distinct index ranges before the pass.
+        size_t prototypes     = 0;   // Distinct index ranges after it.
+        size_t totalBytes     = 0;   // Vertex, index and edge bytes if every object had its own copy.
+        size_t uniqueBytes    = 0;   // The same bytes actually stored.
+        double seconds        = 0.0;
+
+        [[nodiscard]] double ratio() const { return uniqueBytes > 0 ? static_cast<double>(totalBytes) / static_cast<double>(uniqueBytes) : 1.0; }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Instances repeated geometry of mesh in place. Canonical forms are computed in
+     *  parallel on the shared OttThreadPool. **/
+    InstancingStats instance(OttModel::MeshData& mesh, const InstancingOptions& options = {});
+
+} // namespace OttInstancing
@@ -0,0 +1,149 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <stop_token>
+
+#include "bvh.h"
+#include "cleanup.h"
+#include "edges.h"
+#include "instancing.h"
+#include "meshlets.h"
+#include "model.h"
+#include "normals.h"
+#include "optimize.h"
+#include "simplify.h"
+#include "task.h"
+#include "topology.h"
+#include "weld.h"
+
+//----------------------------------------------------------------------------
+/** CPU side of model loading: turns a file on disk into an OttModel::MeshData.
+ *  Nothing in here touches Vulkan, so it can run on any thread. **/
+namespace OttLoader
+{
+    struct LoadOptions
+    {
+        // Tolerance weld after exact deduplication; disabled when empty.
+        std::optional<OttWeld::WeldOptions> weld;
+        // Removes collapsed, zero-area and duplicate triangles before edges are extracted; disabled when empty.
+        std::optional<OttCleanup::CleanupOptions> cleanup;
+        // Generates normals for OBJ files without vn records; their normals stay zero when empty.
+        std::optional<OttNormals::NormalOptions> normals;
+        // Replaces repeated geometry by transformed instances of one prototype; disabled when empty.
+        std::optional<OttInstancing::InstancingOptions> instancing;
+        // Draws crease lines instead of the topological boundary; boundary edges when empty.
+        std::optional<OttEdges::CreaseOptions> creases;
+        // Index ranges with more triangles are left without edges, for OttGpuEdges to fill
+        // in after the upload; 0 extracts everything on the CPU.
+        uint32_t gpuEdgesAbove = 0;
+        // Appends simplified index ranges to every large object for distant drawing; disabled when empty.
+        std::optional<OttSimplify::LodOptions> lods;
+        // Reorders triangles and vertices for the vertex cache, overdraw and fetch; disabled when empty.
+        std::optional<OttOptimize::OptimizeOptions> optimize;
+        // Splits large objects into meshlets for GPU culling; disabled when empty.
+        std::optional<OttMeshlets::MeshletOptions> meshlets;
+        // Keeps the side adjacency of every object's range in MeshData::links for topology
+        // queries. Built after the cache is read or written and not part of the fingerprint.
+        bool adjacency = false;
+        // Builds the object and triangle trees of MeshData::bvh for picking and raycasts.
+        // Built after the cache is read or written and not part of the fingerprint.
+        bool bvh = false;
+
+        [[nodiscard]] uint64_t fingerprint() const;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Written by the loading thread, read by the UI. fraction is a coarse estimate that
+     *  advances as each stage completes. **/
+    struct LoadProgress
+    {
+        enum class Stage : uint8_t
+        {
+            Queued,
+            Parsing,
+            Deduplicating,
+            Welding,
+            Cleaning,
+            Normals,
+            Edges,
+            Instancing,
+            Simplifying,
+            Optimizing,
+            Clustering,
+            Adjacency,
+            Hierarchy,
+            Uploading,
+            Done,
+            Cancelled,
+            Failed,
+        };
+
+        std::atomic<Stage> stage    { Stage::Queued };
+        std::atomic<float> fraction { 0.0f };
+
+        void report(const Stage next, const float done)
+        {
+            stage.store(next, std::memory_order_relaxed);
+            fraction.store(done, std::memory_order_relaxed);
+        }
+    };
+
+    const char* stageName(LoadProgress::Stage stage);
+
+    //----------------------------------------------------------------------------
+    /** Parses a Wavefront file, deduplicates its vertices and extracts its edges.
+     *  A stop request is honoured between stages and makes the load return false. **/
+    bool loadObj(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options = {},
+                 std::stop_token stop = {}, LoadProgress* progress = nullptr);
+
+    //----------------------------------------------------------------------------
+    /** Reads a glTF 2.0 (.gltf/.glb) file and extracts the edges of each distinct primitive.
+     *  The vertices are taken as they are: no deduplication and no welding, since instanced
+     *  primitives share their ranges and glTF exporters already pack the data. **/
+    bool loadGltf(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options = {},
+                  std::stop_token stop = {}, LoadProgress* progress = nullptr);
+
+    //----------------------------------------------------------------------------
+    /** Reads an IFC (.ifc) file: one object per building element, tagged with its GlobalId
+     *  in MeshData::objectIds, and the edges of each. The stop token is checked while
+     *  products are tessellated. **/
+    bool loadIfc(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options = {},
+                 std::stop_token stop = {}, LoadProgress* progress = nullptr);
+
+    //----------------------------------------------------------------------------
+    /** Returns the cached mesh when the .ottmesh entry is still valid, otherwise loads the
+     *  source (OBJ, glTF or IFC, by extension), instances its repeated geometry when
+     *  options.instancing is set, builds the LOD chains when options.lods is set, orders
+     *  the buffers for the GPU when options.optimize is set, splits meshlets when
+     *  options.meshlets is set and refreshes the cache. Either way mesh.bounds is computed
+     *  afresh, mesh.links when options.adjacency is set and mesh.bvh when options.bvh is
+     *  set; none of them is cached. **/
+    bool loadMesh(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options = {},
+                  std::stop_token stop = {}, LoadProgress* progress = nullptr);
+
+    //----------------------------------------------------------------------------
+    /** loadMesh on a worker of the shared pool. The awaiting coroutine resumes on that
+     *  worker; empty result on failure or cancellation. **/
+    OttTask<std::optional<OttModel::MeshData>> loadMeshAsync(std::filesystem::path modelPath, LoadOptions options,
+                                                             std::stop_token stop = {}, LoadProgress* progress = nullptr);
+
+} // namespace OttLoader
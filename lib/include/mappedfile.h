@@ -0,0 +1,61 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+//----------------------------------------------------------------------------
+/** Read-only memory mapping of a whole file (mmap on POSIX, MapViewOfFile on Windows).
+ *  The mapping lives as long as the object, so views handed out by data()/view()
+ *  must not outlive it. A failed open leaves the object closed; check isOpen(). **/
+class OttMappedFile
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    OttMappedFile() = default;
+    explicit OttMappedFile(const std::filesystem::path& path);
+    ~OttMappedFile();
+
+    OttMappedFile(const OttMappedFile&) = delete;
+    OttMappedFile& operator=(const OttMappedFile&) = delete;
+    OttMappedFile(OttMappedFile&& other) noexcept;
+    OttMappedFile& operator=(OttMappedFile&& other) noexcept;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    [[nodiscard]] bool             isOpen() const { return opened; }
+    [[nodiscard]] const char*      data()   const { return mappedData; }
+    [[nodiscard]] size_t           size()   const { return mappedSize; }
+    [[nodiscard]] std::string_view view()   const { return { mappedData, mappedSize }; }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    const char* mappedData = nullptr;
+    size_t      mappedSize = 0;
+    bool        opened     = false;
+#ifdef _WIN32
+    void*       fileHandle    = nullptr;
+    void*       mappingHandle = nullptr;
+#endif
+}; // class OttMappedFile
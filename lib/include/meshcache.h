@@ -0,0 +1,53 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Binary cache (.ottmesh) of fully processed meshes, so reopening a model skips parsing,
+ *  vertex deduplication and edge extraction. Entries live in the user's temp directory,
+ *  named after a hash of the absolute source path.
+ *
+ *  An entry is valid when the source size and mtime match the header. If only the mtime
+ *  changed (copies, checkouts, touch) the source content hash decides, and a matching entry
+ *  is kept. Any layout change to OttModel::Vertex or the file format must bump
+ *  CACHE_VERSION.
+ *
+ *  variant identifies the load options that shaped the mesh (welding and so on), so the
+ *  same source processed differently gets its own entry. **/
+namespace OttMeshCache
+{
+    constexpr uint32_t CACHE_VERSION = 9;
+
+    std::filesystem::path cacheDirectory();
+    std::filesystem::path cachePathFor(const std::filesystem::path& source, uint64_t variant = 0);
+
+    //----------------------------------------------------------------------------
+    /** Maps the cache entry of source and copies it into mesh.
+     *  Returns false on a miss, a stale entry or a corrupt file. **/
+    bool read(const std::filesystem::path& source, OttModel::MeshData& mesh, uint64_t variant = 0);
+
+    //----------------------------------------------------------------------------
+    /** Writes mesh as the cache entry of source. The file is written under a temporary
+     *  name and renamed into place, so concurrent readers never see a partial entry. **/
+    bool write(const std::filesystem::path& source, const OttModel::MeshData& mesh, uint64_t variant = 0);
+
+} // namespace OttMeshCache
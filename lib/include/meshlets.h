@@ -0,0 +1,76 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Splits large index ranges into meshlets (clusters) the GPU can cull one by one, for
+ *  the single huge objects (terrain, façades, scans) where culling whole objects does
+ *  nothing.
+ *
+ *  Clusters grow greedily over shared vertices: each step adds the adjacent triangle that
+ *  brings the fewest new vertices, until the vertex or triangle limit is reached. The
+ *  triangles of the range are reordered so every cluster is contiguous in the index
+ *  buffer; the range as a whole draws the same triangles as before.
+ *
+ *  Backface cones are only kept for ranges that are closed and consistently wound, since
+ *  the pipelines draw both sides and only there the back of a face is never seen. **/
+namespace OttMeshlets
+{
+    struct MeshletOptions
+    {
+        uint32_t maxVertices  = 64;
+        uint32_t maxTriangles = 124;
+        uint32_t minTriangles = 4096;   // Smaller index ranges are drawn whole.
+    };
+
+    struct MeshletStats
+    {
+        size_t ranges    = 0;   // Distinct index ranges that were split.
+        size_t meshlets  = 0;
+        size_t triangles = 0;   // Triangles of those ranges.
+        size_t coned     = 0;   // Meshlets with a backface cone.
+        double seconds   = 0.0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Clusters the triangles of indices, reordering them in place, and returns the
+     *  meshlets with startIndex relative to the start of indices. closed enables the
+     *  backface cones. **/
+    std::vector<OttModel::Meshlet> buildMeshlets(std::span<const OttModel::Vertex> vertices, std::span<uint32_t> indices,
+                                                 bool closed, const MeshletOptions& options = {});
+
+    //----------------------------------------------------------------------------
+    /** True when every side of the triangles, on welded positions, is shared by exactly
+     *  one other triangle running it the opposite way and the enclosed volume is positive,
+     *  i.e. the faces wind counter-clockwise seen from outside. **/
+    bool isClosed(std::span<const OttModel::Vertex> vertices, std::span<const uint32_t> indices);
+
+    //----------------------------------------------------------------------------
+    /** Splits every distinct index range of at least options.minTriangles triangles, in
+     *  parallel on the shared OttThreadPool, and fills mesh.meshlets and the meshlet range
+     *  of every object. Objects sharing a range (instances) share its meshlets. The
+     *  triangles inside each meshlet are ordered for the vertex cache. **/
+    MeshletStats build(OttModel::MeshData& mesh, const MeshletOptions& options = {});
+
+} // namespace OttMeshlets
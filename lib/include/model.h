@@ -24,9 +24,16 @@
 #include <glm/gtx/hash.hpp>
 
 #include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
 #include <vector>
 #include <volk.h>
 
+#include "bvh.h"
+
 namespace OttModel
 {
     //----------------------------------------------------------------------------
@@ -37,13 +44,21 @@ namespace OttModel
         glm::vec2 texCoord;
         glm::vec3 normal;
 
-        constexpr static auto getBindingDescription() -> VkVertexInputBindingDescription
+        // Binding 0 holds the positions, binding 1 the rest, see positionStride.
+        constexpr static auto getBindingDescriptions() -> std::array<VkVertexInputBindingDescription, 2>
         {
             return
             {
-                .binding   = 0,
-                .stride    = sizeof(Vertex),
-                .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+                VkVertexInputBindingDescription {
+                    .binding   = 0,
+                    .stride    = sizeof(pos),
+                    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+                },
+                VkVertexInputBindingDescription {
+                    .binding   = 1,
+                    .stride    = sizeof(Vertex) - sizeof(pos),
+                    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+                }
             };
         }
     
@@ -54,35 +69,192 @@ namespace OttModel
                     .location = 0,
                     .binding  = 0,
                     .format   = VK_FORMAT_R32G32B32_SFLOAT,
-                    .offset   = offsetof(Vertex, pos)
+                    .offset   = 0
                 },
 
                 VkVertexInputAttributeDescription {
                     .location = 1,
-                    .binding  = 0,
+                    .binding  = 1,
                     .format   = VK_FORMAT_R32G32B32_SFLOAT,
-                    .offset   = offsetof(Vertex, color)
+                    .offset   = offsetof(Vertex, color) - sizeof(pos)
                 },
                 
                 VkVertexInputAttributeDescription {
                     .location = 2,
-                    .binding  = 0,
+                    .binding  = 1,
                     .format   = VK_FORMAT_R32G32_SFLOAT,
-                    .offset   = offsetof(Vertex, texCoord)
+                    .offset   = offsetof(Vertex, texCoord) - sizeof(pos)
                 },
                 
                 VkVertexInputAttributeDescription {
                     .location = 3,
-                    .binding  = 0,
+                    .binding  = 1,
                     .format   = VK_FORMAT_R32G32B32_SFLOAT,
-                    .offset   = offsetof(Vertex, normal)
+                    .offset   = offsetof(Vertex, normal) - sizeof(pos)
                 }
             };
             return attributeDescriptions;
         }
         bool operator==(const Vertex& other) const = default;
     };
-    std::vector<uint32_t> extractBoundaryEdges(std::vector<uint32_t>& indices);
+
+    //----------------------------------------------------------------------------
+    /** Layout of the scene vertex buffer, chosen per scene. Packed vertices take 20 bytes
+     *  instead of 44: positions as 16-bit fractions of their vertex range's bounding box,
+     *  octahedral normals in two 16-bit values, half float texture coordinates and 8-bit
+     *  color. object.vert decodes them when its PACKED_VERTICES constant is set. **/
+    enum class VertexFormat : uint8_t
+    {
+        Float,
+        Packed,
+    };
+
+    //----------------------------------------------------------------------------
+    struct PackedVertex
+    {
+        std::array<uint16_t, 4> pos;        // Fractions of the object's quantization box; w unused.
+        std::array<int16_t, 2>  normal;     // Octahedral.
+        std::array<uint16_t, 2> texCoord;   // Half floats.
+        std::array<uint8_t, 4>  color;      // Alpha unused.
+
+        constexpr static auto getBindingDescriptions() -> std::array<VkVertexInputBindingDescription, 2>
+        {
+            return
+            {
+                VkVertexInputBindingDescription {
+                    .binding   = 0,
+                    .stride    = sizeof(pos),
+                    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+                },
+                VkVertexInputBindingDescription {
+                    .binding   = 1,
+                    .stride    = sizeof(PackedVertex) - sizeof(pos),
+                    .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+                }
+            };
+        }
+
+        // Same locations as Vertex; the normal reaches the shader as (x, y, 0).
+        constexpr static auto getAttributeDescriptions() -> std::array<VkVertexInputAttributeDescription, 4>
+        {
+            std::array attributeDescriptions = {
+                VkVertexInputAttributeDescription {
+                    .location = 0,
+                    .binding  = 0,
+                    .format   = VK_FORMAT_R16G16B16A16_UNORM,
+                    .offset   = 0
+                },
+
+                VkVertexInputAttributeDescription {
+                    .location = 1,
+                    .binding  = 1,
+                    .format   = VK_FORMAT_R8G8B8A8_UNORM,
+                    .offset   = offsetof(PackedVertex, color) - sizeof(pos)
+                },
+
+                VkVertexInputAttributeDescription {
+                    .location = 2,
+                    .binding  = 1,
+                    .format   = VK_FORMAT_R16G16_SFLOAT,
+                    .offset   = offsetof(PackedVertex, texCoord) - sizeof(pos)
+                },
+
+                VkVertexInputAttributeDescription {
+                    .location = 3,
+                    .binding  = 1,
+                    .format   = VK_FORMAT_R16G16_SNORM,
+                    .offset   = offsetof(PackedVertex, normal) - sizeof(pos)
+                }
+            };
+            return attributeDescriptions;
+        }
+        bool operator==(const PackedVertex& other) const = default;
+    };
+
+    constexpr uint32_t vertexStride(const VertexFormat format)
+    {
+        return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+    }
+
+    //----------------------------------------------------------------------------
+    /** The GPU reads vertices as two streams: the leading position of each vertex in
+     *  binding 0 and its remaining bytes in binding 1. Position only passes (wireframe,
+     *  depth, picking) bind the first binding and attribute description alone. **/
+    constexpr uint32_t positionStride(const VertexFormat format)
+    {
+        return format == VertexFormat::Packed ? sizeof(PackedVertex::pos) : sizeof(Vertex::pos);
+    }
+
+    constexpr uint32_t attributeStride(const VertexFormat format)
+    {
+        return vertexStride(format) - positionStride(format);
+    }
+
+    //----------------------------------------------------------------------------
+    /** Packs a vertex whose position lies in the box from offset spanning scale. **/
+    PackedVertex packVertex(const Vertex& vertex, const glm::vec3& offset, const glm::vec3& scale);
+
+    //----------------------------------------------------------------------------
+    /** What object.vert decodes from a packed vertex. **/
+    Vertex unpackVertex(const PackedVertex& packed, const glm::vec3& offset, const glm::vec3& scale);
+
+    //----------------------------------------------------------------------------
+    /** Boundary edges (pairs of vertex indices) of the triangles in indices, sorted by
+     *  (min, max). Large ranges are sorted in parallel on the shared OttThreadPool. **/
+    std::vector<uint32_t> extractBoundaryEdges(std::span<const uint32_t> indices);
+
+    //----------------------------------------------------------------------------
+    /** 64-bit hash over every attribute of the vertex, consistent with operator==.
+     *  Each float is folded in with a multiply-xorshift round, so vertices that only differ
+     *  in their normal (flat shaded CAD geometry) still spread over the whole range.
+     *  Adding 0.0f turns -0.0f into +0.0f, since the two compare equal. **/
+    inline uint64_t hashVertex(const Vertex& vertex)
+    {
+        const float attributes[] = {
+            vertex.pos.x,      vertex.pos.y,      vertex.pos.z,
+            vertex.color.x,    vertex.color.y,    vertex.color.z,
+            vertex.texCoord.x, vertex.texCoord.y,
+            vertex.normal.x,   vertex.normal.y,   vertex.normal.z,
+        };
+        uint64_t hash = 0x9E3779B97F4A7C15ULL;
+        for (const float attribute : attributes)
+        {
+            hash ^= std::bit_cast<uint32_t>(attribute + 0.0f);
+            hash *= 0xBF58476D1CE4E5B9ULL;
+            hash ^= hash >> 29;
+        }
+        hash ^= hash >> 32;
+        hash *= 0x94D049BB133111EBULL;
+        hash ^= hash >> 29;
+        return hash;
+    }
+
+    //----------------------------------------------------------------------------
+    /** A simplified version of an object's index range. Its indices address the same
+     *  vertices, relative to startVertex like the full range. **/
+    struct LodRange
+    {
+        uint32_t startIndex;
+        uint32_t indexCount;
+        float    error;   // Largest deviation from the full geometry, relative to the bounding radius.
+    };
+
+    // Simplified levels an object can have besides its full index range.
+    constexpr uint32_t MAX_LODS = 3;
+    // firstLink of objects without adjacency.
+    constexpr uint32_t NO_LINKS = UINT32_MAX;
+
+    //----------------------------------------------------------------------------
+    /** A cluster of up to 124 neighbouring triangles of an object's full index range, with
+     *  the bounds the GPU culls it by. cone holds the mean face normal and the sine of the
+     *  cone's half angle; a zero axis marks clusters that can't be backface culled. **/
+    struct Meshlet
+    {
+        glm::vec4 boundingSphere;   // Center and radius, before transform.
+        glm::vec4 cone;
+        uint32_t  startIndex;       // In MeshData::indices, inside the object's range.
+        uint32_t  indexCount;
+    };
 
     //----------------------------------------------------------------------------
     struct modelObject
@@ -95,9 +267,142 @@ namespace OttModel
         uint32_t  textureID;
         glm::vec3 pushColorID;
         glm::vec3 offset{0.0f, 0.0f, 0.0f};
+        glm::mat4 transform{1.0f};
+        std::array<LodRange, MAX_LODS> lods{};    // Coarser levels, finest first.
+        uint32_t  lodCount = 0;
+        glm::vec4 boundingSphere{0.0f};           // Center and radius of the geometry, before transform.
+        uint32_t  firstMeshlet = 0;               // Clusters of the full range, in MeshData::meshlets.
+        uint32_t  meshletCount = 0;
+        glm::vec3 quantOffset{0.0f};              // Packed positions decode to quantOffset + quantScale * fraction.
+        glm::vec3 quantScale{1.0f};
+        bool      shortIndices = false;           // startIndex and lods address MeshData::shortIndices.
+        uint32_t  firstLink    = NO_LINKS;        // Adjacency of the full range in MeshData::links, see OttTopology.
     };
 
-    
+    //----------------------------------------------------------------------------
+    /** Center and half extent of the axis-aligned box around the box from low to high once
+     *  transformed: the transformed center, and the half extent mapped through the
+     *  absolute value of the linear part. **/
+    void transformBox(const glm::mat4& transform, const glm::vec3& low, const glm::vec3& high, glm::vec3& center, glm::vec3& extent);
+
+    //----------------------------------------------------------------------------
+    /** Axis-aligned boxes and bounding spheres of objects, one array per component so
+     *  culling and picking stream through only the columns they test. Boxes and spheres
+     *  are before transform; the scene box holds every box after its transform. Objects
+     *  without vertices get an inverted box and a zero sphere, and leave the scene box as
+     *  it is. **/
+    struct BoundsTable
+    {
+        std::vector<float> minX, minY, minZ;
+        std::vector<float> maxX, maxY, maxZ;
+        std::vector<float> centerX, centerY, centerZ, radius;
+        glm::vec3 sceneLow  { std::numeric_limits<float>::max() };
+        glm::vec3 sceneHigh { std::numeric_limits<float>::lowest() };
+
+        [[nodiscard]] size_t    size()            const { return radius.size(); }
+        [[nodiscard]] bool      empty(size_t i)   const { return minX[i] > maxX[i]; }
+        [[nodiscard]] bool      sceneEmpty()      const { return sceneLow.x > sceneHigh.x; }
+        [[nodiscard]] glm::vec3 low(size_t i)     const { return { minX[i], minY[i], minZ[i] }; }
+        [[nodiscard]] glm::vec3 high(size_t i)    const { return { maxX[i], maxY[i], maxZ[i] }; }
+        [[nodiscard]] glm::vec4 sphere(size_t i)  const { return { centerX[i], centerY[i], centerZ[i], radius[i] }; }
+
+        void clear();
+        void append(const glm::vec3& low, const glm::vec3& high, const glm::vec4& sphere, const glm::mat4& transform = glm::mat4(1.0f));
+    };
+
+    //----------------------------------------------------------------------------
+    /** Fully processed geometry of one source file, ready to be appended to the scene.
+     *  The object ranges are local to this mesh and the index and edge values of an object
+     *  are relative to its startVertex, which the renderer passes as vertexOffset, so the
+     *  buffers can be uploaded as they are. textureID is relative to the first entry of
+     *  materialPaths. objectIds is either empty or holds the stable source identifier
+     *  (an IFC GlobalId, for instance) of each entry in objects. Objects sharing a range
+     *  share its meshlets. **/
+    struct MeshData
+    {
+        std::vector<Vertex>      vertices;
+        std::vector<uint32_t>    indices;
+        std::vector<uint32_t>    edges;
+        std::vector<modelObject> objects;
+        std::vector<Meshlet>     meshlets;
+        std::vector<std::string> materialPaths;
+        std::vector<std::string> objectIds;
+        std::vector<uint16_t>    shortIndices;   // Ranges of objects with shortIndices set, see splitShortIndices.
+        std::vector<uint32_t>    links;          // Side adjacency of object ranges, not cached, see OttTopology::buildMeshAdjacency.
+        BoundsTable              bounds;         // One entry per object, see computeBounds.
+        OttBvh::SceneBvh         bvh;            // Object and range trees, see OttBvh::build. Empty unless asked for.
+    };
+
+    //----------------------------------------------------------------------------
+    /** Instruction sets the bounds kernels can run on, from the least to the most capable. **/
+    enum class SimdPath : uint8_t
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    //----------------------------------------------------------------------------
+    /** The most capable path this CPU runs. AVX2 is picked at run time, since the build
+     *  targets baseline x86-64. **/
+    [[nodiscard]] SimdPath simdPath();
+    [[nodiscard]] const char* simdPathName(SimdPath path);
+
+    //----------------------------------------------------------------------------
+    /** Smallest box holding the positions of vertices, reduced with min/max over four
+     *  lanes (SSE2) or two vertices per register (AVX2). A zero box for no vertices.
+     *  path is capped at simdPath().
+     *
+     *  This kernel and boundingRadius read the interleaved Vertex records in place, one
+     *  unaligned load per position, rather than separate x, y and z columns: a position
+     *  copy for a pass run once per load would cost more than it saves. Only the output,
+     *  BoundsTable, is stored by column. **/
+    void positionBounds(std::span<const Vertex> vertices, glm::vec3& low, glm::vec3& high, SimdPath path = simdPath());
+
+    //----------------------------------------------------------------------------
+    /** Largest distance from center to the position of a vertex. The SIMD paths transpose
+     *  four vertices per 128-bit lane to get their squared distances in one register. **/
+    [[nodiscard]] float boundingRadius(std::span<const Vertex> vertices, const glm::vec3& center, SimdPath path = simdPath());
+
+    //----------------------------------------------------------------------------
+    struct BoundsStats
+    {
+        size_t   objects  = 0;
+        size_t   ranges   = 0;
+        size_t   vertices = 0;
+        SimdPath path     = SimdPath::Scalar;
+        double   seconds  = 0.0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Fills mesh.bounds with the box and sphere of every object's vertex range, which runs
+     *  from its startVertex to the next object's, and the scene box over their transforms.
+     *  The sphere is centered on the box, like the one OttSimplify::buildLods keeps in
+     *  modelObject::boundingSphere, but holds every vertex of the range rather than only
+     *  those the indices reach. Large ranges are reduced in blocks on the shared
+     *  OttThreadPool. **/
+    BoundsStats computeBounds(MeshData& mesh);
+
+    //----------------------------------------------------------------------------
+    /** Sets the quantization box of every object to the bounds of its vertex range, which
+     *  runs from its startVertex to the next object's. Objects sharing a startVertex share
+     *  the box, so their vertices are packed once. **/
+    void quantize(MeshData& mesh);
+
+    //----------------------------------------------------------------------------
+    /** Packs the vertices of a quantized mesh into out, which holds one entry per vertex. **/
+    void packVertices(const MeshData& mesh, std::span<PackedVertex> out);
+
+    // Vertices a range may address, relative to its startVertex, to be drawn with 16-bit indices.
+    constexpr uint32_t SHORT_INDEX_VERTICES = 65536;
+
+    //----------------------------------------------------------------------------
+    /** Moves the index ranges (full and simplified levels) of objects addressing fewer than
+     *  SHORT_INDEX_VERTICES vertices into shortIndices, and sets their shortIndices flag.
+     *  Objects with meshlets, and every object drawing a range one of them needs, stay in
+     *  indices, which is compacted; meshlets follow their ranges. Expects the index ranges
+     *  of different objects to be disjoint or identical, as the loader leaves them. **/
+    void splitShortIndices(MeshData& mesh);
 } // namespace OttModel
 
 //----------------------------------------------------------------------------
@@ -105,8 +410,6 @@ template<> struct std::hash<OttModel::Vertex>
 {
     size_t operator()(OttModel::Vertex const& vertex) const
     {
-        return ((std::hash<glm::vec3>()(vertex.pos) ^
-               ( std::hash<glm::vec3>()(vertex.color)    << 1)) >> 1) ^
-               ( std::hash<glm::vec2>()(vertex.texCoord) << 1);
+        return static_cast<size_t>(OttModel::hashVertex(vertex));
     }
-};
\ No newline at end of file
+};
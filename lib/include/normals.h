@@ -0,0 +1,60 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Vertex normals for meshes that come without them (OBJ files without vn records).
+ *
+ *  Every corner gets the weighted sum of the face normals around its position, counting
+ *  only the faces within the crease angle of its own face. Corners of one vertex that end
+ *  up with different normals split it, so hard edges stay hard while UV seams, which
+ *  already split vertices, stay smooth. Face normals and corner sums run in parallel on
+ *  the shared OttThreadPool. **/
+namespace OttNormals
+{
+    enum class Weighting : uint8_t
+    {
+        Angle,   // By the corner angle: independent of how a surface is triangulated.
+        Area,    // By the face area: large faces dominate.
+    };
+
+    struct NormalOptions
+    {
+        Weighting weighting          = Weighting::Angle;
+        float     creaseAngleDegrees = 30.0f;   // Faces further apart don't smooth each other; 0 is flat, 180 smooth.
+    };
+
+    struct NormalStats
+    {
+        size_t triangles     = 0;
+        size_t splitVertices = 0;   // Vertices added at creases.
+        double seconds       = 0.0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Overwrites the normals of vertices. Vertices split at creases are appended.
+     *  Degenerate triangles don't contribute, so vertices no other triangle touches end up
+     *  with a zero normal, as do unreferenced ones. **/
+    NormalStats generate(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices, const NormalOptions& options = {});
+
+} // namespace OttNormals
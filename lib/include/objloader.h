@@ -0,0 +1,71 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tiny_obj_loader.h"
+
+//----------------------------------------------------------------------------
+/** Parallel Wavefront OBJ reader. The file is memory mapped, split into line-aligned
+ *  chunks and every chunk is tokenized on the shared OttThreadPool. The per-chunk
+ *  v/vt/vn/f streams are then stitched back together in file order.
+ *
+ *  Output goes into the tinyobj structures so it is a drop-in replacement for
+ *  tinyobj::LoadObj with triangulation enabled: negative (relative) indices, `g`/`o`
+ *  groups, `usemtl`, `s` smoothing groups, vertex colors and `mtllib` behave the same.
+ *  Known differences: all `mtllib` statements are read before any `usemtl` is resolved,
+ *  polygons with more than four corners are fan triangulated, and faces referencing
+ *  out-of-range vertices are dropped with a warning instead of being passed through. **/
+namespace OttObj
+{
+    struct ParseStats
+    {
+        size_t bytes   = 0;
+        size_t chunks  = 0;
+        double seconds = 0.0;
+
+        [[nodiscard]] double megabytesPerSecond() const
+        {
+            return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+        }
+    };
+
+    bool LoadObj (
+        tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+        std::string* warn, std::string* err,
+        const std::filesystem::path& filename, const std::filesystem::path& mtl_basedir,
+        ParseStats* stats = nullptr
+    );
+
+    bool ParseObj (
+        std::string_view text,
+        tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+        std::string* warn, std::string* err,
+        const std::filesystem::path& mtl_basedir,
+        ParseStats* stats = nullptr
+    );
+
+    //----------------------------------------------------------------------------
+    /** Parses a decimal floating point number at cursor, skipping leading blanks.
+     *  Advances cursor past the number and returns false if no number was found. **/
+    bool parseFloat(const char*& cursor, const char* end, float& value);
+
+} // namespace OttObj
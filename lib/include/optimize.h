@@ -0,0 +1,99 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Reorders index buffers for the GPU's vertex pipeline, after loading:
+ *
+ *  - triangles for the post-transform vertex cache, with Forsyth's scoring of an LRU
+ *    cache, so neighbouring triangles reuse the vertices just shaded;
+ *  - patches of that order for overdraw, outward facing ones first, where splitting the
+ *    order costs little cache efficiency (as in Tipsify);
+ *  - vertices in order of first use, so vertex fetch reads memory front to back.
+ *
+ *  The triangles drawn and their winding stay the same. Efficiency is reported as ACMR
+ *  (vertex shader invocations per triangle) and ATVR (invocations per distinct vertex,
+ *  1.0 being ideal) under a FIFO cache, comparable to the vertex shader invocations a
+ *  pipeline statistics query counts. **/
+namespace OttOptimize
+{
+    struct OptimizeOptions
+    {
+        uint32_t cacheSize         = 16;      // FIFO entries the ACMR and ATVR are measured with.
+        float    overdrawThreshold = 1.05f;   // ACMR the overdraw order may cost, as a factor; 0 keeps the cache order.
+        bool     fetch             = true;    // Renumbers vertices in order of first use.
+    };
+
+    struct CacheStats
+    {
+        size_t triangles = 0;
+        size_t vertices  = 0;   // Distinct vertices referenced.
+        size_t misses    = 0;   // Vertex shader invocations.
+
+        [[nodiscard]] double acmr() const { return triangles ? static_cast<double>(misses) / static_cast<double>(triangles) : 0.0; }
+        [[nodiscard]] double atvr() const { return vertices ? static_cast<double>(misses) / static_cast<double>(vertices) : 0.0; }
+
+        CacheStats& operator+=(const CacheStats& other)
+        {
+            triangles += other.triangles;
+            vertices  += other.vertices;
+            misses    += other.misses;
+            return *this;
+        }
+    };
+
+    struct OptimizeStats
+    {
+        size_t     ranges   = 0;   // Distinct index ranges reordered, LOD levels included.
+        size_t     remapped = 0;   // Vertices that moved for fetch locality.
+        CacheStats before;
+        CacheStats after;
+        double     seconds  = 0.0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Simulates a FIFO post-transform cache of cache_size entries over indices. **/
+    CacheStats analyzeCache(std::span<const uint32_t> indices, uint32_t cache_size = 16);
+
+    //----------------------------------------------------------------------------
+    /** Reorders the triangles of indices in place for the vertex cache. **/
+    void optimizeVertexCache(std::span<uint32_t> indices);
+
+    //----------------------------------------------------------------------------
+    /** Reorders patches of a cache optimized index order so those on the outside, facing
+     *  away from the center of the range, are drawn first and the depth test rejects what
+     *  they hide.
+     *  A patch is split off where its ACMR, on an empty cache, is within threshold times
+     *  that of the run it came from. **/
+    void optimizeOverdraw(std::span<const OttModel::Vertex> vertices, std::span<uint32_t> indices, float threshold,
+                          uint32_t cache_size = 16);
+
+    //----------------------------------------------------------------------------
+    /** Reorders every distinct index range (full and LOD levels) of mesh for the vertex
+     *  cache and overdraw, in parallel on the shared OttThreadPool, then renumbers the
+     *  vertices of each object's vertex range in order of first use, rewriting its indices
+     *  and edges. Vertex ranges that objects don't own alone are left in place. **/
+    OptimizeStats optimize(OttModel::MeshData& mesh, const OptimizeOptions& options = {});
+
+} // namespace OttOptimize
@@ -31,6 +31,8 @@ struct PushConstantData {
     alignas(16) glm::vec3 offset;
     alignas(16) glm::vec3 color;
     alignas(4)  uint32_t  textureID;
+    alignas(16) glm::vec3 quantOffset;      // Quantization box of packed vertices, see OttModel::VertexFormat.
+    alignas(16) glm::vec3 quantScale;
 };
 
 /** Wrapper that will act as a boilerplate to create multiple graphics pipelines.
@@ -78,7 +80,8 @@ public:
     void createGraphicsPipeline (
         std::string vertex_shader_path, std::string fragment_shader_path,
         VkPipeline& pipeline, VkPipelineVertexInputStateCreateInfo vertex_input_info,
-        VkPolygonMode polygon_mode, VkPrimitiveTopology topology_mode
+        VkPolygonMode polygon_mode, VkPrimitiveTopology topology_mode,
+        const VkSpecializationInfo* vertex_specialization = nullptr
     );
     
 //----------------------------------------------------------------------------
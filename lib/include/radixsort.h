@@ -0,0 +1,92 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "threadpool.h"
+
+//----------------------------------------------------------------------------
+/** Parallel radix sort shared by the edge extraction kernels. **/
+namespace OttRadix
+{
+    constexpr size_t BLOCK_SIZE = 1 << 16;
+    constexpr int    DIGIT_BITS = 8;
+    constexpr size_t DIGITS     = size_t(1) << DIGIT_BITS;
+
+    //----------------------------------------------------------------------------
+    /** Stable LSD sort of items by key(item), a uint64_t below 2^bits, one byte per pass.
+     *  Every block of items builds its own histogram, so both the counting and the scatter
+     *  run in parallel on the shared OttThreadPool. Passes in which every key has the same
+     *  digit are skipped. Inputs of a single block are sorted with std::ranges::stable_sort. **/
+    template<typename T, typename Key>
+    void sort(std::vector<T>& items, const int bits, Key key)
+    {
+        const size_t count  = items.size();
+        const size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (blocks <= 1)
+        {
+            std::ranges::stable_sort(items, {}, key);
+            return;
+        }
+
+        std::vector<T>      scratch(count);
+        std::vector<size_t> offsets(blocks * DIGITS);
+        for (int shift = 0; shift < bits; shift += DIGIT_BITS)
+        {
+            std::ranges::fill(offsets, 0);
+            OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+            {
+                size_t* histogram = offsets.data() + block * DIGITS;
+                const size_t last = std::min(count, (block + 1) * BLOCK_SIZE);
+                for (size_t i = block * BLOCK_SIZE; i < last; i++)
+                    histogram[(key(items[i]) >> shift) & (DIGITS - 1)]++;
+            });
+
+            // Digit-major prefix sum: all of digit 0 from every block, then digit 1, ...
+            size_t total   = 0;
+            bool   trivial = false;
+            for (size_t digit = 0; digit < DIGITS; digit++)
+            {
+                size_t digitCount = 0;
+                for (size_t block = 0; block < blocks; block++)
+                {
+                    const size_t n = offsets[block * DIGITS + digit];
+                    offsets[block * DIGITS + digit] = total;
+                    total      += n;
+                    digitCount += n;
+                }
+                trivial |= digitCount == count;
+            }
+            if (trivial)
+                continue;
+
+            OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+            {
+                size_t* next = offsets.data() + block * DIGITS;
+                const size_t last = std::min(count, (block + 1) * BLOCK_SIZE);
+                for (size_t i = block * BLOCK_SIZE; i < last; i++)
+                    scratch[next[(key(items[i]) >> shift) & (DIGITS - 1)]++] = items[i];
+            });
+            items.swap(scratch);
+        }
+    }
+
+} // namespace OttRadix
@@ -0,0 +1,71 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Level of detail generation with quadric error metrics (Garland & Heckbert).
+ *
+ *  Edges collapse onto one of their end points, so a simplified level is just another
+ *  index list over the vertices of the full one. Errors are measured on position-welded
+ *  vertices. A vertex on an open boundary only slides along that boundary, and a vertex on
+ *  an attribute seam (split UVs or normals) only along the seam, all of its copies
+ *  together. Vertices where boundaries or seams meet, end or turn non-manifold never move,
+ *  so boundaries and seams keep their attributes and, within the error bound, their shape. **/
+namespace OttSimplify
+{
+    struct LodOptions
+    {
+        uint32_t levels       = 3;       // Simplified levels after the full one, at most OttModel::MAX_LODS.
+        float    ratio        = 0.25f;   // Target fraction of the previous level's triangles.
+        uint32_t minTriangles = 1024;    // Smaller index ranges keep their full level only.
+        float    maxError     = 0.05f;   // Largest deviation of any level, relative to the bounding radius.
+    };
+
+    struct LodStats
+    {
+        size_t ranges        = 0;   // Distinct index ranges that received levels.
+        size_t levels        = 0;
+        size_t fullTriangles = 0;   // Triangles of those ranges at full detail.
+        size_t lodTriangles  = 0;   // Triangles of all their levels together.
+        double seconds       = 0.0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Collapses edges of the triangles in indices, cheapest first, until at most
+     *  target_index_count indices are left or the next collapse would deviate more than
+     *  target_error (in model units). result_error receives the largest deviation made. **/
+    std::vector<uint32_t> simplify(std::span<const OttModel::Vertex> vertices, std::span<const uint32_t> indices,
+                                   size_t target_index_count, float target_error, float* result_error = nullptr);
+
+    //----------------------------------------------------------------------------
+    /** Center and radius of a sphere around the vertices the indices reach. **/
+    glm::vec4 boundingSphere(std::span<const OttModel::Vertex> vertices, std::span<const uint32_t> indices);
+
+    //----------------------------------------------------------------------------
+    /** Sets the bounding sphere of every object and appends a chain of simplified levels for
+     *  every distinct index range to mesh.indices. Objects sharing a range (instances) share
+     *  its levels. Ranges are simplified in parallel on the shared OttThreadPool. **/
+    LodStats buildLods(OttModel::MeshData& mesh, const LodOptions& options = {});
+
+} // namespace OttSimplify
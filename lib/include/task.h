@@ -0,0 +1,333 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "logger.h"
+#include "threadpool.h"
+
+//----------------------------------------------------------------------------
+/** Small coroutine toolkit used by the asset pipeline.
+ *  - OttTask<T>: lazy coroutine; starts when awaited and resumes the awaiter on whatever
+ *    thread it finishes on.
+ *  - OttAsync::resumeOn(pool): continues the current coroutine on a pool worker.
+ *  - OttMainThreadQueue::schedule(): continues it on the thread that calls drain(),
+ *    which for the application is the main loop, between two frames.
+ *  - OttAsync::whenAll(tasks): runs several tasks at once and waits for all of them.
+ *  - OttAsync::spawn(task): starts a task without awaiting it. **/
+template<typename T = void>
+class OttTask;
+
+namespace OttAsync::detail
+{
+    //----------------------------------------------------------------------------
+    /** Hands control back to the awaiting coroutine (symmetric transfer), or to nobody. **/
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            const std::coroutine_handle<> continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    struct PromiseBase
+    {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr      error;
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter        final_suspend()   const noexcept { return {}; }
+        void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    template<typename T>
+    struct Promise : PromiseBase
+    {
+        std::optional<T> value;
+
+        OttTask<T> get_return_object();
+        void return_value(T result) { value.emplace(std::move(result)); }
+
+        T take()
+        {
+            if (error)
+                std::rethrow_exception(error);
+            return std::move(*value);
+        }
+    };
+
+    template<>
+    struct Promise<void> : PromiseBase
+    {
+        OttTask<void> get_return_object();
+        void return_void() const noexcept {}
+
+        void take() const
+        {
+            if (error)
+                std::rethrow_exception(error);
+        }
+    };
+} // namespace OttAsync::detail
+
+//----------------------------------------------------------------------------
+template<typename T>
+class OttTask
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    using promise_type = OttAsync::detail::Promise<T>;
+
+    explicit OttTask(std::coroutine_handle<promise_type> handle) : coroutine(handle) {}
+    OttTask(OttTask&& other) noexcept : coroutine(std::exchange(other.coroutine, {})) {}
+    OttTask& operator=(OttTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (coroutine)
+                coroutine.destroy();
+            coroutine = std::exchange(other.coroutine, {});
+        }
+        return *this;
+    }
+    OttTask(const OttTask&) = delete;
+    OttTask& operator=(const OttTask&) = delete;
+    ~OttTask()
+    {
+        if (coroutine)
+            coroutine.destroy();
+    }
+
+    //----------------------------------------------------------------------------
+    /** Starts the task and suspends the caller until it finishes. Exceptions thrown by the
+     *  task are rethrown at the co_await. **/
+    auto operator co_await() && noexcept
+    {
+        struct Awaiter
+        {
+            std::coroutine_handle<promise_type> coroutine;
+
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                coroutine.promise().continuation = awaiting;
+                return coroutine;
+            }
+            T await_resume() { return coroutine.promise().take(); }
+        };
+        return Awaiter { coroutine };
+    }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    std::coroutine_handle<promise_type> coroutine;
+}; // class OttTask
+
+template<typename T>
+OttTask<T> OttAsync::detail::Promise<T>::get_return_object()
+{
+    return OttTask<T>(std::coroutine_handle<Promise>::from_promise(*this));
+}
+
+inline OttTask<void> OttAsync::detail::Promise<void>::get_return_object()
+{
+    return OttTask<void>(std::coroutine_handle<Promise>::from_promise(*this));
+}
+
+//----------------------------------------------------------------------------
+/** Coroutine resumptions posted from any thread and run by the owner thread in drain().
+ *  The application drains it once per frame, before recording, so work resumed through
+ *  schedule() sees the scene between two frames. **/
+class OttMainThreadQueue
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    void post(std::function<void()> work)
+    {
+        std::lock_guard lock(queueMutex);
+        queued.push_back(std::move(work));
+    }
+
+    //----------------------------------------------------------------------------
+    /** Runs everything posted so far. Work posted while draining waits for the next call,
+     *  so a coroutine that reschedules itself cannot stall the frame. **/
+    void drain()
+    {
+        std::vector<std::function<void()>> work;
+        {
+            std::lock_guard lock(queueMutex);
+            work.swap(queued);
+        }
+        for (auto& item : work)
+            item();
+    }
+
+    auto schedule()
+    {
+        struct Awaiter
+        {
+            OttMainThreadQueue* queue;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) const { queue->post([handle]() { handle.resume(); }); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter { this };
+    }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    std::mutex                         queueMutex;
+    std::vector<std::function<void()>> queued;
+}; // class OttMainThreadQueue
+
+namespace OttAsync
+{
+    //----------------------------------------------------------------------------
+    inline auto resumeOn(OttThreadPool& pool)
+    {
+        struct Awaiter
+        {
+            OttThreadPool* pool;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) const { pool->submit([handle]() { handle.resume(); }); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter { &pool };
+    }
+
+    //----------------------------------------------------------------------------
+    /** Frame of a spawned task; it owns itself and is freed when the task finishes. **/
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend()   const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    namespace detail
+    {
+        template<typename T>
+        struct WhenAllState
+        {
+            std::atomic<size_t>           remaining;
+            std::coroutine_handle<>       parent;
+            std::vector<std::optional<T>> results;
+            std::exception_ptr            error;
+            std::mutex                    errorMutex;
+        };
+
+        //----------------------------------------------------------------------------
+        template<typename T>
+        Detached runChild(OttTask<T> task, WhenAllState<T>& state, const size_t slot)
+        {
+            try
+            {
+                state.results[slot].emplace(co_await std::move(task));
+            }
+            catch (...)
+            {
+                std::lock_guard lock(state.errorMutex);
+                if (!state.error)
+                    state.error = std::current_exception();
+            }
+            if (state.remaining.fetch_sub(1) == 1)
+                state.parent.resume();
+        }
+    } // namespace detail
+
+    //----------------------------------------------------------------------------
+    /** Starts every task, then resumes the caller on the thread that finished last with the
+     *  results in input order. Tasks run concurrently only if they move themselves to the
+     *  pool; the first exception is rethrown once all of them are done. **/
+    template<typename T>
+    OttTask<std::vector<T>> whenAll(std::vector<OttTask<T>> tasks)
+    {
+        detail::WhenAllState<T> state;
+        state.results.resize(tasks.size());
+
+        // One extra count for the starter, so the caller cannot be resumed before it suspended.
+        struct Awaiter
+        {
+            detail::WhenAllState<T>& state;
+            std::vector<OttTask<T>>& tasks;
+
+            bool await_ready() const noexcept { return tasks.empty(); }
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                state.remaining = tasks.size() + 1;
+                state.parent    = handle;
+                for (size_t i = 0; i < tasks.size(); i++)
+                    detail::runChild(std::move(tasks[i]), state, i);
+                return state.remaining.fetch_sub(1) != 1;
+            }
+            void await_resume() const noexcept {}
+        };
+        co_await Awaiter { state, tasks };
+
+        if (state.error)
+            std::rethrow_exception(state.error);
+        std::vector<T> results;
+        results.reserve(state.results.size());
+        for (std::optional<T>& result : state.results)
+            results.push_back(std::move(*result));
+        co_return results;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Runs task to completion without an awaiter. It starts on the calling thread and runs
+     *  until its first suspension. Exceptions that escape the task are logged. **/
+    inline Detached spawn(OttTask<void> task)
+    {
+        try
+        {
+            co_await std::move(task);
+        }
+        catch (const std::exception& e)
+        {
+            log_t<error>("Asynchronous task failed: {}", e.what());
+        }
+    }
+} // namespace OttAsync
@@ -0,0 +1,126 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+/** Fixed-size pool of worker threads shared by the geometry loading kernels.
+ *  Tasks are plain std::function objects executed in FIFO order.
+ *  parallelFor() lets the calling thread take part in the work, so it is safe to
+ *  call it from inside another pool task without starving the pool. **/
+class OttThreadPool
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    explicit OttThreadPool(unsigned thread_count);
+    ~OttThreadPool();
+
+    OttThreadPool(const OttThreadPool&) = delete;
+    OttThreadPool& operator=(const OttThreadPool&) = delete;
+
+    static OttThreadPool& shared();
+
+    [[nodiscard]] size_t size() const { return workers.size(); }
+
+    void submit(std::function<void()> task);
+
+    template<typename F>
+    void parallelFor(size_t count, F&& fn);
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    std::vector<std::thread>          workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex                        queueMutex;
+    std::condition_variable           queueCondition;
+    bool                              stopping = false;
+
+    void workerLoop();
+}; // class OttThreadPool
+
+//----------------------------------------------------------------------------
+/** Calls fn(i) for every i in [0, count) spread across the pool and the calling thread.
+ *  Indices are handed out one at a time through an atomic counter, so callers should
+ *  pass a count of coarse work items (chunks, objects) rather than single elements.
+ *  The first exception thrown by fn is rethrown on the calling thread. **/
+template<typename F>
+void OttThreadPool::parallelFor(const size_t count, F&& fn)
+{
+    if (count == 0)
+        return;
+    if (count == 1 || workers.empty())
+    {
+        for (size_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    struct SharedState
+    {
+        std::atomic<size_t>     next { 0 };
+        std::atomic<size_t>     done { 0 };
+        std::mutex              mutex;
+        std::condition_variable finished;
+        std::exception_ptr      error;
+    };
+    auto state = std::make_shared<SharedState>();
+
+    // Helpers that start after all indices were claimed return without touching fn,
+    // which keeps the reference capture valid even if they outlive this call.
+    auto drain = [state, &fn, count]()
+    {
+        for (size_t i = state->next.fetch_add(1); i < count; i = state->next.fetch_add(1))
+        {
+            try { fn(i); }
+            catch (...)
+            {
+                std::lock_guard lock(state->mutex);
+                if (!state->error)
+                    state->error = std::current_exception();
+            }
+            if (state->done.fetch_add(1) + 1 == count)
+            {
+                std::lock_guard lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helpers = std::min(count, workers.size() + 1) - 1;
+    for (size_t i = 0; i < helpers; i++)
+        submit(drain);
+    drain();
+
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock, [&state, count]() { return state->done.load() == count; });
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
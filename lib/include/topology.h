@@ -0,0 +1,121 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Triangle adjacency in flat arrays, built once at load time for the geometry kernels
+ *  that need it (creases, silhouettes, holes, selection growth).
+ *
+ *  Corner c is corner c % 3 of triangle c / 3, and side c runs from corner c to
+ *  nextCorner(c). Sides are matched over welded positions, so split vertices (UV seams,
+ *  flat shading) stay connected. links[c] is the next side over the same edge:
+ *
+ *  - c itself on a border;
+ *  - the side of the neighbouring triangle on a manifold edge, which links back;
+ *  - the sides of a non-manifold edge form a cycle through all of them;
+ *  - NONE on triangles without area, which take no part. **/
+namespace OttTopology
+{
+    constexpr uint32_t NONE = UINT32_MAX;
+
+    inline uint32_t nextCorner(const uint32_t corner) { return corner % 3 == 2 ? corner - 2 : corner + 1; }
+    inline uint32_t prevCorner(const uint32_t corner) { return corner % 3 == 0 ? corner + 2 : corner - 1; }
+
+    inline bool isBorder(const std::span<const uint32_t> links, const uint32_t side)   { return links[side] == side; }
+    inline bool isManifold(const std::span<const uint32_t> links, const uint32_t side)
+    {
+        return links[side] != NONE && links[side] != side && links[links[side]] == side;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Triangle across a manifold side, NONE across any other. **/
+    inline uint32_t neighbour(const std::span<const uint32_t> links, const uint32_t side)
+    {
+        return isManifold(links, side) ? links[side] / 3 : NONE;
+    }
+
+    //----------------------------------------------------------------------------
+    /** The next corner at the same position, turning from side corner to the side that
+     *  comes into it; NONE where that side is not manifold. Repeating it walks the fan
+     *  around a position. **/
+    inline uint32_t nextAround(const std::span<const uint32_t> links, const uint32_t corner)
+    {
+        return isManifold(links, prevCorner(corner)) ? links[prevCorner(corner)] : NONE;
+    }
+
+    struct Adjacency
+    {
+        std::vector<uint32_t> links;       // Per side, as above.
+        std::vector<uint32_t> positions;   // Per corner, the welded position id.
+        uint32_t              positionCount = 0;
+    };
+
+    struct AdjacencyStats
+    {
+        size_t ranges              = 0;
+        size_t triangles           = 0;
+        size_t borderSides         = 0;
+        size_t nonManifoldSides    = 0;
+        size_t degenerateTriangles = 0;
+        size_t bytes               = 0;   // Of the links kept.
+        double seconds             = 0.0;
+
+        [[nodiscard]] double bytesPerTriangle() const { return triangles ? static_cast<double>(bytes) / static_cast<double>(triangles) : 0.0; }
+
+        AdjacencyStats& operator+=(const AdjacencyStats& other)
+        {
+            ranges              += other.ranges;
+            triangles           += other.triangles;
+            borderSides         += other.borderSides;
+            nonManifoldSides    += other.nonManifoldSides;
+            degenerateTriangles += other.degenerateTriangles;
+            bytes               += other.bytes;
+            return *this;
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Adjacency of the triangles in indices, which index into vertices. Positions are
+     *  welded exactly, then every side is keyed by its two position ids and radix sorted
+     *  so the sides of one edge are adjacent; both steps run on the shared OttThreadPool. **/
+    Adjacency build(std::span<const OttModel::Vertex> vertices, std::span<const uint32_t> indices,
+                    AdjacencyStats* stats = nullptr);
+
+    //----------------------------------------------------------------------------
+    /** Builds the links of every object's full index range into MeshData::links, once per
+     *  range shared by instances, and points the objects' firstLink at them. Ranges are
+     *  built in parallel. Called after the index order is final, since reordering the
+     *  triangles of a range invalidates its links. **/
+    AdjacencyStats buildMeshAdjacency(OttModel::MeshData& mesh);
+
+    //----------------------------------------------------------------------------
+    /** The links of object's range, empty if none were built. **/
+    inline std::span<const uint32_t> linksOf(const OttModel::MeshData& mesh, const OttModel::modelObject& object)
+    {
+        if (object.firstLink == OttModel::NO_LINKS)
+            return {};
+        return std::span(mesh.links).subspan(object.firstLink, object.indexCount / 3 * 3);
+    }
+
+} // namespace OttTopology
@@ -0,0 +1,217 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+#include "arena.h"
+#include "device.h"
+#include "edges.h"
+#include "gpuedges.h"
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Owns the scene vertex, index and edge arenas and appends meshes to them without
+ *  stalling the frame loop.
+ *
+ *  1. stage() copies one or more meshes back to back into host visible buffers; it is safe
+ *     on any thread.
+ *  2. co_await upload() queues the staged geometry. At the next update() its copies into
+ *     the free tail of each arena (growing it on the GPU when full) are submitted on the
+ *     graphics queue under a fence.
+ *  3. Once the fence signals, update() commits the arenas, retires replaced buffers and
+ *     resumes the awaiting coroutine with the placement of the geometry.
+ *
+ *  With enableGpuEdges(), index ranges the loader left without edges are extracted by
+ *  OttGpuEdges in the same submission, straight into the edge arena after the staged edges.
+ *
+ *  Retired buffers are destroyed only after MAX_FRAMES_IN_FLIGHT more frames were recorded,
+ *  so frames still in flight keep valid handles. Everything except stage() and discard()
+ *  belongs to the main thread. **/
+class OttGeometryUploader
+{
+//----------------------------------------------------------------------------
+public:
+//----------------------------------------------------------------------------
+
+    struct Buffer
+    {
+        VkBuffer       buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize   size   = 0;
+    };
+
+    // An index range of the staged meshes to extract edges from on the GPU, in elements
+    // from the start of the staging.
+    struct EdgeJob
+    {
+        uint32_t firstVertex;
+        uint32_t firstIndex;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+    };
+
+    struct Staging
+    {
+        Buffer   positions, attributes, indices, shortIndices, edges;
+        uint32_t vertexCount     = 0;
+        uint32_t indexCount      = 0;
+        uint32_t shortIndexCount = 0;
+        uint32_t edgeCount   = 0;
+        std::vector<EdgeJob> edgeJobs;
+    };
+
+    // Edges extracted on the GPU for the index range starting at firstIndex, in elements.
+    struct EdgeRange
+    {
+        uint32_t firstIndex;
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+    };
+
+    // Where an uploaded mesh landed in the scene buffers, in elements.
+    struct Placement
+    {
+        uint32_t firstVertex;
+        uint32_t firstIndex;
+        uint32_t firstShortIndex;
+        uint32_t firstEdge;
+        std::vector<EdgeRange> gpuEdges;
+    };
+
+    //----------------------------------------------------------------------------
+    /** vertex_format is the layout of the vertex streams (OttModel::positionStride); Packed
+     *  meshes must be quantized (OttModel::quantize) before they are staged. **/
+    explicit OttGeometryUploader(OttDevice* device_reference, OttModel::VertexFormat vertex_format = OttModel::VertexFormat::Float);
+    ~OttGeometryUploader();
+
+    OttGeometryUploader(const OttGeometryUploader&) = delete;
+    OttGeometryUploader& operator=(const OttGeometryUploader&) = delete;
+
+    //----------------------------------------------------------------------------
+    /** Reserves arena capacity up front, in elements. Main thread, before any upload. **/
+    void reserve(VkDeviceSize vertex_count, VkDeviceSize index_count, VkDeviceSize short_index_count, VkDeviceSize edge_count);
+
+    //----------------------------------------------------------------------------
+    /** Extracts the edges of staged index ranges with more than triangles_above triangles
+     *  and no edges of their own on the GPU, as crease edges when creases is set. Main
+     *  thread, before any upload; throws when the compute kernels can't be created or the
+     *  vertices are packed, as the kernels read float positions. **/
+    void enableGpuEdges(const std::filesystem::path& shader_dir, uint32_t triangles_above,
+                        const std::optional<OttEdges::CreaseOptions>& creases);
+
+    Staging stage(std::span<const OttModel::MeshData> meshes);
+    Staging stage(const OttModel::MeshData& mesh) { return stage(std::span(&mesh, 1)); }
+    void    discard(Staging& staging);
+
+    //----------------------------------------------------------------------------
+    /** Awaitable that completes at a frame boundary once the mesh is resident. Resumes with
+     *  an empty placement when stop was requested before the copy was submitted. **/
+    auto upload(Staging staging, std::stop_token stop = {})
+    {
+        struct Awaiter
+        {
+            OttGeometryUploader*     uploader;
+            PendingUpload            pending;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                pending.continuation = handle;
+                uploader->queued.push_back(&pending);
+            }
+            std::optional<Placement> await_resume() const { return pending.placement; }
+        };
+        return Awaiter { this, PendingUpload { .staging = staging, .stop = std::move(stop) } };
+    }
+
+    //----------------------------------------------------------------------------
+    /** Call once per loop iteration, before recording. frame counts the frames recorded so far. **/
+    void update(uint64_t frame);
+    void deferDestroy(std::function<void()> destroy);
+    [[nodiscard]] bool idle() const { return inFlight == nullptr && queued.empty(); }
+
+    [[nodiscard]] VkBuffer getPositionBuffer()  const { return positionArena.getBuffer(); }
+    [[nodiscard]] VkBuffer getAttributeBuffer() const { return attributeArena.getBuffer(); }
+    [[nodiscard]] VkBuffer getIndexBuffer()  const { return indexArena.getBuffer(); }
+    [[nodiscard]] VkBuffer getShortIndexBuffer() const { return shortIndexArena.getBuffer(); }
+    [[nodiscard]] VkBuffer getEdgesBuffer()  const { return edgeArena.getBuffer(); }
+    [[nodiscard]] VkDeviceAddress getEdgesBufferAddress() const { return edgesBufferAddress; }
+    [[nodiscard]] uint32_t vertexCount() const { return static_cast<uint32_t>(positionArena.getUsed() / positionStride); }
+    [[nodiscard]] uint32_t indexCount()  const { return static_cast<uint32_t>(indexArena.getUsed()  / sizeof(uint32_t)); }
+    [[nodiscard]] uint32_t shortIndexCount() const { return static_cast<uint32_t>(shortIndexArena.getUsed() / sizeof(uint16_t)); }
+    [[nodiscard]] uint32_t edgeCount()   const { return static_cast<uint32_t>(edgeArena.getUsed()   / sizeof(uint32_t)); }
+
+//----------------------------------------------------------------------------
+private:
+//----------------------------------------------------------------------------
+
+    struct PendingUpload
+    {
+        Staging                  staging;
+        std::stop_token          stop;
+        std::coroutine_handle<>  continuation;
+        std::optional<Placement> placement;
+    };
+
+    struct Retired
+    {
+        uint64_t              frame;
+        std::function<void()> destroy;
+    };
+
+    OttDevice* deviceRef;
+    OttModel::VertexFormat vertexFormat;
+    uint32_t               positionStride;
+    uint32_t               attributeStride;
+
+    OttGeometryArena positionArena;    // Vertex binding 0, read by every pass and the edge kernels.
+    OttGeometryArena attributeArena;   // Vertex binding 1: color, texture coordinates and normal.
+    OttGeometryArena indexArena;
+    OttGeometryArena shortIndexArena;   // MeshData::shortIndices, drawn as VK_INDEX_TYPE_UINT16.
+    OttGeometryArena edgeArena;
+    VkDeviceAddress  edgesBufferAddress = 0;
+
+    std::unique_ptr<OttGpuEdges>           gpuEdges;
+    uint32_t                               gpuEdgesAbove = 0;
+    std::optional<OttEdges::CreaseOptions> gpuCreases;
+    Buffer                                 gpuEdgeCounts;   // Host visible, one per submission.
+
+    std::deque<PendingUpload*> queued;
+    PendingUpload*             inFlight = nullptr;
+    VkCommandBuffer            copyCommands = VK_NULL_HANDLE;
+    VkFence                    copyFence    = VK_NULL_HANDLE;
+
+    std::deque<Retired> retired;
+    uint64_t            currentFrame = 0;
+
+    void submit(PendingUpload& pending);
+    void finish();
+    void updateEdgesAddress();
+    void recordGpuEdges(const Staging& staging, VkDeviceSize vertex_offset, VkDeviceSize index_offset, VkDeviceSize edge_offset);
+    void finishGpuEdges(PendingUpload& done);
+    void destroyBuffer(Buffer& buffer) const;
+}; // class OttGeometryUploader
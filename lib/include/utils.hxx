@@ -1,4 +1,6 @@
 ﻿#pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -17,4 +19,9 @@ namespace Utils
      *  The advantage of starting to read at the end of the file is
      *  that we can use the read position to determine the size of the file and allocate a buffer. **/
     std::vector<char> readFile(const std::string& filename);
+
+    //----------------------------------------------------------------------------
+    /** Non-cryptographic 64-bit hash (XXH64) used to fingerprint file contents and keys.
+     *  Stable across runs and platforms, so it can be persisted in cache files. **/
+    uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
 }
\ No newline at end of file
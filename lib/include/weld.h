@@ -0,0 +1,80 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "model.h"
+
+//----------------------------------------------------------------------------
+/** Vertex welding: collapses the per-corner vertex stream produced by the loaders
+ *  into an indexed mesh. **/
+namespace OttWeld
+{
+    // Inputs with fewer corners than this are welded on the calling thread.
+    constexpr size_t PARALLEL_THRESHOLD = 1 << 20;
+
+    //----------------------------------------------------------------------------
+    /** Exact deduplication. Vertices are emitted in order of first occurrence and every
+     *  corner gets the index of its first equal vertex, which is the same output the old
+     *  std::unordered_map loop produced.
+     *  Small inputs use one open-addressing table. Large inputs are hash-partitioned and the
+     *  partitions are welded in parallel before the ids are renumbered with a prefix sum. **/
+    void deduplicate(std::span<const OttModel::Vertex> corners,
+                     std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                     size_t parallel_threshold = PARALLEL_THRESHOLD);
+
+    //----------------------------------------------------------------------------
+    /** How attributes are merged when positions fall within the weld tolerance.
+     *  - SnapPositions: positions snap to the cluster's first vertex. Vertices merge only if
+     *    their other attributes are then equal, so UV seams and hard edges survive.
+     *  - KeepFirst: the whole cluster collapses into its first vertex.
+     *  - Average: the whole cluster collapses into one vertex with averaged attributes. **/
+    enum class WeldPolicy
+    {
+        SnapPositions,
+        KeepFirst,
+        Average,
+    };
+
+    struct WeldOptions
+    {
+        float      epsilon = 1e-5f; // in model units
+        WeldPolicy policy  = WeldPolicy::SnapPositions;
+    };
+
+    struct WeldStats
+    {
+        size_t inputVertices      = 0;
+        size_t outputVertices     = 0;
+        size_t collapsedTriangles = 0;
+
+        [[nodiscard]] size_t mergedVertices() const { return inputVertices - outputVertices; }
+        [[nodiscard]] size_t savedBytes()     const { return mergedVertices() * sizeof(OttModel::Vertex); }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Tolerance weld of an indexed mesh using a uniform spatial hash grid with cells of
+     *  options.epsilon. A vertex joins the cluster of the lowest-indexed earlier vertex
+     *  within epsilon, so the result is deterministic. Triangles that collapse to a line or
+     *  point are removed. Works in place and keeps vertices in first-occurrence order. **/
+    WeldStats weld(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices, const WeldOptions& options);
+
+} // namespace OttWeld
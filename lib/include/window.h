@@ -53,6 +53,7 @@ public:
     [[nodiscard]] std::pair<double, double> getCursorPos() const;
 
     void setCursorPos(double xpos, double ypos) const;
+    void setTitle(const char* title) const { glfwSetWindowTitle(m_window, title); }
 
 //----------------------------------------------------------------------------
 // Callbacks and glfw specific setup
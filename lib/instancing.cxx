@@ -0,0 +1,363 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "instancing.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+#include "threadpool.h"
+#include "utils.hxx"
+
+namespace
+{
+    // Geometries handed to a worker at once.
+    constexpr size_t GEOMETRY_BLOCK = 64;
+
+    // Frame anchors must be at least this fraction of the radius away from the centroid
+    // (and from the first axis), so float noise cannot swing the frame.
+    constexpr double ANCHOR_FRACTION = 0.1;
+
+    // Quantum of canonical normals in the hash, and their tolerance when verifying.
+    constexpr double NORMAL_QUANTUM = 1e-3;
+
+    //----------------------------------------------------------------------------
+    struct GeometryRange
+    {
+        uint32_t startIndex;
+        uint32_t indexCount;
+        uint32_t startVertex;
+        uint32_t startEdge;
+        uint32_t edgeCount;
+
+        bool operator==(const GeometryRange&) const = default;
+
+        static GeometryRange of(const OttModel::modelObject& object)
+        {
+            return { object.startIndex, object.indexCount, object.startVertex, object.startEdge, object.edgeCount };
+        }
+    };
+
+    struct GeometryRangeHash
+    {
+        size_t operator()(const GeometryRange& range) const { return Utils::hash64(&range, sizeof(range)); }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Geometry in its canonical frame. frame maps canonical to geometry coordinates. **/
+    struct Canonical
+    {
+        bool                   valid   = false;
+        uint64_t               hash    = 0;
+        double                 quantum = 0.0;
+        uint32_t               vertexSpan = 0;   // One past the highest local vertex id used.
+        glm::dmat4             frame   = glm::dmat4(1.0);
+        std::vector<uint32_t>  indices;          // Renumbered in order of first use.
+        std::vector<uint32_t>  order;            // Local vertex id of each renumbered vertex.
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+    };
+
+    //----------------------------------------------------------------------------
+    glm::dmat4 rigidInverse(const glm::dmat4& frame)
+    {
+        glm::dmat4 inverse(1.0);
+        for (int column = 0; column < 3; column++)
+            for (int row = 0; row < 3; row++)
+                inverse[column][row] = frame[row][column];
+        const glm::dvec3 translation(frame[3].x, frame[3].y, frame[3].z);
+        const glm::dvec4 moved = inverse * glm::dvec4(translation, 0.0);
+        inverse[3] = glm::dvec4(-moved.x, -moved.y, -moved.z, 1.0);
+        return inverse;
+    }
+
+    //----------------------------------------------------------------------------
+    Canonical canonicalize(const OttModel::MeshData& mesh, const GeometryRange& range, const double tolerance)
+    {
+        Canonical result;
+        const auto first = mesh.indices.begin() + range.startIndex;
+        const auto edges = mesh.edges.begin() + range.startEdge;
+        uint32_t span = 0;
+        for (uint32_t i = 0; i < range.indexCount; i++)
+            span = std::max(span, first[i] + 1);
+        for (uint32_t i = 0; i < range.edgeCount; i++)
+            span = std::max(span, edges[i] + 1);
+        result.vertexSpan = span;
+        if (range.indexCount == 0 || range.startVertex + span > mesh.vertices.size())
+            return result;
+
+        std::vector<uint32_t> renumbered(span, UINT32_MAX);
+        result.indices.reserve(range.indexCount);
+        for (uint32_t i = 0; i < range.indexCount; i++)
+        {
+            uint32_t& id = renumbered[first[i]];
+            if (id == UINT32_MAX)
+            {
+                id = static_cast<uint32_t>(result.order.size());
+                result.order.push_back(first[i]);
+            }
+            result.indices.push_back(id);
+        }
+
+        std::vector<glm::dvec3> points(result.order.size());
+        glm::dvec3 centroid(0.0);
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            points[i] = glm::dvec3(mesh.vertices[range.startVertex + result.order[i]].pos);
+            centroid += points[i];
+        }
+        centroid = centroid / static_cast<double>(points.size());
+
+        double radius = 0.0;
+        for (const glm::dvec3& p : points)
+            radius = std::max(radius, glm::length(p - centroid));
+        if (radius <= 0.0)
+            return result;
+
+        // The first vertex far from the centroid fixes x, the first one far from that axis fixes y.
+        glm::dvec3 x(0.0), y(0.0);
+        bool haveX = false, haveY = false;
+        for (const glm::dvec3& p : points)
+        {
+            const glm::dvec3 d = p - centroid;
+            if (!haveX)
+            {
+                if (glm::length(d) > ANCHOR_FRACTION * radius)
+                {
+                    x = glm::normalize(d);
+                    haveX = true;
+                }
+                continue;
+            }
+            const glm::dvec3 across = d - x * glm::dot(d, x);
+            if (glm::length(across) > ANCHOR_FRACTION * radius)
+            {
+                y = glm::normalize(across);
+                haveY = true;
+                break;
+            }
+        }
+        if (!haveY)
+            return result;
+        const glm::dvec3 z = glm::cross(x, y);
+        result.frame = glm::dmat4(glm::dvec4(x, 0.0), glm::dvec4(y, 0.0), glm::dvec4(z, 0.0), glm::dvec4(centroid, 1.0));
+        result.quantum = tolerance * radius;
+
+        std::vector<int64_t> words;
+        words.reserve(points.size() * 11 + result.indices.size());
+        result.positions.reserve(points.size());
+        result.normals.reserve(points.size());
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            const OttModel::Vertex& vertex = mesh.vertices[range.startVertex + result.order[i]];
+            const glm::dvec3 d = points[i] - centroid;
+            const glm::dvec3 n(vertex.normal);
+            const glm::dvec3 q(glm::dot(d, x), glm::dot(d, y), glm::dot(d, z));
+            const glm::dvec3 m(glm::dot(n, x), glm::dot(n, y), glm::dot(n, z));
+            result.positions.emplace_back(q);
+            result.normals.emplace_back(m);
+            for (int k = 0; k < 3; k++)
+            {
+                words.push_back(std::llround(q[k] / result.quantum));
+                words.push_back(std::llround(m[k] / NORMAL_QUANTUM));
+            }
+            for (const float value : { vertex.color.x, vertex.color.y, vertex.color.z, vertex.texCoord.x, vertex.texCoord.y })
+                words.push_back(std::bit_cast<int32_t>(value));
+        }
+        words.insert(words.end(), result.indices.begin(), result.indices.end());
+        result.hash  = Utils::hash64(words.data(), words.size() * sizeof(int64_t));
+        result.valid = true;
+        return result;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Whether copy is prototype moved rigidly, within the tolerance of both. **/
+    bool sameShape(const OttModel::MeshData& mesh, const GeometryRange& prototypeRange, const Canonical& prototype,
+                   const GeometryRange& copyRange, const Canonical& copy)
+    {
+        if (prototype.indices != copy.indices || prototype.positions.size() != copy.positions.size())
+            return false;
+        const double limit = 2.0 * std::max(prototype.quantum, copy.quantum);
+        for (size_t i = 0; i < prototype.positions.size(); i++)
+        {
+            const glm::dvec3 offset(prototype.positions[i] - copy.positions[i]);
+            const glm::dvec3 turn(prototype.normals[i] - copy.normals[i]);
+            if (std::abs(offset.x) > limit || std::abs(offset.y) > limit || std::abs(offset.z) > limit ||
+                glm::length(turn) > 2.0 * NORMAL_QUANTUM)
+                return false;
+            const OttModel::Vertex& a = mesh.vertices[prototypeRange.startVertex + prototype.order[i]];
+            const OttModel::Vertex& b = mesh.vertices[copyRange.startVertex + copy.order[i]];
+            if (a.color != b.color || a.texCoord != b.texCoord)
+                return false;
+        }
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    struct Interval
+    {
+        uint64_t begin, end, target;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Appends the union of ranges of source to out, in source order, and returns where
+     *  each merged interval landed. **/
+    template<typename T>
+    std::vector<Interval> compact(const std::vector<T>& source, std::vector<std::pair<uint64_t, uint64_t>> ranges, std::vector<T>& out)
+    {
+        std::ranges::sort(ranges);
+        std::vector<Interval> intervals;
+        for (const auto& [begin, end] : ranges)
+        {
+            if (begin == end)
+                continue;
+            if (!intervals.empty() && begin <= intervals.back().end)
+                intervals.back().end = std::max(intervals.back().end, end);
+            else
+                intervals.push_back({ begin, end, 0 });
+        }
+        for (Interval& interval : intervals)
+        {
+            interval.target = out.size();
+            out.insert(out.end(), source.begin() + static_cast<ptrdiff_t>(interval.begin), source.begin() + static_cast<ptrdiff_t>(interval.end));
+        }
+        return intervals;
+    }
+
+    uint32_t remap(const std::vector<Interval>& intervals, const uint64_t position)
+    {
+        auto found = std::ranges::upper_bound(intervals, position, {}, &Interval::begin);
+        if (found == intervals.begin())
+            return 0;
+        --found;
+        return static_cast<uint32_t>(found->target + position - found->begin);
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttInstancing::InstancingStats OttInstancing::instance(OttModel::MeshData& mesh, const InstancingOptions& options)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    InstancingStats stats;
+    stats.objects = mesh.objects.size();
+
+    // Objects already sharing a range (glTF instances) are one geometry.
+    std::vector<GeometryRange> geometries;
+    std::vector<uint32_t>      geometryOf(mesh.objects.size());
+    std::unordered_map<GeometryRange, uint32_t, GeometryRangeHash> lookup;
+    for (size_t i = 0; i < mesh.objects.size(); i++)
+    {
+        const auto [found, inserted] = lookup.try_emplace(GeometryRange::of(mesh.objects[i]), static_cast<uint32_t>(geometries.size()));
+        if (inserted)
+            geometries.push_back(found->first);
+        geometryOf[i] = found->second;
+    }
+    stats.geometries = geometries.size();
+
+    std::vector<Canonical> canonical(geometries.size());
+    const size_t blocks = (geometries.size() + GEOMETRY_BLOCK - 1) / GEOMETRY_BLOCK;
+    OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+    {
+        const size_t last = std::min(geometries.size(), (block + 1) * GEOMETRY_BLOCK);
+        for (size_t g = block * GEOMETRY_BLOCK; g < last; g++)
+            canonical[g] = canonicalize(mesh, geometries[g], options.tolerance);
+    });
+
+    auto geometryBytes = [&](const size_t g)
+    {
+        return canonical[g].vertexSpan * sizeof(OttModel::Vertex) + (geometries[g].indexCount + geometries[g].edgeCount) * sizeof(uint32_t);
+    };
+    for (const uint32_t g : geometryOf)
+        stats.totalBytes += geometryBytes(g);
+
+    // The first geometry of each shape becomes its prototype; later copies map onto it.
+    std::vector<uint32_t>   prototypeOf(geometries.size());
+    std::vector<glm::dmat4> motion(geometries.size(), glm::dmat4(1.0));
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    size_t duplicates = 0;
+    for (uint32_t g = 0; g < geometries.size(); g++)
+    {
+        prototypeOf[g] = g;
+        if (!canonical[g].valid)
+            continue;
+        std::vector<uint32_t>& bucket = buckets[canonical[g].hash];
+        for (const uint32_t p : bucket)
+        {
+            if (sameShape(mesh, geometries[p], canonical[p], geometries[g], canonical[g]))
+            {
+                prototypeOf[g] = p;
+                motion[g] = canonical[g].frame * rigidInverse(canonical[p].frame);
+                duplicates++;
+                break;
+            }
+        }
+        if (prototypeOf[g] == g)
+            bucket.push_back(g);
+    }
+    buckets = {};
+
+    if (duplicates > 0)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> vertexRanges, indexRanges, edgeRanges;
+        for (uint32_t g = 0; g < geometries.size(); g++)
+        {
+            if (prototypeOf[g] != g)
+                continue;
+            const GeometryRange& range = geometries[g];
+            vertexRanges.emplace_back(range.startVertex, std::min<uint64_t>(range.startVertex + canonical[g].vertexSpan, mesh.vertices.size()));
+            indexRanges.emplace_back(range.startIndex, range.startIndex + range.indexCount);
+            edgeRanges.emplace_back(range.startEdge, range.startEdge + range.edgeCount);
+        }
+
+        OttModel::MeshData compacted;
+        const std::vector<Interval> vertexMap = compact(mesh.vertices, std::move(vertexRanges), compacted.vertices);
+        const std::vector<Interval> indexMap  = compact(mesh.indices,  std::move(indexRanges),  compacted.indices);
+        const std::vector<Interval> edgeMap   = compact(mesh.edges,    std::move(edgeRanges),   compacted.edges);
+
+        for (size_t i = 0; i < mesh.objects.size(); i++)
+        {
+            OttModel::modelObject& object = mesh.objects[i];
+            const uint32_t g = geometryOf[i];
+            const GeometryRange& range = geometries[prototypeOf[g]];
+            object.startVertex = remap(vertexMap, range.startVertex);
+            object.startIndex  = remap(indexMap,  range.startIndex);
+            object.startEdge   = range.edgeCount > 0 ? remap(edgeMap, range.startEdge) : 0;
+            object.indexCount  = range.indexCount;
+            object.edgeCount   = range.edgeCount;
+            if (prototypeOf[g] != g)
+                object.transform = object.transform * glm::mat4(motion[g]);
+        }
+        mesh.vertices = std::move(compacted.vertices);
+        mesh.indices  = std::move(compacted.indices);
+        mesh.edges    = std::move(compacted.edges);
+    }
+
+    std::vector<uint8_t> kept(geometries.size(), 0);
+    for (uint32_t g = 0; g < geometries.size(); g++)
+    {
+        if (!kept[prototypeOf[g]])
+        {
+            kept[prototypeOf[g]] = 1;
+            stats.prototypes++;
+        }
+    }
+    stats.uniqueBytes = mesh.vertices.size() * sizeof(OttModel::Vertex) + (mesh.indices.size() + mesh.edges.size()) * sizeof(uint32_t);
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
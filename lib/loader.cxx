@@ -0,0 +1,547 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "loader.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <unordered_map>
+
+#include <fmt/std.h>
+
+#include "gltfloader.h"
+#include "ifcloader.h"
+#include "logger.h"
+#include "meshcache.h"
+#include "objloader.h"
+#include "threadpool.h"
+#include "utils.hxx"
+
+namespace
+{
+    constexpr size_t CORNER_BLOCK = 1 << 16;
+
+    //----------------------------------------------------------------------------
+    OttModel::Vertex makeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
+    {
+        OttModel::Vertex vertex{};
+
+        if (index.vertex_index >= 0)
+        {
+            vertex.pos =
+            {
+                attrib.vertices[3 * static_cast<size_t>(index.vertex_index) + 0],
+                attrib.vertices[3 * static_cast<size_t>(index.vertex_index) + 1],
+                attrib.vertices[3 * static_cast<size_t>(index.vertex_index) + 2]
+            };
+
+            vertex.color =
+            {
+                attrib.colors[3 * static_cast<size_t>(index.vertex_index) + 0],
+                attrib.colors[3 * static_cast<size_t>(index.vertex_index) + 1],
+                attrib.colors[3 * static_cast<size_t>(index.vertex_index) + 2]
+            };
+        }
+        if (index.texcoord_index >= 0)
+        {
+            vertex.texCoord =
+            {
+                attrib.texcoords[2 * static_cast<size_t>(index.texcoord_index) + 0],
+                1.0f - attrib.texcoords[2 * static_cast<size_t>(index.texcoord_index) + 1]
+            };
+        }
+        if (index.normal_index >= 0)
+        {
+            vertex.normal =
+            {
+                attrib.normals[3 * static_cast<size_t>(index.normal_index) + 0],
+                attrib.normals[3 * static_cast<size_t>(index.normal_index) + 1],
+                attrib.normals[3 * static_cast<size_t>(index.normal_index) + 2],
+            };
+        }
+        return vertex;
+    }
+
+    //----------------------------------------------------------------------------
+    bool isGltf(const std::filesystem::path& path)
+    {
+        std::string extension = path.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".gltf" || extension == ".glb";
+    }
+
+    //----------------------------------------------------------------------------
+    bool isIfc(const std::filesystem::path& path)
+    {
+        std::string extension = path.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".ifc";
+    }
+
+    //----------------------------------------------------------------------------
+    void logCleanup(const OttCleanup::CleanupStats& stats)
+    {
+        log_t<info>("Cleaned up {} of {} triangles in {:.3f}s: {} collapsed, {} zero-area, {} duplicates ({} reversed), "
+                    "{} unreferenced vertices dropped\n", stats.removedTriangles(), stats.triangles, stats.seconds,
+                    stats.collapsedTriangles, stats.zeroAreaTriangles, stats.duplicateTriangles, stats.reversedDuplicates,
+                    stats.unreferencedVertices);
+    }
+
+    //----------------------------------------------------------------------------
+    void logBounds(const OttModel::BoundsStats& stats)
+    {
+        log_t<info>("Bounds of {} objects over {} vertex ranges, {} vertices, in {:.3f}s ({})\n", stats.objects,
+                    stats.ranges, stats.vertices, stats.seconds, OttModel::simdPathName(stats.path));
+    }
+
+    //----------------------------------------------------------------------------
+    /** The parts of a mesh the cache leaves out: its bounds, and its adjacency and BVH when
+     *  options ask for them. **/
+    void buildUncached(OttModel::MeshData& mesh, const OttLoader::LoadOptions& options, OttLoader::LoadProgress* progress)
+    {
+        logBounds(OttModel::computeBounds(mesh));
+        if (options.adjacency)
+        {
+            if (progress)
+                progress->report(OttLoader::LoadProgress::Stage::Adjacency, 0.98f);
+            const OttTopology::AdjacencyStats stats = OttTopology::buildMeshAdjacency(mesh);
+            log_t<info>("Built the adjacency of {} index ranges, {} triangles, in {:.3f}s: {:.1f} bytes per triangle, "
+                        "{} border and {} non-manifold sides\n", stats.ranges, stats.triangles, stats.seconds,
+                        stats.bytesPerTriangle(), stats.borderSides, stats.nonManifoldSides);
+        }
+        if (options.bvh)
+        {
+            if (progress)
+                progress->report(OttLoader::LoadProgress::Stage::Hierarchy, 0.99f);
+            OttBvh::BvhStats stats;
+            mesh.bvh = OttBvh::build(mesh, &stats);
+            log_t<info>("Built the BVH of {} objects over {} index ranges, {} triangles, in {:.3f}s: {} nodes, {:.2f} MB\n",
+                        stats.objects, stats.ranges, stats.triangles, stats.seconds, stats.nodes,
+                        static_cast<double>(stats.bytes) / (1024.0 * 1024.0));
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Boundary edges, or crease edges when options.creases is set, of the triangles in
+     *  indices. None for ranges above options.gpuEdgesAbove, which the GPU extracts. **/
+    std::vector<uint32_t> extractEdges(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices,
+                                       const OttLoader::LoadOptions& options)
+    {
+        if (options.gpuEdgesAbove > 0 && indices.size() / 3 > options.gpuEdgesAbove)
+            return {};
+        return options.creases ? OttEdges::extractCreaseEdges(vertices, indices, *options.creases)
+                               : OttModel::extractBoundaryEdges(indices);
+    }
+
+    //----------------------------------------------------------------------------
+    /** Edges of every object. Objects sharing an index range (instances) share their edges
+     *  too, so each range is extracted once. Ranges are extracted in parallel and appended
+     *  in order of first use. **/
+    void extractObjectEdges(OttModel::MeshData& mesh, const OttLoader::LoadOptions& options)
+    {
+        std::unordered_map<uint32_t, size_t> rangeOf;
+        std::vector<const OttModel::modelObject*> ranges;
+        for (const OttModel::modelObject& object : mesh.objects)
+        {
+            if (rangeOf.try_emplace(object.startIndex, ranges.size()).second)
+                ranges.push_back(&object);
+        }
+
+        std::vector<std::vector<uint32_t>> rangeEdges(ranges.size());
+        OttThreadPool::shared().parallelFor(ranges.size(), [&](const size_t r)
+        {
+            rangeEdges[r] = extractEdges(std::span(mesh.vertices).subspan(ranges[r]->startVertex),
+                                         std::span(mesh.indices).subspan(ranges[r]->startIndex, ranges[r]->indexCount), options);
+        });
+
+        std::vector<uint32_t> rangeStart(ranges.size());
+        for (size_t r = 0; r < ranges.size(); r++)
+        {
+            rangeStart[r] = static_cast<uint32_t>(mesh.edges.size());
+            mesh.edges.insert(mesh.edges.end(), rangeEdges[r].begin(), rangeEdges[r].end());
+        }
+        for (OttModel::modelObject& object : mesh.objects)
+        {
+            const size_t r   = rangeOf[object.startIndex];
+            object.startEdge = rangeStart[r];
+            object.edgeCount = static_cast<uint32_t>(rangeEdges[r].size());
+        }
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Identifies the options in the mesh cache. Default options map to 0 so entries written
+ *  before options existed stay valid. **/
+uint64_t OttLoader::LoadOptions::fingerprint() const
+{
+    std::vector<uint32_t> words;
+    if (weld)
+        words.insert(words.end(), { 1, std::bit_cast<uint32_t>(weld->epsilon), static_cast<uint32_t>(weld->policy) });
+    if (cleanup)
+        words.insert(words.end(), { 9, std::bit_cast<uint32_t>(cleanup->areaRatio), uint32_t(cleanup->duplicates), uint32_t(cleanup->unreferenced) });
+    if (normals)
+        words.insert(words.end(), { 8, static_cast<uint32_t>(normals->weighting), std::bit_cast<uint32_t>(normals->creaseAngleDegrees) });
+    if (instancing)
+        words.insert(words.end(), { 2, std::bit_cast<uint32_t>(instancing->tolerance) });
+    if (creases)
+        words.insert(words.end(), { 3, std::bit_cast<uint32_t>(creases->angleDegrees), uint32_t(creases->boundaries), uint32_t(creases->suppressSeams) });
+    if (gpuEdgesAbove > 0)
+        words.insert(words.end(), { 4, gpuEdgesAbove });
+    if (lods)
+        words.insert(words.end(), { 5, lods->levels, std::bit_cast<uint32_t>(lods->ratio), lods->minTriangles, std::bit_cast<uint32_t>(lods->maxError) });
+    if (optimize)
+        words.insert(words.end(), { 7, optimize->cacheSize, std::bit_cast<uint32_t>(optimize->overdrawThreshold), uint32_t(optimize->fetch) });
+    if (meshlets)
+        words.insert(words.end(), { 6, meshlets->maxVertices, meshlets->maxTriangles, meshlets->minTriangles });
+    return words.empty() ? 0 : Utils::hash64(words.data(), words.size() * sizeof(uint32_t));
+}
+
+//----------------------------------------------------------------------------
+const char* OttLoader::stageName(const LoadProgress::Stage stage)
+{
+    switch (stage)
+    {
+        case LoadProgress::Stage::Queued:        return "queued";
+        case LoadProgress::Stage::Parsing:       return "parsing";
+        case LoadProgress::Stage::Deduplicating: return "deduplicating";
+        case LoadProgress::Stage::Welding:       return "welding";
+        case LoadProgress::Stage::Cleaning:      return "cleaning up";
+        case LoadProgress::Stage::Normals:       return "generating normals";
+        case LoadProgress::Stage::Edges:         return "extracting edges";
+        case LoadProgress::Stage::Instancing:    return "instancing";
+        case LoadProgress::Stage::Simplifying:   return "simplifying";
+        case LoadProgress::Stage::Optimizing:    return "optimizing";
+        case LoadProgress::Stage::Clustering:    return "clustering";
+        case LoadProgress::Stage::Adjacency:     return "building adjacency";
+        case LoadProgress::Stage::Hierarchy:     return "building the BVH";
+        case LoadProgress::Stage::Uploading:     return "uploading";
+        case LoadProgress::Stage::Done:          return "done";
+        case LoadProgress::Stage::Cancelled:     return "cancelled";
+        case LoadProgress::Stage::Failed:        return "failed";
+    }
+    return "";
+}
+
+//----------------------------------------------------------------------------
+bool OttLoader::loadObj(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options,
+                        const std::stop_token stop, LoadProgress* progress)
+{
+    auto report = [progress](const LoadProgress::Stage stage, const float done)
+    {
+        if (progress)
+            progress->report(stage, done);
+    };
+    auto cancelled = [&stop, &modelPath]()
+    {
+        if (!stop.stop_requested())
+            return false;
+        log_t<info>("Loading {} cancelled", modelPath);
+        return true;
+    };
+
+    report(LoadProgress::Stage::Parsing, 0.0f);
+
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+    OttObj::ParseStats parseStats;
+    const auto baseDir = modelPath.parent_path();
+
+    if (!OttObj::LoadObj(&attrib, &shapes, &materials, &warn, &err, modelPath, baseDir, &parseStats))
+    {
+        log_t<error>("{}, {}", warn, err);
+        return false;
+    }
+    if (!warn.empty())
+        log_t<warning>("{}", warn);
+
+    log_t<info>(DASHED_SEPARATOR);
+    log_t<info>("Loading Wavefront {}\n", modelPath);
+    log_t<info>("BaseDir {}\n", baseDir);
+    log_t<info>("Parsed {:.1f} MB in {:.3f}s ({:.1f} MB/s, {} chunks)\n",
+                static_cast<double>(parseStats.bytes) / (1024.0 * 1024.0), parseStats.seconds,
+                parseStats.megabytesPerSecond(), parseStats.chunks);
+
+    if (cancelled())
+        return false;
+    report(LoadProgress::Stage::Deduplicating, 0.5f);
+
+    mesh = {};
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        log_t<info>("material[{}].diffuse_texname = {}\n", i, materials[i].diffuse_texname);
+        if (!materials[i].diffuse_texname.empty())
+            mesh.materialPaths.push_back((baseDir / materials[i].diffuse_texname).string());
+    }
+
+    size_t cornerCount = 0;
+    for (const auto& shape : shapes)
+        cornerCount += shape.mesh.indices.size();
+
+    std::vector<OttModel::Vertex> corners(cornerCount);
+    size_t shapeStart = 0;
+    for (const auto& shape : shapes)
+    {
+        const size_t blocks = (shape.mesh.indices.size() + CORNER_BLOCK - 1) / CORNER_BLOCK;
+        OttThreadPool::shared().parallelFor(blocks, [&, shapeStart](const size_t block)
+        {
+            const size_t last = std::min(shape.mesh.indices.size(), (block + 1) * CORNER_BLOCK);
+            for (size_t i = block * CORNER_BLOCK; i < last; i++)
+                corners[shapeStart + i] = makeVertex(attrib, shape.mesh.indices[i]);
+        });
+        shapeStart += shape.mesh.indices.size();
+    }
+    OttWeld::deduplicate(corners, mesh.vertices, mesh.indices);
+    log_t<info>("Unique vertices {} of {} corners\n", mesh.vertices.size(), cornerCount);
+    corners = {};
+
+    if (options.weld)
+    {
+        if (cancelled())
+            return false;
+        report(LoadProgress::Stage::Welding, 0.7f);
+        const OttWeld::WeldStats weldStats = OttWeld::weld(mesh.vertices, mesh.indices, *options.weld);
+        log_t<info>("Welded {} vertices within {} ({:.2f} MB saved), {} collapsed triangles removed\n",
+                    weldStats.mergedVertices(), options.weld->epsilon,
+                    static_cast<double>(weldStats.savedBytes()) / (1024.0 * 1024.0), weldStats.collapsedTriangles);
+    }
+
+    if (options.cleanup)
+    {
+        if (cancelled())
+            return false;
+        report(LoadProgress::Stage::Cleaning, 0.75f);
+        logCleanup(OttCleanup::cleanup(mesh.vertices, mesh.indices, *options.cleanup));
+    }
+
+    if (options.normals && attrib.normals.empty())
+    {
+        if (cancelled())
+            return false;
+        report(LoadProgress::Stage::Normals, 0.78f);
+        const OttNormals::NormalStats normalStats = OttNormals::generate(mesh.vertices, mesh.indices, *options.normals);
+        log_t<info>("Generated normals for {} triangles in {:.3f}s, {} vertices split at creases of {} degrees\n",
+                    normalStats.triangles, normalStats.seconds, normalStats.splitVertices, options.normals->creaseAngleDegrees);
+    }
+
+    if (cancelled())
+        return false;
+    report(LoadProgress::Stage::Edges, 0.85f);
+    mesh.edges = extractEdges(mesh.vertices, mesh.indices, options);
+    log_t<info>("Edges Size == {}", mesh.edges.size());
+
+    mesh.objects.push_back({
+        .startIndex  = 0,
+        .startVertex = 0,
+        .startEdge   = 0,
+        .indexCount  = static_cast<uint32_t>(mesh.indices.size()),
+        .edgeCount   = static_cast<uint32_t>(mesh.edges.size()),
+        .textureID   = 0,
+        .pushColorID = glm::vec3(0.0f),
+    });
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttLoader::loadGltf(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options,
+                         const std::stop_token stop, LoadProgress* progress)
+{
+    if (progress)
+        progress->report(LoadProgress::Stage::Parsing, 0.0f);
+
+    std::string warn, err;
+    OttGltf::ImportStats stats;
+    if (!OttGltf::Load(modelPath, mesh, &warn, &err, &stats))
+    {
+        log_t<error>("{}, {}", warn, err);
+        return false;
+    }
+    if (!warn.empty())
+        log_t<warning>("{}", warn);
+
+    log_t<info>(DASHED_SEPARATOR);
+    log_t<info>("Loading glTF {}\n", modelPath);
+    log_t<info>("Read {:.1f} MB in {:.3f}s: {} primitives, {} instances, {} accessors copied as blocks\n",
+                static_cast<double>(stats.bytes) / (1024.0 * 1024.0), stats.seconds,
+                stats.primitives, stats.instances, stats.blockCopies);
+
+    if (stop.stop_requested())
+    {
+        log_t<info>("Loading {} cancelled", modelPath);
+        return false;
+    }
+    if (options.cleanup)
+    {
+        if (progress)
+            progress->report(LoadProgress::Stage::Cleaning, 0.75f);
+        logCleanup(OttCleanup::cleanup(mesh, *options.cleanup));
+    }
+    if (progress)
+        progress->report(LoadProgress::Stage::Edges, 0.85f);
+
+    extractObjectEdges(mesh, options);
+    log_t<info>("Edges Size == {}", mesh.edges.size());
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttLoader::loadIfc(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options,
+                        const std::stop_token stop, LoadProgress* progress)
+{
+    if (progress)
+        progress->report(LoadProgress::Stage::Parsing, 0.0f);
+
+    std::string warn, err;
+    OttIfc::ImportStats stats;
+    if (!OttIfc::Load(modelPath, mesh, &warn, &err, &stats, stop))
+    {
+        if (stop.stop_requested())
+            log_t<info>("Loading {} cancelled", modelPath);
+        else
+            log_t<error>("{}, {}", warn, err);
+        return false;
+    }
+    if (!warn.empty())
+        log_t<warning>("{}", warn);
+
+    log_t<info>(DASHED_SEPARATOR);
+    log_t<info>("Loading IFC {}\n", modelPath);
+    log_t<info>("Read {:.1f} MB in {:.3f}s: {} entities in {} chunks, {} products\n",
+                static_cast<double>(stats.bytes) / (1024.0 * 1024.0), stats.seconds,
+                stats.entities, stats.chunks, stats.products);
+
+    if (stop.stop_requested())
+    {
+        log_t<info>("Loading {} cancelled", modelPath);
+        return false;
+    }
+    if (options.cleanup)
+    {
+        if (progress)
+            progress->report(LoadProgress::Stage::Cleaning, 0.75f);
+        logCleanup(OttCleanup::cleanup(mesh, *options.cleanup));
+    }
+    if (progress)
+        progress->report(LoadProgress::Stage::Edges, 0.85f);
+
+    extractObjectEdges(mesh, options);
+    log_t<info>("Edges Size == {}", mesh.edges.size());
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttLoader::loadMesh(const std::filesystem::path& modelPath, OttModel::MeshData& mesh, const LoadOptions& options,
+                         const std::stop_token stop, LoadProgress* progress)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const uint64_t variant = options.fingerprint();
+    if (OttMeshCache::read(modelPath, mesh, variant))
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+        log_t<info>(DASHED_SEPARATOR);
+        log_t<info>("Loaded {} from mesh cache {} in {:.3f}s\n", modelPath, OttMeshCache::cachePathFor(modelPath, variant), seconds);
+        buildUncached(mesh, options, progress);
+        return true;
+    }
+
+    const bool loaded = isGltf(modelPath) ? loadGltf(modelPath, mesh, options, stop, progress)
+                      : isIfc(modelPath)  ? loadIfc(modelPath, mesh, options, stop, progress)
+                                          : loadObj(modelPath, mesh, options, stop, progress);
+    if (!loaded)
+        return false;
+
+    if (options.instancing)
+    {
+        if (stop.stop_requested())
+        {
+            log_t<info>("Loading {} cancelled", modelPath);
+            return false;
+        }
+        if (progress)
+            progress->report(LoadProgress::Stage::Instancing, 0.88f);
+        const OttInstancing::InstancingStats stats = OttInstancing::instance(mesh, *options.instancing);
+        log_t<info>("Instanced {} objects onto {} of {} geometries in {:.3f}s: {:.2f} MB unique of {:.2f} MB total ({:.1f}x)\n",
+                    stats.objects, stats.prototypes, stats.geometries, stats.seconds,
+                    static_cast<double>(stats.uniqueBytes) / (1024.0 * 1024.0),
+                    static_cast<double>(stats.totalBytes) / (1024.0 * 1024.0), stats.ratio());
+    }
+    if (options.lods)
+    {
+        if (stop.stop_requested())
+        {
+            log_t<info>("Loading {} cancelled", modelPath);
+            return false;
+        }
+        if (progress)
+            progress->report(LoadProgress::Stage::Simplifying, 0.92f);
+        const OttSimplify::LodStats stats = OttSimplify::buildLods(mesh, *options.lods);
+        log_t<info>("Built {} LOD levels for {} index ranges in {:.3f}s: {} triangles over {} at full detail\n",
+                    stats.levels, stats.ranges, stats.seconds, stats.lodTriangles, stats.fullTriangles);
+    }
+    if (options.optimize)
+    {
+        if (stop.stop_requested())
+        {
+            log_t<info>("Loading {} cancelled", modelPath);
+            return false;
+        }
+        if (progress)
+            progress->report(LoadProgress::Stage::Optimizing, 0.94f);
+        const OttOptimize::OptimizeStats stats = OttOptimize::optimize(mesh, *options.optimize);
+        log_t<info>("Optimized {} index ranges in {:.3f}s: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} vertices moved\n",
+                    stats.ranges, stats.seconds, stats.before.acmr(), stats.after.acmr(),
+                    stats.before.atvr(), stats.after.atvr(), stats.remapped);
+    }
+    if (options.meshlets)
+    {
+        if (stop.stop_requested())
+        {
+            log_t<info>("Loading {} cancelled", modelPath);
+            return false;
+        }
+        if (progress)
+            progress->report(LoadProgress::Stage::Clustering, 0.96f);
+        const OttMeshlets::MeshletStats stats = OttMeshlets::build(mesh, *options.meshlets);
+        log_t<info>("Split {} index ranges of {} triangles into {} meshlets, {} with backface cones, in {:.3f}s\n",
+                    stats.ranges, stats.triangles, stats.meshlets, stats.coned, stats.seconds);
+    }
+    if (!OttMeshCache::write(modelPath, mesh, variant))
+        log_t<warning>("Could not write mesh cache for {}", modelPath);
+    if ((options.adjacency || options.bvh) && stop.stop_requested())
+    {
+        log_t<info>("Loading {} cancelled", modelPath);
+        return false;
+    }
+    buildUncached(mesh, options, progress);
+    return true;
+}
+
+//----------------------------------------------------------------------------
+OttTask<std::optional<OttModel::MeshData>> OttLoader::loadMeshAsync(std::filesystem::path modelPath, LoadOptions options,
+                                                                    std::stop_token stop, LoadProgress* progress)
+{
+    co_await OttAsync::resumeOn(OttThreadPool::shared());
+    if (stop.stop_requested())
+        co_return std::nullopt;
+
+    OttModel::MeshData mesh;
+    if (!loadMesh(modelPath, mesh, options, stop, progress))
+        co_return std::nullopt;
+    co_return mesh;
+}
@@ -0,0 +1,150 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "mappedfile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "logger.h"
+
+//----------------------------------------------------------------------------
+OttMappedFile::OttMappedFile(const std::filesystem::path& path)
+{
+    open(path);
+}
+
+//----------------------------------------------------------------------------
+OttMappedFile::~OttMappedFile()
+{
+    close();
+}
+
+//----------------------------------------------------------------------------
+OttMappedFile::OttMappedFile(OttMappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+//----------------------------------------------------------------------------
+OttMappedFile& OttMappedFile::operator=(OttMappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        mappedData = std::exchange(other.mappedData, nullptr);
+        mappedSize = std::exchange(other.mappedSize, 0);
+        opened     = std::exchange(other.opened, false);
+#ifdef _WIN32
+        fileHandle    = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+//----------------------------------------------------------------------------
+/** Maps the whole file read-only. Empty files are reported as open with an empty view,
+ *  since neither mmap nor MapViewOfFile accept a zero-length mapping. **/
+bool OttMappedFile::open(const std::filesystem::path& path)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        log_t<error>("OttMappedFile: cannot open {}", path.string());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    fileHandle = file;
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    if (mappedSize > 0)
+    {
+        mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle != nullptr)
+            mappedData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (mappedData == nullptr)
+        {
+            log_t<error>("OttMappedFile: cannot map {}", path.string());
+            close();
+            return false;
+        }
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        log_t<error>("OttMappedFile: cannot open {}", path.string());
+        return false;
+    }
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    mappedSize = static_cast<size_t>(fileStat.st_size);
+    if (mappedSize > 0)
+    {
+        void* mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            log_t<error>("OttMappedFile: cannot map {}", path.string());
+            ::close(fd);
+            mappedSize = 0;
+            return false;
+        }
+        madvise(mapping, mappedSize, MADV_SEQUENTIAL);
+        mappedData = static_cast<const char*>(mapping);
+    }
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+#endif
+    opened = true;
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void OttMappedFile::close()
+{
+#ifdef _WIN32
+    if (mappedData != nullptr)    { UnmapViewOfFile(mappedData); }
+    if (mappingHandle != nullptr) { CloseHandle(mappingHandle); }
+    if (fileHandle != nullptr)    { CloseHandle(fileHandle); }
+    mappingHandle = nullptr;
+    fileHandle    = nullptr;
+#else
+    if (mappedData != nullptr) { munmap(const_cast<char*>(mappedData), mappedSize); }
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+    opened     = false;
+}
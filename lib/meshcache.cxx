@@ -0,0 +1,309 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "meshcache.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+#include "logger.h"
+#include "mappedfile.h"
+#include "utils.hxx"
+
+namespace
+{
+    constexpr char   MAGIC[8]          = { 'O', 'T', 'T', 'M', 'E', 'S', 'H', '\0' };
+    constexpr size_t SECTION_ALIGNMENT = 16;
+
+    static_assert(std::is_trivially_copyable_v<OttModel::Vertex>);
+    static_assert(std::is_trivially_copyable_v<OttModel::modelObject>);
+    static_assert(std::is_trivially_copyable_v<OttModel::Meshlet>);
+
+    //----------------------------------------------------------------------------
+    /** On-disk layout: header, then the vertex, index, edge, object, meshlet, material and
+     *  object id sections, each starting on a SECTION_ALIGNMENT boundary. Material paths
+     *  and object ids are stored as a uint32 byte length followed by the UTF-8 bytes. **/
+    struct FileHeader
+    {
+        char     magic[8];
+        uint32_t version;
+        uint32_t vertexStride;
+        uint32_t objectStride;
+        uint32_t reserved;
+        uint64_t sourceSize;
+        int64_t  sourceMtime;
+        uint64_t sourceHash;
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t edgeCount;
+        uint64_t objectCount;
+        uint64_t meshletCount;
+        uint64_t materialBytes;
+        uint64_t objectIdBytes;
+    };
+
+    struct SourceStamp
+    {
+        uint64_t size  = 0;
+        int64_t  mtime = 0;
+    };
+
+    //----------------------------------------------------------------------------
+    constexpr size_t alignSection(const size_t offset)
+    {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    //----------------------------------------------------------------------------
+    bool stampSource(const std::filesystem::path& source, SourceStamp& stamp)
+    {
+        std::error_code ec;
+        stamp.size = std::filesystem::file_size(source, ec);
+        if (ec)
+            return false;
+        stamp.mtime = static_cast<int64_t>(std::filesystem::last_write_time(source, ec).time_since_epoch().count());
+        return !ec;
+    }
+
+    //----------------------------------------------------------------------------
+    bool hashSource(const std::filesystem::path& source, uint64_t& hash)
+    {
+        const OttMappedFile file(source);
+        if (!file.isOpen())
+            return false;
+        hash = Utils::hash64(file.data(), file.size());
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Byte offsets of every section for the counts stored in header, plus the total size. **/
+    struct SectionLayout
+    {
+        size_t vertices, indices, edges, objects, meshlets, materials, objectIds, total;
+    };
+
+    SectionLayout layoutFor(const FileHeader& header)
+    {
+        SectionLayout layout{};
+        layout.vertices  = alignSection(sizeof(FileHeader));
+        layout.indices   = alignSection(layout.vertices  + header.vertexCount * sizeof(OttModel::Vertex));
+        layout.edges     = alignSection(layout.indices   + header.indexCount  * sizeof(uint32_t));
+        layout.objects   = alignSection(layout.edges     + header.edgeCount   * sizeof(uint32_t));
+        layout.meshlets  = alignSection(layout.objects   + header.objectCount * sizeof(OttModel::modelObject));
+        layout.materials = alignSection(layout.meshlets  + header.meshletCount * sizeof(OttModel::Meshlet));
+        layout.objectIds = alignSection(layout.materials + header.materialBytes);
+        layout.total     = layout.objectIds + header.objectIdBytes;
+        return layout;
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename T>
+    void copySection(const char* base, const size_t offset, const uint64_t count, std::vector<T>& out)
+    {
+        out.resize(count);
+        if (count > 0)
+            std::memcpy(out.data(), base + offset, count * sizeof(T));
+    }
+
+    //----------------------------------------------------------------------------
+    /** Reads length prefixed strings until end. Returns false if one runs past it. **/
+    bool readStrings(const char* cursor, const char* end, std::vector<std::string>& out)
+    {
+        out.clear();
+        while (end - cursor >= static_cast<ptrdiff_t>(sizeof(uint32_t)))
+        {
+            uint32_t length;
+            std::memcpy(&length, cursor, sizeof(length));
+            cursor += sizeof(length);
+            if (length > static_cast<size_t>(end - cursor))
+                return false;
+            out.emplace_back(cursor, length);
+            cursor += length;
+        }
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    std::vector<char> packStrings(const std::vector<std::string>& strings)
+    {
+        std::vector<char> blob;
+        for (const std::string& string : strings)
+        {
+            const auto length = static_cast<uint32_t>(string.size());
+            blob.insert(blob.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+            blob.insert(blob.end(), string.begin(), string.end());
+        }
+        return blob;
+    }
+
+    //----------------------------------------------------------------------------
+    template<typename T>
+    void writeSection(std::ofstream& out, const std::vector<T>& data)
+    {
+        const auto position = static_cast<size_t>(out.tellp());
+        const std::vector<char> padding(alignSection(position) - position, 0);
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+std::filesystem::path OttMeshCache::cacheDirectory()
+{
+    return std::filesystem::temp_directory_path() / "ottocento" / "meshcache";
+}
+
+//----------------------------------------------------------------------------
+std::filesystem::path OttMeshCache::cachePathFor(const std::filesystem::path& source, const uint64_t variant)
+{
+    std::error_code ec;
+    auto absolute = std::filesystem::weakly_canonical(source, ec);
+    if (ec)
+        absolute = std::filesystem::absolute(source);
+    const std::string key = absolute.generic_string();
+    return cacheDirectory() / fmt::format("{:016x}.ottmesh", Utils::hash64(key.data(), key.size(), variant));
+}
+
+//----------------------------------------------------------------------------
+bool OttMeshCache::read(const std::filesystem::path& source, OttModel::MeshData& mesh, const uint64_t variant)
+{
+    const auto cachePath = cachePathFor(source, variant);
+    std::error_code ec;
+    if (!std::filesystem::exists(cachePath, ec))
+        return false;
+
+    SourceStamp stamp;
+    if (!stampSource(source, stamp))
+        return false;
+
+    bool refreshMtime = false;
+    {
+        const OttMappedFile file(cachePath);
+        if (!file.isOpen() || file.size() < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != CACHE_VERSION ||
+            header.vertexStride != sizeof(OttModel::Vertex) || header.objectStride != sizeof(OttModel::modelObject))
+        {
+            log_t<warning>("Mesh cache {} has an incompatible format, ignoring it", cachePath.string());
+            return false;
+        }
+        if (header.sourceSize != stamp.size)
+            return false;
+        if (header.sourceMtime != stamp.mtime)
+        {
+            uint64_t hash;
+            if (!hashSource(source, hash) || hash != header.sourceHash)
+                return false;
+            refreshMtime = true;
+        }
+
+        const SectionLayout layout = layoutFor(header);
+        if (layout.total > file.size())
+        {
+            log_t<warning>("Mesh cache {} is truncated, ignoring it", cachePath.string());
+            return false;
+        }
+
+        copySection(file.data(), layout.vertices, header.vertexCount, mesh.vertices);
+        copySection(file.data(), layout.indices,  header.indexCount,  mesh.indices);
+        copySection(file.data(), layout.edges,    header.edgeCount,   mesh.edges);
+        copySection(file.data(), layout.objects,  header.objectCount, mesh.objects);
+        copySection(file.data(), layout.meshlets, header.meshletCount, mesh.meshlets);
+
+        const char* base = file.data();
+        if (!readStrings(base + layout.materials, base + layout.materials + header.materialBytes, mesh.materialPaths) ||
+            !readStrings(base + layout.objectIds, base + layout.total, mesh.objectIds))
+            return false;
+    }
+
+    // The content is unchanged, only the timestamp moved: keep the fast path for next time.
+    if (refreshMtime)
+    {
+        std::fstream patch(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+        patch.seekp(offsetof(FileHeader, sourceMtime));
+        patch.write(reinterpret_cast<const char*>(&stamp.mtime), sizeof(stamp.mtime));
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttMeshCache::write(const std::filesystem::path& source, const OttModel::MeshData& mesh, const uint64_t variant)
+{
+    SourceStamp stamp;
+    FileHeader  header{};
+    if (!stampSource(source, stamp) || !hashSource(source, header.sourceHash))
+        return false;
+
+    const std::vector<char> materialBlob = packStrings(mesh.materialPaths);
+    const std::vector<char> objectIdBlob = packStrings(mesh.objectIds);
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version       = CACHE_VERSION;
+    header.vertexStride  = sizeof(OttModel::Vertex);
+    header.objectStride  = sizeof(OttModel::modelObject);
+    header.sourceSize    = stamp.size;
+    header.sourceMtime   = stamp.mtime;
+    header.vertexCount   = mesh.vertices.size();
+    header.indexCount    = mesh.indices.size();
+    header.edgeCount     = mesh.edges.size();
+    header.objectCount   = mesh.objects.size();
+    header.meshletCount  = mesh.meshlets.size();
+    header.materialBytes = materialBlob.size();
+    header.objectIdBytes = objectIdBlob.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDirectory(), ec);
+    const auto cachePath = cachePathFor(source, variant);
+    auto       tempPath  = cachePath;
+    tempPath += fmt::format(".{:x}.tmp", Utils::random_nr(0, 0xFFFFFF));
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            log_t<warning>("Cannot write mesh cache {}", tempPath.string());
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeSection(out, mesh.vertices);
+        writeSection(out, mesh.indices);
+        writeSection(out, mesh.edges);
+        writeSection(out, mesh.objects);
+        writeSection(out, mesh.meshlets);
+        writeSection(out, materialBlob);
+        writeSection(out, objectIdBlob);
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        log_t<warning>("Cannot move mesh cache into place: {}", ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
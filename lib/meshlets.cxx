@@ -0,0 +1,291 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "meshlets.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+#include "optimize.h"
+#include "radixsort.h"
+#include "simplify.h"
+#include "threadpool.h"
+#include "weld.h"
+
+namespace
+{
+    // Cones narrower than this half angle sine are not worth a test; the cluster's faces
+    // point in too many directions to ever be all turned away.
+    constexpr float MAX_CONE_SINE = 0.95f;
+
+    //----------------------------------------------------------------------------
+    /** Mean face normal of the triangles and the sine of the largest angle between it and
+     *  any of them. A zero axis when the normals spread over a hemisphere or more. **/
+    glm::vec4 normalCone(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices)
+    {
+        std::vector<glm::vec3> normals;
+        normals.reserve(indices.size() / 3);
+        glm::vec3 sum(0.0f);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec3& a = vertices[indices[i]].pos;
+            const glm::vec3  n = glm::cross(vertices[indices[i + 1]].pos - a, vertices[indices[i + 2]].pos - a);
+            const float length = glm::length(n);
+            if (!(length > 0.0f))
+                continue;
+            normals.push_back(n / length);
+            sum += normals.back();
+        }
+        const float length = glm::length(sum);
+        if (normals.empty() || !(length > 0.0f))
+            return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        const glm::vec3 axis = sum / length;
+        float minimumDot = 1.0f;
+        for (const glm::vec3& n : normals)
+            minimumDot = std::min(minimumDot, glm::dot(n, axis));
+        const float sine = std::sqrt(std::max(0.0f, 1.0f - minimumDot * minimumDot));
+        if (minimumDot <= 0.0f || sine > MAX_CONE_SINE)
+            return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        return glm::vec4(axis, sine);
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** The candidates of a growing cluster are the unused triangles around its vertices, kept
+ *  in the order they were reached. A triangle adding no vertex is taken at once. When no
+ *  neighbour fits, the next unused triangle in index order starts over, so disconnected
+ *  pieces fill clusters in the order the exporter wrote them. **/
+std::vector<OttModel::Meshlet> OttMeshlets::buildMeshlets(const std::span<const OttModel::Vertex> vertices, const std::span<uint32_t> indices,
+                                                          const bool closed, const MeshletOptions& options)
+{
+    std::vector<OttModel::Meshlet> meshlets;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return meshlets;
+    const uint32_t maxVertices  = std::max(options.maxVertices, 3u);
+    const uint32_t maxTriangles = std::max(options.maxTriangles, 1u);
+
+    const uint32_t vertexCount = *std::max_element(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(3 * triangleCount)) + 1;
+    std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0), adjacency(3 * triangleCount);
+    for (size_t corner = 0; corner < 3 * triangleCount; corner++)
+        adjacencyStart[indices[corner] + 1]++;
+    for (uint32_t v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    {
+        std::vector<uint32_t> cursor(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (size_t corner = 0; corner < 3 * triangleCount; corner++)
+            adjacency[cursor[indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+    }
+
+    std::vector<uint8_t>  used(triangleCount, 0);
+    std::vector<uint32_t> owner(vertexCount, UINT32_MAX);   // Meshlet the vertex was last added to.
+    std::vector<uint32_t> ordered;
+    ordered.reserve(3 * triangleCount);
+    std::vector<uint32_t> triangles, candidates;
+    uint32_t clusterVertices = 0;
+    size_t   next = 0;
+
+    auto newVertices = [&](const size_t t, const uint32_t id)
+    {
+        uint32_t count = 0;
+        for (size_t k = 0; k < 3; k++)
+            count += owner[indices[3 * t + k]] != id;
+        // A corner repeated within the triangle is only added once.
+        const uint32_t a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+        if (owner[a] != id && (a == b || a == c)) count--;
+        if (owner[b] != id && b == c)             count--;
+        return count;
+    };
+    auto add = [&](const uint32_t t, const uint32_t id)
+    {
+        used[t] = 1;
+        triangles.push_back(t);
+        for (size_t k = 0; k < 3; k++)
+        {
+            const uint32_t v = indices[3 * t + k];
+            if (owner[v] == id)
+                continue;
+            owner[v] = id;
+            clusterVertices++;
+            for (uint32_t j = adjacencyStart[v]; j < adjacencyStart[v + 1]; j++)
+            {
+                if (!used[adjacency[j]])
+                    candidates.push_back(adjacency[j]);
+            }
+        }
+    };
+
+    while (ordered.size() < 3 * triangleCount)
+    {
+        const auto id = static_cast<uint32_t>(meshlets.size());
+        triangles.clear();
+        candidates.clear();
+        clusterVertices = 0;
+        while (used[next])
+            next++;
+        add(static_cast<uint32_t>(next), id);
+
+        while (triangles.size() < maxTriangles)
+        {
+            // Used candidates are dropped on the way; the scan stops at the first free fit.
+            uint32_t best = UINT32_MAX, bestAdded = 4;
+            size_t kept = 0, scanned = 0;
+            while (scanned < candidates.size() && bestAdded > 0)
+            {
+                const uint32_t t = candidates[scanned++];
+                if (used[t])
+                    continue;
+                candidates[kept++] = t;
+                const uint32_t added = newVertices(t, id);
+                if (added < bestAdded && clusterVertices + added <= maxVertices)
+                {
+                    best      = t;
+                    bestAdded = added;
+                }
+            }
+            candidates.erase(candidates.begin() + static_cast<std::ptrdiff_t>(kept), candidates.begin() + static_cast<std::ptrdiff_t>(scanned));
+
+            if (best == UINT32_MAX)
+            {
+                while (next < triangleCount && used[next])
+                    next++;
+                if (next == triangleCount || clusterVertices + newVertices(next, id) > maxVertices)
+                    break;
+                best = static_cast<uint32_t>(next);
+            }
+            add(best, id);
+        }
+
+        const auto start = static_cast<uint32_t>(ordered.size());
+        for (const uint32_t t : triangles)
+            ordered.insert(ordered.end(), indices.begin() + static_cast<std::ptrdiff_t>(3 * t), indices.begin() + static_cast<std::ptrdiff_t>(3 * t + 3));
+        const std::span<const uint32_t> cluster(ordered.data() + start, ordered.size() - start);
+        meshlets.push_back({
+            .boundingSphere = OttSimplify::boundingSphere(vertices, cluster),
+            .cone           = closed ? normalCone(vertices, cluster) : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+            .startIndex     = start,
+            .indexCount     = static_cast<uint32_t>(cluster.size()),
+        });
+    }
+
+    std::ranges::copy(ordered, indices.begin());
+    return meshlets;
+}
+
+//----------------------------------------------------------------------------
+/** Sorts the directed sides by their welded end points; a closed, consistently wound
+ *  surface has every side exactly once and its reverse exactly once. Triangles collapsed
+ *  onto a line or point are ignored. **/
+bool OttMeshlets::isClosed(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices)
+{
+    if (indices.size() < 12)
+        return false;
+    const uint32_t vertexCount = *std::ranges::max_element(indices) + 1;
+    std::vector<OttModel::Vertex> corners(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        corners[v].pos = vertices[v].pos;
+    std::vector<OttModel::Vertex> unique;
+    std::vector<uint32_t>         positionOf;
+    OttWeld::deduplicate(corners, unique, positionOf);
+
+    const uint64_t stride = unique.size();
+    std::vector<uint64_t> sides;
+    sides.reserve(indices.size());
+    const glm::dvec3 origin(unique[0].pos);
+    double volume = 0.0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const uint32_t a = positionOf[indices[i]], b = positionOf[indices[i + 1]], c = positionOf[indices[i + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+        sides.insert(sides.end(), { a * stride + b, b * stride + c, c * stride + a });
+        const glm::dvec3 pa = glm::dvec3(unique[a].pos) - origin;
+        const glm::dvec3 pb = glm::dvec3(unique[b].pos) - origin;
+        const glm::dvec3 pc = glm::dvec3(unique[c].pos) - origin;
+        volume += glm::dot(pa, glm::cross(pb, pc));
+    }
+    if (!(volume > 0.0))
+        return false;
+
+    OttRadix::sort(sides, std::bit_width(stride * stride), [](const uint64_t side) { return side; });
+    for (size_t i = 0; i < sides.size(); i++)
+    {
+        if (i + 1 < sides.size() && sides[i + 1] == sides[i])
+            return false;
+        const uint64_t reverse = (sides[i] % stride) * stride + sides[i] / stride;
+        if (!std::ranges::binary_search(sides, reverse))
+            return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/** Ranges are split in parallel and their meshlets appended in the order the ranges
+ *  first appear in mesh.objects. **/
+OttMeshlets::MeshletStats OttMeshlets::build(OttModel::MeshData& mesh, const MeshletOptions& options)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::unordered_map<uint32_t, size_t> rangeOf;
+    std::vector<const OttModel::modelObject*> ranges;
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        if (object.indexCount / 3 >= options.minTriangles && rangeOf.try_emplace(object.startIndex, ranges.size()).second)
+            ranges.push_back(&object);
+    }
+
+    std::vector<std::vector<OttModel::Meshlet>> results(ranges.size());
+    OttThreadPool::shared().parallelFor(ranges.size(), [&](const size_t r)
+    {
+        const OttModel::modelObject& object = *ranges[r];
+        const auto vertices = std::span<const OttModel::Vertex>(mesh.vertices).subspan(object.startVertex);
+        const auto indices  = std::span(mesh.indices).subspan(object.startIndex, object.indexCount);
+        results[r] = buildMeshlets(vertices, indices, isClosed(vertices, indices), options);
+        for (const OttModel::Meshlet& meshlet : results[r])
+            OttOptimize::optimizeVertexCache(indices.subspan(meshlet.startIndex, meshlet.indexCount));
+    });
+
+    MeshletStats stats;
+    std::vector<uint32_t> firstOf(ranges.size());
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        firstOf[r] = static_cast<uint32_t>(mesh.meshlets.size());
+        for (OttModel::Meshlet meshlet : results[r])
+        {
+            meshlet.startIndex += ranges[r]->startIndex;
+            stats.coned += meshlet.cone != glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            mesh.meshlets.push_back(meshlet);
+        }
+        stats.ranges++;
+        stats.meshlets  += results[r].size();
+        stats.triangles += ranges[r]->indexCount / 3;
+    }
+    for (OttModel::modelObject& object : mesh.objects)
+    {
+        const auto found = rangeOf.find(object.startIndex);
+        if (found == rangeOf.end() || object.indexCount / 3 < options.minTriangles)
+            continue;
+        object.firstMeshlet = firstOf[found->second];
+        object.meshletCount = static_cast<uint32_t>(results[found->second].size());
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
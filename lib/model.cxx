@@ -4,57 +4,621 @@
 #include "model.h"
 
 #include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <glm/gtc/packing.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define OTT_X86_SIMD 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define OTT_TARGET_AVX2
+    #else
+        #define OTT_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+#include "radixsort.h"
+#include "threadpool.h"
+
+namespace
+{
+    constexpr size_t EDGE_BLOCK = OttRadix::BLOCK_SIZE;
+    constexpr float  UNORM16    = 65535.0f;
+    constexpr size_t BOUNDS_BLOCK = 1 << 16;   // Vertices per task of computeBounds.
+
+    static_assert(offsetof(OttModel::Vertex, pos) == 0 && sizeof(OttModel::Vertex) >= 4 * sizeof(float),
+                  "The bounds kernels load pos together with the float after it");
+
+    //----------------------------------------------------------------------------
+    /** Octahedral mapping of a direction onto [-1, 1]^2: the unit octahedron is unfolded
+     *  into a square, the lower half folded over the corners. A zero vector maps to the
+     *  center, which decodes to +z. **/
+    glm::vec2 octEncode(const glm::vec3& direction)
+    {
+        const float sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+        if (!(sum > 0.0f))
+            return glm::vec2(0.0f);
+        glm::vec2 folded(direction.x / sum, direction.y / sum);
+        if (direction.z < 0.0f)
+        {
+            folded = glm::vec2((1.0f - std::abs(folded.y)) * (folded.x >= 0.0f ? 1.0f : -1.0f),
+                               (1.0f - std::abs(folded.x)) * (folded.y >= 0.0f ? 1.0f : -1.0f));
+        }
+        return folded;
+    }
+
+    glm::vec3 octDecode(const glm::vec2& encoded)
+    {
+        glm::vec3 direction(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+        const float fold = std::max(-direction.z, 0.0f);
+        direction.x += direction.x >= 0.0f ? -fold : fold;
+        direction.y += direction.y >= 0.0f ? -fold : fold;
+        return glm::normalize(direction);
+    }
+
+    //----------------------------------------------------------------------------
+    /** Calls visit(first, count, object) for the vertex range of every distinct
+     *  startVertex, in order, with the first object starting there. **/
+    template<typename Mesh, typename Visit>
+    void forEachVertexRange(Mesh& mesh, Visit&& visit)
+    {
+        std::vector<uint32_t> order(mesh.objects.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+            order[i] = i;
+        std::ranges::stable_sort(order, {}, [&mesh](const uint32_t i) { return mesh.objects[i].startVertex; });
+        for (size_t k = 0; k < order.size(); k++)
+        {
+            const uint32_t first = mesh.objects[order[k]].startVertex;
+            if (k > 0 && mesh.objects[order[k - 1]].startVertex == first)
+                continue;
+            size_t next = k + 1;
+            while (next < order.size() && mesh.objects[order[next]].startVertex == first)
+                next++;
+            const uint32_t last = next < order.size() ? mesh.objects[order[next]].startVertex
+                                                      : static_cast<uint32_t>(mesh.vertices.size());
+            visit(first, std::min(last, static_cast<uint32_t>(mesh.vertices.size())) - first, std::span(order).subspan(k, next - k));
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Bounds kernels over count > 0 vertices. The radius kernels return the squared
+     *  radius. **/
+    void boundsScalar(const OttModel::Vertex* vertices, const size_t count, glm::vec3& low, glm::vec3& high)
+    {
+        low = high = vertices[0].pos;
+        for (size_t v = 1; v < count; v++)
+        {
+            low  = glm::min(low, vertices[v].pos);
+            high = glm::max(high, vertices[v].pos);
+        }
+    }
+
+    float radiusScalar(const OttModel::Vertex* vertices, const size_t count, const glm::vec3& center)
+    {
+        float best = 0.0f;
+        for (size_t v = 0; v < count; v++)
+        {
+            const glm::vec3 d = vertices[v].pos - center;
+            best = std::max(best, d.x * d.x + d.y * d.y + d.z * d.z);
+        }
+        return best;
+    }
+
+#ifdef OTT_X86_SIMD
+    // Position of a vertex in the three low lanes; the fourth holds color.r and is ignored.
+    __m128 loadPosition(const OttModel::Vertex* vertex)
+    {
+        return _mm_loadu_ps(&vertex->pos.x);
+    }
+
+    glm::vec3 lowLanes(const __m128 value)
+    {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, value);
+        return { lanes[0], lanes[1], lanes[2] };
+    }
+
+    float maxLane(const __m128 value)
+    {
+        const __m128 pairs = _mm_max_ps(value, _mm_movehl_ps(value, value));
+        return _mm_cvtss_f32(_mm_max_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+
+    //----------------------------------------------------------------------------
+    void boundsSse2(const OttModel::Vertex* vertices, const size_t count, glm::vec3& low, glm::vec3& high)
+    {
+        __m128 low0 = loadPosition(vertices), high0 = low0, low1 = low0, high1 = low0;
+        size_t v = 1;
+        for (; v + 2 <= count; v += 2)
+        {
+            const __m128 a = loadPosition(vertices + v), b = loadPosition(vertices + v + 1);
+            low0  = _mm_min_ps(low0, a);
+            high0 = _mm_max_ps(high0, a);
+            low1  = _mm_min_ps(low1, b);
+            high1 = _mm_max_ps(high1, b);
+        }
+        if (v < count)
+        {
+            const __m128 a = loadPosition(vertices + v);
+            low0  = _mm_min_ps(low0, a);
+            high0 = _mm_max_ps(high0, a);
+        }
+        low  = lowLanes(_mm_min_ps(low0, low1));
+        high = lowLanes(_mm_max_ps(high0, high1));
+    }
+
+    float radiusSse2(const OttModel::Vertex* vertices, const size_t count, const glm::vec3& center)
+    {
+        const __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+        __m128 best = _mm_setzero_ps();
+        size_t v = 0;
+        for (; v + 4 <= count; v += 4)
+        {
+            __m128 x = loadPosition(vertices + v),     y = loadPosition(vertices + v + 1);
+            __m128 z = loadPosition(vertices + v + 2), w = loadPosition(vertices + v + 3);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            const __m128 dx = _mm_sub_ps(x, cx), dy = _mm_sub_ps(y, cy), dz = _mm_sub_ps(z, cz);
+            best = _mm_max_ps(best, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        }
+        return std::max(maxLane(best), radiusScalar(vertices + v, count - v, center));
+    }
+
+    //----------------------------------------------------------------------------
+    // Positions of two vertices, a in the low and b in the high 128-bit lane.
+    OTT_TARGET_AVX2 __m256 loadPositions(const OttModel::Vertex* a, const OttModel::Vertex* b)
+    {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(loadPosition(a)), loadPosition(b), 1);
+    }
+
+    OTT_TARGET_AVX2 void boundsAvx2(const OttModel::Vertex* vertices, const size_t count, glm::vec3& low, glm::vec3& high)
+    {
+        const __m256 first = loadPositions(vertices, vertices);
+        __m256 low0 = first, high0 = first, low1 = first, high1 = first;
+        size_t v = 1;
+        for (; v + 4 <= count; v += 4)
+        {
+            const __m256 a = loadPositions(vertices + v, vertices + v + 1);
+            const __m256 b = loadPositions(vertices + v + 2, vertices + v + 3);
+            low0  = _mm256_min_ps(low0, a);
+            high0 = _mm256_max_ps(high0, a);
+            low1  = _mm256_min_ps(low1, b);
+            high1 = _mm256_max_ps(high1, b);
+        }
+        low0  = _mm256_min_ps(low0, low1);
+        high0 = _mm256_max_ps(high0, high1);
+        __m128 lower = _mm_min_ps(_mm256_castps256_ps128(low0), _mm256_extractf128_ps(low0, 1));
+        __m128 upper = _mm_max_ps(_mm256_castps256_ps128(high0), _mm256_extractf128_ps(high0, 1));
+        for (; v < count; v++)
+        {
+            const __m128 a = loadPosition(vertices + v);
+            lower = _mm_min_ps(lower, a);
+            upper = _mm_max_ps(upper, a);
+        }
+        low  = lowLanes(lower);
+        high = lowLanes(upper);
+    }
+
+    OTT_TARGET_AVX2 float radiusAvx2(const OttModel::Vertex* vertices, const size_t count, const glm::vec3& center)
+    {
+        const __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+        __m256 best = _mm256_setzero_ps();
+        size_t v = 0;
+        for (; v + 8 <= count; v += 8)
+        {
+            // Vertices v..v+3 in the low lanes, v+4..v+7 in the high ones, transposed per lane.
+            const __m256 r0 = loadPositions(vertices + v,     vertices + v + 4);
+            const __m256 r1 = loadPositions(vertices + v + 1, vertices + v + 5);
+            const __m256 r2 = loadPositions(vertices + v + 2, vertices + v + 6);
+            const __m256 r3 = loadPositions(vertices + v + 3, vertices + v + 7);
+            const __m256 xy01 = _mm256_unpacklo_ps(r0, r1), xy23 = _mm256_unpacklo_ps(r2, r3);
+            const __m256 zw01 = _mm256_unpackhi_ps(r0, r1), zw23 = _mm256_unpackhi_ps(r2, r3);
+            const __m256 dx = _mm256_sub_ps(_mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(1, 0, 1, 0)), cx);
+            const __m256 dy = _mm256_sub_ps(_mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 2, 3, 2)), cy);
+            const __m256 dz = _mm256_sub_ps(_mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(1, 0, 1, 0)), cz);
+            best = _mm256_max_ps(best, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz)));
+        }
+        const float lanes = maxLane(_mm_max_ps(_mm256_castps256_ps128(best), _mm256_extractf128_ps(best, 1)));
+        return std::max(lanes, radiusScalar(vertices + v, count - v, center));
+    }
+#endif
+} // anonymous namespace
 
 //----------------------------------------------------------------------------
-/** Computes the boundary edges from a mesh.
- * Algorithm and function provided by Yaliya on Reddit.
- * Original thread: https://www.reddit.com/r/opengl/comments/1gpthh9/my_first_mesh_editor/ **/
-std::vector<uint32_t> OttModel::extractBoundaryEdges(std::vector<uint32_t>& indices)
-{
-    /* 
-       Count how many times each edge appears
-       In a triangular mesh, an edge is either shared between two triangles 
-       or belongs to the boundary of the mesh  (appearing only once).
-       
-       By counting occurrences of each edge:
-       Edges with a count of 2 are shared edges between adjacent triangles (middle edge).
-       Edges with a count of 1 are boundary edges.
-   */
-    std::map<std::pair<uint32_t, uint32_t>, int> edgeCount;
-    
-    // Store boundary edges
-    std::vector<uint32_t> edges; 
- 
-    auto addEdge = [&edgeCount](uint32_t v1, uint32_t v2) {
-        /*
-            Ensure consistent edge ordering. Why?
-            In a triangle mesh, an edge can appear in different orders depending on how triangles are defined. 
-            For example: One triangle might define the edge as (v1, v2).
-            An adjacent triangle might define the same edge as (v2, v1).
-            If we treat (v1, v2) and (v2, v1) as distinct edges, we would incorrectly count them separately. 
-            And remember that we needed the counting to detect the shared edge (between adjacent triangles)
-        */
-        auto edge = std::minmax(v1, v2); 
-        edgeCount[edge]++;
+void OttModel::BoundsTable::clear()
+{
+    for (std::vector<float>* column : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ, &centerX, &centerY, &centerZ, &radius })
+        column->clear();
+    sceneLow  = glm::vec3(std::numeric_limits<float>::max());
+    sceneHigh = glm::vec3(std::numeric_limits<float>::lowest());
+}
+
+//----------------------------------------------------------------------------
+void OttModel::transformBox(const glm::mat4& transform, const glm::vec3& low, const glm::vec3& high, glm::vec3& center, glm::vec3& extent)
+{
+    const glm::mat3 linear(transform);
+    const glm::mat3 absolute(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]));
+    center = glm::vec3(transform * glm::vec4(0.5f * (low + high), 1.0f));
+    extent = absolute * (0.5f * (high - low));
+}
+
+//----------------------------------------------------------------------------
+void OttModel::BoundsTable::append(const glm::vec3& low, const glm::vec3& high, const glm::vec4& sphere, const glm::mat4& transform)
+{
+    minX.push_back(low.x);
+    minY.push_back(low.y);
+    minZ.push_back(low.z);
+    maxX.push_back(high.x);
+    maxY.push_back(high.y);
+    maxZ.push_back(high.z);
+    centerX.push_back(sphere.x);
+    centerY.push_back(sphere.y);
+    centerZ.push_back(sphere.z);
+    radius.push_back(sphere.w);
+    if (low.x > high.x)
+        return;
+
+    glm::vec3 center, extent;
+    transformBox(transform, low, high, center, extent);
+    sceneLow  = glm::min(sceneLow, center - extent);
+    sceneHigh = glm::max(sceneHigh, center + extent);
+}
+
+//----------------------------------------------------------------------------
+OttModel::SimdPath OttModel::simdPath()
+{
+#if defined(OTT_X86_SIMD) && defined(_MSC_VER) && !defined(__clang__)
+    static const SimdPath path = []
+    {
+        int info[4];
+        __cpuid(info, 1);
+        const bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return avx && (info[1] & (1 << 5)) ? SimdPath::Avx2 : SimdPath::Sse2;
+    }();
+    return path;
+#elif defined(OTT_X86_SIMD)
+    static const SimdPath path = __builtin_cpu_supports("avx2") ? SimdPath::Avx2 : SimdPath::Sse2;
+    return path;
+#else
+    return SimdPath::Scalar;
+#endif
+}
+
+//----------------------------------------------------------------------------
+const char* OttModel::simdPathName(const SimdPath path)
+{
+    switch (path)
+    {
+        case SimdPath::Avx2: return "AVX2";
+        case SimdPath::Sse2: return "SSE2";
+        default:             return "scalar";
+    }
+}
+
+//----------------------------------------------------------------------------
+void OttModel::positionBounds(const std::span<const Vertex> vertices, glm::vec3& low, glm::vec3& high, SimdPath path)
+{
+    if (vertices.empty())
+    {
+        low = high = glm::vec3(0.0f);
+        return;
+    }
+    path = std::min(path, simdPath());
+#ifdef OTT_X86_SIMD
+    if (path == SimdPath::Avx2)
+        return boundsAvx2(vertices.data(), vertices.size(), low, high);
+    if (path == SimdPath::Sse2)
+        return boundsSse2(vertices.data(), vertices.size(), low, high);
+#endif
+    boundsScalar(vertices.data(), vertices.size(), low, high);
+}
+
+//----------------------------------------------------------------------------
+float OttModel::boundingRadius(const std::span<const Vertex> vertices, const glm::vec3& center, SimdPath path)
+{
+    path = std::min(path, simdPath());
+    float squared = 0.0f;
+#ifdef OTT_X86_SIMD
+    if (path == SimdPath::Avx2)
+        squared = radiusAvx2(vertices.data(), vertices.size(), center);
+    else if (path == SimdPath::Sse2)
+        squared = radiusSse2(vertices.data(), vertices.size(), center);
+    else
+#endif
+        squared = radiusScalar(vertices.data(), vertices.size(), center);
+    return std::sqrt(squared);
+}
+
+//----------------------------------------------------------------------------
+/** Ranges are cut into blocks of BOUNDS_BLOCK vertices; the boxes of the blocks are
+ *  reduced to the range's box, then the blocks measure their distance to its center. **/
+OttModel::BoundsStats OttModel::computeBounds(MeshData& mesh)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    BoundsStats stats { .objects = mesh.objects.size(), .path = simdPath() };
+
+    struct Block
+    {
+        uint32_t range;
+        uint32_t first;
+        uint32_t count;
     };
- 
-    // Process triangles and count edges
-    for (size_t i = 0; i < indices.size(); i += 3)
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;   // First vertex and count.
+    std::vector<uint32_t> rangeOf(mesh.objects.size());
+    std::vector<Block> blocks;
+    forEachVertexRange(mesh, [&](const uint32_t first, const uint32_t count, const std::span<const uint32_t> objects)
+    {
+        const auto range = static_cast<uint32_t>(ranges.size());
+        ranges.emplace_back(first, count);
+        for (const uint32_t i : objects)
+            rangeOf[i] = range;
+        for (uint32_t offset = 0; offset < count; offset += BOUNDS_BLOCK)
+            blocks.push_back({ range, first + offset, std::min<uint32_t>(BOUNDS_BLOCK, count - offset) });
+        stats.vertices += count;
+    });
+    stats.ranges = ranges.size();
+
+    auto blockVertices = [&mesh](const Block& block) { return std::span<const Vertex>(mesh.vertices).subspan(block.first, block.count); };
+    std::vector<glm::vec3> blockLow(blocks.size()), blockHigh(blocks.size());
+    OttThreadPool::shared().parallelFor(blocks.size(), [&](const size_t b)
+    {
+        positionBounds(blockVertices(blocks[b]), blockLow[b], blockHigh[b], stats.path);
+    });
+    std::vector<glm::vec3> low(ranges.size(), glm::vec3(std::numeric_limits<float>::max()));
+    std::vector<glm::vec3> high(ranges.size(), glm::vec3(std::numeric_limits<float>::lowest()));
+    for (size_t b = 0; b < blocks.size(); b++)
     {
-        addEdge(indices[i], indices[i + 1]);
-        addEdge(indices[i + 1], indices[i + 2]);
-        addEdge(indices[i + 2], indices[i]);
+        low[blocks[b].range]  = glm::min(low[blocks[b].range], blockLow[b]);
+        high[blocks[b].range] = glm::max(high[blocks[b].range], blockHigh[b]);
     }
- 
-    // Collect edges that appear only once
-    for (const auto& [edge, count] : edgeCount)
+
+    std::vector<float> blockRadius(blocks.size());
+    OttThreadPool::shared().parallelFor(blocks.size(), [&](const size_t b)
     {
-        if (count == 1)
+        const uint32_t range = blocks[b].range;
+        blockRadius[b] = boundingRadius(blockVertices(blocks[b]), 0.5f * (low[range] + high[range]), stats.path);
+    });
+    std::vector<float> radius(ranges.size(), 0.0f);
+    for (size_t b = 0; b < blocks.size(); b++)
+        radius[blocks[b].range] = std::max(radius[blocks[b].range], blockRadius[b]);
+
+    mesh.bounds.clear();
+    for (size_t i = 0; i < mesh.objects.size(); i++)
+    {
+        const uint32_t range = rangeOf[i];
+        if (ranges[range].second == 0)
         {
-            edges.push_back(edge.first);
-            edges.push_back(edge.second);
+            mesh.bounds.append(low[range], high[range], glm::vec4(0.0f));
+            continue;
         }
+        const glm::vec3 center = 0.5f * (low[range] + high[range]);
+        mesh.bounds.append(low[range], high[range], glm::vec4(center, radius[range]), mesh.objects[i].transform);
     }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
+
+//----------------------------------------------------------------------------
+OttModel::PackedVertex OttModel::packVertex(const Vertex& vertex, const glm::vec3& offset, const glm::vec3& scale)
+{
+    PackedVertex packed {};
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const float fraction = scale[axis] > 0.0f ? (vertex.pos[axis] - offset[axis]) / scale[axis] : 0.0f;
+        packed.pos[axis] = static_cast<uint16_t>(std::lround(std::clamp(fraction, 0.0f, 1.0f) * UNORM16));
+    }
+    const glm::vec2 normal = octEncode(vertex.normal);
+    packed.normal   = { static_cast<int16_t>(glm::packSnorm1x16(normal.x)), static_cast<int16_t>(glm::packSnorm1x16(normal.y)) };
+    packed.texCoord = { glm::packHalf1x16(vertex.texCoord.x), glm::packHalf1x16(vertex.texCoord.y) };
+    packed.color    = { static_cast<uint8_t>(std::lround(std::clamp(vertex.color.x, 0.0f, 1.0f) * 255.0f)),
+                        static_cast<uint8_t>(std::lround(std::clamp(vertex.color.y, 0.0f, 1.0f) * 255.0f)),
+                        static_cast<uint8_t>(std::lround(std::clamp(vertex.color.z, 0.0f, 1.0f) * 255.0f)), 255 };
+    return packed;
+}
+
+//----------------------------------------------------------------------------
+OttModel::Vertex OttModel::unpackVertex(const PackedVertex& packed, const glm::vec3& offset, const glm::vec3& scale)
+{
+    const glm::vec3 fraction(float(packed.pos[0]) / UNORM16, float(packed.pos[1]) / UNORM16, float(packed.pos[2]) / UNORM16);
+    return {
+        .pos      = offset + scale * fraction,
+        .color    = glm::vec3(float(packed.color[0]), float(packed.color[1]), float(packed.color[2])) / 255.0f,
+        .texCoord = glm::vec2(glm::unpackHalf1x16(packed.texCoord[0]), glm::unpackHalf1x16(packed.texCoord[1])),
+        .normal   = octDecode(glm::vec2(glm::unpackSnorm1x16(static_cast<uint16_t>(packed.normal[0])),
+                                        glm::unpackSnorm1x16(static_cast<uint16_t>(packed.normal[1])))),
+    };
+}
+
+//----------------------------------------------------------------------------
+void OttModel::quantize(MeshData& mesh)
+{
+    forEachVertexRange(mesh, [&mesh](const uint32_t first, const uint32_t count, const std::span<const uint32_t> objects)
+    {
+        glm::vec3 lower, upper;
+        positionBounds(std::span<const Vertex>(mesh.vertices).subspan(first, count), lower, upper);
+        for (const uint32_t i : objects)
+        {
+            mesh.objects[i].quantOffset = lower;
+            mesh.objects[i].quantScale  = upper - lower;
+        }
+    });
+}
+
+//----------------------------------------------------------------------------
+/** Vertices ahead of the first object's range keep the identity box. **/
+void OttModel::packVertices(const MeshData& mesh, const std::span<PackedVertex> out)
+{
+    const uint32_t head = mesh.objects.empty() ? static_cast<uint32_t>(mesh.vertices.size())
+                        : std::ranges::min(mesh.objects, {}, &modelObject::startVertex).startVertex;
+    for (uint32_t v = 0; v < std::min<size_t>(head, mesh.vertices.size()); v++)
+        out[v] = packVertex(mesh.vertices[v], glm::vec3(0.0f), glm::vec3(1.0f));
+
+    forEachVertexRange(mesh, [&mesh, &out](const uint32_t first, const uint32_t count, const std::span<const uint32_t> objects)
+    {
+        const modelObject& object = mesh.objects[objects.front()];
+        for (uint32_t v = first; v < first + count; v++)
+            out[v] = packVertex(mesh.vertices[v], object.quantOffset, object.quantScale);
+    });
+}
+
+//----------------------------------------------------------------------------
+void OttModel::splitShortIndices(MeshData& mesh)
+{
+    auto forEachRange = [](const modelObject& object, auto&& visit)
+    {
+        visit(object.startIndex, object.indexCount);
+        for (uint32_t level = 0; level < object.lodCount; level++)
+            visit(object.lods[level].startIndex, object.lods[level].indexCount);
+    };
+
+    // Ranges by startIndex that have to stay 32-bit.
+    std::unordered_map<uint32_t, bool> fits;
+    std::unordered_set<uint32_t> longRanges;
+    for (const modelObject& object : mesh.objects)
+    {
+        bool fitting = object.meshletCount == 0;
+        forEachRange(object, [&](const uint32_t start, const uint32_t count)
+        {
+            const auto [entry, inserted] = fits.try_emplace(start, true);
+            if (inserted)
+            {
+                entry->second = std::ranges::all_of(std::span(mesh.indices).subspan(start, count),
+                                                    [](const uint32_t index) { return index < SHORT_INDEX_VERTICES; });
+            }
+            fitting = fitting && entry->second;
+        });
+        if (!fitting)
+            forEachRange(object, [&longRanges](const uint32_t start, uint32_t) { longRanges.insert(start); });
+    }
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (const modelObject& object : mesh.objects)
+        {
+            bool shared = false;
+            forEachRange(object, [&](const uint32_t start, uint32_t) { shared = shared || longRanges.contains(start); });
+            if (shared)
+                forEachRange(object, [&](const uint32_t start, uint32_t) { changed = longRanges.insert(start).second || changed; });
+        }
+    }
+
+    std::map<uint32_t, uint32_t> shortRanges;
+    for (const modelObject& object : mesh.objects)
+    {
+        if (!longRanges.contains(object.startIndex))
+            forEachRange(object, [&shortRanges](const uint32_t start, const uint32_t count) { shortRanges.emplace(start, count); });
+    }
+    if (shortRanges.empty())
+        return;
+
+    // Copies the indices between short ranges; removed holds (end of a short range, indices
+    // removed up to there) to rebase the 32-bit ranges after it.
+    std::vector<uint32_t> indices;
+    std::vector<std::pair<uint32_t, uint32_t>> removed;
+    std::unordered_map<uint32_t, uint32_t> moved;
+    indices.reserve(mesh.indices.size());
+    mesh.shortIndices.clear();
+    uint32_t cursor = 0;
+    for (const auto& [start, count] : shortRanges)
+    {
+        indices.insert(indices.end(), mesh.indices.begin() + cursor, mesh.indices.begin() + start);
+        moved.emplace(start, static_cast<uint32_t>(mesh.shortIndices.size()));
+        for (uint32_t i = start; i < start + count; i++)
+            mesh.shortIndices.push_back(static_cast<uint16_t>(mesh.indices[i]));
+        cursor = start + count;
+        removed.emplace_back(cursor, cursor - static_cast<uint32_t>(indices.size()));
+    }
+    indices.insert(indices.end(), mesh.indices.begin() + cursor, mesh.indices.end());
+
+    auto rebase = [&removed](const uint32_t start)
+    {
+        const auto after = std::ranges::upper_bound(removed, start, {}, &std::pair<uint32_t, uint32_t>::first);
+        return after == removed.begin() ? start : start - std::prev(after)->second;
+    };
+    for (modelObject& object : mesh.objects)
+    {
+        object.shortIndices = !longRanges.contains(object.startIndex);
+        auto place = [&](uint32_t& start) { start = object.shortIndices ? moved.at(start) : rebase(start); };
+        place(object.startIndex);
+        for (uint32_t level = 0; level < object.lodCount; level++)
+            place(object.lods[level].startIndex);
+    }
+    for (Meshlet& meshlet : mesh.meshlets)
+        meshlet.startIndex = rebase(meshlet.startIndex);
+    mesh.indices = std::move(indices);
+}
+
+//----------------------------------------------------------------------------
+/** Computes the boundary edges from a mesh.
+ *  In a triangle mesh an edge is either shared between two triangles or belongs to the
+ *  boundary of the mesh, appearing only once. Every triangle edge is packed into a single
+ *  integer key, (min, max) ordered so both windings of a shared edge meet. The keys are
+ *  radix sorted and an edge is a boundary edge when its key differs from both neighbours.
+ *
+ *  Edges come out ordered by (min, max), the order of the std::map counting this replaces,
+ *  originally provided by Yaliya on Reddit:
+ *  https://www.reddit.com/r/opengl/comments/1gpthh9/my_first_mesh_editor/ **/
+std::vector<uint32_t> OttModel::extractBoundaryEdges(const std::span<const uint32_t> indices)
+{
+    const size_t triangles = indices.size() / 3;
+    const size_t count     = triangles * 3;
+    if (count == 0)
+        return {};
+
+    // (min, max) packs into min * stride + max, which keeps the lexicographic order and
+    // needs far fewer radix passes than a 32:32 split when the indices are small.
+    const uint64_t stride = uint64_t(*std::ranges::max_element(indices.first(count))) + 1;
+    std::vector<uint64_t> keys(count);
+    const size_t blocks = (count + EDGE_BLOCK - 1) / EDGE_BLOCK;
+    OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+    {
+        const size_t last = std::min(count, (block + 1) * EDGE_BLOCK);
+        for (size_t i = block * EDGE_BLOCK; i < last; i++)
+        {
+            const size_t next = i % 3 == 2 ? i - 2 : i + 1;
+            const auto [low, high] = std::minmax(indices[i], indices[next]);
+            keys[i] = uint64_t(low) * stride + high;
+        }
+    });
+
+    OttRadix::sort(keys, std::bit_width(stride * stride - 1), [](const uint64_t key) { return key; });
+
+    auto isBoundary = [&keys, count](const size_t i)
+    {
+        return (i == 0 || keys[i] != keys[i - 1]) && (i + 1 == count || keys[i] != keys[i + 1]);
+    };
+
+    std::vector<size_t> firsts(blocks + 1, 0);
+    OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+    {
+        const size_t last = std::min(count, (block + 1) * EDGE_BLOCK);
+        for (size_t i = block * EDGE_BLOCK; i < last; i++)
+            firsts[block + 1] += isBoundary(i);
+    });
+    for (size_t block = 0; block < blocks; block++)
+        firsts[block + 1] += firsts[block];
+
+    std::vector<uint32_t> edges(2 * firsts[blocks]);
+    OttThreadPool::shared().parallelFor(blocks, [&](const size_t block)
+    {
+        uint32_t* out = edges.data() + 2 * firsts[block];
+        const size_t last = std::min(count, (block + 1) * EDGE_BLOCK);
+        for (size_t i = block * EDGE_BLOCK; i < last; i++)
+        {
+            if (!isBoundary(i))
+                continue;
+            *out++ = static_cast<uint32_t>(keys[i] / stride);
+            *out++ = static_cast<uint32_t>(keys[i] % stride);
+        }
+    });
     return edges;
 }
@@ -0,0 +1,193 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "normals.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+
+#include "threadpool.h"
+#include "utils.hxx"
+
+namespace
+{
+    constexpr size_t   BLOCK_SIZE = 1 << 14;
+    constexpr uint32_t NO_COPY    = UINT32_MAX;
+    constexpr float    SAME_COS   = 0.9999f;   // Corner normals this close share a vertex.
+
+    //----------------------------------------------------------------------------
+    /** Runs body(first, last) over count items in blocks on the shared pool. **/
+    template<typename Body>
+    void forEachBlock(const size_t count, Body&& body)
+    {
+        OttThreadPool::shared().parallelFor((count + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](const size_t block)
+        {
+            body(block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE));
+        });
+    }
+
+    //----------------------------------------------------------------------------
+    /** Dense ids of the distinct positions of vertices, in order of first occurrence, from
+     *  an open-addressing table of representative vertices. **/
+    uint32_t positionIds(const std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& position_of)
+    {
+        const size_t mask = std::bit_ceil(std::max<size_t>(vertices.size() * 2, 16)) - 1;
+        std::vector<uint32_t> table(mask + 1, UINT32_MAX);
+        position_of.resize(vertices.size());
+        uint32_t count = 0;
+        for (uint32_t v = 0; v < vertices.size(); v++)
+        {
+            // Adding zero turns -0 into +0, so equal positions hash alike.
+            const glm::vec3 key = vertices[v].pos + glm::vec3(0.0f);
+            for (size_t slot = Utils::hash64(&key, sizeof(key)) & mask; ; slot = (slot + 1) & mask)
+            {
+                if (table[slot] == UINT32_MAX)
+                {
+                    table[slot] = v;
+                    position_of[v] = count++;
+                    break;
+                }
+                if (vertices[table[slot]].pos == key)
+                {
+                    position_of[v] = position_of[table[slot]];
+                    break;
+                }
+            }
+        }
+        return count;
+    }
+
+    float cornerAngle(const glm::vec3& corner, const glm::vec3& a, const glm::vec3& b)
+    {
+        const glm::vec3 u = a - corner, v = b - corner;
+        const float lengths = glm::length(u) * glm::length(v);
+        return lengths > 0.0f ? std::acos(std::clamp(glm::dot(u, v) / lengths, -1.0f, 1.0f)) : 0.0f;
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttNormals::NormalStats OttNormals::generate(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                                             const NormalOptions& options)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    NormalStats stats { .triangles = indices.size() / 3 };
+    const size_t corners = stats.triangles * 3;
+
+    // Unit face normals, and the weight each corner gives its face.
+    std::vector<glm::vec3> faceNormals(stats.triangles);
+    std::vector<float> weights(corners);
+    forEachBlock(stats.triangles, [&](const size_t first, const size_t last)
+    {
+        for (size_t t = first; t < last; t++)
+        {
+            const glm::vec3& a = vertices[indices[3 * t]].pos;
+            const glm::vec3& b = vertices[indices[3 * t + 1]].pos;
+            const glm::vec3& c = vertices[indices[3 * t + 2]].pos;
+            const glm::vec3 cross = glm::cross(b - a, c - a);
+            const float twiceArea = glm::length(cross);
+            faceNormals[t] = twiceArea > 0.0f ? cross / twiceArea : glm::vec3(0.0f);
+            if (options.weighting == Weighting::Area)
+            {
+                weights[3 * t] = weights[3 * t + 1] = weights[3 * t + 2] = twiceArea;
+            }
+            else
+            {
+                weights[3 * t]     = cornerAngle(a, b, c);
+                weights[3 * t + 1] = cornerAngle(b, c, a);
+                weights[3 * t + 2] = cornerAngle(c, a, b);
+            }
+        }
+    });
+
+    // Corners grouped by position, so UV seams don't split the sums.
+    std::vector<uint32_t> positionOf;
+    const uint32_t positions = positionIds(vertices, positionOf);
+    std::vector<uint32_t> cornerStart(positions + 1, 0);
+    for (size_t c = 0; c < corners; c++)
+        cornerStart[positionOf[indices[c]] + 1]++;
+    for (size_t p = 0; p < positions; p++)
+        cornerStart[p + 1] += cornerStart[p];
+    std::vector<uint32_t> cornersAt(corners);
+    std::vector<uint32_t> fill(cornerStart.begin(), cornerStart.end() - 1);
+    for (size_t c = 0; c < corners; c++)
+        cornersAt[fill[positionOf[indices[c]]]++] = static_cast<uint32_t>(c);
+
+    const float creaseCos = std::cos(glm::radians(std::clamp(options.creaseAngleDegrees, 0.0f, 180.0f)));
+    std::vector<glm::vec3> cornerNormals(corners, glm::vec3(0.0f));
+    forEachBlock(positions, [&](const size_t first, const size_t last)
+    {
+        for (size_t p = first; p < last; p++)
+        {
+            for (uint32_t i = cornerStart[p]; i < cornerStart[p + 1]; i++)
+            {
+                const glm::vec3& own = faceNormals[cornersAt[i] / 3];
+                if (own == glm::vec3(0.0f))
+                    continue;
+                glm::vec3 sum(0.0f);
+                for (uint32_t j = cornerStart[p]; j < cornerStart[p + 1]; j++)
+                {
+                    const glm::vec3& other = faceNormals[cornersAt[j] / 3];
+                    if (glm::dot(own, other) >= creaseCos - 1e-6f)
+                        sum += weights[cornersAt[j]] * other;
+                }
+                const float length = glm::length(sum);
+                cornerNormals[cornersAt[i]] = length > 0.0f ? sum / length : own;
+            }
+        }
+    });
+
+    // Corners keep their vertex when it has their normal (or none yet), else move to a copy.
+    const size_t original = vertices.size();
+    std::vector<uint32_t> nextCopy(original, NO_COPY);
+    std::vector<uint8_t> assigned(original, 0);
+    for (size_t c = 0; c < corners; c++)
+    {
+        const glm::vec3& normal = cornerNormals[c];
+        if (normal == glm::vec3(0.0f))
+            continue;
+        uint32_t vertex = indices[c];
+        if (!assigned[vertex])
+        {
+            vertices[vertex].normal = normal;
+            assigned[vertex] = 1;
+            continue;
+        }
+        while (glm::dot(vertices[vertex].normal, normal) < SAME_COS && nextCopy[vertex] != NO_COPY)
+            vertex = nextCopy[vertex];
+        if (glm::dot(vertices[vertex].normal, normal) < SAME_COS)
+        {
+            OttModel::Vertex copy = vertices[vertex];
+            copy.normal = normal;
+            nextCopy[vertex] = static_cast<uint32_t>(vertices.size());
+            nextCopy.push_back(NO_COPY);
+            assigned.push_back(1);
+            vertices.push_back(copy);
+            vertex = nextCopy[vertex];
+        }
+        indices[c] = vertex;
+    }
+    for (size_t v = 0; v < original; v++)
+    {
+        if (!assigned[v])
+            vertices[v].normal = glm::vec3(0.0f);
+    }
+
+    stats.splitVertices = vertices.size() - original;
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
@@ -0,0 +1,789 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "objloader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+
+#include "mappedfile.h"
+#include "threadpool.h"
+
+namespace
+{
+    // Below this size a chunk costs more to schedule than to parse.
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    constexpr double POWERS_OF_TEN[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    //----------------------------------------------------------------------------
+    /** A run of faces that share the same group, material and smoothing state.
+     *  A new segment starts at every g/o/usemtl/s statement, since the state they set
+     *  can only be resolved once all previous chunks are known. **/
+    struct Segment
+    {
+        bool        startsGroup   = false;
+        bool        setsMaterial  = false;
+        bool        setsSmoothing = false;
+        std::string groupName;
+        std::string materialName;
+        unsigned    smoothingId   = 0;
+
+        std::vector<tinyobj::index_t> corners;
+        std::vector<uint32_t>         faceSizes;
+
+        // Filled while stitching the chunks together.
+        int      materialId = -1;
+        unsigned smoothing  = 0;
+
+        std::vector<tinyobj::index_t> triangles;
+        size_t                        triangleOffset = 0;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Corner holding at least one negative OBJ index. The stored value is relative to the
+     *  start of its chunk and gets the chunk's global attribute base added afterwards. **/
+    struct RelativeCorner
+    {
+        uint32_t segment;
+        uint32_t corner;
+        uint8_t  components; // bit 0: v, bit 1: vt, bit 2: vn
+    };
+
+    struct Chunk
+    {
+        std::vector<float>          positions;
+        std::vector<float>          colors;
+        std::vector<float>          texcoords;
+        std::vector<float>          normals;
+        std::vector<Segment>        segments;
+        std::vector<RelativeCorner> relativeCorners;
+        std::vector<std::string>    mtllibs;
+        std::string                 err;
+        size_t                      invalidFaces    = 0;
+        size_t                      degenerateFaces = 0;
+    };
+
+    struct ShapePlan
+    {
+        std::string           name;
+        std::vector<Segment*> segments;
+    };
+
+    //----------------------------------------------------------------------------
+    inline bool isBlank(const char c)   { return c == ' ' || c == '\t'; }
+    inline bool isDigit(const char c)   { return static_cast<unsigned char>(c - '0') < 10; }
+
+    inline const char* skipBlanks(const char* cursor, const char* end)
+    {
+        while (cursor < end && isBlank(*cursor))
+            cursor++;
+        return cursor;
+    }
+
+    //----------------------------------------------------------------------------
+    /** SWAR digit handling: checks and converts eight ASCII digits held in one 64-bit
+     *  little-endian word at once, instead of looping over them one by one. **/
+    inline uint64_t loadEightBytes(const char* cursor)
+    {
+        uint64_t word;
+        std::memcpy(&word, cursor, sizeof(word));
+        return word;
+    }
+
+    inline bool isEightDigits(const uint64_t word)
+    {
+        return (((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+                == 0x3333333333333333);
+    }
+
+    inline uint32_t parseEightDigits(uint64_t word)
+    {
+        constexpr uint64_t mask = 0x000000FF000000FF;
+        constexpr uint64_t mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+        constexpr uint64_t mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+        word -= 0x3030303030303030;
+        word = (word * 10) + (word >> 8);
+        word = (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+        return static_cast<uint32_t>(word);
+    }
+
+    //----------------------------------------------------------------------------
+    /** Accumulates a run of digits into mantissa. Returns the number of digits read;
+     *  digits beyond 19 do not fit in the mantissa and are reported through overflow. **/
+    inline int parseDigits(const char*& cursor, const char* end, uint64_t& mantissa, int& significant, bool& overflow)
+    {
+        const char* start = cursor;
+        if constexpr (std::endian::native == std::endian::little)
+        {
+            while (end - cursor >= 8 && significant <= 11 && isEightDigits(loadEightBytes(cursor)))
+            {
+                mantissa     = mantissa * 100000000 + parseEightDigits(loadEightBytes(cursor));
+                cursor      += 8;
+                significant += 8;
+            }
+        }
+        while (cursor < end && isDigit(*cursor))
+        {
+            if (significant < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+                if (mantissa != 0)
+                    significant++;
+            }
+            else
+                overflow = true;
+            cursor++;
+        }
+        return static_cast<int>(cursor - start);
+    }
+
+    //----------------------------------------------------------------------------
+    inline bool parseInt(const char*& cursor, const char* end, int& value)
+    {
+        const char* p = cursor;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = (*p++ == '-');
+        if (p >= end || !isDigit(*p))
+            return false;
+
+        int64_t result = 0;
+        while (p < end && isDigit(*p))
+        {
+            result = std::min<int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+            p++;
+        }
+        value  = static_cast<int>(negative ? -result : result);
+        cursor = p;
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    inline std::string_view nextToken(const char*& cursor, const char* end)
+    {
+        cursor = skipBlanks(cursor, end);
+        const char* start = cursor;
+        while (cursor < end && !isBlank(*cursor))
+            cursor++;
+        return { start, static_cast<size_t>(cursor - start) };
+    }
+
+    inline std::string_view trimRight(const char* begin, const char* end)
+    {
+        while (end > begin && isBlank(end[-1]))
+            end--;
+        return { begin, static_cast<size_t>(end - begin) };
+    }
+
+    //----------------------------------------------------------------------------
+    inline float parseFloatOr(const char*& cursor, const char* end, const float fallback)
+    {
+        float value;
+        return OttObj::parseFloat(cursor, end, value) ? value : fallback;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Converts an OBJ index into the tinyobj 0-based convention.
+     *  Negative indices are kept relative to the start of the chunk. **/
+    inline bool resolveIndex(const int raw, const size_t local_count, int& resolved, bool& relative)
+    {
+        relative = raw < 0;
+        if (raw > 0)        { resolved = raw - 1; return true; }
+        if (raw < 0)        { resolved = static_cast<int>(local_count) + raw; return true; }
+        return false;
+    }
+
+    //----------------------------------------------------------------------------
+    Segment& segmentForDirective(Chunk& chunk)
+    {
+        if (chunk.segments.back().faceSizes.empty())
+            return chunk.segments.back();
+        return chunk.segments.emplace_back();
+    }
+
+    //----------------------------------------------------------------------------
+    /** Parses one `f` statement into the current segment. **/
+    bool parseFace(const char* cursor, const char* end, Chunk& chunk)
+    {
+        Segment& segment   = chunk.segments.back();
+        const size_t first = segment.corners.size();
+        const size_t vCount  = chunk.positions.size() / 3;
+        const size_t vtCount = chunk.texcoords.size() / 2;
+        const size_t vnCount = chunk.normals.size() / 3;
+
+        while (true)
+        {
+            cursor = skipBlanks(cursor, end);
+            if (cursor >= end)
+                break;
+
+            tinyobj::index_t corner { -1, -1, -1 };
+            uint8_t relativeMask = 0;
+            int  raw;
+            bool relative;
+
+            if (!parseInt(cursor, end, raw) || !resolveIndex(raw, vCount, corner.vertex_index, relative))
+            {
+                chunk.err += "Failed to parse `f' line (e.g. zero value for vertex index or invalid relative vertex index).\n";
+                return false;
+            }
+            relativeMask |= relative ? 1 : 0;
+
+            if (cursor < end && *cursor == '/')
+            {
+                cursor++;
+                if (cursor < end && *cursor != '/' && parseInt(cursor, end, raw))
+                {
+                    if (resolveIndex(raw, vtCount, corner.texcoord_index, relative))
+                        relativeMask |= relative ? 2 : 0;
+                    else
+                        corner.texcoord_index = -1;
+                }
+                if (cursor < end && *cursor == '/')
+                {
+                    cursor++;
+                    if (parseInt(cursor, end, raw))
+                    {
+                        if (resolveIndex(raw, vnCount, corner.normal_index, relative))
+                            relativeMask |= relative ? 4 : 0;
+                        else
+                            corner.normal_index = -1;
+                    }
+                }
+            }
+            // Skip anything unexpected up to the next blank so a malformed corner cannot stall the loop.
+            while (cursor < end && !isBlank(*cursor))
+                cursor++;
+
+            if (relativeMask != 0)
+            {
+                chunk.relativeCorners.push_back({
+                    .segment    = static_cast<uint32_t>(chunk.segments.size() - 1),
+                    .corner     = static_cast<uint32_t>(segment.corners.size()),
+                    .components = relativeMask,
+                });
+            }
+            segment.corners.push_back(corner);
+        }
+        segment.faceSizes.push_back(static_cast<uint32_t>(segment.corners.size() - first));
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Parses a single line. The [cursor, end) range excludes the line terminator. **/
+    bool parseLine(const char* cursor, const char* end, Chunk& chunk)
+    {
+        if (end > cursor && end[-1] == '\r')
+            end--;
+        cursor = skipBlanks(cursor, end);
+        if (cursor >= end || *cursor == '#')
+            return true;
+
+        const size_t length = static_cast<size_t>(end - cursor);
+        auto keyword = [cursor, length](const char* word, const size_t size)
+        {
+            return length > size && std::memcmp(cursor, word, size) == 0 && isBlank(cursor[size]);
+        };
+
+        if (keyword("v", 1))
+        {
+            cursor += 2;
+            const float x = parseFloatOr(cursor, end, 0.0f);
+            const float y = parseFloatOr(cursor, end, 0.0f);
+            const float z = parseFloatOr(cursor, end, 0.0f);
+            chunk.positions.insert(chunk.positions.end(), { x, y, z });
+
+            // Optional vertex color extension: only a full r g b triple counts.
+            float r, g, b;
+            if (!(OttObj::parseFloat(cursor, end, r) && OttObj::parseFloat(cursor, end, g) && OttObj::parseFloat(cursor, end, b)))
+                r = g = b = 1.0f;
+            chunk.colors.insert(chunk.colors.end(), { r, g, b });
+            return true;
+        }
+        if (keyword("vt", 2))
+        {
+            cursor += 3;
+            const float u = parseFloatOr(cursor, end, 0.0f);
+            const float v = parseFloatOr(cursor, end, 0.0f);
+            chunk.texcoords.insert(chunk.texcoords.end(), { u, v });
+            return true;
+        }
+        if (keyword("vn", 2))
+        {
+            cursor += 3;
+            const float x = parseFloatOr(cursor, end, 0.0f);
+            const float y = parseFloatOr(cursor, end, 0.0f);
+            const float z = parseFloatOr(cursor, end, 0.0f);
+            chunk.normals.insert(chunk.normals.end(), { x, y, z });
+            return true;
+        }
+        if (keyword("f", 1))
+            return parseFace(cursor + 2, end, chunk);
+
+        if (keyword("g", 1))
+        {
+            // tinyobj joins multiple group names with a single space.
+            cursor += 2;
+            std::string name;
+            for (std::string_view token = nextToken(cursor, end); !token.empty(); token = nextToken(cursor, end))
+            {
+                if (!name.empty())
+                    name += ' ';
+                name += token;
+            }
+            Segment& segment    = segmentForDirective(chunk);
+            segment.startsGroup = true;
+            segment.groupName   = std::move(name);
+            return true;
+        }
+        if (keyword("o", 1))
+        {
+            Segment& segment    = segmentForDirective(chunk);
+            segment.startsGroup = true;
+            segment.groupName   = trimRight(skipBlanks(cursor + 2, end), end);
+            return true;
+        }
+        if (keyword("usemtl", 6))
+        {
+            cursor += 7;
+            Segment& segment     = segmentForDirective(chunk);
+            segment.setsMaterial = true;
+            segment.materialName = nextToken(cursor, end);
+            return true;
+        }
+        if (keyword("mtllib", 6))
+        {
+            chunk.mtllibs.emplace_back(trimRight(skipBlanks(cursor + 7, end), end));
+            return true;
+        }
+        if (keyword("s", 1))
+        {
+            cursor += 2;
+            const std::string_view token = nextToken(cursor, end);
+            int id = 0;
+            const char* digits = token.data();
+            if (token != "off")
+                parseInt(digits, token.data() + token.size(), id);
+            Segment& segment      = segmentForDirective(chunk);
+            segment.setsSmoothing = true;
+            segment.smoothingId   = static_cast<unsigned>(std::max(id, 0));
+            return true;
+        }
+        // Free-form curves, lines, points and any other statement are ignored like tinyobj does.
+        return true;
+    }
+
+    //----------------------------------------------------------------------------
+    void parseChunk(const char* begin, const char* end, Chunk& chunk)
+    {
+        chunk.segments.emplace_back();
+        // Rough reservation: BIM exports are dominated by `v` and `f` lines of ~30 bytes.
+        const size_t estimatedLines = static_cast<size_t>(end - begin) / 32;
+        chunk.positions.reserve(estimatedLines * 3 / 2);
+        chunk.colors.reserve(estimatedLines * 3 / 2);
+
+        const char* cursor = begin;
+        while (cursor < end)
+        {
+            const void* newline = std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+            const char* lineEnd = newline ? static_cast<const char*>(newline) : end;
+            if (!parseLine(cursor, lineEnd, chunk))
+                return;
+            cursor = lineEnd + 1;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Splits a polygon run into triangles following tinyobj's rules: quads are split
+     *  along their shorter diagonal, larger polygons are fanned from the first corner. **/
+    void triangulateSegment(Segment& segment, const std::vector<float>& positions,
+                            const size_t vCount, const size_t vtCount, const size_t vnCount,
+                            size_t& invalid_faces, size_t& degenerate_faces)
+    {
+        segment.triangles.reserve(segment.corners.size() * 3 / 2);
+
+        auto inRange = [vCount, vtCount, vnCount](const tinyobj::index_t& c)
+        {
+            return c.vertex_index >= 0 && static_cast<size_t>(c.vertex_index) < vCount &&
+                   (c.texcoord_index < 0 || static_cast<size_t>(c.texcoord_index) < vtCount) &&
+                   (c.normal_index   < 0 || static_cast<size_t>(c.normal_index)   < vnCount);
+        };
+        auto distanceSquared = [&positions](const tinyobj::index_t& a, const tinyobj::index_t& b)
+        {
+            const float* pa = &positions[3 * static_cast<size_t>(a.vertex_index)];
+            const float* pb = &positions[3 * static_cast<size_t>(b.vertex_index)];
+            const float dx = pb[0] - pa[0], dy = pb[1] - pa[1], dz = pb[2] - pa[2];
+            return dx * dx + dy * dy + dz * dz;
+        };
+
+        size_t first = 0;
+        for (const uint32_t faceSize : segment.faceSizes)
+        {
+            const tinyobj::index_t* c = &segment.corners[first];
+            first += faceSize;
+
+            if (faceSize < 3)
+            {
+                degenerate_faces++;
+                continue;
+            }
+            if (!std::all_of(c, c + faceSize, inRange))
+            {
+                invalid_faces++;
+                continue;
+            }
+
+            if (faceSize == 3)
+                segment.triangles.insert(segment.triangles.end(), { c[0], c[1], c[2] });
+            else if (faceSize == 4)
+            {
+                if (distanceSquared(c[0], c[2]) < distanceSquared(c[1], c[3]))
+                    segment.triangles.insert(segment.triangles.end(), { c[0], c[1], c[2], c[0], c[2], c[3] });
+                else
+                    segment.triangles.insert(segment.triangles.end(), { c[0], c[1], c[3], c[1], c[2], c[3] });
+            }
+            else
+            {
+                for (uint32_t k = 1; k + 1 < faceSize; k++)
+                    segment.triangles.insert(segment.triangles.end(), { c[0], c[k], c[k + 1] });
+            }
+        }
+        segment.corners   = {};
+        segment.faceSizes = {};
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Decimal parser with a Clinger fast path: when the significand fits in 53 bits and the
+ *  decimal exponent is within 10^22 the result is exact in double precision, which covers
+ *  practically every coordinate written by CAD exporters. Anything else (long significands,
+ *  huge exponents) falls back to strtod on the isolated token. **/
+bool OttObj::parseFloat(const char*& cursor, const char* end, float& value)
+{
+    const char* p = skipBlanks(cursor, end);
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = (*p++ == '-');
+
+    uint64_t mantissa    = 0;
+    int      significant = 0;
+    int      exponent    = 0;
+    bool     overflow    = false;
+
+    int digitCount = parseDigits(p, end, mantissa, significant, overflow);
+    if (p < end && *p == '.')
+    {
+        p++;
+        const char* fraction = p;
+        digitCount += parseDigits(p, end, mantissa, significant, overflow);
+        // Only exact when no digit was dropped; an overflowing mantissa takes the slow path anyway.
+        exponent -= static_cast<int>(p - fraction);
+    }
+    if (digitCount == 0)
+        return false;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponentStart = p + 1;
+        int exponentValue;
+        if (parseInt(exponentStart, end, exponentValue))
+        {
+            // Far beyond any double, so the sum cannot overflow and strtod still sees the token.
+            exponent += std::clamp(exponentValue, -100000, 100000);
+            p = exponentStart;
+        }
+    }
+
+    if (!overflow && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        double result = static_cast<double>(mantissa);
+        result = exponent < 0 ? result / POWERS_OF_TEN[-exponent] : result * POWERS_OF_TEN[exponent];
+        value  = static_cast<float>(negative ? -result : result);
+        cursor = p;
+        return true;
+    }
+
+    // Slow path: re-scan the token and let the C library round it.
+    const char* tokenEnd = start;
+    while (tokenEnd < end && !isBlank(*tokenEnd) && *tokenEnd != '/')
+        tokenEnd++;
+    const std::string token(start, tokenEnd);
+    char* parsedEnd = nullptr;
+    const double result = std::strtod(token.c_str(), &parsedEnd);
+    if (parsedEnd == token.c_str())
+        return false;
+    value  = static_cast<float>(result);
+    cursor = start + (parsedEnd - token.c_str());
+    return true;
+}
+
+//----------------------------------------------------------------------------
+bool OttObj::LoadObj(tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+                     std::string* warn, std::string* err,
+                     const std::filesystem::path& filename, const std::filesystem::path& mtl_basedir,
+                     ParseStats* stats)
+{
+    const OttMappedFile file(filename);
+    if (!file.isOpen())
+    {
+        if (err)
+            *err += "Cannot open file [" + filename.string() + "]\n";
+        return false;
+    }
+    return ParseObj(file.view(), attrib, shapes, materials, warn, err, mtl_basedir, stats);
+}
+
+//----------------------------------------------------------------------------
+/** Three phases:
+ *  1. Tokenize line-aligned chunks in parallel, keeping negative indices chunk-relative.
+ *  2. Stitch sequentially: prefix-sum attribute counts, resolve group/material state
+ *     across chunk borders and read the referenced .mtl files.
+ *  3. Copy attributes, fix up relative indices and triangulate segments in parallel. **/
+bool OttObj::ParseObj(std::string_view text,
+                      tinyobj::attrib_t* attrib, std::vector<tinyobj::shape_t>* shapes, std::vector<tinyobj::material_t>* materials,
+                      std::string* warn, std::string* err,
+                      const std::filesystem::path& mtl_basedir,
+                      ParseStats* stats)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    OttThreadPool& pool  = OttThreadPool::shared();
+
+    attrib->vertices.clear();
+    attrib->colors.clear();
+    attrib->texcoords.clear();
+    attrib->normals.clear();
+    shapes->clear();
+
+    // Phase 1: chunking and tokenization.
+    const size_t maxChunks  = (pool.size() + 1) * 4;
+    const size_t chunkCount = std::clamp<size_t>(text.size() / MIN_CHUNK_BYTES, 1, maxChunks);
+
+    std::vector<const char*> bounds(chunkCount + 1);
+    bounds.front() = text.data();
+    bounds.back()  = text.data() + text.size();
+    for (size_t i = 1; i < chunkCount; i++)
+    {
+        const char* cut = std::max(bounds[i - 1], text.data() + text.size() * i / chunkCount);
+        const void* newline = std::memchr(cut, '\n', static_cast<size_t>(bounds.back() - cut));
+        bounds[i] = newline ? static_cast<const char*>(newline) + 1 : bounds.back();
+    }
+
+    std::vector<Chunk> chunks(chunkCount);
+    pool.parallelFor(chunkCount, [&](const size_t i) { parseChunk(bounds[i], bounds[i + 1], chunks[i]); });
+
+    for (const Chunk& chunk : chunks)
+    {
+        if (!chunk.err.empty())
+        {
+            if (err)
+                *err += chunk.err;
+            return false;
+        }
+    }
+
+    // Phase 2: stitching.
+    std::vector<size_t> vBase(chunkCount + 1, 0), vtBase(chunkCount + 1, 0), vnBase(chunkCount + 1, 0);
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+        vBase[i + 1]  = vBase[i]  + chunks[i].positions.size() / 3;
+        vtBase[i + 1] = vtBase[i] + chunks[i].texcoords.size() / 2;
+        vnBase[i + 1] = vnBase[i] + chunks[i].normals.size() / 3;
+    }
+
+    std::string baseDir = mtl_basedir.string();
+    if (!baseDir.empty() && baseDir.back() != '/' && baseDir.back() != '\\')
+        baseDir += static_cast<char>(std::filesystem::path::preferred_separator);
+
+    tinyobj::MaterialFileReader materialReader(baseDir);
+    std::map<std::string, int> materialMap;
+    std::set<std::string>      loadedMaterialFiles;
+    std::string                materialWarnings;
+    for (const Chunk& chunk : chunks)
+    {
+        for (const std::string& line : chunk.mtllibs)
+        {
+            const char* cursor = line.data();
+            const char* end    = line.data() + line.size();
+            bool found = false;
+            for (std::string_view name = nextToken(cursor, end); !name.empty() && !found; name = nextToken(cursor, end))
+            {
+                const std::string filename(name);
+                if (loadedMaterialFiles.contains(filename))
+                {
+                    found = true;
+                    continue;
+                }
+                std::string mtlWarn, mtlErr;
+                found = materialReader(filename, materials, &materialMap, &mtlWarn, &mtlErr);
+                materialWarnings += mtlWarn;
+                if (found)
+                    loadedMaterialFiles.insert(filename);
+            }
+            if (!found)
+                materialWarnings += "Failed to load material file(s). Use default material.\n";
+        }
+    }
+
+    std::vector<ShapePlan> plans(1);
+    int      currentMaterial  = -1;
+    unsigned currentSmoothing = 0;
+    for (Chunk& chunk : chunks)
+    {
+        for (Segment& segment : chunk.segments)
+        {
+            if (segment.startsGroup)
+            {
+                if (!plans.back().segments.empty())
+                    plans.emplace_back();
+                plans.back().name = segment.groupName;
+            }
+            if (segment.setsMaterial)
+            {
+                const auto material = materialMap.find(segment.materialName);
+                currentMaterial = material != materialMap.end() ? material->second : -1;
+                if (material == materialMap.end())
+                    materialWarnings += "material [ '" + segment.materialName + "' ] not found in .mtl\n";
+            }
+            if (segment.setsSmoothing)
+                currentSmoothing = segment.smoothingId;
+
+            segment.materialId = currentMaterial;
+            segment.smoothing  = currentSmoothing;
+            if (!segment.faceSizes.empty())
+                plans.back().segments.push_back(&segment);
+        }
+    }
+
+    // Phase 3: attribute copy, relative index fix-up and triangulation.
+    attrib->vertices.resize(vBase.back() * 3);
+    attrib->colors.resize(vBase.back() * 3);
+    attrib->texcoords.resize(vtBase.back() * 2);
+    attrib->normals.resize(vnBase.back() * 3);
+
+    std::atomic<bool> badRelativeIndex = false;
+    pool.parallelFor(chunkCount, [&](const size_t i)
+    {
+        Chunk& chunk = chunks[i];
+        std::ranges::copy(chunk.positions, attrib->vertices.begin()  + static_cast<ptrdiff_t>(vBase[i] * 3));
+        std::ranges::copy(chunk.colors,    attrib->colors.begin()    + static_cast<ptrdiff_t>(vBase[i] * 3));
+        std::ranges::copy(chunk.texcoords, attrib->texcoords.begin() + static_cast<ptrdiff_t>(vtBase[i] * 2));
+        std::ranges::copy(chunk.normals,   attrib->normals.begin()   + static_cast<ptrdiff_t>(vnBase[i] * 3));
+        chunk.positions = {};
+        chunk.colors    = {};
+        chunk.texcoords = {};
+        chunk.normals   = {};
+
+        for (const RelativeCorner& relative : chunk.relativeCorners)
+        {
+            tinyobj::index_t& corner = chunk.segments[relative.segment].corners[relative.corner];
+            if (relative.components & 1) corner.vertex_index   += static_cast<int>(vBase[i]);
+            if (relative.components & 2) corner.texcoord_index += static_cast<int>(vtBase[i]);
+            if (relative.components & 4) corner.normal_index   += static_cast<int>(vnBase[i]);
+            if (corner.vertex_index < 0 || ((relative.components & 2) && corner.texcoord_index < 0) ||
+                ((relative.components & 4) && corner.normal_index < 0))
+                badRelativeIndex = true;
+        }
+    });
+    if (badRelativeIndex)
+    {
+        if (err)
+            *err += "Failed to parse `f' line (e.g. zero value for vertex index or invalid relative vertex index).\n";
+        return false;
+    }
+
+    std::vector<Segment*> allSegments;
+    for (const ShapePlan& plan : plans)
+        allSegments.insert(allSegments.end(), plan.segments.begin(), plan.segments.end());
+
+    std::atomic<size_t> invalidFaces = 0, degenerateFaces = 0;
+    pool.parallelFor(allSegments.size(), [&](const size_t i)
+    {
+        size_t invalid = 0, degenerate = 0;
+        triangulateSegment(*allSegments[i], attrib->vertices, vBase.back(), vtBase.back(), vnBase.back(), invalid, degenerate);
+        invalidFaces    += invalid;
+        degenerateFaces += degenerate;
+    });
+
+    for (ShapePlan& plan : plans)
+    {
+        size_t corners = 0;
+        for (Segment* segment : plan.segments)
+        {
+            segment->triangleOffset = corners;
+            corners += segment->triangles.size();
+        }
+        if (corners == 0)
+            continue;
+
+        tinyobj::shape_t& shape = shapes->emplace_back();
+        shape.name = plan.name;
+        shape.mesh.indices.resize(corners);
+        shape.mesh.num_face_vertices.assign(corners / 3, 3);
+        shape.mesh.material_ids.resize(corners / 3);
+        shape.mesh.smoothing_group_ids.resize(corners / 3);
+    }
+
+    size_t shapeIndex = 0;
+    std::vector<std::pair<Segment*, tinyobj::shape_t*>> copies;
+    for (ShapePlan& plan : plans)
+    {
+        if (std::ranges::all_of(plan.segments, [](const Segment* s) { return s->triangles.empty(); }))
+            continue;
+        for (Segment* segment : plan.segments)
+            copies.emplace_back(segment, &(*shapes)[shapeIndex]);
+        shapeIndex++;
+    }
+
+    pool.parallelFor(copies.size(), [&copies](const size_t i)
+    {
+        auto& [segment, shape] = copies[i];
+        const size_t triangleOffset = segment->triangleOffset / 3;
+        std::ranges::copy(segment->triangles, shape->mesh.indices.begin() + static_cast<ptrdiff_t>(segment->triangleOffset));
+        std::fill_n(shape->mesh.material_ids.begin()        + static_cast<ptrdiff_t>(triangleOffset), segment->triangles.size() / 3, segment->materialId);
+        std::fill_n(shape->mesh.smoothing_group_ids.begin() + static_cast<ptrdiff_t>(triangleOffset), segment->triangles.size() / 3, segment->smoothing);
+        segment->triangles = {};
+    });
+
+    if (warn)
+    {
+        *warn += materialWarnings;
+        if (degenerateFaces > 0)
+            *warn += "Degenerated face found: " + std::to_string(degenerateFaces.load()) + " face(s) with fewer than three corners skipped.\n";
+        if (invalidFaces > 0)
+            *warn += std::to_string(invalidFaces.load()) + " face(s) referencing missing vertices skipped.\n";
+    }
+
+    if (stats)
+    {
+        stats->bytes   = text.size();
+        stats->chunks  = chunkCount;
+        stats->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    }
+    return true;
+}
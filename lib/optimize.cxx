@@ -0,0 +1,472 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "optimize.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include "threadpool.h"
+
+namespace
+{
+    // Forsyth's constants: the LRU cache the scores model, the flat score of the last
+    // triangle's vertices, the falloff behind them and the bonus for vertices with few
+    // triangles left, so none are left stranded.
+    constexpr uint32_t SCORE_CACHE_SIZE    = 32;
+    constexpr float    LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float    CACHE_DECAY_POWER   = 1.5f;
+    constexpr float    VALENCE_BOOST_SCALE = 2.0f;
+    constexpr float    VALENCE_BOOST_POWER = 0.5f;
+    constexpr uint32_t NONE = UINT32_MAX;
+
+    //----------------------------------------------------------------------------
+    /** Numbers the vertices of indices densely, in order of first use, into local;
+     *  returns how many there are. Ranges addressing few vertices of a large span (a
+     *  meshlet, for instance) are numbered through a sorted copy instead of a table. **/
+    uint32_t denseIds(const std::span<const uint32_t> indices, std::vector<uint32_t>& local)
+    {
+        local.resize(indices.size());
+        if (indices.empty())
+            return 0;
+
+        const uint32_t largest = *std::ranges::max_element(indices);
+        if (largest / 4 <= indices.size())
+        {
+            std::vector<uint32_t> table(size_t(largest) + 1, NONE);
+            uint32_t count = 0;
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                uint32_t& id = table[indices[i]];
+                if (id == NONE)
+                    id = count++;
+                local[i] = id;
+            }
+            return count;
+        }
+
+        std::vector<uint32_t> sorted(indices.begin(), indices.end());
+        std::ranges::sort(sorted);
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        for (size_t i = 0; i < indices.size(); i++)
+            local[i] = static_cast<uint32_t>(std::ranges::lower_bound(sorted, indices[i]) - sorted.begin());
+        return static_cast<uint32_t>(sorted.size());
+    }
+
+    //----------------------------------------------------------------------------
+    /** A FIFO cache by timestamps: a vertex is cached while fewer than size misses
+     *  happened since its own. reset() empties it without touching the table. **/
+    struct FifoCache
+    {
+        std::vector<uint32_t> stamps;
+        uint32_t size;
+        uint32_t time;
+
+        FifoCache(const uint32_t vertex_count, const uint32_t cache_size)
+            : stamps(vertex_count, 0), size(cache_size), time(cache_size + 1) {}
+
+        uint32_t access(const uint32_t vertex)
+        {
+            if (time - stamps[vertex] <= size)
+                return 0;
+            stamps[vertex] = time++;
+            return 1;
+        }
+
+        uint32_t triangle(const uint32_t* corners) { return access(corners[0]) + access(corners[1]) + access(corners[2]); }
+
+        void reset() { time += size + 1; }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Forsyth's vertex score, from tables: cache_position is -1 outside the cache. **/
+    float vertexScore(const int32_t cache_position, const uint32_t remaining)
+    {
+        constexpr uint32_t VALENCE_TABLE_SIZE = 32;
+        static const auto tables = []
+        {
+            std::pair<std::array<float, SCORE_CACHE_SIZE>, std::array<float, VALENCE_TABLE_SIZE>> result;
+            for (uint32_t i = 0; i < SCORE_CACHE_SIZE; i++)
+            {
+                result.first[i] = i < 3 ? LAST_TRIANGLE_SCORE
+                                        : std::pow(1.0f - float(i - 3) / float(SCORE_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+            }
+            for (uint32_t i = 1; i < VALENCE_TABLE_SIZE; i++)
+                result.second[i] = VALENCE_BOOST_SCALE * std::pow(float(i), -VALENCE_BOOST_POWER);
+            return result;
+        }();
+
+        if (remaining == 0)
+            return -1.0f;
+        const float cached  = cache_position >= 0 ? tables.first[cache_position] : 0.0f;
+        const float valence = remaining < VALENCE_TABLE_SIZE ? tables.second[remaining]
+                                                             : VALENCE_BOOST_SCALE * std::pow(float(remaining), -VALENCE_BOOST_POWER);
+        return cached + valence;
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttOptimize::CacheStats OttOptimize::analyzeCache(const std::span<const uint32_t> indices, const uint32_t cache_size)
+{
+    std::vector<uint32_t> local;
+    CacheStats stats { .triangles = indices.size() / 3 };
+    stats.vertices = denseIds(indices.first(stats.triangles * 3), local);
+
+    FifoCache cache(static_cast<uint32_t>(stats.vertices), cache_size);
+    for (size_t t = 0; t < stats.triangles; t++)
+        stats.misses += cache.triangle(&local[t * 3]);
+    return stats;
+}
+
+//----------------------------------------------------------------------------
+/** Forsyth's greedy order: each step emits the best scored triangle among those of the
+ *  vertices in the simulated cache, then rescores only those. When none is left there,
+ *  the next triangle not emitted yet in the input order starts a new patch. **/
+void OttOptimize::optimizeVertexCache(const std::span<uint32_t> indices)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+
+    std::vector<uint32_t> local;
+    const uint32_t vertexCount = denseIds(indices.first(triangleCount * 3), local);
+
+    // Triangles of every vertex, row by row; the first remaining[v] of a row are live.
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (const uint32_t vertex : local)
+        remaining[vertex]++;
+    std::vector<uint32_t> rows(size_t(vertexCount) + 1, 0);
+    std::inclusive_scan(remaining.begin(), remaining.end(), rows.begin() + 1);
+    std::vector<uint32_t> adjacency(local.size());
+    {
+        std::vector<uint32_t> cursor(rows.begin(), rows.end() - 1);
+        for (size_t corner = 0; corner < local.size(); corner++)
+            adjacency[cursor[local[corner]]++] = static_cast<uint32_t>(corner / 3);
+    }
+
+    std::vector<int32_t> position(vertexCount, -1);
+    std::vector<float>   score(vertexCount);
+    for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        score[vertex] = vertexScore(-1, remaining[vertex]);
+
+    std::vector<uint8_t>  emitted(triangleCount, 0);
+    std::vector<uint32_t> order;
+    order.reserve(triangleCount);
+    std::array<uint32_t, SCORE_CACHE_SIZE + 3> cache {}, next {};
+    size_t   cached = 0;
+    size_t   scan   = 0;
+    uint32_t best   = 0;
+    while (order.size() < triangleCount)
+    {
+        if (best == NONE)
+        {
+            while (emitted[scan])
+                scan++;
+            best = static_cast<uint32_t>(scan);
+        }
+        emitted[best] = 1;
+        order.push_back(best);
+        const uint32_t* corners = &local[size_t(best) * 3];
+        for (size_t k = 0; k < 3; k++)
+        {
+            const uint32_t vertex = corners[k];
+            uint32_t* row  = &adjacency[rows[vertex]];
+            uint32_t* live = std::find(row, row + remaining[vertex], best);
+            if (live != row + remaining[vertex])
+                std::swap(*live, row[--remaining[vertex]]);
+        }
+
+        // The triangle's vertices move to the front; the rest shift back, the last fall out.
+        size_t count = 0;
+        for (size_t k = 0; k < 3; k++)
+        {
+            if (std::find(next.begin(), next.begin() + count, corners[k]) == next.begin() + count)
+                next[count++] = corners[k];
+        }
+        for (size_t i = 0; i < cached; i++)
+        {
+            if (cache[i] != corners[0] && cache[i] != corners[1] && cache[i] != corners[2])
+                next[count++] = cache[i];
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            position[next[i]] = i < SCORE_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+            score[next[i]]    = vertexScore(position[next[i]], remaining[next[i]]);
+        }
+        cached = std::min<size_t>(count, SCORE_CACHE_SIZE);
+        std::copy_n(next.begin(), cached, cache.begin());
+
+        best = NONE;
+        float bestScore = 0.0f;
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint32_t vertex = next[i];
+            for (uint32_t j = rows[vertex]; j < rows[vertex] + remaining[vertex]; j++)
+            {
+                const uint32_t  triangle = adjacency[j];
+                const uint32_t* around   = &local[size_t(triangle) * 3];
+                const float     sum      = score[around[0]] + score[around[1]] + score[around[2]];
+                if (sum > bestScore)
+                {
+                    bestScore = sum;
+                    best      = triangle;
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> reordered(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; t++)
+        std::copy_n(indices.begin() + static_cast<std::ptrdiff_t>(order[t] * 3), 3, reordered.begin() + static_cast<std::ptrdiff_t>(t * 3));
+    std::ranges::copy(reordered, indices.begin());
+}
+
+//----------------------------------------------------------------------------
+/** Patches start where the cache order jumps (all three corners miss), and are split
+ *  further where a run replayed on an empty cache is within threshold of the patch's
+ *  ACMR. Patches are then sorted by how far their area weighted centroid lies out from
+ *  the range's centroid along their mean normal. **/
+void OttOptimize::optimizeOverdraw(const std::span<const OttModel::Vertex> vertices, const std::span<uint32_t> indices,
+                                   const float threshold, const uint32_t cache_size)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || !(threshold > 0.0f))
+        return;
+
+    std::vector<uint32_t> local;
+    const uint32_t vertexCount = denseIds(indices.first(triangleCount * 3), local);
+    FifoCache cache(vertexCount, cache_size);
+
+    std::vector<size_t> jumps { 0 };
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        if (cache.triangle(&local[t * 3]) == 3 && t > 0)
+            jumps.push_back(t);
+    }
+    jumps.push_back(triangleCount);
+
+    std::vector<size_t> patches;
+    for (size_t j = 0; j + 1 < jumps.size(); j++)
+    {
+        const size_t start = jumps[j], end = jumps[j + 1];
+        cache.reset();
+        size_t misses = 0;
+        for (size_t t = start; t < end; t++)
+            misses += cache.triangle(&local[t * 3]);
+        const double limit = threshold * static_cast<double>(misses) / static_cast<double>(end - start);
+
+        cache.reset();
+        patches.push_back(start);
+        size_t runMisses = 0, runStart = start;
+        for (size_t t = start; t + 1 < end; t++)
+        {
+            runMisses += cache.triangle(&local[t * 3]);
+            if (static_cast<double>(runMisses) <= limit * static_cast<double>(t + 1 - runStart))
+            {
+                patches.push_back(t + 1);
+                cache.reset();
+                runMisses = 0;
+                runStart  = t + 1;
+            }
+        }
+    }
+    patches.push_back(triangleCount);
+    if (patches.size() <= 2)
+        return;
+
+    auto corner = [&](const size_t t, const size_t k) { return glm::dvec3(vertices[indices[t * 3 + k]].pos); };
+    struct Patch
+    {
+        glm::dvec3 centroid { 0.0 };
+        glm::dvec3 normal   { 0.0 };   // Sum of the faces' cross products, twice their area.
+        double     area     = 0.0;
+        double     key      = 0.0;
+    };
+    std::vector<Patch> sums(patches.size() - 1);
+    glm::dvec3 center(0.0);
+    double totalArea = 0.0;
+    for (size_t p = 0; p < sums.size(); p++)
+    {
+        Patch& patch = sums[p];
+        for (size_t t = patches[p]; t < patches[p + 1]; t++)
+        {
+            const glm::dvec3 a = corner(t, 0), b = corner(t, 1), c = corner(t, 2);
+            const glm::dvec3 normal = glm::cross(b - a, c - a);
+            const double area = glm::length(normal);
+            patch.centroid += (a + b + c) * (area / 3.0);
+            patch.normal   += normal;
+            patch.area     += area;
+        }
+        center    += patch.centroid;
+        totalArea += patch.area;
+        if (patch.area > 0.0)
+            patch.centroid /= patch.area;
+    }
+    if (!(totalArea > 0.0))
+        return;
+    center /= totalArea;
+    for (Patch& patch : sums)
+    {
+        const double length = glm::length(patch.normal);
+        patch.key = length > 0.0 ? glm::dot(patch.centroid - center, patch.normal / length) : 0.0;
+    }
+
+    std::vector<uint32_t> order(sums.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::ranges::stable_sort(order, [&sums](const uint32_t a, const uint32_t b) { return sums[a].key > sums[b].key; });
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(triangleCount * 3);
+    for (const uint32_t p : order)
+    {
+        reordered.insert(reordered.end(), indices.begin() + static_cast<std::ptrdiff_t>(patches[p] * 3),
+                         indices.begin() + static_cast<std::ptrdiff_t>(patches[p + 1] * 3));
+    }
+    std::ranges::copy(reordered, indices.begin());
+}
+
+//----------------------------------------------------------------------------
+OttOptimize::OptimizeStats OttOptimize::optimize(OttModel::MeshData& mesh, const OptimizeOptions& options)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Objects sharing a startVertex share a vertex range, up to the next one.
+    std::vector<uint32_t> starts;
+    for (const OttModel::modelObject& object : mesh.objects)
+        starts.push_back(object.startVertex);
+    std::ranges::sort(starts);
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+
+    struct VertexRange
+    {
+        uint32_t startVertex = 0;
+        uint32_t vertexCount = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;   // Index ranges (start, count), full ones first.
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        bool     shared = false;                             // Some of its ranges belong to another one too.
+    };
+    std::vector<VertexRange> groups(starts.size());
+    for (size_t g = 0; g < starts.size(); g++)
+    {
+        groups[g].startVertex = starts[g];
+        groups[g].vertexCount = (g + 1 < starts.size() ? starts[g + 1] : static_cast<uint32_t>(mesh.vertices.size())) - starts[g];
+    }
+
+    std::unordered_map<uint32_t, size_t> indexOwner, edgeOwner;
+    auto claim = [&groups](std::unordered_map<uint32_t, size_t>& owner, std::vector<std::pair<uint32_t, uint32_t>>& list,
+                           const size_t g, const uint32_t start, const uint32_t count)
+    {
+        if (count == 0)
+            return;
+        const auto [found, inserted] = owner.try_emplace(start, g);
+        if (inserted)
+            list.emplace_back(start, count);
+        else if (found->second != g)
+            groups[g].shared = groups[found->second].shared = true;
+    };
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        const size_t g = static_cast<size_t>(std::ranges::lower_bound(starts, object.startVertex) - starts.begin());
+        claim(indexOwner, groups[g].ranges, g, object.startIndex, object.indexCount);
+        claim(edgeOwner, groups[g].edges, g, object.startEdge, object.edgeCount);
+    }
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        const size_t g = static_cast<size_t>(std::ranges::lower_bound(starts, object.startVertex) - starts.begin());
+        for (uint32_t level = 0; level < object.lodCount; level++)
+            claim(indexOwner, groups[g].ranges, g, object.lods[level].startIndex, object.lods[level].indexCount);
+    }
+
+    struct GroupStats
+    {
+        CacheStats before, after;
+        size_t     remapped = 0;
+    };
+    std::vector<GroupStats> results(groups.size());
+    OttThreadPool::shared().parallelFor(groups.size(), [&](const size_t g)
+    {
+        const VertexRange& group = groups[g];
+        GroupStats& out = results[g];
+        const auto vertices = std::span(mesh.vertices).subspan(group.startVertex);
+        for (const auto& [start, count] : group.ranges)
+        {
+            const auto indices = std::span(mesh.indices).subspan(start, count);
+            out.before += analyzeCache(indices, options.cacheSize);
+            optimizeVertexCache(indices);
+            optimizeOverdraw(vertices, indices, options.overdrawThreshold, options.cacheSize);
+            out.after += analyzeCache(indices, options.cacheSize);
+        }
+        if (!options.fetch || group.shared)
+            return;
+
+        std::vector<uint32_t> remap(group.vertexCount, NONE);
+        uint32_t next = 0;
+        for (const auto& [start, count] : group.ranges)
+        {
+            for (const uint32_t index : std::span(mesh.indices).subspan(start, count))
+            {
+                if (index >= group.vertexCount)
+                    return;   // Reaches into another object's vertices.
+                if (remap[index] == NONE)
+                    remap[index] = next++;
+            }
+        }
+        for (const auto& [start, count] : group.edges)
+        {
+            if (std::ranges::any_of(std::span(mesh.edges).subspan(start, count), [&](const uint32_t index) { return index >= group.vertexCount; }))
+                return;
+        }
+        for (uint32_t& id : remap)
+        {
+            if (id == NONE)
+                id = next++;
+        }
+
+        std::vector<OttModel::Vertex> reordered(group.vertexCount);
+        for (uint32_t vertex = 0; vertex < group.vertexCount; vertex++)
+        {
+            reordered[remap[vertex]] = vertices[vertex];
+            out.remapped += remap[vertex] != vertex;
+        }
+        std::ranges::copy(reordered, vertices.begin());
+        for (const auto& [start, count] : group.ranges)
+        {
+            for (uint32_t& index : std::span(mesh.indices).subspan(start, count))
+                index = remap[index];
+        }
+        for (const auto& [start, count] : group.edges)
+        {
+            for (uint32_t& index : std::span(mesh.edges).subspan(start, count))
+                index = remap[index];
+        }
+    });
+
+    OptimizeStats stats;
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        stats.ranges   += groups[g].ranges.size();
+        stats.remapped += results[g].remapped;
+        stats.before   += results[g].before;
+        stats.after    += results[g].after;
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
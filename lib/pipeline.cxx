@@ -48,11 +48,13 @@ OttPipeline::~OttPipeline()
  *  Input Assembler (f) > Vertex Shader (p) > Tessellation (p) > Geometry Shader >
  *  Rasterization (f) > Fragment Shader (p) > Color Blending (f) > Framebuffer. \n
  *  - Bindings: spacing between data and whether the data is per-vertex or per-instance
- *  - Attribute descriptions: type of the attributes passed to the vertex shader, which binding to land which offset. **/
+ *  - Attribute descriptions: type of the attributes passed to the vertex shader, which binding to land which offset.
+ *  - Vertex specialization: optional constants of the vertex stage, such as object.vert's PACKED_VERTICES. **/
 void OttPipeline::createGraphicsPipeline (
     std::string vertex_shader_path, std::string fragment_shader_path,
     VkPipeline&  pipeline, VkPipelineVertexInputStateCreateInfo vertex_input_info,
-    VkPolygonMode polygon_mode, VkPrimitiveTopology topology_mode
+    VkPolygonMode polygon_mode, VkPrimitiveTopology topology_mode,
+    const VkSpecializationInfo* vertex_specialization
     )
 {
     std::filesystem::path cwd = std::filesystem::current_path();
@@ -67,6 +69,7 @@ void OttPipeline::createGraphicsPipeline (
     VkPipelineShaderStageCreateInfo { initShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule) },
     VkPipelineShaderStageCreateInfo { initShaderStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule) }
     };
+    shaderStages[0].pSpecializationInfo = vertex_specialization;
     
     VkPipelineInputAssemblyStateCreateInfo inputAssembly        = initInputAssembly(topology_mode);
     VkPipelineViewportStateCreateInfo      viewportState        = initViewportState(1, 1);
@@ -0,0 +1,506 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "simplify.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+#include "radixsort.h"
+#include "threadpool.h"
+#include "weld.h"
+
+namespace
+{
+    // Boundary and seam planes weigh this much per squared edge length, against the face
+    // planes which weigh their area.
+    constexpr double CONSTRAINT_WEIGHT = 10.0;
+
+    uint32_t nextCorner(const uint32_t corner) { return corner % 3 == 2 ? corner - 2 : corner + 1; }
+
+    //----------------------------------------------------------------------------
+    /** Weighted sum of squared distances to a set of planes, as a symmetric 4x4 matrix. **/
+    struct Quadric
+    {
+        double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+        double b0  = 0.0, b1  = 0.0, b2  = 0.0, c   = 0.0;
+        double weight = 0.0;
+
+        static Quadric plane(const glm::dvec3& n, const double d, const double w)
+        {
+            return { n.x * n.x * w, n.x * n.y * w, n.x * n.z * w, n.y * n.y * w, n.y * n.z * w, n.z * n.z * w,
+                     n.x * d * w,   n.y * d * w,   n.z * d * w,   d * d * w,     w };
+        }
+
+        Quadric& operator+=(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0  += q.b0;  b1  += q.b1;  b2  += q.b2;  c   += q.c;   weight += q.weight;
+            return *this;
+        }
+
+        // Weighted mean of the squared distances from p to the planes.
+        [[nodiscard]] double error(const glm::dvec3& p) const
+        {
+            const double rx = a00 * p.x + a01 * p.y + a02 * p.z;
+            const double ry = a01 * p.x + a11 * p.y + a12 * p.z;
+            const double rz = a02 * p.x + a12 * p.y + a22 * p.z;
+            const double e  = p.x * rx + p.y * ry + p.z * rz + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+            return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+        }
+    };
+
+    // Where a welded position may move to.
+    enum class Kind : uint8_t
+    {
+        Manifold,   // Anywhere along its edges.
+        Border,     // Along one of its two boundary edges.
+        Seam,       // Along one of its two seam edges.
+        Locked,     // Nowhere.
+    };
+
+    enum class EdgeType : uint8_t
+    {
+        Interior,
+        Border,
+        Seam,
+        NonManifold,
+    };
+
+    // One triangle side, keyed by the welded positions of its two ends.
+    struct SideRecord
+    {
+        uint64_t key;
+        uint32_t corner;
+    };
+
+    struct Edge
+    {
+        uint32_t low, high;
+        EdgeType type;
+    };
+
+    struct Collapse
+    {
+        double   cost;
+        uint32_t from, to;
+    };
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Runs in passes. Every pass rebuilds the edges of the current triangles from sorted side
+ *  records, classifies the positions and picks the cheaper allowed direction of every
+ *  edge. The collapses are then applied cheapest first; one that touches a position an
+ *  earlier collapse of the pass already changed waits for the next pass, so the costs and
+ *  triangle fans it was checked against stay valid. A collapse is refused when the copies
+ *  of the moving vertex can't all be matched to a copy of the target on the same side, or
+ *  when it would flip a face. **/
+std::vector<uint32_t> OttSimplify::simplify(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices,
+                                            const size_t target_index_count, const float target_error, float* result_error)
+{
+    if (result_error)
+        *result_error = 0.0f;
+    std::vector<uint32_t> result(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(indices.size() / 3 * 3));
+    if (result.size() <= target_index_count)
+        return result;
+
+    const uint32_t vertexCount = std::ranges::max(result) + 1;
+    std::vector<OttModel::Vertex> corners(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        corners[v].pos = vertices[v].pos;
+    std::vector<OttModel::Vertex> unique;
+    std::vector<uint32_t>         positionOf;
+    OttWeld::deduplicate(corners, unique, positionOf);
+    corners = {};
+
+    // Relative to the center, so the quadrics of far away site geometry keep their precision.
+    const glm::dvec3 center(glm::vec3(boundingSphere(vertices, result)));
+    const auto positionCount = static_cast<uint32_t>(unique.size());
+    std::vector<glm::dvec3> positions(positionCount);
+    for (uint32_t p = 0; p < positionCount; p++)
+        positions[p] = glm::dvec3(unique[p].pos) - center;
+    auto positionAt = [&](const size_t corner) { return positionOf[result[corner]]; };
+
+    // Triangles with two corners on one position are invisible and have no edges to speak of.
+    size_t kept = 0;
+    for (size_t t = 0; t < result.size() / 3; t++)
+    {
+        const uint32_t a = positionAt(3 * t), b = positionAt(3 * t + 1), c = positionAt(3 * t + 2);
+        if (a == b || b == c || c == a)
+            continue;
+        std::copy_n(result.begin() + static_cast<std::ptrdiff_t>(3 * t), 3, result.begin() + static_cast<std::ptrdiff_t>(3 * kept++));
+    }
+    result.resize(3 * kept);
+
+    std::vector<Quadric> quadrics(positionCount);
+    auto faceNormal = [&](const size_t t)
+    {
+        const glm::dvec3& a = positions[positionAt(3 * t)];
+        return glm::cross(positions[positionAt(3 * t + 1)] - a, positions[positionAt(3 * t + 2)] - a);
+    };
+    for (size_t t = 0; t < result.size() / 3; t++)
+    {
+        const glm::dvec3 n    = faceNormal(t);
+        const double     area = glm::length(n);
+        if (!(area > 0.0))
+            continue;
+        const Quadric q = Quadric::plane(n / area, -glm::dot(n / area, positions[positionAt(3 * t)]), 0.5 * area);
+        for (size_t k = 0; k < 3; k++)
+            quadrics[positionAt(3 * t + k)] += q;
+    }
+
+    auto sameSide = [&result](const uint32_t a, const uint32_t b)
+    {
+        return std::minmax(result[a], result[nextCorner(a)]) == std::minmax(result[b], result[nextCorner(b)]);
+    };
+    // Keeps a boundary or seam where it is: a plane through the side, upright on its face.
+    auto constrain = [&](const uint32_t corner)
+    {
+        const glm::dvec3 n = faceNormal(corner / 3);
+        const glm::dvec3& a = positions[positionAt(corner)];
+        const glm::dvec3  side = positions[positionAt(nextCorner(corner))] - a;
+        const glm::dvec3  upright = glm::cross(side, n);
+        const double      length = glm::length(upright);
+        if (!(length > 0.0))
+            return;
+        const Quadric q = Quadric::plane(upright / length, -glm::dot(upright / length, a), CONSTRAINT_WEIGHT * glm::dot(side, side));
+        quadrics[positionAt(corner)] += q;
+        quadrics[positionAt(nextCorner(corner))] += q;
+    };
+
+    const uint64_t stride  = positionCount;
+    const int      keyBits = std::bit_width(stride * stride);
+    const double   maxCost = double(target_error) * double(target_error);
+    double worst = 0.0;
+    bool   constrained = false;
+
+    std::vector<SideRecord> sides;
+    std::vector<Edge>       edges;
+    std::vector<Collapse>   candidates;
+    std::vector<uint32_t>   borderEdges(positionCount), seamEdges(positionCount), fanStart(positionCount + 1), fan;
+    std::vector<Kind>       kinds(positionCount);
+    std::vector<uint8_t>    touched(positionCount), dead;
+    std::vector<std::pair<uint32_t, uint32_t>> copies;
+
+    while (result.size() > target_index_count && target_error >= 0.0f)
+    {
+        const size_t count = result.size();
+        sides.resize(count);
+        for (uint32_t corner = 0; corner < count; corner++)
+        {
+            const uint32_t a = positionAt(corner), b = positionAt(nextCorner(corner));
+            sides[corner] = { .key = uint64_t(std::min(a, b)) * stride + std::max(a, b), .corner = corner };
+        }
+        OttRadix::sort(sides, keyBits, [](const SideRecord& side) { return side.key; });
+
+        edges.clear();
+        std::ranges::fill(borderEdges, 0);
+        std::ranges::fill(seamEdges, 0);
+        std::ranges::fill(kinds, Kind::Manifold);
+        for (size_t i = 0; i < count;)
+        {
+            size_t end = i + 1;
+            while (end < count && sides[end].key == sides[i].key)
+                end++;
+            const auto low  = static_cast<uint32_t>(sides[i].key / stride);
+            const auto high = static_cast<uint32_t>(sides[i].key % stride);
+            EdgeType type = EdgeType::NonManifold;
+            if (end - i == 1)
+                type = EdgeType::Border;
+            else if (end - i == 2)
+                type = sameSide(sides[i].corner, sides[i + 1].corner) ? EdgeType::Interior : EdgeType::Seam;
+
+            if (type == EdgeType::NonManifold)
+                kinds[low] = kinds[high] = Kind::Locked;
+            if (type == EdgeType::Border || type == EdgeType::Seam)
+            {
+                std::vector<uint32_t>& counter = type == EdgeType::Border ? borderEdges : seamEdges;
+                counter[low]++;
+                counter[high]++;
+                for (size_t j = i; j < end && !constrained; j++)
+                    constrain(sides[j].corner);
+            }
+            edges.push_back({ .low = low, .high = high, .type = type });
+            i = end;
+        }
+        constrained = true;
+
+        for (uint32_t p = 0; p < positionCount; p++)
+        {
+            if (kinds[p] == Kind::Locked || (borderEdges[p] == 0 && seamEdges[p] == 0))
+                continue;
+            kinds[p] = borderEdges[p] == 2 && seamEdges[p] == 0 ? Kind::Border
+                     : seamEdges[p] == 2 && borderEdges[p] == 0 ? Kind::Seam
+                                                                : Kind::Locked;
+        }
+
+        candidates.clear();
+        for (const Edge& edge : edges)
+        {
+            auto allowed = [&](const uint32_t from)
+            {
+                return kinds[from] == Kind::Manifold || (kinds[from] == Kind::Border && edge.type == EdgeType::Border)
+                                                     || (kinds[from] == Kind::Seam && edge.type == EdgeType::Seam);
+            };
+            if (edge.type == EdgeType::NonManifold)
+                continue;
+            Quadric sum = quadrics[edge.low];
+            sum += quadrics[edge.high];
+            Collapse best { .cost = std::numeric_limits<double>::infinity(), .from = 0, .to = 0 };
+            if (allowed(edge.low))
+                best = { .cost = sum.error(positions[edge.high]), .from = edge.low, .to = edge.high };
+            if (allowed(edge.high) && sum.error(positions[edge.low]) < best.cost)
+                best = { .cost = sum.error(positions[edge.low]), .from = edge.high, .to = edge.low };
+            if (best.cost <= maxCost)
+                candidates.push_back(best);
+        }
+        if (candidates.empty())
+            break;
+        std::ranges::sort(candidates, [](const Collapse& a, const Collapse& b)
+        {
+            return std::tie(a.cost, a.from, a.to) < std::tie(b.cost, b.from, b.to);
+        });
+
+        const size_t triangles = count / 3;
+        std::ranges::fill(fanStart, 0);
+        for (size_t corner = 0; corner < count; corner++)
+            fanStart[positionAt(corner) + 1]++;
+        for (uint32_t p = 0; p < positionCount; p++)
+            fanStart[p + 1] += fanStart[p];
+        fan.resize(count);
+        {
+            std::vector<uint32_t> cursor(fanStart.begin(), fanStart.end() - 1);
+            for (size_t corner = 0; corner < count; corner++)
+                fan[cursor[positionAt(corner)]++] = static_cast<uint32_t>(corner / 3);
+        }
+
+        dead.assign(triangles, 0);
+        std::ranges::fill(touched, 0);
+        size_t removed = 0;
+        for (const Collapse& collapse : candidates)
+        {
+            if (count - 3 * removed <= target_index_count)
+                break;
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+            const std::span<const uint32_t> around(fan.data() + fanStart[collapse.from], fan.data() + fanStart[collapse.from + 1]);
+
+            // Every copy of the moving vertex goes to the copy of the target on its side.
+            bool valid = true;
+            copies.clear();
+            for (const uint32_t t : around)
+            {
+                uint32_t from = UINT32_MAX, to = UINT32_MAX;
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const uint32_t p = positionAt(3 * t + k);
+                    if (p == collapse.from) from = result[3 * t + k];
+                    if (p == collapse.to)   to   = result[3 * t + k];
+                }
+                if (to == UINT32_MAX)
+                    continue;
+                const auto copy = std::ranges::find(copies, from, &std::pair<uint32_t, uint32_t>::first);
+                if (copy == copies.end())
+                    copies.emplace_back(from, to);
+                else
+                    valid &= copy->second == to;
+            }
+            for (size_t i = 0; i < around.size() && valid; i++)
+            {
+                const uint32_t t = around[i];
+                for (size_t k = 0; k < 3; k++)
+                {
+                    if (positionAt(3 * t + k) == collapse.from)
+                        valid &= std::ranges::find(copies, result[3 * t + k], &std::pair<uint32_t, uint32_t>::first) != copies.end();
+                }
+            }
+
+            // The faces that stay may neither flip nor degenerate.
+            for (size_t i = 0; i < around.size() && valid; i++)
+            {
+                const uint32_t t = around[i];
+                glm::dvec3 moved[3];
+                bool keepsTarget = false;
+                for (size_t k = 0; k < 3; k++)
+                {
+                    const uint32_t p = positionAt(3 * t + k);
+                    keepsTarget |= p == collapse.to;
+                    moved[k] = positions[p == collapse.from ? collapse.to : p];
+                }
+                if (!keepsTarget)
+                    valid = glm::dot(faceNormal(t), glm::cross(moved[1] - moved[0], moved[2] - moved[0])) > 0.0;
+            }
+            if (!valid)
+                continue;
+
+            for (const uint32_t t : around)
+            {
+                bool hasTarget = false;
+                for (size_t k = 0; k < 3; k++)
+                    hasTarget |= positionAt(3 * t + k) == collapse.to;
+                if (hasTarget)
+                {
+                    dead[t] = 1;
+                    removed++;
+                    continue;
+                }
+                for (size_t k = 0; k < 3; k++)
+                {
+                    if (positionAt(3 * t + k) == collapse.from)
+                        result[3 * t + k] = std::ranges::find(copies, result[3 * t + k], &std::pair<uint32_t, uint32_t>::first)->second;
+                }
+            }
+            for (const uint32_t t : around)
+            {
+                for (size_t k = 0; k < 3; k++)
+                    touched[positionAt(3 * t + k)] = 1;
+            }
+            touched[collapse.from] = 1;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            worst = std::max(worst, collapse.cost);
+        }
+        if (removed == 0)
+            break;
+
+        kept = 0;
+        for (size_t t = 0; t < triangles; t++)
+        {
+            if (!dead[t])
+                std::copy_n(result.begin() + static_cast<std::ptrdiff_t>(3 * t), 3, result.begin() + static_cast<std::ptrdiff_t>(3 * kept++));
+        }
+        result.resize(3 * kept);
+    }
+
+    if (result_error)
+        *result_error = static_cast<float>(std::sqrt(worst));
+    return result;
+}
+
+//----------------------------------------------------------------------------
+/** Centered on the bounding box, which is within a few percent of the smallest sphere for
+ *  the boxy shapes of buildings and cheap to compute. **/
+glm::vec4 OttSimplify::boundingSphere(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices)
+{
+    if (indices.empty())
+        return glm::vec4(0.0f);
+    glm::vec3 low(std::numeric_limits<float>::max()), high(std::numeric_limits<float>::lowest());
+    for (const uint32_t index : indices)
+    {
+        low  = glm::min(low,  vertices[index].pos);
+        high = glm::max(high, vertices[index].pos);
+    }
+    const glm::vec3 center = 0.5f * (low + high);
+    float radius2 = 0.0f;
+    for (const uint32_t index : indices)
+    {
+        const glm::vec3 d = vertices[index].pos - center;
+        radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    return glm::vec4(center, std::sqrt(radius2));
+}
+
+//----------------------------------------------------------------------------
+/** Every level is simplified from the previous one, which is cheaper than starting from
+ *  the full range every time; its error adds up accordingly. The chain stops early at a
+ *  level that would shrink by less than a tenth, exceed the error budget or drop below
+ *  minTriangles. **/
+OttSimplify::LodStats OttSimplify::buildLods(OttModel::MeshData& mesh, const LodOptions& options)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::unordered_map<uint32_t, size_t> rangeOf;
+    std::vector<const OttModel::modelObject*> ranges;
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        if (rangeOf.try_emplace(object.startIndex, ranges.size()).second)
+            ranges.push_back(&object);
+    }
+
+    struct RangeLods
+    {
+        glm::vec4                          sphere;
+        std::vector<std::vector<uint32_t>> levels;
+        std::array<float, OttModel::MAX_LODS> errors {};
+    };
+    std::vector<RangeLods> results(ranges.size());
+    const uint32_t levels = std::min(options.levels, OttModel::MAX_LODS);
+    OttThreadPool::shared().parallelFor(ranges.size(), [&](const size_t r)
+    {
+        const OttModel::modelObject& object = *ranges[r];
+        const auto vertices = std::span(mesh.vertices).subspan(object.startVertex);
+        const auto full     = std::span(mesh.indices).subspan(object.startIndex, object.indexCount);
+        RangeLods& out = results[r];
+        out.sphere = boundingSphere(vertices, full);
+        if (object.indexCount / 3 < options.minTriangles || !(out.sphere.w > 0.0f))
+            return;
+
+        std::vector<uint32_t> previous(full.begin(), full.end());
+        float error = 0.0f;
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            const auto  target = static_cast<size_t>(static_cast<double>(previous.size() / 3) * options.ratio) * 3;
+            const float budget = options.maxError * out.sphere.w - error;
+            if (target / 3 < options.minTriangles / 4 || !(budget > 0.0f))
+                break;
+            float levelError = 0.0f;
+            std::vector<uint32_t> simplified = simplify(vertices, previous, target, budget, &levelError);
+            if (simplified.empty() || simplified.size() * 10 > previous.size() * 9)
+                break;
+            error += levelError;
+            out.errors[out.levels.size()] = error / out.sphere.w;
+            previous = simplified;
+            out.levels.push_back(std::move(simplified));
+        }
+    });
+
+    LodStats stats;
+    std::vector<std::array<OttModel::LodRange, OttModel::MAX_LODS>> lods(ranges.size());
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        if (!results[r].levels.empty())
+        {
+            stats.ranges++;
+            stats.fullTriangles += ranges[r]->indexCount / 3;
+        }
+        for (size_t level = 0; level < results[r].levels.size(); level++)
+        {
+            const std::vector<uint32_t>& indices = results[r].levels[level];
+            lods[r][level] = {
+                .startIndex = static_cast<uint32_t>(mesh.indices.size()),
+                .indexCount = static_cast<uint32_t>(indices.size()),
+                .error      = results[r].errors[level],
+            };
+            mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+            stats.levels++;
+            stats.lodTriangles += indices.size() / 3;
+        }
+    }
+    for (OttModel::modelObject& object : mesh.objects)
+    {
+        const size_t r = rangeOf[object.startIndex];
+        object.boundingSphere = results[r].sphere;
+        object.lodCount       = static_cast<uint32_t>(results[r].levels.size());
+        object.lods           = lods[r];
+    }
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
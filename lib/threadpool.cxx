@@ -0,0 +1,88 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "threadpool.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+//----------------------------------------------------------------------------
+/** \param thread_count: number of worker threads. The thread that calls parallelFor()
+ *  also takes part in the work, so the default pool leaves one hardware thread for it. **/
+OttThreadPool::OttThreadPool(const unsigned thread_count)
+{
+    workers.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; i++)
+        workers.emplace_back([this]() { workerLoop(); });
+}
+
+//----------------------------------------------------------------------------
+/** Pending tasks are still executed before the workers are joined. **/
+OttThreadPool::~OttThreadPool()
+{
+    {
+        std::lock_guard lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+}
+
+//----------------------------------------------------------------------------
+/** Process-wide pool sized to the hardware concurrency minus the calling thread,
+ *  with at least one worker so background tasks never run inline. **/
+OttThreadPool& OttThreadPool::shared()
+{
+    static OttThreadPool pool(std::max(2u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+//----------------------------------------------------------------------------
+void OttThreadPool::submit(std::function<void()> task)
+{
+    if (workers.empty())
+    {
+        task();
+        return;
+    }
+    {
+        std::lock_guard lock(queueMutex);
+        tasks.push_back(std::move(task));
+    }
+    queueCondition.notify_one();
+}
+
+//----------------------------------------------------------------------------
+void OttThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        try { task(); }
+        catch (const std::exception& e) { log_t<error>("OttThreadPool task threw: {}", e.what()); }
+    }
+}
@@ -0,0 +1,179 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "topology.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <unordered_map>
+
+#include "radixsort.h"
+#include "threadpool.h"
+#include "weld.h"
+
+namespace
+{
+    constexpr size_t BLOCK_SIZE = OttRadix::BLOCK_SIZE;
+
+    // One triangle side, keyed by the welded positions of its two ends.
+    struct SideRecord
+    {
+        uint64_t key;
+        uint32_t corner;
+    };
+
+    //----------------------------------------------------------------------------
+    /** Calls fn(block, first, last) for every block of count items in parallel. **/
+    template<typename F>
+    void forBlocks(const size_t count, F&& fn)
+    {
+        OttThreadPool::shared().parallelFor((count + BLOCK_SIZE - 1) / BLOCK_SIZE, [&](const size_t block)
+        {
+            fn(block, block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE));
+        });
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+/** Each run of equal keys after the sort is one edge. Runs are linked in parallel by the
+ *  block their first record falls in, which may read on into the next block. **/
+OttTopology::Adjacency OttTopology::build(const std::span<const OttModel::Vertex> vertices, const std::span<const uint32_t> indices,
+                                          AdjacencyStats* stats)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const size_t count = indices.size() / 3 * 3;
+    Adjacency adjacency;
+    if (count == 0)
+    {
+        if (stats)
+            *stats = { .ranges = 1 };
+        return adjacency;
+    }
+
+    std::vector<OttModel::Vertex> corners(count);
+    forBlocks(count, [&](size_t, const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+            corners[i].pos = vertices[indices[i]].pos;
+    });
+    std::vector<OttModel::Vertex> positions;
+    OttWeld::deduplicate(corners, positions, adjacency.positions);
+    adjacency.positionCount = static_cast<uint32_t>(positions.size());
+    corners = {};
+
+    // Sides of triangles without area sort after every real key and stay unlinked.
+    const size_t   triangles = count / 3;
+    const uint64_t stride    = positions.size();
+    const uint64_t unused    = stride * stride;
+    std::vector<SideRecord> sides(count);
+    const size_t triangleBlocks = (triangles + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<size_t> degenerate(triangleBlocks, 0);
+    forBlocks(triangles, [&](const size_t block, const size_t first, const size_t last)
+    {
+        for (size_t t = first; t < last; t++)
+        {
+            const glm::vec3& a = positions[adjacency.positions[3 * t + 0]].pos;
+            const glm::vec3& b = positions[adjacency.positions[3 * t + 1]].pos;
+            const glm::vec3& c = positions[adjacency.positions[3 * t + 2]].pos;
+            const float area = glm::length(glm::cross(b - a, c - a));
+            const bool  flat = !(area > 0.0f) || std::isinf(area);
+            degenerate[block] += flat;
+            for (uint32_t corner = static_cast<uint32_t>(3 * t); corner < 3 * t + 3; corner++)
+            {
+                const auto [low, high] = std::minmax(adjacency.positions[corner], adjacency.positions[nextCorner(corner)]);
+                sides[corner] = { .key = flat ? unused : uint64_t(low) * stride + high, .corner = corner };
+            }
+        }
+    });
+    OttRadix::sort(sides, std::bit_width(unused), [](const SideRecord& side) { return side.key; });
+
+    adjacency.links.resize(count);
+    const size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::vector<size_t> borders(blocks, 0), nonManifold(blocks, 0);
+    forBlocks(count, [&](const size_t block, const size_t first, const size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            if (sides[i].key == unused)
+            {
+                adjacency.links[sides[i].corner] = NONE;
+                continue;
+            }
+            if (i > 0 && sides[i - 1].key == sides[i].key)
+                continue;
+            size_t end = i + 1;
+            while (end < count && sides[end].key == sides[i].key)
+                end++;
+            for (size_t k = i; k < end; k++)
+                adjacency.links[sides[k].corner] = sides[k + 1 < end ? k + 1 : i].corner;
+            borders[block]     += end - i == 1;
+            nonManifold[block] += end - i > 2 ? end - i : 0;
+        }
+    });
+
+    if (stats)
+    {
+        *stats = { .ranges = 1, .triangles = triangles, .bytes = adjacency.links.size() * sizeof(uint32_t) };
+        for (size_t block = 0; block < blocks; block++)
+        {
+            stats->borderSides      += borders[block];
+            stats->nonManifoldSides += nonManifold[block];
+        }
+        for (const size_t flat : degenerate)
+            stats->degenerateTriangles += flat;
+        stats->seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    }
+    return adjacency;
+}
+
+//----------------------------------------------------------------------------
+OttTopology::AdjacencyStats OttTopology::buildMeshAdjacency(OttModel::MeshData& mesh)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    std::unordered_map<uint32_t, size_t> rangeOf;
+    std::vector<const OttModel::modelObject*> ranges;
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        if (rangeOf.try_emplace(object.startIndex, ranges.size()).second)
+            ranges.push_back(&object);
+    }
+
+    std::vector<std::vector<uint32_t>> rangeLinks(ranges.size());
+    std::vector<AdjacencyStats> rangeStats(ranges.size());
+    OttThreadPool::shared().parallelFor(ranges.size(), [&](const size_t r)
+    {
+        rangeLinks[r] = build(std::span(mesh.vertices).subspan(ranges[r]->startVertex),
+                              std::span(mesh.indices).subspan(ranges[r]->startIndex, ranges[r]->indexCount), &rangeStats[r]).links;
+    });
+
+    AdjacencyStats stats;
+    mesh.links.clear();
+    std::vector<uint32_t> rangeStart(ranges.size());
+    for (size_t r = 0; r < ranges.size(); r++)
+    {
+        rangeStart[r] = static_cast<uint32_t>(mesh.links.size());
+        mesh.links.insert(mesh.links.end(), rangeLinks[r].begin(), rangeLinks[r].end());
+        stats += rangeStats[r];
+    }
+    for (OttModel::modelObject& object : mesh.objects)
+        object.firstLink = rangeStart[rangeOf[object.startIndex]];
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return stats;
+}
@@ -0,0 +1,437 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "upload.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "logger.h"
+#include "swapchain.h"
+
+namespace
+{
+    // Vulkan rejects zero sized buffers; empty sections still get a valid handle.
+    constexpr VkDeviceSize MIN_BUFFER_SIZE = 16;
+
+    VkDeviceAddress addressOf(const VkDevice device, const VkBuffer buffer)
+    {
+        const VkBufferDeviceAddressInfo addressInfo {
+            .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+            .buffer = buffer,
+        };
+        return vkGetBufferDeviceAddress(device, &addressInfo);
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+OttGeometryUploader::OttGeometryUploader(OttDevice* device_reference, const OttModel::VertexFormat vertex_format)
+    : deviceRef(device_reference),
+      vertexFormat(vertex_format),
+      positionStride(OttModel::positionStride(vertex_format)),
+      attributeStride(OttModel::attributeStride(vertex_format)),
+      positionArena (device_reference, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, "positions"),
+      attributeArena(device_reference, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, "vertex attributes"),
+      indexArena (device_reference, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, "indices"),
+      shortIndexArena(device_reference, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, "short indices"),
+      edgeArena  (device_reference, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, "edges")
+{
+}
+
+//----------------------------------------------------------------------------
+/** Expects the device to be idle: whatever is still queued is dropped without resuming. **/
+OttGeometryUploader::~OttGeometryUploader()
+{
+    const VkDevice device = deviceRef->getDevice();
+    if (inFlight)
+    {
+        vkWaitForFences(device, 1, &copyFence, VK_TRUE, UINT64_MAX);
+        discard(inFlight->staging);
+        vkFreeCommandBuffers(device, deviceRef->getCommandPool(), 1, &copyCommands);
+        vkDestroyFence(device, copyFence, nullptr);
+    }
+    destroyBuffer(gpuEdgeCounts);
+    for (PendingUpload* pending : queued)
+        discard(pending->staging);
+    for (Retired& entry : retired)
+        entry.destroy();
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::reserve(const VkDeviceSize vertex_count, const VkDeviceSize index_count, const VkDeviceSize short_index_count,
+                                  const VkDeviceSize edge_count)
+{
+    positionArena.reserve (vertex_count * positionStride);
+    attributeArena.reserve(vertex_count * attributeStride);
+    indexArena.reserve (index_count  * sizeof(uint32_t));
+    shortIndexArena.reserve(short_index_count * sizeof(uint16_t));
+    edgeArena.reserve  (edge_count   * sizeof(uint32_t));
+    updateEdgesAddress();
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::enableGpuEdges(const std::filesystem::path& shader_dir, const uint32_t triangles_above,
+                                         const std::optional<OttEdges::CreaseOptions>& creases)
+{
+    if (vertexFormat != OttModel::VertexFormat::Float)
+        throw std::runtime_error("GPU edge extraction needs float vertices.");
+    const OttGpuEdges::Context context {
+        .device         = deviceRef->getDevice(),
+        .physicalDevice = deviceRef->getPhysicalDevice(),
+        .queue          = deviceRef->getGraphicsQueue(),
+        .queueFamily    = deviceRef->findQueueFamilies(deviceRef->getPhysicalDevice()).graphicsFamily.value(),
+    };
+    gpuEdges      = std::make_unique<OttGpuEdges>(context, shader_dir);
+    gpuEdgesAbove = triangles_above;
+    gpuCreases    = creases;
+}
+
+//----------------------------------------------------------------------------
+/** Creates host visible copies of the mesh sections, concatenated in the order given, so a
+ *  whole batch of meshes lands in the scene with a single copy. Runs on worker threads, so
+ *  nothing here may touch the command pool or the queue. **/
+OttGeometryUploader::Staging OttGeometryUploader::stage(std::span<const OttModel::MeshData> meshes)
+{
+    const VkDevice device = deviceRef->getDevice();
+    Staging staging;
+    for (const OttModel::MeshData& mesh : meshes)
+    {
+        staging.vertexCount += static_cast<uint32_t>(mesh.vertices.size());
+        staging.indexCount  += static_cast<uint32_t>(mesh.indices.size());
+        staging.shortIndexCount += static_cast<uint32_t>(mesh.shortIndices.size());
+        staging.edgeCount   += static_cast<uint32_t>(mesh.edges.size());
+    }
+
+    if (gpuEdges)
+    {
+        uint32_t firstVertex = 0, firstIndex = 0;
+        for (const OttModel::MeshData& mesh : meshes)
+        {
+            std::unordered_set<uint32_t> seen;
+            for (const OttModel::modelObject& object : mesh.objects)
+            {
+                // Short ranges address too few vertices to come near gpuEdgesAbove triangles.
+                if (object.shortIndices || object.edgeCount > 0 || object.indexCount / 3 <= gpuEdgesAbove ||
+                    !seen.insert(object.startIndex).second)
+                    continue;
+                const auto range = std::span(mesh.indices).subspan(object.startIndex, object.indexCount);
+                staging.edgeJobs.push_back({
+                    .firstVertex = firstVertex + object.startVertex,
+                    .firstIndex  = firstIndex + object.startIndex,
+                    .vertexCount = std::ranges::max(range) + 1,
+                    .indexCount  = object.indexCount,
+                });
+            }
+            firstVertex += static_cast<uint32_t>(mesh.vertices.size());
+            firstIndex  += static_cast<uint32_t>(mesh.indices.size());
+        }
+    }
+
+    auto stageSection = [&](const VkDeviceSize size, Buffer& section, auto write)
+    {
+        section.size = size;
+        deviceRef->createBuffer(std::max(size, MIN_BUFFER_SIZE),
+                                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                section.buffer, section.memory);
+        if (size == 0)
+            return;
+        void* mapped;
+        vkMapMemory(device, section.memory, 0, size, 0, &mapped);
+        auto* cursor = static_cast<char*>(mapped);
+        for (const OttModel::MeshData& mesh : meshes)
+            cursor += write(mesh, cursor);
+        vkUnmapMemory(device, section.memory);
+    };
+    auto copyOf = [](auto member)
+    {
+        return [member](const OttModel::MeshData& mesh, char* cursor)
+        {
+            const auto& data = mesh.*member;
+            std::memcpy(cursor, data.data(), data.size() * sizeof(data[0]));
+            return data.size() * sizeof(data[0]);
+        };
+    };
+    // Splits the vertices of every mesh after their position into the two streams.
+    auto stageStreams = [&](auto vertexOf)
+    {
+        auto bytesOf = [&vertexOf](const size_t offset, const size_t bytes)
+        {
+            return [&vertexOf, offset, bytes](const OttModel::MeshData& mesh, char* cursor)
+            {
+                for (size_t v = 0; v < mesh.vertices.size(); v++, cursor += bytes)
+                    std::memcpy(cursor, reinterpret_cast<const char*>(&vertexOf(mesh, v)) + offset, bytes);
+                return mesh.vertices.size() * bytes;
+            };
+        };
+        stageSection(staging.vertexCount * positionStride,  staging.positions,  bytesOf(0, positionStride));
+        stageSection(staging.vertexCount * attributeStride, staging.attributes, bytesOf(positionStride, attributeStride));
+    };
+    if (vertexFormat == OttModel::VertexFormat::Packed)
+    {
+        std::vector<std::vector<OttModel::PackedVertex>> packed(meshes.size());
+        for (size_t m = 0; m < meshes.size(); m++)
+        {
+            packed[m].resize(meshes[m].vertices.size());
+            OttModel::packVertices(meshes[m], packed[m]);
+        }
+        stageStreams([&packed, &meshes](const OttModel::MeshData& mesh, const size_t v) -> const OttModel::PackedVertex&
+        {
+            return packed[&mesh - meshes.data()][v];
+        });
+        log_t<info>("Packed {} vertices: {:.2f} MB instead of {:.2f} MB", staging.vertexCount,
+                    staging.vertexCount * sizeof(OttModel::PackedVertex) / 1048576.0,
+                    staging.vertexCount * sizeof(OttModel::Vertex) / 1048576.0);
+    }
+    else
+    {
+        stageStreams([](const OttModel::MeshData& mesh, const size_t v) -> const OttModel::Vertex& { return mesh.vertices[v]; });
+    }
+    stageSection(staging.indexCount * sizeof(uint32_t), staging.indices, copyOf(&OttModel::MeshData::indices));
+    stageSection(staging.shortIndexCount * sizeof(uint16_t), staging.shortIndices, copyOf(&OttModel::MeshData::shortIndices));
+    stageSection(staging.edgeCount  * sizeof(uint32_t), staging.edges,   copyOf(&OttModel::MeshData::edges));
+    return staging;
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::discard(Staging& staging)
+{
+    destroyBuffer(staging.positions);
+    destroyBuffer(staging.attributes);
+    destroyBuffer(staging.indices);
+    destroyBuffer(staging.shortIndices);
+    destroyBuffer(staging.edges);
+}
+
+//----------------------------------------------------------------------------
+/** Frame boundary work: completes the upload in flight, starts the next queued one and
+ *  destroys retired resources that no recorded frame can reference anymore. **/
+void OttGeometryUploader::update(const uint64_t frame)
+{
+    currentFrame = frame;
+
+    if (inFlight && vkGetFenceStatus(deviceRef->getDevice(), copyFence) == VK_SUCCESS)
+        finish();
+
+    while (!inFlight && !queued.empty())
+    {
+        PendingUpload* pending = queued.front();
+        queued.pop_front();
+        if (pending->stop.stop_requested())
+        {
+            discard(pending->staging);
+            pending->continuation.resume();
+            continue;
+        }
+        submit(*pending);
+    }
+
+    while (!retired.empty() && retired.front().frame + MAX_FRAMES_IN_FLIGHT < currentFrame)
+    {
+        retired.front().destroy();
+        retired.pop_front();
+    }
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::deferDestroy(std::function<void()> destroy)
+{
+    retired.push_back({ .frame = currentFrame, .destroy = std::move(destroy) });
+}
+
+//----------------------------------------------------------------------------
+/** Records the staged sections into the free tail of each arena. Only arenas that run out
+ *  of room are reallocated, with their used range carried over by a GPU copy. The trailing
+ *  barrier makes the copies visible to the vertex input of later submissions. **/
+void OttGeometryUploader::submit(PendingUpload& pending)
+{
+    const VkDevice device = deviceRef->getDevice();
+    const Staging& staging = pending.staging;
+
+    const VkCommandBufferAllocateInfo allocInfo {
+        .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool        = deviceRef->getCommandPool(),
+        .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+    vkAllocateCommandBuffers(device, &allocInfo, &copyCommands);
+
+    const VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(copyCommands, &beginInfo);
+
+    const VkDeviceSize vertexOffset = positionArena.recordAppend(copyCommands, staging.positions.buffer, staging.positions.size);
+    attributeArena.recordAppend(copyCommands, staging.attributes.buffer, staging.attributes.size);   // In step with the positions.
+    const VkDeviceSize indexOffset  = indexArena.recordAppend (copyCommands, staging.indices.buffer,  staging.indices.size);
+    const VkDeviceSize shortOffset  = shortIndexArena.recordAppend(copyCommands, staging.shortIndices.buffer, staging.shortIndices.size);
+    VkDeviceSize gpuEdgeBytes = 0;
+    for (const EdgeJob& job : staging.edgeJobs)
+        gpuEdgeBytes += OttGpuEdges::maxEdgeBytes(job.indexCount);
+    const VkDeviceSize edgeOffset   = edgeArena.recordAppend  (copyCommands, staging.edges.buffer,    staging.edges.size, gpuEdgeBytes);
+
+    const VkMemoryBarrier barrier {
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+    };
+    vkCmdPipelineBarrier(copyCommands, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    if (!staging.edgeJobs.empty())
+        recordGpuEdges(staging, vertexOffset, indexOffset, edgeOffset);
+    vkEndCommandBuffer(copyCommands);
+
+    const VkFenceCreateInfo fenceInfo { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+    if (vkCreateFence(device, &fenceInfo, nullptr, &copyFence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create geometry upload fence!");
+
+    const VkSubmitInfo submitInfo {
+        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers    = &copyCommands,
+    };
+    if (vkQueueSubmit(deviceRef->getGraphicsQueue(), 1, &submitInfo, copyFence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit geometry upload!");
+
+    pending.placement = Placement {
+        .firstVertex = static_cast<uint32_t>(vertexOffset / positionStride),
+        .firstIndex  = static_cast<uint32_t>(indexOffset  / sizeof(uint32_t)),
+        .firstShortIndex = static_cast<uint32_t>(shortOffset / sizeof(uint16_t)),
+        .firstEdge   = static_cast<uint32_t>(edgeOffset   / sizeof(uint32_t)),
+    };
+    inFlight = &pending;
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::finish()
+{
+    const VkDevice device = deviceRef->getDevice();
+    vkFreeCommandBuffers(device, deviceRef->getCommandPool(), 1, &copyCommands);
+    vkDestroyFence(device, copyFence, nullptr);
+    copyCommands = VK_NULL_HANDLE;
+    copyFence    = VK_NULL_HANDLE;
+
+    PendingUpload& done = *std::exchange(inFlight, nullptr);
+    if (!done.staging.edgeJobs.empty())
+        finishGpuEdges(done);
+    discard(done.staging);
+
+    auto retire = [this](std::function<void()> destroy) { deferDestroy(std::move(destroy)); };
+    positionArena.commit(retire);
+    attributeArena.commit(retire);
+    indexArena.commit(retire);
+    shortIndexArena.commit(retire);
+    edgeArena.commit(retire);
+    updateEdgesAddress();
+
+    log_t<info>("Geometry upload resident: {} vertices, {} + {} 16-bit indices, {} edges in the scene", vertexCount(), indexCount(),
+                shortIndexCount(), edgeCount());
+    done.continuation.resume();
+}
+
+//----------------------------------------------------------------------------
+/** Records the GPU edge extraction of the staged jobs, reading the geometry at its place in
+ *  the arenas and writing the edges into the tail reserved after the staged edges. Runs
+ *  after the copies, in the same command buffer. **/
+void OttGeometryUploader::recordGpuEdges(const Staging& staging, const VkDeviceSize vertex_offset, const VkDeviceSize index_offset,
+                                         const VkDeviceSize edge_offset)
+{
+    const VkDevice device = deviceRef->getDevice();
+    const VkDeviceAddress vertices = addressOf(device, positionArena.getPendingBuffer()) + vertex_offset;
+    const VkDeviceAddress indices  = addressOf(device, indexArena.getPendingBuffer())  + index_offset;
+
+    std::vector<OttGpuEdges::Job> jobs;
+    for (const EdgeJob& job : staging.edgeJobs)
+    {
+        jobs.push_back({
+            .vertices    = vertices + VkDeviceSize(job.firstVertex) * positionStride,
+            .indices     = indices  + VkDeviceSize(job.firstIndex)  * sizeof(uint32_t),
+            .vertexCount = job.vertexCount,
+            .indexCount  = job.indexCount,
+        });
+    }
+
+    gpuEdgeCounts.size = (jobs.size() + 1) * sizeof(uint32_t);
+    deviceRef->createBuffer(gpuEdgeCounts.size,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            gpuEdgeCounts.buffer, gpuEdgeCounts.memory);
+
+    const OttGpuEdges::Output output {
+        .edges  = addressOf(device, edgeArena.getPendingBuffer()) + edge_offset + staging.edges.size,
+        .counts = gpuEdgeCounts.buffer,
+    };
+    gpuEdges->record(copyCommands, jobs, output, gpuCreases);
+}
+
+//----------------------------------------------------------------------------
+/** Reads back how many edges every job produced, hands the unused part of the reserved
+ *  tail back to the edge arena and reports the ranges in the placement. **/
+void OttGeometryUploader::finishGpuEdges(PendingUpload& done)
+{
+    const std::vector<EdgeJob>& jobs = done.staging.edgeJobs;
+    std::vector<uint32_t> counts(jobs.size() + 1);
+    void* mapped;
+    vkMapMemory(deviceRef->getDevice(), gpuEdgeCounts.memory, 0, gpuEdgeCounts.size, 0, &mapped);
+    std::memcpy(counts.data(), mapped, counts.size() * sizeof(uint32_t));
+    vkUnmapMemory(deviceRef->getDevice(), gpuEdgeCounts.memory);
+    destroyBuffer(gpuEdgeCounts);
+
+    VkDeviceSize reserved = 0;
+    uint32_t firstEdge = done.placement->firstEdge + done.staging.edgeCount;
+    for (size_t k = 0; k < jobs.size(); k++)
+    {
+        const uint32_t edgeCount = 2 * counts[k];
+        done.placement->gpuEdges.push_back({
+            .firstIndex = done.placement->firstIndex + jobs[k].firstIndex,
+            .firstEdge  = firstEdge,
+            .edgeCount  = edgeCount,
+        });
+        firstEdge += edgeCount;
+        reserved  += OttGpuEdges::maxEdgeBytes(jobs[k].indexCount);
+    }
+    const VkDeviceSize written = VkDeviceSize(firstEdge - done.placement->firstEdge - done.staging.edgeCount) * sizeof(uint32_t);
+    edgeArena.releaseTail(reserved - written);
+
+    if (counts.back() > 0)
+        log_t<warning>("{} position hash collisions during GPU edge extraction, extra lines may show there", counts.back());
+    log_t<info>("GPU edges for {} index ranges: {} edges", jobs.size(), (written / sizeof(uint32_t)) / 2);
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::updateEdgesAddress()
+{
+    if (edgeArena.getBuffer() == VK_NULL_HANDLE)
+        return;
+    const VkBufferDeviceAddressInfo addressInfo {
+        .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = edgeArena.getBuffer(),
+    };
+    edgesBufferAddress = vkGetBufferDeviceAddress(deviceRef->getDevice(), &addressInfo);
+}
+
+//----------------------------------------------------------------------------
+void OttGeometryUploader::destroyBuffer(Buffer& buffer) const
+{
+    const VkDevice device = deviceRef->getDevice();
+    if (buffer.buffer != VK_NULL_HANDLE) { vkDestroyBuffer (device, buffer.buffer, nullptr); }
+    if (buffer.memory != VK_NULL_HANDLE) { vkFreeMemory    (device, buffer.memory, nullptr); }
+    buffer = {};
+}
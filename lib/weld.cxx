@@ -0,0 +1,405 @@
+// Ottocento Engine. Architectural BIM Engine.
+// Copyright (C) 2024  Lucas M. Faria.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "weld.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "threadpool.h"
+
+namespace
+{
+    constexpr size_t   BLOCK_SIZE     = 1 << 16;
+    constexpr unsigned PARTITION_BITS = 6;
+    constexpr size_t   PARTITIONS     = size_t(1) << PARTITION_BITS;
+
+    //----------------------------------------------------------------------------
+    /** Open-addressing hash set of vertex ids with linear probing.
+     *  A slot keeps the id and the upper half of the hash, so most probes are rejected
+     *  without touching the vertex itself. The ids index into a caller-provided array. **/
+    class FlatVertexTable
+    {
+    public:
+        explicit FlatVertexTable(const size_t expected)
+        {
+            slots.resize(std::bit_ceil(std::max<size_t>(16, expected * 2)), { EMPTY, 0 });
+            mask = slots.size() - 1;
+        }
+
+        //----------------------------------------------------------------------------
+        /** Returns the id of a stored vertex equal to vertex, or inserts candidate and returns it. **/
+        uint32_t findOrInsert(const uint64_t hash, const OttModel::Vertex& vertex, const uint32_t candidate, const OttModel::Vertex* base)
+        {
+            if ((count + 1) * 2 > slots.size())
+                grow(base);
+
+            const auto tag = static_cast<uint32_t>(hash >> 32);
+            for (size_t slot = hash & mask; ; slot = (slot + 1) & mask)
+            {
+                Slot& entry = slots[slot];
+                if (entry.id == EMPTY)
+                {
+                    entry = { candidate, tag };
+                    count++;
+                    return candidate;
+                }
+                if (entry.tag == tag && base[entry.id] == vertex)
+                    return entry.id;
+            }
+        }
+
+    private:
+        struct Slot
+        {
+            uint32_t id;
+            uint32_t tag;
+        };
+        static constexpr uint32_t EMPTY = UINT32_MAX;
+
+        std::vector<Slot> slots;
+        size_t            mask  = 0;
+        size_t            count = 0;
+
+        void grow(const OttModel::Vertex* base)
+        {
+            std::vector<Slot> previous(slots.size() * 2, { EMPTY, 0 });
+            previous.swap(slots);
+            mask = slots.size() - 1;
+            for (const Slot& entry : previous)
+            {
+                if (entry.id == EMPTY)
+                    continue;
+                size_t slot = OttModel::hashVertex(base[entry.id]) & mask;
+                while (slots[slot].id != EMPTY)
+                    slot = (slot + 1) & mask;
+                slots[slot] = entry;
+            }
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    void deduplicateSequential(std::span<const OttModel::Vertex> corners,
+                               std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        // Dedup ratios of real meshes sit between ~1 (flat shaded) and ~6 (smooth); start low and grow.
+        FlatVertexTable table(corners.size() / 4);
+        vertices.reserve(corners.size() / 4);
+        for (size_t i = 0; i < corners.size(); i++)
+        {
+            const auto candidate = static_cast<uint32_t>(vertices.size());
+            const uint32_t id    = table.findOrInsert(OttModel::hashVertex(corners[i]), corners[i], candidate, vertices.data());
+            if (id == candidate)
+                vertices.push_back(corners[i]);
+            indices[i] = id;
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** 1. Hash every corner and scatter the corner ids into PARTITIONS buckets by the top
+     *     hash bits, keeping them in ascending order inside each bucket.
+     *  2. Weld each bucket independently: the first corner inserted is the first occurrence.
+     *  3. Number the first occurrences with a prefix sum over blocks, in corner order. **/
+    void deduplicateParallel(std::span<const OttModel::Vertex> corners,
+                             std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        OttThreadPool& pool = OttThreadPool::shared();
+        const size_t count  = corners.size();
+        const size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        auto blockRange = [count](const size_t block)
+        {
+            return std::pair { block * BLOCK_SIZE, std::min(count, (block + 1) * BLOCK_SIZE) };
+        };
+
+        std::vector<uint64_t> hashes(count);
+        std::vector<size_t>   bucketOffsets(blocks * PARTITIONS, 0);
+        pool.parallelFor(blocks, [&](const size_t block)
+        {
+            const auto [first, last] = blockRange(block);
+            size_t* counts = &bucketOffsets[block * PARTITIONS];
+            for (size_t i = first; i < last; i++)
+            {
+                hashes[i] = OttModel::hashVertex(corners[i]);
+                counts[hashes[i] >> (64 - PARTITION_BITS)]++;
+            }
+        });
+
+        std::vector<size_t> partitionStart(PARTITIONS + 1, 0);
+        size_t running = 0;
+        for (size_t p = 0; p < PARTITIONS; p++)
+        {
+            partitionStart[p] = running;
+            for (size_t block = 0; block < blocks; block++)
+            {
+                const size_t blockCount = bucketOffsets[block * PARTITIONS + p];
+                bucketOffsets[block * PARTITIONS + p] = running;
+                running += blockCount;
+            }
+        }
+        partitionStart[PARTITIONS] = running;
+
+        std::vector<uint32_t> order(count);
+        pool.parallelFor(blocks, [&](const size_t block)
+        {
+            const auto [first, last] = blockRange(block);
+            size_t* cursor = &bucketOffsets[block * PARTITIONS];
+            for (size_t i = first; i < last; i++)
+                order[cursor[hashes[i] >> (64 - PARTITION_BITS)]++] = static_cast<uint32_t>(i);
+        });
+
+        std::vector<uint32_t> firstOf(count);
+        pool.parallelFor(PARTITIONS, [&](const size_t p)
+        {
+            FlatVertexTable table((partitionStart[p + 1] - partitionStart[p]) / 4);
+            for (size_t k = partitionStart[p]; k < partitionStart[p + 1]; k++)
+            {
+                const uint32_t i = order[k];
+                firstOf[i] = table.findOrInsert(hashes[i], corners[i], i, corners.data());
+            }
+        });
+        hashes = {};
+
+        // order is no longer needed and becomes the corner -> vertex id map.
+        std::vector<uint32_t>& vertexId = order;
+        std::vector<size_t> blockFirst(blocks + 1, 0);
+        pool.parallelFor(blocks, [&](const size_t block)
+        {
+            const auto [first, last] = blockRange(block);
+            size_t unique = 0;
+            for (size_t i = first; i < last; i++)
+                unique += firstOf[i] == i ? 1 : 0;
+            blockFirst[block + 1] = unique;
+        });
+        for (size_t block = 0; block < blocks; block++)
+            blockFirst[block + 1] += blockFirst[block];
+
+        vertices.resize(blockFirst[blocks]);
+        pool.parallelFor(blocks, [&](const size_t block)
+        {
+            const auto [first, last] = blockRange(block);
+            auto id = static_cast<uint32_t>(blockFirst[block]);
+            for (size_t i = first; i < last; i++)
+            {
+                if (firstOf[i] == i)
+                {
+                    vertexId[i]  = id;
+                    vertices[id] = corners[i];
+                    id++;
+                }
+            }
+        });
+        pool.parallelFor(blocks, [&](const size_t block)
+        {
+            const auto [first, last] = blockRange(block);
+            for (size_t i = first; i < last; i++)
+                indices[i] = vertexId[firstOf[i]];
+        });
+    }
+
+    //----------------------------------------------------------------------------
+    struct CellEntry
+    {
+        uint64_t key;
+        uint32_t vertex;
+
+        bool operator<(const CellEntry& other) const
+        {
+            return key != other.key ? key < other.key : vertex < other.vertex;
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    /** Spatial hash of an integer grid cell. Distinct cells may share a key; that only
+     *  adds candidates, which the distance test rejects. **/
+    uint64_t cellKey(const int64_t x, const int64_t y, const int64_t z)
+    {
+        uint64_t key = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ULL;
+        key ^= static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4FULL + (key << 6) + (key >> 2);
+        key ^= static_cast<uint64_t>(z) * 0x165667B19E3779F9ULL + (key << 6) + (key >> 2);
+        key ^= key >> 31;
+        return key * 0x94D049BB133111EBULL;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Sorts blocks on the pool, then merges neighbouring runs pairwise in parallel rounds. **/
+    void parallelSort(std::vector<CellEntry>& entries)
+    {
+        OttThreadPool& pool = OttThreadPool::shared();
+        const size_t runs   = std::min((pool.size() + 1) * 2, (entries.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        if (runs <= 1)
+        {
+            std::sort(entries.begin(), entries.end());
+            return;
+        }
+
+        auto boundary = [&entries, runs](const size_t run)
+        {
+            return entries.begin() + static_cast<ptrdiff_t>(std::min(entries.size(), entries.size() * run / runs));
+        };
+        pool.parallelFor(runs, [&](const size_t run) { std::sort(boundary(run), boundary(run + 1)); });
+        for (size_t width = 1; width < runs; width *= 2)
+        {
+            pool.parallelFor((runs + 2 * width - 1) / (2 * width), [&](const size_t pair)
+            {
+                const size_t first = pair * 2 * width;
+                if (first + width < runs)
+                    std::inplace_merge(boundary(first), boundary(first + width), boundary(std::min(runs, first + 2 * width)));
+            });
+        }
+    }
+} // anonymous namespace
+
+//----------------------------------------------------------------------------
+void OttWeld::deduplicate(std::span<const OttModel::Vertex> corners,
+                          std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                          const size_t parallel_threshold)
+{
+    vertices.clear();
+    indices.resize(corners.size());
+    if (corners.size() < parallel_threshold || OttThreadPool::shared().size() == 0)
+        deduplicateSequential(corners, vertices, indices);
+    else
+        deduplicateParallel(corners, vertices, indices);
+}
+
+//----------------------------------------------------------------------------
+OttWeld::WeldStats OttWeld::weld(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices, const WeldOptions& options)
+{
+    WeldStats stats { .inputVertices = vertices.size(), .outputVertices = vertices.size() };
+    if (vertices.empty() || !(options.epsilon > 0.0f))
+        return stats;
+
+    OttThreadPool& pool   = OttThreadPool::shared();
+    const size_t   count  = vertices.size();
+    const size_t   blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const double   inverseCell = 1.0 / static_cast<double>(options.epsilon);
+    const float    epsilonSquared = options.epsilon * options.epsilon;
+    auto cellOf = [inverseCell](const float coordinate)
+    {
+        return static_cast<int64_t>(std::floor(static_cast<double>(coordinate) * inverseCell));
+    };
+
+    // Bucket every vertex into the grid.
+    std::vector<CellEntry> grid(count);
+    pool.parallelFor(blocks, [&](const size_t block)
+    {
+        for (size_t i = block * BLOCK_SIZE; i < std::min(count, (block + 1) * BLOCK_SIZE); i++)
+        {
+            const glm::vec3& p = vertices[i].pos;
+            grid[i] = { cellKey(cellOf(p.x), cellOf(p.y), cellOf(p.z)), static_cast<uint32_t>(i) };
+        }
+    });
+    parallelSort(grid);
+
+    // For every vertex, the lowest index within epsilon in the 27 surrounding cells.
+    std::vector<uint32_t> cluster(count);
+    pool.parallelFor(blocks, [&](const size_t block)
+    {
+        for (size_t i = block * BLOCK_SIZE; i < std::min(count, (block + 1) * BLOCK_SIZE); i++)
+        {
+            const glm::vec3& p = vertices[i].pos;
+            const int64_t cx = cellOf(p.x), cy = cellOf(p.y), cz = cellOf(p.z);
+            auto nearest = static_cast<uint32_t>(i);
+            for (int64_t dz = -1; dz <= 1; dz++)
+            for (int64_t dy = -1; dy <= 1; dy++)
+            for (int64_t dx = -1; dx <= 1; dx++)
+            {
+                const uint64_t key = cellKey(cx + dx, cy + dy, cz + dz);
+                auto entry = std::lower_bound(grid.begin(), grid.end(), CellEntry { key, 0 });
+                for (; entry != grid.end() && entry->key == key && entry->vertex < nearest; ++entry)
+                {
+                    const glm::vec3 d = vertices[entry->vertex].pos - p;
+                    if (d.x * d.x + d.y * d.y + d.z * d.z <= epsilonSquared)
+                        nearest = entry->vertex;
+                }
+            }
+            cluster[i] = nearest;
+        }
+    });
+    grid = {};
+
+    // Resolve chains in index order; the nearest earlier vertex always points further back.
+    for (size_t i = 0; i < count; i++)
+        cluster[i] = cluster[cluster[i]];
+
+    std::vector<uint32_t> remap(count);
+    if (options.policy == WeldPolicy::SnapPositions)
+    {
+        for (size_t i = 0; i < count; i++)
+            vertices[i].pos = vertices[cluster[i]].pos;
+        std::vector<OttModel::Vertex> unique;
+        deduplicate(vertices, unique, remap);
+        vertices = std::move(unique);
+    }
+    else
+    {
+        std::vector<OttModel::Vertex> unique;
+        std::vector<uint32_t>         members;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (cluster[i] == i)
+            {
+                remap[i] = static_cast<uint32_t>(unique.size());
+                unique.push_back(vertices[i]);
+                members.push_back(1);
+                continue;
+            }
+            remap[i] = remap[cluster[i]];
+            if (options.policy == WeldPolicy::Average)
+            {
+                OttModel::Vertex& sum = unique[remap[i]];
+                sum.pos      += vertices[i].pos;
+                sum.color    += vertices[i].color;
+                sum.texCoord += vertices[i].texCoord;
+                sum.normal   += vertices[i].normal;
+                members[remap[i]]++;
+            }
+        }
+        if (options.policy == WeldPolicy::Average)
+        {
+            for (size_t v = 0; v < unique.size(); v++)
+            {
+                const float scale = 1.0f / static_cast<float>(members[v]);
+                unique[v].pos      *= scale;
+                unique[v].color    *= scale;
+                unique[v].texCoord *= scale;
+                const float length  = glm::length(unique[v].normal);
+                unique[v].normal    = length > 0.0f ? unique[v].normal / length : unique[v].normal;
+            }
+        }
+        vertices = std::move(unique);
+    }
+
+    // Remap the triangles and drop the ones that collapsed.
+    size_t kept = 0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const uint32_t a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+        if (a == b || b == c || c == a)
+        {
+            stats.collapsedTriangles++;
+            continue;
+        }
+        indices[kept++] = a;
+        indices[kept++] = b;
+        indices[kept++] = c;
+    }
+    indices.resize(kept);
+
+    stats.outputVertices = vertices.size();
+    return stats;
+}
@@ -11,8 +11,18 @@ layout(binding = 0) uniform UniformBufferObject {
     mat4 inverseproj;
     vec3 cameraPos;
     uint64_t edgesBuffer;
+    uint64_t instanceBuffer;
 } ubo;
 
+// One transform per drawn object, indexed by gl_InstanceIndex (firstInstance included).
+layout(buffer_reference, std430) readonly buffer InstanceTransforms {
+    mat4 transforms[];
+};
+
+// Set for scenes uploaded as OttModel::PackedVertex: positions arrive as fractions of the
+// object's quantization box and normals octahedral encoded in xy.
+layout(constant_id = 0) const bool PACKED_VERTICES = false;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
@@ -32,18 +42,35 @@ const float AMBIENT = 0.3;
 layout(push_constant) uniform PushConstantData {
     vec3 offset;
     vec3 color;
+    uint textureID;
+    vec3 quantOffset;
+    vec3 quantScale;
 } push;
 
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float fold = max(-n.z, 0.0);
+    n.xy += mix(vec2(fold), vec2(-fold), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
 void main() {
-    normal  = (ubo.view * ubo.model * vec4(inNormal, 0.0)).xyz;
-    viewPos = (ubo.view * ubo.model * vec4(inPosition, 1.0)).xyz;
+    // Object transform (glTF node, instanced copy); assumes uniform scale for the normals.
+    vec3 position     = PACKED_VERTICES ? push.quantOffset + push.quantScale * inPosition : inPosition;
+    vec3 vertexNormal = PACKED_VERTICES ? octDecode(inNormal.xy) : inNormal;
+    mat4 transform    = InstanceTransforms(ubo.instanceBuffer).transforms[gl_InstanceIndex];
+    vec4 objectPos    = transform * vec4(position, 1.0);
+    vec4 objectNormal = transform * vec4(vertexNormal, 0.0);
+
+    normal  = (ubo.view * ubo.model * objectNormal).xyz;
+    viewPos = (ubo.view * ubo.model * objectPos).xyz;
     
-    vec3 normalWorldSpace = normalize((ubo.normalMatrix * vec4(inNormal, 0.0f)).xyz);
+    vec3 normalWorldSpace = normalize((ubo.normalMatrix * objectNormal).xyz);
     lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
     
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * ubo.model * objectPos;
             
     fragColor    = inColor;
     fragTexCoord = inTexCoord;
-    fragPosition = inPosition;
+    fragPosition = position;
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#version 450
+
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : enable
+#extension GL_EXT_buffer_reference : require
+
+// Vertex stage of passes that only need positions (wireframe, depth, picking): it reads
+// vertex binding 0 alone, the position stream, and skips the attribute stream.
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 normalMatrix;
+    mat4 view;
+    mat4 proj;
+    mat4 inverseproj;
+    vec3 cameraPos;
+    uint64_t edgesBuffer;
+    uint64_t instanceBuffer;
+} ubo;
+
+layout(buffer_reference, std430) readonly buffer InstanceTransforms {
+    mat4 transforms[];
+};
+
+layout(constant_id = 0) const bool PACKED_VERTICES = false;
+
+layout(location = 0) in vec3 inPosition;
+
+layout(location = 2) out vec3 fragPosition;
+
+layout(push_constant) uniform PushConstantData {
+    vec3 offset;
+    vec3 color;
+    uint textureID;
+    vec3 quantOffset;
+    vec3 quantScale;
+} push;
+
+void main() {
+    vec3 position  = PACKED_VERTICES ? push.quantOffset + push.quantScale * inPosition : inPosition;
+    mat4 transform = InstanceTransforms(ubo.instanceBuffer).transforms[gl_InstanceIndex];
+    gl_Position    = ubo.proj * ubo.view * ubo.model * transform * vec4(position, 1.0);
+    fragPosition   = position;
+}
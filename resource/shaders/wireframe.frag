@@ -3,8 +3,7 @@
 
 layout(binding = 1) uniform sampler2D texSampler[1024];
 
-layout(location = 0) in vec3 fragColor;
-layout(location = 1) in vec2 fragTexCoord;
+// Fed by position.vert, which has nothing but the position to pass on.
 layout(location = 2) in vec3 fragPosition;
 
 layout(location = 0) out vec4 outColor;
@@ -20,5 +19,5 @@ float rand(vec2 co) {
 }
 
 void main() {
-    outColor = vec4(vec3(0.2, 0.2, 0.2) * clamp(rand(fragTexCoord), 0.5f, 1.0f), 1.0);
+    outColor = vec4(vec3(0.2, 0.2, 0.2) * clamp(rand(fragPosition.xy), 0.5f, 1.0f), 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include <loader.h>
+#include <model.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    //----------------------------------------------------------------------------
+    std::vector<OttModel::Vertex> randomVertices(const size_t count, const uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+        std::vector<OttModel::Vertex> vertices(count);
+        for (OttModel::Vertex& vertex : vertices)
+        {
+            vertex.pos   = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+            vertex.color = glm::vec3(coordinate(random) * 10.0f);   // Read by the loads, never part of the result.
+        }
+        return vertices;
+    }
+
+    float referenceRadius(const std::span<const OttModel::Vertex> vertices, const glm::vec3& center)
+    {
+        float best = 0.0f;
+        for (const OttModel::Vertex& vertex : vertices)
+            best = std::max(best, glm::length(vertex.pos - center));
+        return best;
+    }
+} // anonymous namespace
+
+TEST_CASE("SIMD bounds match the scalar reduction", "[bounds]")
+{
+    const std::vector<OttModel::Vertex> vertices = randomVertices(1000, 7);
+    for (int level = 0; level <= static_cast<int>(OttModel::simdPath()); level++)
+    {
+        const auto path = static_cast<OttModel::SimdPath>(level);
+        // Counts around the widths of the unrolled loops.
+        for (const size_t count : { size_t(1), size_t(2), size_t(3), size_t(4), size_t(5), size_t(7), size_t(8),
+                                    size_t(9), size_t(15), size_t(16), size_t(17), size_t(1000) })
+        {
+            const std::span<const OttModel::Vertex> slice = std::span(vertices).subspan(0, count);
+            glm::vec3 expectedLow = slice[0].pos, expectedHigh = slice[0].pos;
+            for (const OttModel::Vertex& vertex : slice)
+            {
+                expectedLow  = glm::min(expectedLow, vertex.pos);
+                expectedHigh = glm::max(expectedHigh, vertex.pos);
+            }
+            glm::vec3 low, high;
+            OttModel::positionBounds(slice, low, high, path);
+            REQUIRE(low == expectedLow);
+            REQUIRE(high == expectedHigh);
+
+            const glm::vec3 center = 0.5f * (low + high);
+            REQUIRE(std::abs(OttModel::boundingRadius(slice, center, path) - referenceRadius(slice, center)) < 1e-3f);
+        }
+    }
+
+    glm::vec3 low(1.0f), high(1.0f);
+    OttModel::positionBounds({}, low, high);
+    REQUIRE(low == glm::vec3(0.0f));
+    REQUIRE(high == glm::vec3(0.0f));
+    REQUIRE(OttModel::boundingRadius({}, glm::vec3(0.0f)) == 0.0f);
+}
+
+TEST_CASE("computeBounds fills one entry per object and the scene box", "[bounds]")
+{
+    // Two ranges, the second one spread over several blocks and drawn twice, moved.
+    OttModel::MeshData mesh;
+    mesh.vertices = randomVertices(200'000, 11);
+    for (size_t v = 0; v < 100; v++)
+        mesh.vertices[v].pos *= 0.01f;
+    // Turned a quarter around z and lifted to y = 1000: (x, y, z) -> (-y, x + 1000, z).
+    const glm::mat4 moved(glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f),
+                          glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(0.0f, 1000.0f, 0.0f, 1.0f));
+    mesh.objects = { { .startVertex = 100 }, { .startVertex = 0 }, { .startVertex = 100, .transform = moved } };
+
+    const OttModel::BoundsStats stats = OttModel::computeBounds(mesh);
+    REQUIRE(stats.objects == 3);
+    REQUIRE(stats.ranges == 2);
+    REQUIRE(stats.vertices == mesh.vertices.size());
+    REQUIRE(mesh.bounds.size() == 3);
+
+    const std::span<const OttModel::Vertex> small = std::span(mesh.vertices).subspan(0, 100);
+    const std::span<const OttModel::Vertex> large = std::span(mesh.vertices).subspan(100);
+    glm::vec3 low, high;
+    OttModel::positionBounds(large, low, high, OttModel::SimdPath::Scalar);
+    REQUIRE(mesh.bounds.low(0) == low);
+    REQUIRE(mesh.bounds.high(0) == high);
+    REQUIRE(mesh.bounds.low(2) == low);
+    const glm::vec4 sphere = mesh.bounds.sphere(0);
+    REQUIRE(glm::vec3(sphere) == 0.5f * (low + high));
+    REQUIRE(std::abs(sphere.w - referenceRadius(large, glm::vec3(sphere))) < 1e-3f);
+    for (const OttModel::Vertex& vertex : small)
+    {
+        REQUIRE(glm::min(vertex.pos, mesh.bounds.low(1)) == mesh.bounds.low(1));
+        REQUIRE(glm::max(vertex.pos, mesh.bounds.high(1)) == mesh.bounds.high(1));
+    }
+
+    // The moved copy spans y in [1000 - 100, 1000 + 100] and x in [-100, 100].
+    REQUIRE(!mesh.bounds.sceneEmpty());
+    REQUIRE(std::abs(mesh.bounds.sceneHigh.y - (1000.0f + high.x)) < 1e-2f);
+    REQUIRE(std::abs(mesh.bounds.sceneLow.x - std::min(low.x, -high.y)) < 1e-2f);
+    REQUIRE(std::abs(mesh.bounds.sceneLow.y - low.y) < 1e-2f);
+
+    // An object past the last vertex has an empty box that leaves the scene box alone.
+    mesh.objects.push_back({ .startVertex = static_cast<uint32_t>(mesh.vertices.size()) });
+    const glm::vec3 sceneHigh = mesh.bounds.sceneHigh;
+    OttModel::computeBounds(mesh);
+    REQUIRE(mesh.bounds.size() == 4);
+    REQUIRE(mesh.bounds.empty(3));
+    REQUIRE(mesh.bounds.sphere(3) == glm::vec4(0.0f));
+    REQUIRE(mesh.bounds.sceneHigh == sceneHigh);
+}
+
+TEST_CASE("loadMesh computes bounds on load and from the cache", "[bounds]")
+{
+    const auto path = OttTest::writeTempFile("bounds_triangle.obj", "v -1 0 2\nv 3 4 2\nv 0 -2 5\nf 1 2 3\n");
+    for (int pass = 0; pass < 2; pass++)
+    {
+        OttModel::MeshData mesh;
+        REQUIRE(OttLoader::loadMesh(path, mesh));
+        REQUIRE(mesh.bounds.size() == mesh.objects.size());
+        REQUIRE(mesh.bounds.low(0) == glm::vec3(-1.0f, -2.0f, 2.0f));
+        REQUIRE(mesh.bounds.high(0) == glm::vec3(3.0f, 4.0f, 5.0f));
+        REQUIRE(mesh.bounds.sceneLow == glm::vec3(-1.0f, -2.0f, 2.0f));
+    }
+}
@@ -0,0 +1,292 @@
+#include <bvh.h>
+#include <instancing.h>
+#include <loader.h>
+#include <meshcache.h>
+#include <model.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    //----------------------------------------------------------------------------
+    std::vector<OttBvh::Box> randomBoxes(const size_t count, const uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f), size(0.0f, 2.0f);
+        std::vector<OttBvh::Box> boxes(count);
+        for (OttBvh::Box& box : boxes)
+        {
+            box.low  = glm::vec3(coordinate(random), coordinate(random), coordinate(random));
+            box.high = box.low + glm::vec3(size(random), size(random), size(random));
+        }
+        return boxes;
+    }
+
+    bool contains(const OttBvh::Node& outer, const OttBvh::Node& inner)
+    {
+        return glm::min(outer.low, inner.low) == outer.low && glm::max(outer.high, inner.high) == outer.high;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Checks that every item is in one leaf, that each node is reached once and that its
+     *  box holds its children's. **/
+    void requireWellFormed(const OttBvh::Tree& tree, const size_t items)
+    {
+        REQUIRE(tree.nodes.size() == 2 * items - 1);
+        std::vector<int> reached(tree.nodes.size(), 0), found(items, 0);
+        std::vector<uint32_t> stack { 0 };
+        while (!stack.empty())
+        {
+            const uint32_t index = stack.back();
+            stack.pop_back();
+            reached[index]++;
+            const OttBvh::Node& node = tree.nodes[index];
+            if (node.isLeaf())
+            {
+                found[node.left]++;
+                continue;
+            }
+            REQUIRE(contains(node, tree.nodes[node.left]));
+            REQUIRE(contains(node, tree.nodes[node.right]));
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+        REQUIRE(std::ranges::all_of(reached, [](const int n) { return n == 1; }));
+        REQUIRE(std::ranges::all_of(found, [](const int n) { return n == 1; }));
+    }
+} // anonymous namespace
+
+TEST_CASE("LBVH nodes cover their children and every item once", "[bvh]")
+{
+    REQUIRE(OttBvh::build(std::span<const OttBvh::Box>()).empty());
+    for (const size_t count : { size_t(1), size_t(2), size_t(3), size_t(17), size_t(1000), size_t(100'000) })
+    {
+        const std::vector<OttBvh::Box> boxes = randomBoxes(count, static_cast<uint32_t>(count));
+        const OttBvh::Tree tree = OttBvh::build(boxes);
+        requireWellFormed(tree, count);
+    }
+
+    // Equal centers only differ by their index.
+    const std::vector<OttBvh::Box> stacked(5000, OttBvh::Box { glm::vec3(1.0f), glm::vec3(2.0f) });
+    requireWellFormed(OttBvh::build(stacked), stacked.size());
+}
+
+TEST_CASE("LBVH queries match a linear scan", "[bvh]")
+{
+    const std::vector<OttBvh::Box> boxes = randomBoxes(20'000, 3);
+    const OttBvh::Tree tree = OttBvh::build(boxes);
+    const std::vector<OttBvh::Box> queries = randomBoxes(50, 4);
+    for (OttBvh::Box query : queries)
+    {
+        query.high += glm::vec3(5.0f);
+        std::vector<uint32_t> found, expected;
+        OttBvh::overlapping(tree, query, [&found](const uint32_t item) { found.push_back(item); });
+        for (uint32_t i = 0; i < boxes.size(); i++)
+        {
+            if (boxes[i].overlaps(query))
+                expected.push_back(i);
+        }
+        std::ranges::sort(found);
+        REQUIRE(found == expected);
+    }
+
+    // Rays visit at least the boxes they enter, and can stop at the first.
+    std::mt19937 random(8);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int r = 0; r < 50; r++)
+    {
+        const glm::vec3 origin(unit(random) * 60.0f, unit(random) * 60.0f, -60.0f);
+        const glm::vec3 direction(unit(random) * 0.5f, unit(random) * 0.5f, 1.0f);
+        const glm::vec3 inverse = glm::vec3(1.0f) / direction;
+        float nearest = std::numeric_limits<float>::infinity();
+        for (const OttBvh::Box& box : boxes)
+            nearest = std::min(nearest, OttBvh::entryDistance(box.low, box.high, origin, inverse));
+
+        float limit = std::numeric_limits<float>::infinity();
+        float first = std::numeric_limits<float>::infinity();
+        OttBvh::raycast(tree, origin, direction, limit, [&](const uint32_t item, float& maxDistance)
+        {
+            const float distance = OttBvh::entryDistance(boxes[item].low, boxes[item].high, origin, inverse);
+            if (distance < maxDistance)
+                maxDistance = first = distance;
+        });
+        REQUIRE(first == nearest);
+    }
+}
+
+TEST_CASE("Scene raycasts find the nearest triangle of any instance", "[bvh]")
+{
+    // One grid drawn three times, raised and turned, and one small object with 16-bit indices.
+    OttModel::MeshData mesh;
+    OttTest::grid(64, mesh.vertices, mesh.indices, 1.0f / 64.0f);
+    const auto gridIndices = static_cast<uint32_t>(mesh.indices.size());
+    OttModel::modelObject flat { .startIndex = 0, .startVertex = 0, .indexCount = gridIndices };
+    mesh.objects.push_back(flat);
+    flat.transform[3] = glm::vec4(0.0f, 0.0f, 2.0f, 1.0f);
+    mesh.objects.push_back(flat);
+    flat.transform = glm::mat4(glm::vec4(0.0f, 1.0f, 0.0f, 0.0f), glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f),
+                               glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(0.5f, 0.0f, 1.0f, 1.0f));
+    mesh.objects.push_back(flat);
+
+    const auto smallVertex = static_cast<uint32_t>(mesh.vertices.size());
+    mesh.vertices.push_back({ .pos = glm::vec3(0.4f, 0.4f, 3.0f) });
+    mesh.vertices.push_back({ .pos = glm::vec3(0.6f, 0.4f, 3.0f) });
+    mesh.vertices.push_back({ .pos = glm::vec3(0.5f, 0.6f, 3.0f) });
+    mesh.shortIndices = { 0, 1, 2 };
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = smallVertex, .indexCount = 3, .shortIndices = true });
+    mesh.objects.push_back({ .startIndex = gridIndices, .startVertex = smallVertex, .indexCount = 0 });
+
+    OttBvh::BvhStats stats;
+    const OttBvh::SceneBvh bvh = OttBvh::build(mesh, &stats);
+    REQUIRE(stats.ranges == 2);
+    REQUIRE(stats.triangles == gridIndices / 3 + 1);
+    REQUIRE(bvh.rangeOf[0] == bvh.rangeOf[2]);
+    REQUIRE(bvh.rangeOf[4] == OttBvh::NONE);
+
+    // Straight down from above: the small triangle, then the raised grid.
+    const glm::vec3 down(0.0f, 0.0f, -1.0f);
+    OttBvh::Hit hit = OttBvh::raycast(bvh, mesh, glm::vec3(0.5f, 0.45f, 10.0f), down);
+    REQUIRE(hit.object == 3);
+    REQUIRE(std::abs(hit.distance - 7.0f) < 1e-5f);
+    hit = OttBvh::raycast(bvh, mesh, glm::vec3(0.9f, 0.9f, 10.0f), down);
+    REQUIRE(hit.object == 1);
+    REQUIRE(std::abs(hit.distance - 8.0f) < 1e-5f);
+
+    // The turned copy covers x from -0.5 to 0.5 at z = 1.
+    hit = OttBvh::raycast(bvh, mesh, glm::vec3(-0.25f, 0.5f, 1.5f), down);
+    REQUIRE(hit.object == 2);
+    REQUIRE(std::abs(hit.distance - 0.5f) < 1e-5f);
+    hit = OttBvh::raycast(bvh, mesh, glm::vec3(-0.25f, 0.5f, 1.5f), down, 0.25f);
+    REQUIRE(hit.object == OttBvh::NONE);
+    hit = OttBvh::raycast(bvh, mesh, glm::vec3(5.0f, 5.0f, 10.0f), down);
+    REQUIRE(hit.object == OttBvh::NONE);
+
+    // The hit triangle is under the ray, and no triangle of any object is nearer.
+    std::mt19937 random(12);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int r = 0; r < 100; r++)
+    {
+        const glm::vec3 origin(unit(random) * 1.4f - 0.5f, unit(random), 5.0f);
+        const glm::vec3 direction(unit(random) * 0.2f - 0.1f, unit(random) * 0.2f - 0.1f, -1.0f);
+        hit = OttBvh::raycast(bvh, mesh, origin, direction);
+        float nearest = std::numeric_limits<float>::infinity();
+        for (const OttModel::modelObject& object : mesh.objects)
+        {
+            for (uint32_t c = 0; c + 2 < object.indexCount; c += 3)
+            {
+                auto corner = [&](const uint32_t k)
+                {
+                    const uint32_t index = object.shortIndices ? mesh.shortIndices[object.startIndex + c + k] : mesh.indices[object.startIndex + c + k];
+                    return glm::vec3(object.transform * glm::vec4(mesh.vertices[object.startVertex + index].pos, 1.0f));
+                };
+                nearest = std::min(nearest, OttBvh::intersectTriangle(origin, direction, corner(0), corner(1), corner(2)));
+            }
+        }
+        REQUIRE((hit.distance == nearest || std::abs(hit.distance - nearest) < 1e-4f));
+    }
+
+    // The first quad of the grid alone is a range of its own.
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = 0, .indexCount = 6 });
+    const OttBvh::SceneBvh partial = OttBvh::build(mesh, &stats);
+    REQUIRE(stats.ranges == 3);
+    REQUIRE(partial.ranges[partial.rangeOf[5]].itemCount() == 2);
+    REQUIRE(partial.rangeOf[0] != partial.rangeOf[5]);
+}
+
+TEST_CASE("Rays pick the object they hit after instancing and the 16-bit split", "[bvh]")
+{
+    // Five cubes in a row, each its own range until instancing folds them onto one.
+    OttModel::MeshData mesh;
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        const auto startVertex = static_cast<uint32_t>(mesh.vertices.size());
+        const auto startIndex  = static_cast<uint32_t>(mesh.indices.size());
+        OttTest::unitCube(true, mesh.vertices, mesh.indices);
+        for (size_t v = startVertex; v < mesh.vertices.size(); v++)
+            mesh.vertices[v].pos.x += 3.0f * float(i);
+        mesh.objects.push_back({ .startIndex = startIndex, .startVertex = startVertex,
+                                 .indexCount = static_cast<uint32_t>(mesh.indices.size()) - startIndex });
+    }
+    REQUIRE(OttInstancing::instance(mesh).prototypes == 1);
+    mesh.bvh = OttBvh::build(mesh);
+    OttModel::splitShortIndices(mesh);
+    REQUIRE(mesh.objects[4].shortIndices);
+
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        const OttBvh::Hit hit = OttBvh::raycast(mesh.bvh, mesh, glm::vec3(3.0f * float(i) + 0.5f, 0.25f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        REQUIRE(hit.object == i);
+        REQUIRE(std::abs(hit.distance - 4.0f) < 1e-4f);
+    }
+    REQUIRE(OttBvh::raycast(mesh.bvh, mesh, glm::vec3(2.0f, 0.25f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f)).object == OttBvh::NONE);
+}
+
+TEST_CASE("loadMesh builds the BVH on load and from the cache", "[bvh]")
+{
+    const auto path = OttTest::writeTempFile("bvh_cube.obj", OttTest::UNIT_CUBE_OBJ);
+    const OttLoader::LoadOptions options { .bvh = true };
+    REQUIRE(options.fingerprint() == OttLoader::LoadOptions{}.fingerprint());
+    std::filesystem::remove(OttMeshCache::cachePathFor(path, options.fingerprint()));
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        OttModel::MeshData mesh;
+        REQUIRE(OttLoader::loadMesh(path, mesh, options));
+        REQUIRE(mesh.bvh.rangeOf.size() == mesh.objects.size());
+        // The application moves small ranges to 16-bit indices after loading.
+        OttModel::splitShortIndices(mesh);
+        REQUIRE(mesh.objects[0].shortIndices);
+        const OttBvh::Hit hit = OttBvh::raycast(mesh.bvh, mesh, glm::vec3(0.5f, 0.25f, 5.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+        REQUIRE(hit.object == 0);
+        REQUIRE(std::abs(hit.distance - 4.0f) < 1e-5f);
+    }
+
+    OttModel::MeshData plain;
+    REQUIRE(OttLoader::loadMesh(path, plain));
+    REQUIRE(plain.bvh.objects.empty());
+}
+
+TEST_CASE("LBVH build throughput", "[.][benchmark]")
+{
+    // Two million triangles in one range, and a hundred thousand instances of a small one.
+    OttModel::MeshData mesh;
+    OttTest::grid(1000, mesh.vertices, mesh.indices, 1.0f / 1000.0f);
+    const auto gridIndices = static_cast<uint32_t>(mesh.indices.size());
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = 0, .indexCount = gridIndices });
+    const auto quadVertex = static_cast<uint32_t>(mesh.vertices.size());
+    OttTest::grid(1, mesh.vertices, mesh.indices);
+    for (uint32_t i = 0; i < 100'000; i++)
+    {
+        OttModel::modelObject copy { .startIndex = gridIndices, .startVertex = quadVertex, .indexCount = 6 };
+        copy.transform[3] = glm::vec4(float(i % 300), float(i / 300), 1.0f, 1.0f);
+        mesh.objects.push_back(copy);
+    }
+
+    OttBvh::BvhStats stats;
+    const OttBvh::SceneBvh bvh = OttBvh::build(mesh, &stats);
+    WARN(stats.triangles << " triangles in " << stats.ranges << " ranges, " << stats.objects << " objects: " << stats.nodes
+         << " nodes, " << static_cast<double>(stats.bytes) / (1024.0 * 1024.0) << " MB in " << stats.seconds << "s");
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    size_t hits = 0;
+    constexpr int RAYS = 100'000;
+    for (int r = 0; r < RAYS; r++)
+    {
+        const glm::vec3 origin(unit(random) * 300.0f, unit(random) * 340.0f, 10.0f);
+        hits += OttBvh::raycast(bvh, mesh, origin, glm::vec3(0.0f, 0.0f, -1.0f)).object != OttBvh::NONE;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+    WARN(RAYS << " rays, " << hits << " hits, in " << seconds << "s");
+}
@@ -0,0 +1,170 @@
+#include <cleanup.h>
+#include <loader.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+TEST_CASE("Cleanup removes collapsed, zero-area and duplicate triangles", "[cleanup]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::grid(2, vertices, indices);
+    const std::vector<OttModel::Vertex> original = vertices;
+    const std::vector<uint32_t> originalIndices = indices;
+
+    // The corner 0 again with another UV, a point on the first edge and one nobody uses.
+    vertices.push_back({ .pos = glm::vec3(0.0f), .texCoord = glm::vec2(0.5f) });
+    vertices.push_back({ .pos = glm::vec3(0.5f, 0.0f, 0.0f) });
+    vertices.push_back({ .pos = glm::vec3(7.0f) });
+    indices.insert(indices.end(), {
+        0, 0, 4,      // collapsed by index
+        9, 0, 1,      // collapsed by position
+        0, 10, 1,     // on a line
+        9, 1, 4,      // the first triangle through the other corner 0
+        1, 4, 0,      // the first triangle, rotated
+        0, 4, 1,      // the first triangle, reversed
+    });
+
+    const OttCleanup::CleanupStats stats = OttCleanup::cleanup(vertices, indices);
+    REQUIRE(stats.triangles == 14);
+    REQUIRE(stats.collapsedTriangles == 2);
+    REQUIRE(stats.zeroAreaTriangles == 1);
+    REQUIRE(stats.duplicateTriangles == 3);
+    REQUIRE(stats.reversedDuplicates == 1);
+    REQUIRE(stats.removedTriangles() == 6);
+    REQUIRE(stats.unreferencedVertices == 3);
+
+    // The grid is left as it was.
+    REQUIRE(vertices.size() == original.size());
+    REQUIRE(indices == originalIndices);
+
+    // Nothing to remove leaves the mesh alone.
+    const OttCleanup::CleanupStats clean = OttCleanup::cleanup(vertices, indices);
+    REQUIRE(clean.removedTriangles() == 0);
+    REQUIRE(clean.unreferencedVertices == 0);
+    REQUIRE(indices == originalIndices);
+}
+
+TEST_CASE("Cleanup options keep what they exclude", "[cleanup]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::grid(1, vertices, indices);
+    vertices.push_back({ .pos = glm::vec3(5.0f) });
+    // A sliver 1e-4 high over its 1 long base, and a reversed duplicate.
+    vertices.push_back({ .pos = glm::vec3(0.5f, 1e-4f, 0.0f) });
+    indices.insert(indices.end(), { 0, 1, 5, 0, 3, 1 });
+
+    std::vector<OttModel::Vertex> keptVertices = vertices;
+    std::vector<uint32_t> keptIndices = indices;
+    const OttCleanup::CleanupStats stats = OttCleanup::cleanup(keptVertices, keptIndices,
+                                                               { .areaRatio = 1e-5f, .duplicates = false, .unreferenced = false });
+    REQUIRE(stats.removedTriangles() == 0);
+    REQUIRE(keptIndices == indices);
+    REQUIRE(keptVertices.size() == vertices.size());
+
+    const OttCleanup::CleanupStats slivers = OttCleanup::cleanup(vertices, indices, { .areaRatio = 1e-4f });
+    REQUIRE(slivers.zeroAreaTriangles == 1);
+    REQUIRE(slivers.duplicateTriangles == 1);
+    REQUIRE(slivers.unreferencedVertices == 2);
+    REQUIRE(indices.size() == 6);
+}
+
+TEST_CASE("Cleanup works per range and keeps instances", "[cleanup]")
+{
+    OttModel::MeshData mesh;
+    OttTest::grid(1, mesh.vertices, mesh.indices);
+    // A second object over the same square, with its own vertices and a duplicate face.
+    std::vector<uint32_t> second;
+    OttTest::grid(1, mesh.vertices, second);
+    second.insert(second.end(), { 3, 1, 0 });
+    // An unused vertex between the ranges.
+    mesh.vertices.insert(mesh.vertices.begin() + 4, { .pos = glm::vec3(9.0f) });
+    mesh.indices.insert(mesh.indices.end(), second.begin(), second.end());
+
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = 0, .indexCount = 6 });
+    mesh.objects.push_back({ .startIndex = 6, .startVertex = 5, .indexCount = 9 });
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = 0, .indexCount = 6 });
+    const OttModel::MeshData original = mesh;
+
+    const OttCleanup::CleanupStats stats = OttCleanup::cleanup(mesh);
+    REQUIRE(stats.triangles == 5);
+    REQUIRE(stats.duplicateTriangles == 1);
+    REQUIRE(stats.unreferencedVertices == 1);
+    REQUIRE(mesh.vertices.size() == 8);
+    REQUIRE(mesh.indices.size() == 12);
+
+    // Coincident faces of different objects both stay, and instances still share their range.
+    REQUIRE(mesh.objects[0].indexCount == 6);
+    REQUIRE(mesh.objects[1].indexCount == 6);
+    REQUIRE(mesh.objects[1].startVertex == 4);
+    REQUIRE(mesh.objects[2].startIndex == mesh.objects[0].startIndex);
+    for (size_t o = 0; o < mesh.objects.size(); o++)
+    {
+        const OttModel::modelObject& before = original.objects[o];
+        const OttModel::modelObject& after  = mesh.objects[o];
+        for (uint32_t i = 0; i < after.indexCount; i++)
+            REQUIRE(mesh.vertices[after.startVertex + mesh.indices[after.startIndex + i]].pos ==
+                    original.vertices[before.startVertex + original.indices[before.startIndex + i]].pos);
+    }
+}
+
+TEST_CASE("Parallel cleanup matches a sequential reference", "[cleanup]")
+{
+    // Enough triangles for several chunks, shuffled with copies in both windings.
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::grid(160, vertices, indices);
+    std::mt19937 random(5);
+    const size_t triangles = indices.size() / 3;
+    std::uniform_int_distribution<size_t> pick(0, triangles - 1);
+    for (size_t copy = 0; copy < triangles / 2; copy++)
+    {
+        const size_t t = pick(random);
+        const uint32_t a = indices[3 * t], b = indices[3 * t + 1], c = indices[3 * t + 2];
+        if (copy % 2)
+            indices.insert(indices.end(), { c, b, a });
+        else
+            indices.insert(indices.end(), { b, c, a });
+    }
+
+    // The first triangle over each set of corners stays.
+    std::map<std::array<uint32_t, 3>, size_t> first;
+    std::vector<uint32_t> expected;
+    for (size_t t = 0; t < indices.size() / 3; t++)
+    {
+        std::array<uint32_t, 3> key { indices[3 * t], indices[3 * t + 1], indices[3 * t + 2] };
+        std::ranges::sort(key);
+        if (first.try_emplace(key, t).second)
+            expected.insert(expected.end(), indices.begin() + 3 * t, indices.begin() + 3 * t + 3);
+    }
+
+    const size_t before = indices.size() / 3;
+    const OttCleanup::CleanupStats stats = OttCleanup::cleanup(vertices, indices);
+    REQUIRE(stats.duplicateTriangles == before - expected.size() / 3);
+    REQUIRE(indices == expected);
+}
+
+TEST_CASE("loadObj cleans up before extracting edges", "[cleanup]")
+{
+    // The quad, its back face and a triangle along its bottom edge.
+    const auto path = OttTest::writeTempFile("cleanup_quad.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 2 2 2\n"
+                                                                 "f 1 2 3 4\nf 3 2 1 4\nf 1 2 2\n");
+
+    OttModel::MeshData plain, cleaned;
+    REQUIRE(OttLoader::loadObj(path, plain));
+    REQUIRE(OttLoader::loadObj(path, cleaned, { .cleanup = OttCleanup::CleanupOptions{} }));
+    REQUIRE(plain.indices.size() > cleaned.indices.size());
+    REQUIRE(cleaned.indices.size() == 6);
+    REQUIRE(cleaned.objects[0].indexCount == 6);
+    // The back face no longer hides the quad's outline.
+    REQUIRE(cleaned.edges.size() == 8);
+    REQUIRE(OttLoader::LoadOptions{ .cleanup = OttCleanup::CleanupOptions{} }.fingerprint() != OttLoader::LoadOptions{}.fingerprint());
+}
@@ -0,0 +1,287 @@
+#include <edges.h>
+#include <loader.h>
+#include <model.h>
+
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    // The std::map counting OttModel::extractBoundaryEdges replaced, kept as the reference output.
+    std::vector<uint32_t> referenceBoundaryEdges(const std::vector<uint32_t>& indices)
+    {
+        std::map<std::pair<uint32_t, uint32_t>, int> edgeCount;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            edgeCount[std::minmax(indices[i], indices[i + 1])]++;
+            edgeCount[std::minmax(indices[i + 1], indices[i + 2])]++;
+            edgeCount[std::minmax(indices[i + 2], indices[i])]++;
+        }
+        std::vector<uint32_t> edges;
+        for (const auto& [edge, count] : edgeCount)
+        {
+            if (count == 1)
+                edges.insert(edges.end(), { edge.first, edge.second });
+        }
+        return edges;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Two triangles per cell, alternating diagonals, over a (cells + 1)^2 vertex grid. **/
+    std::vector<uint32_t> gridIndices(const uint32_t cells_per_side)
+    {
+        std::vector<uint32_t> indices;
+        indices.reserve(size_t(cells_per_side) * cells_per_side * 6);
+        const uint32_t row = cells_per_side + 1;
+        for (uint32_t y = 0; y < cells_per_side; y++)
+        {
+            for (uint32_t x = 0; x < cells_per_side; x++)
+            {
+                const uint32_t a = y * row + x, b = a + 1, c = a + row, d = c + 1;
+                if ((x + y) % 2 == 0)
+                    indices.insert(indices.end(), { a, b, d,  a, d, c });
+                else
+                    indices.insert(indices.end(), { a, b, c,  b, d, c });
+            }
+        }
+        return indices;
+    }
+
+    std::vector<uint32_t> randomIndices(const size_t triangles, const uint32_t vertices, const uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<uint32_t> vertex(0, vertices - 1);
+        std::vector<uint32_t> indices(triangles * 3);
+        for (uint32_t& index : indices)
+            index = vertex(rng);
+        return indices;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Straightforward crease extraction over std::map, the reference for the sorted kernel.
+     *  Returns the edges as a set of position pairs, which is what the drawing shows. **/
+    using PositionEdge = std::pair<std::array<float, 3>, std::array<float, 3>>;
+    std::set<PositionEdge> referenceCreases(const std::vector<OttModel::Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                            const float angle_degrees)
+    {
+        auto key = [&vertices](const uint32_t v) { const glm::vec3 p = vertices[v].pos; return std::array<float, 3>{ p.x, p.y, p.z }; };
+        std::map<PositionEdge, std::vector<glm::vec3>> faces;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec3 n = glm::cross(vertices[indices[i + 1]].pos - vertices[indices[i]].pos,
+                                           vertices[indices[i + 2]].pos - vertices[indices[i]].pos);
+            if (!(glm::length(n) > 0.0f))
+                continue;
+            for (size_t k = 0; k < 3; k++)
+                faces[std::minmax(key(indices[i + k]), key(indices[i + (k + 1) % 3]))].push_back(glm::normalize(n));
+        }
+        std::set<PositionEdge> edges;
+        for (const auto& [edge, normals] : faces)
+        {
+            if (normals.size() != 2 || glm::dot(normals[0], normals[1]) < std::cos(angle_degrees * 3.14159265f / 180.0f))
+                edges.insert(edge);
+        }
+        return edges;
+    }
+
+    std::set<PositionEdge> positionEdges(const std::vector<OttModel::Vertex>& vertices, const std::vector<uint32_t>& edges)
+    {
+        std::set<PositionEdge> result;
+        for (size_t i = 0; i + 1 < edges.size(); i += 2)
+        {
+            const glm::vec3 a = vertices[edges[i]].pos, b = vertices[edges[i + 1]].pos;
+            result.insert(std::minmax(std::array<float, 3>{ a.x, a.y, a.z }, std::array<float, 3>{ b.x, b.y, b.z }));
+        }
+        return result;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Grid vertices for gridIndices, with random heights so neighbouring faces fold at
+     *  angles around any threshold. **/
+    std::vector<OttModel::Vertex> gridVertices(const uint32_t cells_per_side, const float roughness)
+    {
+        std::mt19937 rng(cells_per_side);
+        std::uniform_real_distribution<float> height(0.0f, roughness);
+        std::vector<OttModel::Vertex> vertices;
+        for (uint32_t y = 0; y <= cells_per_side; y++)
+        {
+            for (uint32_t x = 0; x <= cells_per_side; x++)
+                vertices.push_back({ .pos = glm::vec3(float(x), float(y), height(rng)) });
+        }
+        return vertices;
+    }
+} // anonymous namespace
+
+TEST_CASE("Boundary edges of a grid are its outline", "[edges]")
+{
+    for (const uint32_t cells : { 1u, 7u, 300u })
+    {
+        const std::vector<uint32_t> indices = gridIndices(cells);
+        const std::vector<uint32_t> edges = OttModel::extractBoundaryEdges(indices);
+        REQUIRE(edges.size() == 2 * 4 * size_t(cells));
+        REQUIRE(edges == referenceBoundaryEdges(indices));
+    }
+}
+
+TEST_CASE("Boundary edges match the std::map reference", "[edges]")
+{
+    // Small vertex counts produce shared, non-manifold and degenerate edges; the larger
+    // triangle counts go through the parallel radix sort.
+    for (const size_t triangles : { size_t(1), size_t(1000), size_t(70000), size_t(200000) })
+    {
+        for (const uint32_t vertices : { 4u, 600u, 1u << 20 })
+        {
+            const std::vector<uint32_t> indices = randomIndices(triangles, vertices, static_cast<uint32_t>(triangles + vertices));
+            REQUIRE(OttModel::extractBoundaryEdges(indices) == referenceBoundaryEdges(indices));
+        }
+    }
+}
+
+TEST_CASE("Boundary edges handle the full index range", "[edges]")
+{
+    std::vector<uint32_t> indices = randomIndices(100000, 50, 3);
+    for (uint32_t& index : indices)
+        index = UINT32_MAX - index;
+    REQUIRE(OttModel::extractBoundaryEdges(indices) == referenceBoundaryEdges(indices));
+
+    REQUIRE(OttModel::extractBoundaryEdges(std::vector<uint32_t>{}).empty());
+    REQUIRE(OttModel::extractBoundaryEdges(std::vector<uint32_t>{ 0, 1 }).empty());
+}
+
+TEST_CASE("Boundary edges of a range ignore the rest of the buffer", "[edges]")
+{
+    std::vector<uint32_t> indices = gridIndices(4);
+    const size_t firstModel = indices.size();
+    const std::vector<uint32_t> second = gridIndices(9);
+    indices.insert(indices.end(), second.begin(), second.end());
+
+    REQUIRE(OttModel::extractBoundaryEdges(std::span(indices).subspan(firstModel)) == referenceBoundaryEdges(second));
+}
+
+TEST_CASE("Crease edges of a cube are its twelve edges", "[edges]")
+{
+    for (const bool split : { false, true })
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        OttTest::unitCube(split, vertices, indices);
+
+        // Shared corners leave no boundary at all, split ones leave every face outline.
+        REQUIRE(OttModel::extractBoundaryEdges(indices).size() == (split ? 2 * 24 : 0));
+
+        const std::vector<uint32_t> edges = OttEdges::extractCreaseEdges(vertices, indices);
+        REQUIRE(edges.size() == 2 * 12);
+        REQUIRE(positionEdges(vertices, edges) == referenceCreases(vertices, indices, 30.0f));
+        for (size_t i = 0; i < edges.size(); i += 2)
+            REQUIRE(glm::length(vertices[edges[i]].pos - vertices[edges[i + 1]].pos) == 1.0f);
+    }
+}
+
+TEST_CASE("Crease edges follow the angle threshold", "[edges]")
+{
+    // A 32 sided prism: side faces meet at 11.25 degrees, the caps at 90.
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    const uint32_t sides = 32;
+    for (uint32_t s = 0; s < sides; s++)
+    {
+        const float angle = 2.0f * 3.14159265f * float(s) / float(sides);
+        vertices.push_back({ .pos = glm::vec3(std::cos(angle), std::sin(angle), 0.0f) });
+        vertices.push_back({ .pos = glm::vec3(std::cos(angle), std::sin(angle), 1.0f) });
+    }
+    for (uint32_t s = 0; s < sides; s++)
+    {
+        const uint32_t a = 2 * s, b = 2 * ((s + 1) % sides);
+        indices.insert(indices.end(), { a, b, b + 1,  a, b + 1, a + 1 });
+        if (s > 0 && s + 1 < sides)
+            indices.insert(indices.end(), { 0, b, a,  1, a + 1, b + 1 });
+    }
+
+    REQUIRE(OttEdges::extractCreaseEdges(vertices, indices, { .angleDegrees = 30.0f }).size() == 2 * 2 * sides);
+    REQUIRE(OttEdges::extractCreaseEdges(vertices, indices, { .angleDegrees = 5.0f }).size() == 2 * 3 * sides);
+}
+
+TEST_CASE("Crease edges suppress or keep coplanar seams", "[edges]")
+{
+    // A flat grid whose right half has its own vertices along the middle column, like a UV seam.
+    const uint32_t cells = 4;
+    std::vector<OttModel::Vertex> vertices = gridVertices(cells, 0.0f);
+    std::vector<uint32_t> indices = gridIndices(cells);
+    const uint32_t row = cells + 1;
+    std::map<uint32_t, uint32_t> copies;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const bool rightHalf = indices[i] % row >= cells / 2 && indices[i + 1] % row >= cells / 2 && indices[i + 2] % row >= cells / 2;
+        for (size_t k = 0; rightHalf && k < 3; k++)
+        {
+            if (indices[i + k] % row != cells / 2)
+                continue;
+            auto [copy, inserted] = copies.try_emplace(indices[i + k], static_cast<uint32_t>(vertices.size()));
+            if (inserted)
+                vertices.push_back(vertices[indices[i + k]]);
+            indices[i + k] = copy->second;
+        }
+    }
+
+    REQUIRE(OttEdges::extractCreaseEdges(vertices, indices).size() == 2 * 4 * cells);
+    REQUIRE(OttEdges::extractCreaseEdges(vertices, indices, { .boundaries = false }).empty());
+    REQUIRE(OttEdges::extractCreaseEdges(vertices, indices, { .boundaries = false, .suppressSeams = false }).size() == 2 * cells);
+}
+
+TEST_CASE("Crease edges match the std::map reference", "[edges]")
+{
+    for (const uint32_t cells : { 3u, 40u, 250u })
+    {
+        const std::vector<OttModel::Vertex> vertices = gridVertices(cells, 0.8f);
+        std::vector<uint32_t> indices = gridIndices(cells);
+        // A collapsed triangle takes no part.
+        indices.insert(indices.end(), { 0, 0, 1 });
+
+        const std::vector<uint32_t> edges = OttEdges::extractCreaseEdges(vertices, indices, { .angleDegrees = 20.0f });
+        REQUIRE(positionEdges(vertices, edges).size() * 2 == edges.size());
+        REQUIRE(positionEdges(vertices, edges) == referenceCreases(vertices, indices, 20.0f));
+    }
+}
+
+TEST_CASE("loadObj extracts crease edges when asked", "[edges]")
+{
+    const auto path = OttTest::writeTempFile("cube.obj", OttTest::UNIT_CUBE_OBJ);
+
+    OttModel::MeshData boundary, creases;
+    REQUIRE(OttLoader::loadObj(path, boundary));
+    REQUIRE(OttLoader::loadObj(path, creases, { .creases = OttEdges::CreaseOptions{} }));
+    REQUIRE(boundary.edges.empty());
+    REQUIRE(creases.edges.size() == 2 * 12);
+    REQUIRE(creases.objects[0].edgeCount == 2 * 12);
+}
+
+TEST_CASE("OttModel::extractBoundaryEdges throughput", "[.][benchmark]")
+{
+    auto measure = [](const std::string& name, const std::vector<uint32_t>& indices)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        const std::vector<uint32_t> edges = OttModel::extractBoundaryEdges(indices);
+        const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        const std::vector<uint32_t> reference = referenceBoundaryEdges(indices);
+        const double referenceSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        REQUIRE(edges == reference);
+
+        const double triangleEdges = static_cast<double>(indices.size());
+        WARN(name << ": " << indices.size() / 3 << " triangles, " << edges.size() / 2 << " boundary edges, radix "
+             << triangleEdges / seconds / 1e6 << " M edges/s, std::map " << triangleEdges / referenceSeconds / 1e6 << " M edges/s");
+    };
+
+    measure("grid 1M triangles", gridIndices(708));
+    measure("grid 4M triangles", gridIndices(1415));
+    measure("random 1M triangles", randomIndices(1000000, 500000, 11));
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <model.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Fixtures shared by the test files.
+namespace OttTest
+{
+    //----------------------------------------------------------------------------
+    /** Writes contents to name in an ottocento-test directory under the system temp path. **/
+    inline std::filesystem::path writeTempFile(const std::string& name, const std::string& contents)
+    {
+        const auto dir = std::filesystem::temp_directory_path() / "ottocento-test";
+        std::filesystem::create_directories(dir);
+        const auto path = dir / name;
+        std::ofstream(path, std::ios::binary) << contents;
+        return path;
+    }
+
+    // The unit cube of unitCube(false, ...) as an OBJ file of quads.
+    inline const std::string UNIT_CUBE_OBJ = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nv 0 0 1\nv 1 0 1\nv 0 1 1\nv 1 1 1\n"
+                                             "f 1 3 4 2\nf 5 6 8 7\nf 1 2 6 5\nf 3 7 8 4\nf 1 5 7 3\nf 2 4 8 6\n";
+
+    //----------------------------------------------------------------------------
+    /** Appends a grid of size x size square cells in the xy plane, two triangles each, from
+     *  the origin to size * cell. Indices count from the first vertex appended. **/
+    inline void grid(const uint32_t size, std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                     const float cell = 1.0f)
+    {
+        for (uint32_t y = 0; y <= size; y++)
+        {
+            for (uint32_t x = 0; x <= size; x++)
+                vertices.push_back({ .pos = glm::vec3(float(x) * cell, float(y) * cell, 0.0f) });
+        }
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const uint32_t a = y * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+                indices.insert(indices.end(), { a, b, d, a, d, c });
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Appends the unit cube, either with 8 shared corners or with 4 corners per face as
+     *  flat shaded exports write it, every quad split in two and wound counter-clockwise
+     *  seen from outside. Indices count from the first vertex appended. **/
+    inline void unitCube(const bool split_faces, std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        const uint32_t faces[6][4] = {
+            { 0, 2, 3, 1 }, { 4, 5, 7, 6 }, { 0, 1, 5, 4 }, { 2, 6, 7, 3 }, { 0, 4, 6, 2 }, { 1, 3, 7, 5 },
+        };
+        auto corner = [](const uint32_t c) { return glm::vec3(float(c & 1), float((c >> 1) & 1), float((c >> 2) & 1)); };
+        const auto base = static_cast<uint32_t>(vertices.size());
+        if (!split_faces)
+        {
+            for (uint32_t c = 0; c < 8; c++)
+                vertices.push_back({ .pos = corner(c) });
+        }
+        for (const auto& face : faces)
+        {
+            uint32_t quad[4];
+            for (int k = 0; k < 4; k++)
+            {
+                quad[k] = face[k];
+                if (split_faces)
+                {
+                    quad[k] = static_cast<uint32_t>(vertices.size()) - base;
+                    vertices.push_back({ .pos = corner(face[k]) });
+                }
+            }
+            indices.insert(indices.end(), { quad[0], quad[1], quad[2],  quad[0], quad[2], quad[3] });
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Appends the cube from -1 to 1 with each face split into cells^2 quads with vertices
+     *  and normals of its own, wound counter-clockwise seen from outside. Faces listed in
+     *  skip are left out. Indices count from the first vertex appended. **/
+    inline void tessellatedCube(const uint32_t cells, std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices,
+                                const std::vector<int>& skip = {})
+    {
+        // Normal and in-plane axes u, v of every face, with cross(u, v) == normal.
+        const glm::vec3 x(1.0f, 0.0f, 0.0f), y(0.0f, 1.0f, 0.0f), z(0.0f, 0.0f, 1.0f);
+        const std::array<std::array<glm::vec3, 3>, 6> faces {{
+            { x, y, z }, { -x, z, y }, { y, z, x }, { -y, x, z }, { z, x, y }, { -z, y, x },
+        }};
+        const uint32_t row = cells + 1;
+        const auto first = static_cast<uint32_t>(vertices.size());
+        for (int face = 0; face < 6; face++)
+        {
+            if (std::ranges::find(skip, face) != skip.end())
+                continue;
+            const auto& [normal, u, v] = faces[face];
+            const uint32_t base = static_cast<uint32_t>(vertices.size()) - first;
+            for (uint32_t j = 0; j <= cells; j++)
+            {
+                for (uint32_t i = 0; i <= cells; i++)
+                {
+                    const float s = 2.0f * float(i) / float(cells) - 1.0f;
+                    const float t = 2.0f * float(j) / float(cells) - 1.0f;
+                    vertices.push_back({ .pos = normal + u * s + v * t, .normal = normal });
+                }
+            }
+            for (uint32_t j = 0; j < cells; j++)
+            {
+                for (uint32_t i = 0; i < cells; i++)
+                {
+                    const uint32_t a = base + j * row + i, b = a + 1, c = a + row, d = c + 1;
+                    indices.insert(indices.end(), { a, b, d, a, d, c });
+                }
+            }
+        }
+    }
+} // namespace OttTest
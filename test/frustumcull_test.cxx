@@ -0,0 +1,137 @@
+#include <clustercull.h>
+#include <frustumcull.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // The identity view projection sees x and y from -1 to 1, z from 0 to 1.
+    const std::array<glm::vec4, 6> UNIT_PLANES = OttClusterCuller::frustumPlanes(glm::mat4(1.0f));
+
+    //----------------------------------------------------------------------------
+    std::vector<OttFrustumCuller::Instance> randomInstances(const size_t count, const uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> coordinate(-3.0f, 3.0f), size(0.01f, 0.5f), angle(0.0f, 6.2831853f);
+        std::vector<OttFrustumCuller::Instance> instances(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::vec3 low(coordinate(random), coordinate(random), coordinate(random));
+            const float turn = angle(random);
+            glm::mat4 transform(1.0f);
+            transform[0] = glm::vec4(std::cos(turn), std::sin(turn), 0.0f, 0.0f);
+            transform[1] = glm::vec4(-std::sin(turn), std::cos(turn), 0.0f, 0.0f);
+            transform[3] = glm::vec4(coordinate(random), 0.0f, 0.0f, 1.0f);
+            instances[i] = { .low = low, .high = low + glm::vec3(size(random), size(random), size(random)),
+                             .transform = transform, .batch = static_cast<uint32_t>(i / 3) };
+        }
+        return instances;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Smallest over the planes of the largest distance of a corner of the instance's world
+     *  space box, positive when the box touches the frustum. **/
+    float referenceDistance(const OttFrustumCuller::Instance& instance, const std::array<glm::vec4, 6>& planes)
+    {
+        glm::vec3 low(std::numeric_limits<float>::max()), high(std::numeric_limits<float>::lowest());
+        for (int c = 0; c < 8; c++)
+        {
+            const glm::vec3 corner((c & 1) ? instance.high.x : instance.low.x, (c & 2) ? instance.high.y : instance.low.y,
+                                   (c & 4) ? instance.high.z : instance.low.z);
+            const glm::vec3 moved = glm::vec3(instance.transform * glm::vec4(corner, 1.0f));
+            low  = glm::min(low, moved);
+            high = glm::max(high, moved);
+        }
+        float nearest = std::numeric_limits<float>::max();
+        for (const glm::vec4& plane : planes)
+        {
+            float furthest = std::numeric_limits<float>::lowest();
+            for (int c = 0; c < 8; c++)
+            {
+                const glm::vec3 corner((c & 1) ? high.x : low.x, (c & 2) ? high.y : low.y, (c & 4) ? high.z : low.z);
+                furthest = std::max(furthest, glm::dot(glm::vec3(plane), corner) + plane.w);
+            }
+            nearest = std::min(nearest, furthest);
+        }
+        return nearest;
+    }
+
+    std::vector<uint8_t> visibility(const OttFrustumCuller& culler)
+    {
+        std::vector<uint8_t> seen(culler.totalCount(), 0);
+        for (const OttFrustumCuller::Run& run : culler.visibleRuns())
+            std::fill_n(seen.begin() + run.firstInstance, run.instanceCount, uint8_t(1));
+        return seen;
+    }
+} // anonymous namespace
+
+TEST_CASE("Frustum culling keeps the boxes touching the frustum", "[frustumcull]")
+{
+    const std::vector<OttFrustumCuller::Instance> instances = randomInstances(1001, 5);
+    OttFrustumCuller culler;
+    culler.setInstances(instances);
+    REQUIRE(culler.totalCount() == instances.size());
+
+    culler.cull(UNIT_PLANES, OttModel::SimdPath::Scalar);
+    const std::vector<uint8_t> scalar = visibility(culler);
+    size_t checked = 0;
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        const float distance = referenceDistance(instances[i], UNIT_PLANES);
+        if (std::abs(distance) < 1e-4f)
+            continue;
+        REQUIRE(scalar[i] == (distance > 0.0f));
+        checked++;
+    }
+    REQUIRE(checked > 990);
+    REQUIRE(culler.visibleCount() == static_cast<size_t>(std::ranges::count(scalar, 1)));
+    REQUIRE(culler.visibleCount() > 0);
+    REQUIRE(culler.visibleCount() < instances.size());
+
+    // Every path gives the same instances.
+    for (int level = 0; level <= static_cast<int>(OttModel::simdPath()); level++)
+    {
+        culler.cull(UNIT_PLANES, static_cast<OttModel::SimdPath>(level));
+        REQUIRE(visibility(culler) == scalar);
+    }
+}
+
+TEST_CASE("Visible instances come out as runs per batch", "[frustumcull]")
+{
+    auto at = [](const float x, const uint32_t batch)
+    {
+        glm::mat4 transform(1.0f);
+        transform[3] = glm::vec4(x, 0.0f, 0.5f, 1.0f);
+        return OttFrustumCuller::Instance { .low = glm::vec3(-0.1f), .high = glm::vec3(0.1f), .transform = transform, .batch = batch };
+    };
+    // Batch 0: in, in, out, in; batch 1: in, in; batch 2 has no vertices.
+    std::vector<OttFrustumCuller::Instance> instances { at(0.0f, 0), at(0.5f, 0), at(5.0f, 0), at(-0.5f, 0), at(0.2f, 1), at(0.3f, 1) };
+    instances.push_back({ .low = glm::vec3(1.0f), .high = glm::vec3(-1.0f), .transform = glm::mat4(1.0f), .batch = 2 });
+
+    OttFrustumCuller culler;
+    culler.setInstances(instances);
+    REQUIRE(culler.visibleRuns().empty());
+    for (int level = 0; level <= static_cast<int>(OttModel::simdPath()); level++)
+    {
+        const std::span<const OttFrustumCuller::Run> runs = culler.cull(UNIT_PLANES, static_cast<OttModel::SimdPath>(level));
+        REQUIRE(runs.size() == 3);
+        REQUIRE((runs[0].batch == 0 && runs[0].firstInstance == 0 && runs[0].instanceCount == 2));
+        REQUIRE((runs[1].batch == 0 && runs[1].firstInstance == 3 && runs[1].instanceCount == 1));
+        REQUIRE((runs[2].batch == 1 && runs[2].firstInstance == 4 && runs[2].instanceCount == 2));
+        REQUIRE(culler.visibleCount() == 5);
+        REQUIRE(culler.totalCount() == 7);
+    }
+
+    // Behind the near plane nothing is left.
+    for (OttFrustumCuller::Instance& instance : instances)
+        instance.transform[3].z = -1.0f;
+    culler.setInstances(instances);
+    REQUIRE(culler.cull(UNIT_PLANES).empty());
+    REQUIRE(culler.visibleCount() == 0);
+}
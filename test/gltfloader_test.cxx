@@ -0,0 +1,236 @@
+#include <gltfloader.h>
+#include <loader.h>
+#include <meshcache.h>
+
+#include <cstring>
+#include <filesystem>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    template<typename T>
+    void appendBytes(std::string& bin, const std::vector<T>& values)
+    {
+        bin.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    //----------------------------------------------------------------------------
+    /** Wraps a JSON document and a binary buffer into a GLB container. **/
+    std::string makeGlb(std::string json, std::string bin)
+    {
+        json.resize((json.size() + 3) & ~size_t(3), ' ');
+        bin.resize((bin.size() + 3) & ~size_t(3), '\0');
+
+        std::string glb;
+        auto put = [&glb](const uint32_t value) { glb.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+        put(0x46546C67);
+        put(2);
+        put(static_cast<uint32_t>(12 + 8 + json.size() + (bin.empty() ? 0 : 8 + bin.size())));
+        put(static_cast<uint32_t>(json.size()));
+        put(0x4E4F534A);
+        glb += json;
+        if (!bin.empty())
+        {
+            put(static_cast<uint32_t>(bin.size()));
+            put(0x004E4942);
+            glb += bin;
+        }
+        return glb;
+    }
+
+    const std::vector<OttModel::Vertex> QUAD_VERTICES = {
+        { .pos = {0, 0, 0}, .color = {1, 0, 0}, .texCoord = {0, 0}, .normal = {0, 0, 1} },
+        { .pos = {1, 0, 0}, .color = {0, 1, 0}, .texCoord = {1, 0}, .normal = {0, 0, 1} },
+        { .pos = {1, 1, 0}, .color = {0, 0, 1}, .texCoord = {1, 1}, .normal = {0, 0, 1} },
+        { .pos = {0, 1, 0}, .color = {1, 1, 1}, .texCoord = {0, 1}, .normal = {0, 0, 1} },
+    };
+    const std::vector<uint32_t> QUAD_INDICES = { 0, 1, 2, 2, 3, 0 };
+
+    //----------------------------------------------------------------------------
+    /** A quad stored exactly like OttModel::Vertex, referenced by two translated nodes. **/
+    std::string interleavedQuadGlb()
+    {
+        std::string bin;
+        appendBytes(bin, QUAD_VERTICES);
+        appendBytes(bin, QUAD_INDICES);
+
+        const std::string json = R"({
+            "asset": { "version": "2.0" },
+            "scene": 0,
+            "scenes": [ { "nodes": [ 0, 1 ] } ],
+            "nodes": [
+                { "mesh": 0, "translation": [ 10, 0, 0 ] },
+                { "mesh": 0, "scale": [ 2, 2, 2 ] }
+            ],
+            "meshes": [ { "primitives": [ {
+                "attributes": { "POSITION": 0, "COLOR_0": 1, "TEXCOORD_0": 2, "NORMAL": 3 },
+                "indices": 4
+            } ] } ],
+            "buffers": [ { "byteLength": 200 } ],
+            "bufferViews": [
+                { "buffer": 0, "byteOffset": 0,   "byteLength": 176, "byteStride": 44 },
+                { "buffer": 0, "byteOffset": 176, "byteLength": 24 }
+            ],
+            "accessors": [
+                { "bufferView": 0, "byteOffset": 0,  "componentType": 5126, "count": 4, "type": "VEC3" },
+                { "bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 4, "type": "VEC3" },
+                { "bufferView": 0, "byteOffset": 24, "componentType": 5126, "count": 4, "type": "VEC2" },
+                { "bufferView": 0, "byteOffset": 32, "componentType": 5126, "count": 4, "type": "VEC3" },
+                { "bufferView": 1, "componentType": 5125, "count": 6, "type": "SCALAR" }
+            ]
+        })";
+        return makeGlb(json, bin);
+    }
+} // anonymous namespace
+
+TEST_CASE("glTF interleaved primitives are copied as blocks and instanced per node", "[gltf]")
+{
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    OttGltf::ImportStats stats;
+    REQUIRE(OttGltf::Parse(interleavedQuadGlb(), {}, mesh, &warn, &err, &stats));
+    REQUIRE(err.empty());
+
+    REQUIRE(stats.blockCopies == 2);
+    REQUIRE(mesh.vertices == QUAD_VERTICES);
+    REQUIRE(mesh.indices == QUAD_INDICES);
+
+    // One copy of the geometry, two objects over it.
+    REQUIRE(mesh.objects.size() == 2);
+    REQUIRE(stats.instances == 2);
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        REQUIRE(object.startVertex == 0);
+        REQUIRE(object.startIndex  == 0);
+        REQUIRE(object.indexCount  == 6);
+    }
+    REQUIRE(mesh.objects[0].transform[3] == glm::vec4(10, 0, 0, 1));
+    REQUIRE(mesh.objects[1].transform[0] == glm::vec4(2, 0, 0, 0));
+    REQUIRE(mesh.objects[1].transform[3] == glm::vec4(0, 0, 0, 1));
+}
+
+TEST_CASE("glTF separate accessors are converted", "[gltf]")
+{
+    // Positions as floats, normalized byte colors with alpha, 16-bit indices.
+    std::string bin;
+    appendBytes(bin, std::vector<float>   { 0, 0, 0,  1, 0, 0,  0, 1, 0 });
+    appendBytes(bin, std::vector<uint8_t> { 255, 0, 0, 255,  0, 255, 0, 255,  0, 0, 255, 255 });
+    appendBytes(bin, std::vector<uint16_t>{ 0, 1, 2, 0 });
+
+    const std::string json = R"({
+        "asset": { "version": "2.0" },
+        "nodes": [ { "children": [ 1 ], "translation": [ 0, 0, 5 ] }, { "mesh": 0, "translation": [ 1, 0, 0 ] } ],
+        "meshes": [ { "primitives": [ { "attributes": { "POSITION": 0, "COLOR_0": 1 }, "indices": 2 } ] } ],
+        "buffers": [ { "byteLength": 56 } ],
+        "bufferViews": [
+            { "buffer": 0, "byteOffset": 0,  "byteLength": 36 },
+            { "buffer": 0, "byteOffset": 36, "byteLength": 12 },
+            { "buffer": 0, "byteOffset": 48, "byteLength": 6 }
+        ],
+        "accessors": [
+            { "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3" },
+            { "bufferView": 1, "componentType": 5121, "normalized": true, "count": 3, "type": "VEC4" },
+            { "bufferView": 2, "componentType": 5123, "count": 3, "type": "SCALAR" }
+        ]
+    })";
+
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    OttGltf::ImportStats stats;
+    REQUIRE(OttGltf::Parse(makeGlb(json, bin), {}, mesh, &warn, &err, &stats));
+    REQUIRE(stats.blockCopies == 0);
+    REQUIRE(mesh.vertices.size() == 3);
+    REQUIRE(mesh.vertices[1].pos   == glm::vec3(1, 0, 0));
+    REQUIRE(mesh.vertices[1].color == glm::vec3(0, 1, 0));
+    REQUIRE(mesh.vertices[2].normal == glm::vec3(0, 0, 0));
+    REQUIRE(mesh.indices == std::vector<uint32_t>{ 0, 1, 2 });
+
+    // Without a scene the parentless node is the root; child transforms accumulate.
+    REQUIRE(mesh.objects.size() == 1);
+    REQUIRE(mesh.objects[0].transform[3] == glm::vec4(1, 0, 5, 1));
+}
+
+TEST_CASE("glTF JSON with a data URI buffer and a triangle strip", "[gltf]")
+{
+    // Four float3 positions, base64 encoded, drawn as a non-indexed strip.
+    std::string bin;
+    appendBytes(bin, std::vector<float>{ 0, 0, 0,  1, 0, 0,  0, 1, 0,  1, 1, 0 });
+    static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    for (size_t i = 0; i < bin.size(); i += 3)
+    {
+        const uint32_t bits = static_cast<uint8_t>(bin[i]) << 16 | static_cast<uint8_t>(bin[i + 1]) << 8 | static_cast<uint8_t>(bin[i + 2]);
+        for (int shift = 18; shift >= 0; shift -= 6)
+            encoded += alphabet[(bits >> shift) & 0x3F];
+    }
+
+    const std::string json = R"({
+        "asset": { "version": "2.0", "generator": "café \"test\"" },
+        "scenes": [ { "nodes": [ 0 ] } ],
+        "nodes": [ { "mesh": 0 } ],
+        "meshes": [ { "primitives": [ { "attributes": { "POSITION": 0 }, "mode": 5 } ] } ],
+        "buffers": [ { "byteLength": 48, "uri": "data:application/octet-stream;base64,)" + encoded + R"(" } ],
+        "bufferViews": [ { "buffer": 0, "byteLength": 48 } ],
+        "accessors": [ { "bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3" } ]
+    })";
+
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    REQUIRE(OttGltf::Parse(json, {}, mesh, &warn, &err));
+    REQUIRE(mesh.vertices.size() == 4);
+    REQUIRE(mesh.vertices[3].pos == glm::vec3(1, 1, 0));
+    REQUIRE(mesh.vertices[3].color == glm::vec3(1, 1, 1));
+    REQUIRE(mesh.indices == std::vector<uint32_t>{ 0, 1, 2,  1, 3, 2 });
+}
+
+TEST_CASE("glTF rejects malformed files", "[gltf]")
+{
+    OttModel::MeshData mesh;
+    std::string warn, err;
+
+    SECTION("invalid JSON")
+    {
+        REQUIRE_FALSE(OttGltf::Parse(R"({ "asset": { "version": "2.0" )", {}, mesh, &warn, &err));
+        REQUIRE(!err.empty());
+    }
+    SECTION("glTF 1.0")
+    {
+        REQUIRE_FALSE(OttGltf::Parse(R"({ "asset": { "version": "1.0" } })", {}, mesh, &warn, &err));
+    }
+    SECTION("accessor past the end of its view")
+    {
+        std::string glb = interleavedQuadGlb();
+        const std::string from = R"("count": 6)";
+        glb.replace(glb.find(from), from.size(), R"("count": 9)");
+        REQUIRE_FALSE(OttGltf::Parse(glb, {}, mesh, &warn, &err));
+        REQUIRE(mesh.objects.empty());
+    }
+    SECTION("index out of range")
+    {
+        std::string glb = interleavedQuadGlb();
+        const uint32_t bad = 7;
+        std::memcpy(glb.data() + glb.size() - 4, &bad, sizeof(bad));
+        REQUIRE_FALSE(OttGltf::Parse(glb, {}, mesh, &warn, &err));
+    }
+}
+
+TEST_CASE("OttLoader extracts edges once per instanced glTF primitive", "[gltf]")
+{
+    const auto path = OttTest::writeTempFile("instanced_quad.glb", interleavedQuadGlb());
+    std::filesystem::remove(OttMeshCache::cachePathFor(path));
+
+    OttModel::MeshData mesh;
+    REQUIRE(OttLoader::loadMesh(path, mesh));
+    REQUIRE(mesh.edges.size() == 8);
+    REQUIRE(mesh.objects.size() == 2);
+    REQUIRE(mesh.objects[0].edgeCount == 8);
+    REQUIRE(mesh.objects[1].startEdge == mesh.objects[0].startEdge);
+
+    // The transforms survive the mesh cache.
+    OttModel::MeshData cached;
+    REQUIRE(OttLoader::loadMesh(path, cached));
+    REQUIRE(cached.objects[0].transform[3] == glm::vec4(10, 0, 0, 1));
+}
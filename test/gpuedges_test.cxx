@@ -0,0 +1,250 @@
+#include <edges.h>
+#include <gpuedges.h>
+#include <model.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    //----------------------------------------------------------------------------
+    /** A Vulkan 1.3 device without a surface, on the first GPU (or software driver, e.g.
+     *  lavapipe) with a compute queue, buffer device addresses and 64-bit integers. **/
+    struct HeadlessDevice
+    {
+        VkInstance       instance       = VK_NULL_HANDLE;
+        VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+        VkDevice         device         = VK_NULL_HANDLE;
+        VkQueue          queue          = VK_NULL_HANDLE;
+        uint32_t         queueFamily    = 0;
+
+        bool create()
+        {
+            if (volkInitialize() != VK_SUCCESS)
+                return false;
+            const VkApplicationInfo appInfo {
+                .sType      = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+                .apiVersion = VK_API_VERSION_1_3,
+            };
+            const VkInstanceCreateInfo instanceInfo {
+                .sType            = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+                .pApplicationInfo = &appInfo,
+            };
+            if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS)
+                return false;
+            volkLoadInstance(instance);
+
+            uint32_t count = 0;
+            vkEnumeratePhysicalDevices(instance, &count, nullptr);
+            std::vector<VkPhysicalDevice> candidates(count);
+            vkEnumeratePhysicalDevices(instance, &count, candidates.data());
+            for (VkPhysicalDevice candidate : candidates)
+            {
+                VkPhysicalDeviceVulkan12Features features12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+                VkPhysicalDeviceFeatures2 features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &features12 };
+                vkGetPhysicalDeviceFeatures2(candidate, &features);
+                if (!features12.bufferDeviceAddress || !features.features.shaderInt64)
+                    continue;
+
+                uint32_t familyCount = 0;
+                vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+                std::vector<VkQueueFamilyProperties> families(familyCount);
+                vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+                for (uint32_t family = 0; family < familyCount && physicalDevice == VK_NULL_HANDLE; family++)
+                {
+                    if (families[family].queueFlags & VK_QUEUE_COMPUTE_BIT)
+                    {
+                        physicalDevice = candidate;
+                        queueFamily    = family;
+                    }
+                }
+                if (physicalDevice != VK_NULL_HANDLE)
+                    break;
+            }
+            if (physicalDevice == VK_NULL_HANDLE)
+                return false;
+
+            const float priority = 1.0f;
+            const VkDeviceQueueCreateInfo queueInfo {
+                .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = queueFamily,
+                .queueCount       = 1,
+                .pQueuePriorities = &priority,
+            };
+            VkPhysicalDeviceVulkan12Features features12 {
+                .sType               = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                .bufferDeviceAddress = VK_TRUE,
+            };
+            const VkPhysicalDeviceFeatures2 features {
+                .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                .pNext    = &features12,
+                .features = { .shaderInt64 = VK_TRUE },
+            };
+            const VkDeviceCreateInfo deviceInfo {
+                .sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                .pNext                = &features,
+                .queueCreateInfoCount = 1,
+                .pQueueCreateInfos    = &queueInfo,
+            };
+            if (vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+                return false;
+            volkLoadDevice(device);
+            vkGetDeviceQueue(device, queueFamily, 0, &queue);
+            return true;
+        }
+
+        ~HeadlessDevice()
+        {
+            if (device != VK_NULL_HANDLE)   { vkDestroyDevice(device, nullptr); }
+            if (instance != VK_NULL_HANDLE) { vkDestroyInstance(instance, nullptr); }
+        }
+    };
+
+    //----------------------------------------------------------------------------
+    /** The extractor on a headless device, or empty when there is no usable device or the
+     *  kernels weren't compiled; the test is skipped then. Shared by every test case. **/
+    OttGpuEdges* gpuEdges()
+    {
+        static HeadlessDevice headless;
+        static std::unique_ptr<OttGpuEdges> edges;
+        static bool tried = false;
+        if (std::exchange(tried, true))
+            return edges.get();
+
+        const std::filesystem::path shaders = std::filesystem::path(OTT_BINARY_RESOURCE_DIR) / "shaders";
+        if (!std::filesystem::exists(shaders / "edges_sides.comp.spv") || !headless.create())
+            return nullptr;
+        edges = std::make_unique<OttGpuEdges>(OttGpuEdges::Context {
+            .device         = headless.device,
+            .physicalDevice = headless.physicalDevice,
+            .queue          = headless.queue,
+            .queueFamily    = headless.queueFamily,
+        }, shaders);
+        return edges.get();
+    }
+
+    //----------------------------------------------------------------------------
+    /** Two triangles per cell over a (cells + 1)^2 vertex grid, every seventh triangle left
+     *  out so the boundary has holes. Heights step by whole units, so neighbouring faces
+     *  are either flat or fold at 45 degrees, far from the thresholds tested. **/
+    void steppedGrid(const uint32_t cells_per_side, std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        const uint32_t row = cells_per_side + 1;
+        for (uint32_t y = 0; y <= cells_per_side; y++)
+        {
+            for (uint32_t x = 0; x <= cells_per_side; x++)
+                vertices.push_back({ .pos = glm::vec3(float(x), float(y), float((x / 2 + y / 3) % 2)) });
+        }
+        uint32_t triangle = 0;
+        for (uint32_t y = 0; y < cells_per_side; y++)
+        {
+            for (uint32_t x = 0; x < cells_per_side; x++)
+            {
+                const uint32_t a = y * row + x, b = a + 1, c = a + row, d = c + 1;
+                for (const std::array<uint32_t, 3>& t : { std::array{ a, b, d }, std::array{ a, d, c } })
+                {
+                    if (triangle++ % 7 != 3)
+                        indices.insert(indices.end(), t.begin(), t.end());
+                }
+            }
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** The same triangles with a copy of every corner, as flat shaded exports write them. **/
+    void splitCorners(std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::vector<OttModel::Vertex> corners;
+        for (uint32_t& index : indices)
+        {
+            corners.push_back(vertices[index]);
+            index = static_cast<uint32_t>(corners.size() - 1);
+        }
+        vertices = std::move(corners);
+    }
+
+    // Edges as sorted (min, max) pairs, for comparing kernels that emit in different orders.
+    std::vector<std::pair<uint32_t, uint32_t>> sortedPairs(const std::vector<uint32_t>& edges)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        for (size_t i = 0; i + 1 < edges.size(); i += 2)
+            pairs.push_back(std::minmax(edges[i], edges[i + 1]));
+        std::ranges::sort(pairs);
+        return pairs;
+    }
+} // anonymous namespace
+
+TEST_CASE("GPU boundary edges match the CPU kernel", "[gpuedges]")
+{
+    OttGpuEdges* gpu = gpuEdges();
+    if (!gpu)
+        SKIP("No Vulkan device with buffer device addresses, or the edge kernels were not compiled");
+
+    for (const uint32_t cells : { 1u, 10u, 250u })
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        steppedGrid(cells, vertices, indices);
+        REQUIRE(gpu->extract(vertices, indices, std::nullopt) == OttModel::extractBoundaryEdges(indices));
+    }
+
+    // Indices far from dense, and triangles sharing sides more than twice.
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<uint32_t> vertex(0, 299);
+    std::vector<OttModel::Vertex> vertices(300);
+    std::vector<uint32_t> indices(3 * 20000);
+    for (uint32_t& index : indices)
+        index = vertex(rng);
+    REQUIRE(gpu->extract(vertices, indices, std::nullopt) == OttModel::extractBoundaryEdges(indices));
+    REQUIRE(gpu->extract(vertices, std::vector<uint32_t>{}, std::nullopt).empty());
+}
+
+TEST_CASE("GPU crease edges match the CPU kernel", "[gpuedges]")
+{
+    OttGpuEdges* gpu = gpuEdges();
+    if (!gpu)
+        SKIP("No Vulkan device with buffer device addresses, or the edge kernels were not compiled");
+
+    for (const bool split : { false, true })
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t> indices;
+        steppedGrid(120, vertices, indices);
+        if (split)
+            splitCorners(vertices, indices);
+
+        for (const OttEdges::CreaseOptions options : { OttEdges::CreaseOptions{ .angleDegrees = 30.0f },
+                                                       OttEdges::CreaseOptions{ .angleDegrees = 60.0f },
+                                                       OttEdges::CreaseOptions{ .angleDegrees = 30.0f, .boundaries = false },
+                                                       OttEdges::CreaseOptions{ .angleDegrees = 30.0f, .suppressSeams = false } })
+        {
+            const std::vector<uint32_t> expected = OttEdges::extractCreaseEdges(vertices, indices, options);
+            REQUIRE(sortedPairs(gpu->extract(vertices, indices, options)) == sortedPairs(expected));
+        }
+    }
+}
+
+TEST_CASE("GPU edges of a mesh that needs a three level scan", "[gpuedges]")
+{
+    OttGpuEdges* gpu = gpuEdges();
+    if (!gpu)
+        SKIP("No Vulkan device with buffer device addresses, or the edge kernels were not compiled");
+
+    // Six million triangle sides: more than the 1024 * 1024 values two scan levels cover.
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    steppedGrid(1000, vertices, indices);
+    REQUIRE(indices.size() > 1024 * 1024);
+
+    REQUIRE(gpu->extract(vertices, indices, std::nullopt) == OttModel::extractBoundaryEdges(indices));
+    const OttEdges::CreaseOptions options {};
+    REQUIRE(sortedPairs(gpu->extract(vertices, indices, options)) == sortedPairs(OttEdges::extractCreaseEdges(vertices, indices, options)));
+}
@@ -0,0 +1,286 @@
+#include <ifcloader.h>
+#include <loader.h>
+#include <meshcache.h>
+
+#include <cmath>
+#include <filesystem>
+
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+
+#include "fixtures.h"
+
+namespace
+{
+    std::string ifcFile(const std::string& data)
+    {
+        return "ISO-10303-21;\n"
+               "HEADER;\n"
+               "FILE_DESCRIPTION(('ViewDefinition [ReferenceView]'),'2;1');\n"
+               "FILE_NAME('test.ifc','2024-01-01T00:00:00',(''),(''),'','','');\n"
+               "FILE_SCHEMA(('IFC4'));\n"
+               "ENDSEC;\n"
+               "DATA;\n" + data +
+               "ENDSEC;\n"
+               "END-ISO-10303-21;\n";
+    }
+
+    // Millimetre units. A wall at x = 1 m, an opening through it, a faceted box, a single
+    // triangle, a column placed through a mapped item and a square plate with a square hole.
+    const std::string SAMPLE = ifcFile(R"(#1=IFCPROJECT('0YvctVUKr0kugbFTf53O9L',$,'Project',$,$,$,$,(#20),#2);
+#2=IFCUNITASSIGNMENT((#4,#3));
+#3=IFCSIUNIT(*,.LENGTHUNIT.,.MILLI.,.METRE.);
+#4=IFCSIUNIT(*,.PLANEANGLEUNIT.,$,.RADIAN.);
+#10=IFCCARTESIANPOINT((0.,0.,0.));
+#11=IFCDIRECTION((0.,0.,1.));
+#12=IFCDIRECTION((1.,0.,0.));
+#13=IFCAXIS2PLACEMENT3D(#10,#11,#12);
+#14=IFCLOCALPLACEMENT($,#13);
+#15=IFCCARTESIANPOINT((1000.,0.,0.));
+#16=IFCAXIS2PLACEMENT3D(#15,$,$);
+#17=IFCLOCALPLACEMENT(#14,#16);
+#20=IFCGEOMETRICREPRESENTATIONCONTEXT($,'Model',3,1.E-05,#13,$);
+/* The wall: a 4000 x 200 rectangle, 3000 high. */
+#30=IFCRECTANGLEPROFILEDEF(.AREA.,$,#31,4000.,200.);
+#31=IFCAXIS2PLACEMENT2D(#32,$);
+#32=IFCCARTESIANPOINT((2000.,100.));
+#33=IFCEXTRUDEDAREASOLID(#30,#13,#11,3000.);
+#34=IFCSHAPEREPRESENTATION(#20,'Body','SweptSolid',(#33));
+#35=IFCSHAPEREPRESENTATION(#20,'Axis','Curve2D',(#99));
+#36=IFCPRODUCTDEFINITIONSHAPE($,$,(#35,#34));
+#37=IFCWALL('2O2Fr$t4X7Zf8NOew3FLOH',$,'Wall; ''quoted''',$,$,#17,#36,$,$);
+#38=IFCOPENINGELEMENT('1hOSvn6df7F8_7GcBWlRGQ',$,'Opening',$,$,#17,#36,$,$);
+#50=IFCCARTESIANPOINT((0.,0.,0.));
+#51=IFCCARTESIANPOINT((1000.,0.,0.));
+#52=IFCCARTESIANPOINT((1000.,1000.,0.));
+#53=IFCCARTESIANPOINT((0.,1000.,0.));
+#54=IFCCARTESIANPOINT((0.,0.,1000.));
+#55=IFCCARTESIANPOINT((1000.,0.,1000.));
+#56=IFCCARTESIANPOINT((1000.,1000.,1000.));
+#57=IFCCARTESIANPOINT((0.,1000.,1000.));
+#60=IFCPOLYLOOP((#50,#53,#52,#51));
+#61=IFCPOLYLOOP((#57,#56,#55,#54));
+#62=IFCPOLYLOOP((#50,#51,#55,#54));
+#63=IFCPOLYLOOP((#51,#52,#56,#55));
+#64=IFCPOLYLOOP((#52,#53,#57,#56));
+#65=IFCPOLYLOOP((#53,#50,#54,#57));
+#66=IFCFACEOUTERBOUND(#60,.T.);
+#67=IFCFACEOUTERBOUND(#61,.F.);
+#68=IFCFACEOUTERBOUND(#62,.T.);
+#69=IFCFACEOUTERBOUND(#63,.T.);
+#70=IFCFACEOUTERBOUND(#64,.T.);
+#71=IFCFACEOUTERBOUND(#65,.T.);
+#72=IFCFACE((#66));
+#73=IFCFACE((#67));
+#74=IFCFACE((#68));
+#75=IFCFACE((#69));
+#76=IFCFACE((#70));
+#77=IFCFACE((#71));
+#78=IFCCLOSEDSHELL((#72,#73,#74,#75,#76,#77));
+#79=IFCFACETEDBREP(#78);
+#80=IFCSHAPEREPRESENTATION(#20,'Body','Brep',(#79));
+#81=IFCPRODUCTDEFINITIONSHAPE($,$,(#80));
+#82=IFCFURNISHINGELEMENT('3vB2YO$MX4xv5uCqZZG05x',$,'Box',$,$,#14,#81,$,$);
+#90=IFCCARTESIANPOINTLIST3D(((0.,0.,0.),(1000.,0.,0.),(0.,1000.,0.)),$);
+#91=IFCTRIANGULATEDFACESET(#90,$,$,((1,2,3)),$);
+#92=IFCSHAPEREPRESENTATION(#20,'Body','Tessellation',(#91));
+#93=IFCPRODUCTDEFINITIONSHAPE($,$,(#92));
+#94=IFCBUILDINGELEMENTPROXY('0u4wgLe6n0ABVaiXyikbkA',$,'Triangle',$,$,#14,#93,$,$);
+#100=IFCCIRCLEPROFILEDEF(.AREA.,$,$,100.);
+#101=IFCEXTRUDEDAREASOLID(#100,#13,#11,3000.);
+#102=IFCSHAPEREPRESENTATION(#20,'Body','SweptSolid',(#101));
+#103=IFCREPRESENTATIONMAP(#13,#102);
+#104=IFCCARTESIANPOINT((0.,5000.,0.));
+#105=IFCCARTESIANTRANSFORMATIONOPERATOR3D($,$,#104,$,$);
+#106=IFCMAPPEDITEM(#103,#105);
+#107=IFCSHAPEREPRESENTATION(#20,'Body','MappedRepresentation',(#106));
+#108=IFCPRODUCTDEFINITIONSHAPE($,$,(#107));
+#109=IFCCOLUMN('1Xqm$8Tz5DEwTc4XVvLQ3_',$,'Column',$,$,#14,#108,$,$);
+#110=IFCCARTESIANPOINTLIST3D(((0.,0.,0.),(3000.,0.,0.),(3000.,3000.,0.),(0.,3000.,0.),(1000.,1000.,0.),(2000.,1000.,0.),(2000.,2000.,0.),(1000.,2000.,0.)),$);
+#111=IFCINDEXEDPOLYGONALFACEWITHVOIDS((1,2,3,4),((5,6,7,8)));
+#112=IFCPOLYGONALFACESET(#110,$,(#111),$);
+#113=IFCSHAPEREPRESENTATION(#20,'Body','Tessellation',(#112));
+#114=IFCPRODUCTDEFINITIONSHAPE($,$,(#113));
+#115=IFCPLATE('2bCfy7HM1BAgBJdC3xKY8k',$,'Plate',$,$,#14,#114,$,$);
+)");
+
+    bool near(const double actual, const double expected)
+    {
+        return std::abs(actual - expected) < 1e-4 * std::max(1.0, std::abs(expected));
+    }
+
+    struct Bounds
+    {
+        glm::vec3 min = glm::vec3( 1e30f);
+        glm::vec3 max = glm::vec3(-1e30f);
+    };
+
+    Bounds boundsOf(const OttModel::MeshData& mesh, const OttModel::modelObject& object)
+    {
+        Bounds bounds;
+        for (uint32_t i = 0; i < object.indexCount; i++)
+        {
+            const glm::vec3 p = mesh.vertices[object.startVertex + mesh.indices[object.startIndex + i]].pos;
+            bounds.min = glm::vec3(std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y), std::min(bounds.min.z, p.z));
+            bounds.max = glm::vec3(std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y), std::max(bounds.max.z, p.z));
+        }
+        return bounds;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Sum of triangle areas of object, and whether every face normal points away from center. **/
+    float areaOf(const OttModel::MeshData& mesh, const OttModel::modelObject& object, const glm::vec3* center = nullptr, bool* outward = nullptr)
+    {
+        float area = 0.0f;
+        for (uint32_t t = 0; t < object.indexCount; t += 3)
+        {
+            const OttModel::Vertex* v[3];
+            for (uint32_t k = 0; k < 3; k++)
+                v[k] = &mesh.vertices[object.startVertex + mesh.indices[object.startIndex + t + k]];
+            const glm::vec3 cross = glm::cross(v[1]->pos - v[0]->pos, v[2]->pos - v[0]->pos);
+            area += glm::length(cross) * 0.5f;
+            if (center && outward && glm::dot(cross, (v[0]->pos + v[1]->pos + v[2]->pos) / 3.0f - *center) <= 0.0f)
+                *outward = false;
+        }
+        return area;
+    }
+
+    //----------------------------------------------------------------------------
+    /** count walls, each a separate extruded rectangle 1 m apart, with its own placement. **/
+    std::string generatedWalls(const int count)
+    {
+        std::string data = "#1=IFCUNITASSIGNMENT((#2));\n#2=IFCSIUNIT(*,.LENGTHUNIT.,$,.METRE.);\n"
+                           "#3=IFCDIRECTION((0.,0.,1.));\n#4=IFCDIRECTION((1.,0.,0.));\n"
+                           "#5=IFCCARTESIANPOINT((0.,0.,0.));\n#6=IFCAXIS2PLACEMENT3D(#5,#3,#4);\n";
+        for (int i = 0; i < count; i++)
+        {
+            const int id = 10 + i * 10;
+            data += fmt::format("#{}=IFCCARTESIANPOINT(({}.,0.,0.));\n", id, i);
+            data += fmt::format("#{}=IFCAXIS2PLACEMENT3D(#{},$,$);\n", id + 1, id);
+            data += fmt::format("#{}=IFCLOCALPLACEMENT($,#{});\n", id + 2, id + 1);
+            data += fmt::format("#{}=IFCRECTANGLEPROFILEDEF(.AREA.,$,$,0.5,0.2);\n", id + 3);
+            data += fmt::format("#{}=IFCEXTRUDEDAREASOLID(#{},#6,#3,3.);\n", id + 4, id + 3);
+            data += fmt::format("#{}=IFCSHAPEREPRESENTATION($,'Body','SweptSolid',(#{}));\n", id + 5, id + 4);
+            data += fmt::format("#{}=IFCPRODUCTDEFINITIONSHAPE($,$,(#{}));\n", id + 6, id + 5);
+            data += fmt::format("#{}=IFCWALL('{:0>22}',$,'Wall {}',$,$,#{},#{},$,$);\n", id + 7, i, i, id + 2, id + 6);
+        }
+        return ifcFile(data);
+    }
+} // anonymous namespace
+
+TEST_CASE("IFC products become objects tagged with their GlobalId", "[ifc]")
+{
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    OttIfc::ImportStats stats;
+    REQUIRE(OttIfc::Parse(SAMPLE, mesh, &warn, &err, &stats));
+    REQUIRE(err.empty());
+
+    // The opening is skipped; everything else is one object each, in file order.
+    REQUIRE(mesh.objectIds == std::vector<std::string>{ "2O2Fr$t4X7Zf8NOew3FLOH", "3vB2YO$MX4xv5uCqZZG05x",
+                                                        "0u4wgLe6n0ABVaiXyikbkA", "1Xqm$8Tz5DEwTc4XVvLQ3_",
+                                                        "2bCfy7HM1BAgBJdC3xKY8k" });
+    REQUIRE(mesh.objects.size() == 5);
+    REQUIRE(stats.products == 5);
+    REQUIRE(stats.skippedItems == 0);
+
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        REQUIRE(object.indexCount % 3 == 0);
+        for (uint32_t i = 0; i < object.indexCount; i++)
+            REQUIRE(object.startVertex + mesh.indices[object.startIndex + i] < mesh.vertices.size());
+    }
+
+    SECTION("extruded wall, in metres and placed through its parent")
+    {
+        const Bounds wall = boundsOf(mesh, mesh.objects[0]);
+        REQUIRE(near(wall.min.x, 1.0f));
+        REQUIRE(near(wall.max.x, 5.0f));
+        REQUIRE(near(wall.max.y, 0.2f));
+        REQUIRE(near(wall.max.z, 3.0f));
+        REQUIRE(mesh.objects[0].indexCount == 12 * 3);
+
+        const glm::vec3 center(3.0f, 0.1f, 1.5f);
+        bool outward = true;
+        REQUIRE(near(areaOf(mesh, mesh.objects[0], &center, &outward), 2 * (4 * 0.2 + 4 * 3 + 0.2 * 3)));
+        REQUIRE(outward);
+    }
+    SECTION("faceted brep with a reversed bound")
+    {
+        const glm::vec3 center(0.5f);
+        bool outward = true;
+        REQUIRE(near(areaOf(mesh, mesh.objects[1], &center, &outward), 6.0f));
+        REQUIRE(outward);
+    }
+    SECTION("triangulated face set")
+    {
+        REQUIRE(mesh.objects[2].indexCount == 3);
+        REQUIRE(mesh.vertices[mesh.objects[2].startVertex].normal == glm::vec3(0, 0, 1));
+    }
+    SECTION("mapped item")
+    {
+        const Bounds column = boundsOf(mesh, mesh.objects[3]);
+        REQUIRE(near(column.min.y, 4.9f));
+        REQUIRE(near(column.max.y, 5.1f));
+        REQUIRE(near(column.max.z, 3.0f));
+    }
+    SECTION("polygonal face with a void")
+    {
+        REQUIRE(near(areaOf(mesh, mesh.objects[4]), 8.0f));
+    }
+}
+
+TEST_CASE("IFC DATA sections are indexed in parallel chunks", "[ifc]")
+{
+    constexpr int COUNT = 12000;
+    const std::string text = generatedWalls(COUNT);
+    REQUIRE(text.size() > 2 * (1 << 20));
+
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    OttIfc::ImportStats stats;
+    REQUIRE(OttIfc::Parse(text, mesh, &warn, &err, &stats));
+    REQUIRE(stats.chunks > 1);
+    REQUIRE(stats.entities == 6 + COUNT * 8);
+    REQUIRE(mesh.objects.size() == COUNT);
+    for (int i = 0; i < COUNT; i += 997)
+    {
+        REQUIRE(mesh.objectIds[i] == fmt::format("{:0>22}", i));
+        REQUIRE(near(boundsOf(mesh, mesh.objects[i]).min.x, i - 0.25f));
+    }
+}
+
+TEST_CASE("IFC import honours a stop request", "[ifc]")
+{
+    std::stop_source source;
+    source.request_stop();
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    REQUIRE_FALSE(OttIfc::Parse(SAMPLE, mesh, &warn, &err, nullptr, source.get_token()));
+    REQUIRE(mesh.objects.empty());
+}
+
+TEST_CASE("IFC rejects files that are not STEP", "[ifc]")
+{
+    OttModel::MeshData mesh;
+    std::string warn, err;
+    REQUIRE_FALSE(OttIfc::Parse("solid cube\nendsolid cube\n", mesh, &warn, &err));
+    REQUIRE(!err.empty());
+}
+
+TEST_CASE("OttLoader loads IFC through the mesh cache with its GlobalIds", "[ifc]")
+{
+    const auto path = OttTest::writeTempFile("sample.ifc", SAMPLE);
+    std::filesystem::remove(OttMeshCache::cachePathFor(path));
+
+    OttModel::MeshData mesh;
+    REQUIRE(OttLoader::loadMesh(path, mesh));
+    REQUIRE(mesh.objects.size() == 5);
+    // Faces keep their own vertices, so each face of the box contributes its four outline edges.
+    REQUIRE(mesh.objects[1].edgeCount == 2 * 6 * 4);
+
+    OttModel::MeshData cached;
+    REQUIRE(OttLoader::loadMesh(path, cached));
+    REQUIRE(cached.objectIds == mesh.objectIds);
+    REQUIRE(cached.vertices == mesh.vertices);
+}
@@ -0,0 +1,197 @@
+#include <instancing.h>
+#include <loader.h>
+#include <meshcache.h>
+
+#include <cmath>
+#include <filesystem>
+
+#include <catch2/catch_test_macros.hpp>
+#include <fmt/format.h>
+
+#include "fixtures.h"
+
+namespace
+{
+    // An asymmetric wedge: no rotation maps it onto itself.
+    const std::vector<glm::vec3> WEDGE_POSITIONS = {
+        { 0, 0, 0 }, { 2, 0, 0 }, { 0, 1, 0 }, { 0, 0, 0.5f }, { 2, 0, 0.5f }, { 0, 1, 0.5f },
+    };
+    const std::vector<uint32_t> WEDGE_INDICES = {
+        0, 2, 1,  3, 4, 5,  0, 1, 4,  0, 4, 3,  1, 2, 5,  1, 5, 4,  2, 0, 3,  2, 3, 5,
+    };
+
+    glm::mat4 rigid(const float angle, const glm::vec3& axis, const glm::vec3& translation)
+    {
+        // Rodrigues, so the test does not depend on glm extensions.
+        const glm::vec3 k = glm::normalize(axis);
+        const float c = std::cos(angle), s = std::sin(angle);
+        glm::mat4 m(1.0f);
+        for (int column = 0; column < 3; column++)
+        {
+            glm::vec3 e(0.0f);
+            e[column] = 1.0f;
+            const glm::vec3 r = e * c + glm::cross(k, e) * s + k * glm::dot(k, e) * (1.0f - c);
+            m[column] = glm::vec4(r, 0.0f);
+        }
+        m[3] = glm::vec4(translation, 1.0f);
+        return m;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Bakes positions moved by transform into mesh as a new object, like an IFC product. **/
+    void appendBaked(OttModel::MeshData& mesh, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices,
+                     const glm::mat4& transform)
+    {
+        mesh.objects.push_back({
+            .startIndex  = static_cast<uint32_t>(mesh.indices.size()),
+            .startVertex = static_cast<uint32_t>(mesh.vertices.size()),
+            .startEdge   = static_cast<uint32_t>(mesh.edges.size()),
+            .indexCount  = static_cast<uint32_t>(indices.size()),
+            .edgeCount   = 2,
+            .textureID   = 0,
+            .pushColorID = glm::vec3(0.0f),
+        });
+        for (const glm::vec3& p : positions)
+            mesh.vertices.push_back({ .pos = glm::vec3(transform * glm::vec4(p, 1.0f)), .color = glm::vec3(1.0f) });
+        mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+        mesh.edges.insert(mesh.edges.end(), { 0, 1 });
+    }
+
+    //----------------------------------------------------------------------------
+    /** World positions of every corner of object, in index order. **/
+    std::vector<glm::vec3> worldCorners(const OttModel::MeshData& mesh, const OttModel::modelObject& object)
+    {
+        std::vector<glm::vec3> corners;
+        for (uint32_t i = 0; i < object.indexCount; i++)
+        {
+            const glm::vec3 p = mesh.vertices[object.startVertex + mesh.indices[object.startIndex + i]].pos;
+            corners.emplace_back(object.transform * glm::vec4(p, 1.0f));
+        }
+        return corners;
+    }
+
+    bool near(const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b, const float tolerance)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (glm::length(a[i] - b[i]) > tolerance)
+                return false;
+        }
+        return true;
+    }
+} // anonymous namespace
+
+TEST_CASE("Rigidly moved copies collapse onto one prototype", "[instancing]")
+{
+    OttModel::MeshData mesh;
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, glm::mat4(1.0f));
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, rigid(0.7f, { 0, 0, 1 }, { 10, 0, 0 }));
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, rigid(2.1f, { 1, 2, 3 }, { -4, 250, 3 }));
+    // A different shape in between, and a copy scaled up, which is not a rigid motion.
+    appendBaked(mesh, { { 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 } }, { 0, 1, 2 }, glm::mat4(1.0f));
+    glm::mat4 scaled(2.0f);
+    scaled[3] = glm::vec4(0, 0, 0, 1);
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, scaled);
+
+    std::vector<std::vector<glm::vec3>> before;
+    for (const OttModel::modelObject& object : mesh.objects)
+        before.push_back(worldCorners(mesh, object));
+
+    const OttInstancing::InstancingStats stats = OttInstancing::instance(mesh);
+    REQUIRE(stats.objects == 5);
+    REQUIRE(stats.geometries == 5);
+    REQUIRE(stats.prototypes == 3);
+    REQUIRE(mesh.vertices.size() == 6 + 3 + 6);
+    REQUIRE(mesh.indices.size() == 2 * WEDGE_INDICES.size() + 3);
+    REQUIRE(mesh.edges.size() == 6);
+    REQUIRE(stats.totalBytes == 18 * sizeof(OttModel::Vertex) + 6 * sizeof(OttModel::Vertex) + 3 * sizeof(OttModel::Vertex)
+                                + (4 * WEDGE_INDICES.size() + 3 + 10) * sizeof(uint32_t));
+    REQUIRE(stats.uniqueBytes == 15 * sizeof(OttModel::Vertex) + (2 * WEDGE_INDICES.size() + 3 + 6) * sizeof(uint32_t));
+
+    REQUIRE(mesh.objects[1].startIndex == mesh.objects[0].startIndex);
+    REQUIRE(mesh.objects[2].startVertex == mesh.objects[0].startVertex);
+    REQUIRE(mesh.objects[1].startEdge == mesh.objects[0].startEdge);
+    REQUIRE(mesh.objects[4].startIndex != mesh.objects[0].startIndex);
+
+    // Every object still lands where it was.
+    for (size_t i = 0; i < mesh.objects.size(); i++)
+        REQUIRE(near(worldCorners(mesh, mesh.objects[i]), before[i], 1e-3f));
+}
+
+TEST_CASE("Instancing composes with existing object transforms", "[instancing]")
+{
+    OttModel::MeshData mesh;
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, glm::mat4(1.0f));
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, rigid(1.0f, { 0, 1, 0 }, { 0, 5, 0 }));
+    // A glTF style instance of the second range, placed by its own transform.
+    mesh.objects.push_back(mesh.objects[1]);
+    mesh.objects[2].transform = rigid(0.3f, { 1, 0, 0 }, { 100, 0, 0 });
+
+    std::vector<std::vector<glm::vec3>> before;
+    for (const OttModel::modelObject& object : mesh.objects)
+        before.push_back(worldCorners(mesh, object));
+
+    const OttInstancing::InstancingStats stats = OttInstancing::instance(mesh);
+    REQUIRE(stats.geometries == 2);
+    REQUIRE(stats.prototypes == 1);
+    for (size_t i = 0; i < mesh.objects.size(); i++)
+        REQUIRE(near(worldCorners(mesh, mesh.objects[i]), before[i], 1e-3f));
+}
+
+TEST_CASE("Copies with different attributes or topology stay separate", "[instancing]")
+{
+    OttModel::MeshData mesh;
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, glm::mat4(1.0f));
+    appendBaked(mesh, WEDGE_POSITIONS, WEDGE_INDICES, rigid(0.5f, { 0, 0, 1 }, { 3, 0, 0 }));
+    mesh.vertices[mesh.objects[1].startVertex].color = glm::vec3(1, 0, 0);
+
+    std::vector<uint32_t> flipped = WEDGE_INDICES;
+    std::swap(flipped[0], flipped[1]);
+    appendBaked(mesh, WEDGE_POSITIONS, flipped, rigid(0.5f, { 0, 0, 1 }, { 6, 0, 0 }));
+
+    const size_t vertexCount = mesh.vertices.size();
+    const OttInstancing::InstancingStats stats = OttInstancing::instance(mesh);
+    REQUIRE(stats.prototypes == 3);
+    REQUIRE(mesh.vertices.size() == vertexCount);
+    REQUIRE(stats.totalBytes == stats.uniqueBytes);
+}
+
+TEST_CASE("Repeated IFC elements are instanced by loadMesh", "[instancing]")
+{
+    // Ten identical rotated columns, baked into world coordinates by the IFC reader.
+    std::string data = "#1=IFCDIRECTION((0.,0.,1.));\n#2=IFCCARTESIANPOINT((0.,0.,0.));\n"
+                       "#3=IFCAXIS2PLACEMENT3D(#2,#1,$);\n"
+                       "#4=IFCRECTANGLEPROFILEDEF(.AREA.,$,$,0.4,0.2);\n"
+                       "#5=IFCEXTRUDEDAREASOLID(#4,#3,#1,3.);\n"
+                       "#6=IFCSHAPEREPRESENTATION($,'Body','SweptSolid',(#5));\n"
+                       "#7=IFCPRODUCTDEFINITIONSHAPE($,$,(#6));\n";
+    for (int i = 0; i < 10; i++)
+    {
+        const int id = 10 + i * 5;
+        data += fmt::format("#{}=IFCCARTESIANPOINT(({}.,{}.,0.));\n", id, i * 3, i % 4);
+        data += fmt::format("#{}=IFCDIRECTION(({},{},0.));\n", id + 1, std::cos(i * 0.4), std::sin(i * 0.4));
+        data += fmt::format("#{}=IFCAXIS2PLACEMENT3D(#{},#1,#{});\n", id + 2, id, id + 1);
+        data += fmt::format("#{}=IFCLOCALPLACEMENT($,#{});\n", id + 3, id + 2);
+        data += fmt::format("#{}=IFCCOLUMN('{:0>22}',$,$,$,$,#{},#7,$,$);\n", id + 4, i, id + 3);
+    }
+    const std::string text = "ISO-10303-21;\nHEADER;\nFILE_SCHEMA(('IFC4'));\nENDSEC;\nDATA;\n" + data + "ENDSEC;\nEND-ISO-10303-21;\n";
+
+    const auto path = OttTest::writeTempFile("columns.ifc", text);
+
+    const OttLoader::LoadOptions options { .instancing = OttInstancing::InstancingOptions{} };
+    std::filesystem::remove(OttMeshCache::cachePathFor(path, options.fingerprint()));
+
+    OttModel::MeshData plain, instanced;
+    REQUIRE(OttLoader::loadMesh(path, plain));
+    REQUIRE(OttLoader::loadMesh(path, instanced, options));
+    REQUIRE(instanced.objects.size() == 10);
+    REQUIRE(instanced.objectIds == plain.objectIds);
+    REQUIRE(instanced.vertices.size() * 10 == plain.vertices.size());
+    for (size_t i = 0; i < plain.objects.size(); i++)
+    {
+        REQUIRE(instanced.objects[i].startIndex == instanced.objects[0].startIndex);
+        REQUIRE(near(worldCorners(instanced, instanced.objects[i]), worldCorners(plain, plain.objects[i]), 1e-4f));
+    }
+}
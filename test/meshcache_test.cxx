@@ -0,0 +1,57 @@
+#include <loader.h>
+#include <meshcache.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    std::filesystem::path writeCube()
+    {
+        const auto path = OttTest::writeTempFile("cache_cube.obj", "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\n"
+                                                                   "v -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+                                                                   "f 1 2 3 4\nf 5 8 7 6\nf 1 5 6 2\nf 2 6 7 3\nf 3 7 8 4\nf 5 1 4 8\n");
+        std::filesystem::remove(OttMeshCache::cachePathFor(path));
+        return path;
+    }
+} // anonymous namespace
+
+TEST_CASE("Mesh cache round trip", "[meshcache]")
+{
+    const auto source = writeCube();
+
+    OttModel::MeshData loaded, cached;
+    REQUIRE_FALSE(OttMeshCache::read(source, cached));
+    REQUIRE(OttLoader::loadMesh(source, loaded));
+    REQUIRE(std::filesystem::exists(OttMeshCache::cachePathFor(source)));
+
+    REQUIRE(OttMeshCache::read(source, cached));
+    REQUIRE(cached.vertices      == loaded.vertices);
+    REQUIRE(cached.indices       == loaded.indices);
+    REQUIRE(cached.edges         == loaded.edges);
+    REQUIRE(cached.materialPaths == loaded.materialPaths);
+    REQUIRE(cached.objects.size() == loaded.objects.size());
+    REQUIRE(cached.objects[0].indexCount == loaded.objects[0].indexCount);
+}
+
+TEST_CASE("Mesh cache validation", "[meshcache]")
+{
+    const auto source = writeCube();
+    OttModel::MeshData mesh;
+    REQUIRE(OttLoader::loadMesh(source, mesh));
+
+    SECTION("a touched but unchanged source still hits")
+    {
+        std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::hours(1));
+        REQUIRE(OttMeshCache::read(source, mesh));
+    }
+    SECTION("an edited source misses")
+    {
+        std::ofstream(source, std::ios::app) << "f 1 3 6\n";
+        REQUIRE_FALSE(OttMeshCache::read(source, mesh));
+    }
+}
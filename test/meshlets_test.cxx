@@ -0,0 +1,227 @@
+#include <clustercull.h>
+#include <meshlets.h>
+#include <model.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    // Triangles as sorted index triples, for comparing sets of triangles in any order.
+    std::multiset<std::array<uint32_t, 3>> triangles(const std::vector<uint32_t>& indices)
+    {
+        std::multiset<std::array<uint32_t, 3>> result;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            std::array<uint32_t, 3> triangle { indices[i], indices[i + 1], indices[i + 2] };
+            std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+            result.insert(triangle);
+        }
+        return result;
+    }
+
+    OttClusterCuller::Cluster cluster(const OttModel::Meshlet& meshlet)
+    {
+        return { .sphere = meshlet.boundingSphere, .cone = meshlet.cone, .firstIndex = meshlet.startIndex,
+                 .indexCount = meshlet.indexCount, .batch = 0 };
+    }
+
+    // Planes every point is inside of.
+    const std::array<glm::vec4, 6> NO_PLANES { glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+                                               glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+                                               glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) };
+} // anonymous namespace
+
+TEST_CASE("Meshlets respect their limits and keep every triangle", "[meshlets]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::grid(100, vertices, indices);
+    const std::vector<uint32_t> original = indices;
+
+    const OttMeshlets::MeshletOptions options { .maxVertices = 64, .maxTriangles = 124 };
+    const std::vector<OttModel::Meshlet> meshlets = OttMeshlets::buildMeshlets(vertices, indices, false, options);
+    REQUIRE(triangles(indices) == triangles(original));
+
+    uint32_t next = 0;
+    for (const OttModel::Meshlet& meshlet : meshlets)
+    {
+        REQUIRE(meshlet.startIndex == next);
+        REQUIRE(meshlet.indexCount % 3 == 0);
+        REQUIRE(meshlet.indexCount > 0);
+        REQUIRE(meshlet.indexCount <= 3 * options.maxTriangles);
+        next += meshlet.indexCount;
+
+        std::set<uint32_t> unique(indices.begin() + meshlet.startIndex, indices.begin() + meshlet.startIndex + meshlet.indexCount);
+        REQUIRE(unique.size() <= options.maxVertices);
+        const glm::vec3 center(meshlet.boundingSphere);
+        for (const uint32_t index : unique)
+            REQUIRE(glm::distance(vertices[index].pos, center) <= meshlet.boundingSphere.w * 1.0001f + 1e-5f);
+
+        // The grid is open, so its back is in sight.
+        REQUIRE(meshlet.cone == glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    REQUIRE(next == indices.size());
+
+    // Greedy growth over shared vertices fills clusters well; a scattered split would not.
+    REQUIRE(meshlets.size() < indices.size() / 3 / 80);
+}
+
+TEST_CASE("Closed meshes are told from open and inside-out ones", "[meshlets]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::tessellatedCube(4, vertices, indices);
+    REQUIRE(OttMeshlets::isClosed(vertices, indices));
+
+    // Turned inside out.
+    std::vector<uint32_t> flipped = indices;
+    for (size_t i = 0; i < flipped.size(); i += 3)
+        std::swap(flipped[i + 1], flipped[i + 2]);
+    REQUIRE_FALSE(OttMeshlets::isClosed(vertices, flipped));
+
+    // One face turned around, so the winding is no longer consistent.
+    std::vector<uint32_t> mixed = indices;
+    for (size_t i = 0; i < mixed.size() / 6; i += 3)
+        std::swap(mixed[i + 1], mixed[i + 2]);
+    REQUIRE_FALSE(OttMeshlets::isClosed(vertices, mixed));
+
+    std::vector<OttModel::Vertex> openVertices;
+    std::vector<uint32_t> openIndices;
+    OttTest::tessellatedCube(4, openVertices, openIndices, { 2 });
+    REQUIRE_FALSE(OttMeshlets::isClosed(openVertices, openIndices));
+
+    std::vector<OttModel::Vertex> gridVertices;
+    std::vector<uint32_t> gridIndices;
+    OttTest::grid(8, gridVertices, gridIndices);
+    REQUIRE_FALSE(OttMeshlets::isClosed(gridVertices, gridIndices));
+    REQUIRE_FALSE(OttMeshlets::isClosed(gridVertices, std::vector<uint32_t>{}));
+}
+
+TEST_CASE("Culled meshlets are out of view or wholly turned away", "[meshlets]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::tessellatedCube(40, vertices, indices);
+    const std::vector<OttModel::Meshlet> meshlets = OttMeshlets::buildMeshlets(vertices, indices, true);
+    const auto coned = std::ranges::count_if(meshlets, [](const OttModel::Meshlet& m) { return m.cone != glm::vec4(0.0f, 0.0f, 0.0f, 1.0f); });
+    REQUIRE(size_t(coned) > meshlets.size() * 3 / 4);
+
+    // From any point outside, a cluster the cone test drops has no face turned to the eye.
+    std::mt19937 rng(15);
+    std::uniform_real_distribution<float> coordinate(-6.0f, 6.0f);
+    const glm::mat4 identity(1.0f);
+    size_t culled = 0;
+    for (int eyes = 0; eyes < 50; eyes++)
+    {
+        glm::vec3 eye(coordinate(rng), coordinate(rng), coordinate(rng));
+        if (std::max({ std::abs(eye.x), std::abs(eye.y), std::abs(eye.z) }) < 1.5f)
+            eye.x = 3.0f;
+
+        for (const OttModel::Meshlet& meshlet : meshlets)
+        {
+            if (OttClusterCuller::isVisible(cluster(meshlet), identity, NO_PLANES, eye))
+                continue;
+            culled++;
+            for (uint32_t i = meshlet.startIndex; i < meshlet.startIndex + meshlet.indexCount; i++)
+            {
+                const OttModel::Vertex& corner = vertices[indices[i]];
+                REQUIRE(glm::dot(corner.normal, eye - corner.pos) <= 1e-4f);
+            }
+        }
+    }
+    REQUIRE(culled > 50 * meshlets.size() / 4);
+
+    // Mirrored instances face the other way, so the cones don't apply to them.
+    const glm::mat4 mirrored(glm::vec4(-1.0f, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, 1.0f, 0.0f, 0.0f),
+                             glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    for (const OttModel::Meshlet& meshlet : meshlets)
+        REQUIRE(OttClusterCuller::isVisible(cluster(meshlet), mirrored, NO_PLANES, glm::vec3(5.0f, 0.0f, 0.0f)));
+
+    // The identity view projection sees x and y from -1 to 1, z from 0 to 1.
+    const std::array<glm::vec4, 6> planes = OttClusterCuller::frustumPlanes(identity);
+    glm::mat4 moved(0.1f);
+    moved[3] = glm::vec4(0.0f, 0.0f, 0.5f, 1.0f);
+    size_t seen = 0;
+    for (const OttModel::Meshlet& meshlet : meshlets)
+        seen += OttClusterCuller::isVisible(cluster(meshlet), moved, planes, glm::vec3(0.0f, 0.0f, -10.0f));
+    REQUIRE(seen > 0);
+    REQUIRE(seen < meshlets.size());
+    moved[3] = glm::vec4(5.0f, 0.0f, 0.5f, 1.0f);
+    for (const OttModel::Meshlet& meshlet : meshlets)
+        REQUIRE_FALSE(OttClusterCuller::isVisible(cluster(meshlet), moved, planes, glm::vec3(0.0f, 0.0f, -10.0f)));
+}
+
+TEST_CASE("Meshlets are shared by instances and skip small ranges", "[meshlets]")
+{
+    OttModel::MeshData mesh;
+    OttTest::grid(100, mesh.vertices, mesh.indices);
+    const OttModel::modelObject large {
+        .startIndex  = 0,
+        .startVertex = 0,
+        .startEdge   = 0,
+        .indexCount  = static_cast<uint32_t>(mesh.indices.size()),
+        .edgeCount   = 0,
+        .textureID   = 0,
+        .pushColorID = glm::vec3(0.0f),
+    };
+    mesh.objects.push_back(large);
+    mesh.objects.push_back(large);
+    mesh.objects[1].transform[3] = glm::vec4(200.0f, 0.0f, 0.0f, 1.0f);
+
+    // A closed range after it, and a small one drawn whole.
+    OttModel::modelObject closed = large;
+    closed.startIndex  = static_cast<uint32_t>(mesh.indices.size());
+    closed.startVertex = static_cast<uint32_t>(mesh.vertices.size());
+    std::vector<OttModel::Vertex> cubeVertices;
+    std::vector<uint32_t> cubeIndices;
+    OttTest::tessellatedCube(30, cubeVertices, cubeIndices);
+    mesh.vertices.insert(mesh.vertices.end(), cubeVertices.begin(), cubeVertices.end());
+    mesh.indices.insert(mesh.indices.end(), cubeIndices.begin(), cubeIndices.end());
+    closed.indexCount = static_cast<uint32_t>(cubeIndices.size());
+    mesh.objects.push_back(closed);
+
+    OttModel::modelObject small = large;
+    small.startIndex  = static_cast<uint32_t>(mesh.indices.size());
+    small.startVertex = static_cast<uint32_t>(mesh.vertices.size());
+    OttTest::grid(4, mesh.vertices, mesh.indices);
+    small.indexCount = static_cast<uint32_t>(mesh.indices.size()) - small.startIndex;
+    mesh.objects.push_back(small);
+    const std::vector<uint32_t> original = mesh.indices;
+
+    const OttMeshlets::MeshletStats stats = OttMeshlets::build(mesh, { .minTriangles = 1024 });
+    REQUIRE(stats.ranges == 2);
+    REQUIRE(stats.triangles == 100 * 100 * 2 + 6 * 30 * 30 * 2);
+    REQUIRE(stats.meshlets == mesh.meshlets.size());
+    REQUIRE(mesh.objects[0].meshletCount > 0);
+    REQUIRE(mesh.objects[1].firstMeshlet == mesh.objects[0].firstMeshlet);
+    REQUIRE(mesh.objects[1].meshletCount == mesh.objects[0].meshletCount);
+    REQUIRE(mesh.objects[3].meshletCount == 0);
+
+    // Only the cube gets cones, and every range still draws its own triangles.
+    REQUIRE(stats.coned > 0);
+    REQUIRE(stats.coned <= mesh.objects[2].meshletCount);
+    for (const OttModel::modelObject& object : mesh.objects)
+    {
+        const auto begin = std::ptrdiff_t(object.startIndex), end = begin + std::ptrdiff_t(object.indexCount);
+        REQUIRE(triangles({ mesh.indices.begin() + begin, mesh.indices.begin() + end })
+                == triangles({ original.begin() + begin, original.begin() + end }));
+
+        uint32_t next = object.startIndex;
+        for (uint32_t m = object.firstMeshlet; m < object.firstMeshlet + object.meshletCount; m++)
+        {
+            REQUIRE(mesh.meshlets[m].startIndex == next);
+            next += mesh.meshlets[m].indexCount;
+        }
+        if (object.meshletCount > 0)
+            REQUIRE(next == object.startIndex + object.indexCount);
+    }
+}
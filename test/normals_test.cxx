@@ -0,0 +1,107 @@
+#include <loader.h>
+#include <normals.h>
+
+#include <cmath>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    glm::vec3 faceNormal(const std::vector<OttModel::Vertex>& vertices, const std::vector<uint32_t>& indices, const size_t t)
+    {
+        const glm::vec3& a = vertices[indices[3 * t]].pos;
+        return glm::normalize(glm::cross(vertices[indices[3 * t + 1]].pos - a, vertices[indices[3 * t + 2]].pos - a));
+    }
+
+    bool near(const glm::vec3& a, const glm::vec3& b)
+    {
+        return glm::length(a - b) < 1e-4f;
+    }
+} // anonymous namespace
+
+TEST_CASE("Creases split the cube into flat faces", "[normals]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::unitCube(false, vertices, indices);
+
+    const OttNormals::NormalStats stats = OttNormals::generate(vertices, indices);
+    REQUIRE(stats.triangles == 12);
+    REQUIRE(stats.splitVertices == 16);
+    REQUIRE(vertices.size() == 24);
+    for (size_t c = 0; c < indices.size(); c++)
+        REQUIRE(near(vertices[indices[c]].normal, faceNormal(vertices, indices, c / 3)));
+
+    // Flat shading splits the same way.
+    std::vector<OttModel::Vertex> flatVertices;
+    std::vector<uint32_t> flatIndices;
+    OttTest::unitCube(false, flatVertices, flatIndices);
+    OttNormals::generate(flatVertices, flatIndices, { .creaseAngleDegrees = 0.0f });
+    REQUIRE(flatVertices.size() == 24);
+}
+
+TEST_CASE("Angle weighting ignores how faces are triangulated", "[normals]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::unitCube(false, vertices, indices);
+    std::vector<OttModel::Vertex> areaVertices = vertices;
+    std::vector<uint32_t> areaIndices = indices;
+
+    // Corners touch one or two triangles of each face; by angle every face counts the same.
+    OttNormals::generate(vertices, indices, { .creaseAngleDegrees = 180.0f });
+    REQUIRE(vertices.size() == 8);
+    for (const OttModel::Vertex& vertex : vertices)
+        REQUIRE(near(vertex.normal, glm::normalize(vertex.pos - glm::vec3(0.5f))));
+
+    OttNormals::generate(areaVertices, areaIndices, { .weighting = OttNormals::Weighting::Area, .creaseAngleDegrees = 180.0f });
+    REQUIRE(areaVertices.size() == 8);
+    REQUIRE(!near(areaVertices[1].normal, glm::normalize(areaVertices[1].pos - glm::vec3(0.5f))));
+    for (const OttModel::Vertex& vertex : areaVertices)
+        REQUIRE(glm::dot(vertex.normal, vertex.pos - glm::vec3(0.5f)) > 0.0f);
+}
+
+TEST_CASE("UV seams share the normal of their position", "[normals]")
+{
+    // Two triangles folded by 20 degrees along x, the fold duplicated with other UVs.
+    const float rise = std::tan(glm::radians(20.0f));
+    std::vector<OttModel::Vertex> vertices {
+        { .pos = glm::vec3(0.0f, 0.0f, 0.0f), .texCoord = glm::vec2(0.0f) },
+        { .pos = glm::vec3(1.0f, 0.0f, 0.0f), .texCoord = glm::vec2(0.0f) },
+        { .pos = glm::vec3(0.5f, -1.0f, 0.0f) },
+        { .pos = glm::vec3(0.0f, 0.0f, 0.0f), .texCoord = glm::vec2(1.0f) },
+        { .pos = glm::vec3(1.0f, 0.0f, 0.0f), .texCoord = glm::vec2(1.0f) },
+        { .pos = glm::vec3(0.5f, 1.0f, rise) },
+    };
+    std::vector<uint32_t> indices { 0, 2, 1, 3, 4, 5 };
+    // Degenerate triangles don't count.
+    vertices.push_back({ .pos = glm::vec3(4.0f) });
+    indices.insert(indices.end(), { 6, 6, 6 });
+
+    OttNormals::generate(vertices, indices);
+    REQUIRE(vertices.size() == 7);
+    REQUIRE(near(vertices[0].normal, vertices[3].normal));
+    REQUIRE(near(vertices[1].normal, vertices[4].normal));
+    REQUIRE(vertices[0].normal.z > 0.9f);
+    REQUIRE(vertices[0].normal.y < 0.0f);
+    REQUIRE(vertices[6].normal == glm::vec3(0.0f));
+}
+
+TEST_CASE("loadObj generates normals for files without them", "[normals]")
+{
+    const auto path = OttTest::writeTempFile("normals_cube.obj", OttTest::UNIT_CUBE_OBJ);
+
+    OttModel::MeshData plain, generated;
+    REQUIRE(OttLoader::loadObj(path, plain));
+    REQUIRE(OttLoader::loadObj(path, generated, { .normals = OttNormals::NormalOptions{} }));
+    REQUIRE(plain.vertices.size() == 8);
+    REQUIRE(plain.vertices[0].normal == glm::vec3(0.0f));
+    REQUIRE(generated.vertices.size() == 24);
+    REQUIRE(generated.objects[0].indexCount == 36);
+    for (const OttModel::Vertex& vertex : generated.vertices)
+        REQUIRE(std::abs(glm::length(vertex.normal) - 1.0f) < 1e-4f);
+    REQUIRE(OttLoader::LoadOptions{ .normals = OttNormals::NormalOptions{} }.fingerprint() != OttLoader::LoadOptions{}.fingerprint());
+}
@@ -0,0 +1,165 @@
+#include <objloader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    struct ObjResult
+    {
+        tinyobj::attrib_t                attrib;
+        std::vector<tinyobj::shape_t>    shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string                      warn, err;
+        bool                             ok = false;
+    };
+
+    ObjResult loadWithTinyObj(const std::filesystem::path& path)
+    {
+        ObjResult r;
+        const auto baseDir = path.parent_path().string() + "/";
+        r.ok = tinyobj::LoadObj(&r.attrib, &r.shapes, &r.materials, &r.warn, &r.err, path.string().c_str(), baseDir.c_str());
+        return r;
+    }
+
+    ObjResult loadWithOttObj(const std::filesystem::path& path)
+    {
+        ObjResult r;
+        r.ok = OttObj::LoadObj(&r.attrib, &r.shapes, &r.materials, &r.warn, &r.err, path, path.parent_path());
+        return r;
+    }
+
+    // tinyobj's own float parser is not correctly rounded, so allow for a last-digit difference.
+    void requireNearlyEqual(const std::vector<tinyobj::real_t>& actual, const std::vector<tinyobj::real_t>& expected)
+    {
+        REQUIRE(actual.size() == expected.size());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (std::abs(actual[i] - expected[i]) > 1e-6f * std::max(1.0f, std::abs(expected[i])))
+                mismatches++;
+        }
+        REQUIRE(mismatches == 0);
+    }
+
+    void requireSameOutput(const ObjResult& expected, const ObjResult& actual)
+    {
+        REQUIRE(expected.ok);
+        REQUIRE(actual.ok);
+        requireNearlyEqual(actual.attrib.vertices, expected.attrib.vertices);
+        requireNearlyEqual(actual.attrib.colors, expected.attrib.colors);
+        requireNearlyEqual(actual.attrib.texcoords, expected.attrib.texcoords);
+        requireNearlyEqual(actual.attrib.normals, expected.attrib.normals);
+        REQUIRE(actual.materials.size() == expected.materials.size());
+        REQUIRE(actual.shapes.size()    == expected.shapes.size());
+        for (size_t s = 0; s < expected.shapes.size(); s++)
+        {
+            const auto& e = expected.shapes[s];
+            const auto& a = actual.shapes[s];
+            REQUIRE(a.name == e.name);
+            REQUIRE(a.mesh.indices.size() == e.mesh.indices.size());
+            for (size_t i = 0; i < e.mesh.indices.size(); i++)
+            {
+                REQUIRE(a.mesh.indices[i].vertex_index   == e.mesh.indices[i].vertex_index);
+                REQUIRE(a.mesh.indices[i].texcoord_index == e.mesh.indices[i].texcoord_index);
+                REQUIRE(a.mesh.indices[i].normal_index   == e.mesh.indices[i].normal_index);
+            }
+            REQUIRE(a.mesh.material_ids        == e.mesh.material_ids);
+            REQUIRE(a.mesh.smoothing_group_ids == e.mesh.smoothing_group_ids);
+        }
+    }
+
+    std::filesystem::path writeSyntheticObj(const size_t target_bytes)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> coord(-500.0f, 500.0f);
+        std::string text;
+        text.reserve(target_bytes + 256);
+        size_t vertexCount = 0;
+        for (size_t group = 0; text.size() < target_bytes; group++)
+        {
+            text += "g wall_" + std::to_string(group) + "\n";
+            for (int i = 0; i < 4096; i++, vertexCount++)
+                text += "v " + std::to_string(coord(rng)) + " " + std::to_string(coord(rng)) + " " + std::to_string(coord(rng)) + "\n";
+            for (size_t i = vertexCount - 4096; i + 3 < vertexCount; i += 2)
+            {
+                text += "f " + std::to_string(i + 1) + " " + std::to_string(i + 2) + " " + std::to_string(i + 3) + " " + std::to_string(i + 4) + "\n";
+                text += "f -1 -2 -3\n";
+            }
+        }
+        return OttTest::writeTempFile("synthetic.obj", text);
+    }
+} // anonymous namespace
+
+TEST_CASE("OttObj::parseFloat matches strtod", "[objloader]")
+{
+    for (const std::string number : { "0", "-1", "3.25", "0.000123", "-42.5e3", "1e-7", "6.02214076e23", "12345678901234567890.5",
+                                      "1.25e-2147483647", "1.25e2147483647", "-0.5e-99999999999" })
+    {
+        const char* cursor = number.data();
+        float value = 0.0f;
+        REQUIRE(OttObj::parseFloat(cursor, number.data() + number.size(), value));
+        REQUIRE(value == static_cast<float>(std::strtod(number.c_str(), nullptr)));
+        REQUIRE(cursor == number.data() + number.size());
+    }
+}
+
+TEST_CASE("OttObj::LoadObj matches tinyobj", "[objloader]")
+{
+    OttTest::writeTempFile("walls.mtl",
+        "newmtl concrete\nKd 0.5 0.5 0.5\n"
+        "newmtl glass\nKd 0.2 0.4 0.8\n");
+    const auto objPath = OttTest::writeTempFile("walls.obj",
+        "# exported wall assembly\n"
+        "mtllib walls.mtl\n"
+        "v 0 0 0\nv 2 0 0\nv 2 3 0\nv 0 3 0\r\n"
+        "v 0 0 1 0.1 0.2 0.3\n"
+        "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+        "vn 0 0 1\n"
+        "g wall north\n"
+        "usemtl concrete\n"
+        "s 1\n"
+        "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+        "o window\n"
+        "usemtl glass\n"
+        "s off\n"
+        "f -5//-1 -4//-1 -1//-1\n"
+        "f 1 3 5\n");
+
+    requireSameOutput(loadWithTinyObj(objPath), loadWithOttObj(objPath));
+}
+
+TEST_CASE("OttObj::LoadObj matches tinyobj across chunks", "[objloader]")
+{
+    const auto objPath = writeSyntheticObj(4 << 20);
+    requireSameOutput(loadWithTinyObj(objPath), loadWithOttObj(objPath));
+}
+
+TEST_CASE("OttObj::LoadObj throughput", "[.][benchmark]")
+{
+    auto measure = [](const std::filesystem::path& path)
+    {
+        OttObj::ParseStats stats;
+        ObjResult r;
+        REQUIRE(OttObj::LoadObj(&r.attrib, &r.shapes, &r.materials, &r.warn, &r.err, path, path.parent_path(), &stats));
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        ObjResult reference = loadWithTinyObj(path);
+        const double tinyobjSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        REQUIRE(reference.ok);
+
+        WARN(path.filename().string() << ": OttObj " << stats.megabytesPerSecond() << " MB/s over "
+             << stats.chunks << " chunks, tinyobj " << static_cast<double>(stats.bytes) / (1024.0 * 1024.0) / tinyobjSeconds << " MB/s");
+    };
+
+    measure(std::filesystem::path(OTT_SOURCE_RESOURCE_DIR) / "models" / "viking_room.obj");
+    measure(writeSyntheticObj(256 << 20));
+}
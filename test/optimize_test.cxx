@@ -0,0 +1,224 @@
+#include <model.h>
+#include <optimize.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+namespace
+{
+    //----------------------------------------------------------------------------
+    /** Two triangles per cell over a (cells + 1)^2 vertex grid, with the triangles
+     *  shuffled as the face order of a careless export would be. **/
+    void shuffledGrid(const uint32_t cells_per_side, std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::vector<uint32_t> ordered;
+        OttTest::grid(cells_per_side, vertices, ordered);
+        std::vector<std::array<uint32_t, 3>> triangles;
+        for (size_t t = 0; t < ordered.size(); t += 3)
+            triangles.push_back({ ordered[t], ordered[t + 1], ordered[t + 2] });
+        std::ranges::shuffle(triangles, std::mt19937(16));
+        for (const std::array<uint32_t, 3>& triangle : triangles)
+            indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+
+    //----------------------------------------------------------------------------
+    /** A sphere of stacks x slices quads around the origin, wound counter-clockwise seen
+     *  from outside. **/
+    void sphere(const uint32_t stacks, const uint32_t slices, std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        for (uint32_t i = 0; i <= stacks; i++)
+        {
+            const float theta = 3.14159265f * float(i) / float(stacks);
+            for (uint32_t j = 0; j <= slices; j++)
+            {
+                const float phi = 2.0f * 3.14159265f * float(j) / float(slices);
+                vertices.push_back({ .pos = glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)) });
+            }
+        }
+        for (uint32_t i = 0; i < stacks; i++)
+        {
+            for (uint32_t j = 0; j < slices; j++)
+            {
+                const uint32_t a = i * (slices + 1) + j, b = a + 1, c = a + slices + 1, d = c + 1;
+                indices.insert(indices.end(), { a, c, d, a, d, b });
+            }
+        }
+    }
+
+    // Triangles as their corner positions, in winding order, for comparing across renumbering.
+    std::multiset<std::array<float, 9>> corners(const std::vector<OttModel::Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                                const size_t start, const size_t count)
+    {
+        std::multiset<std::array<float, 9>> result;
+        for (size_t i = start; i + 2 < start + count; i += 3)
+        {
+            std::array<glm::vec3, 3> triangle { vertices[indices[i]].pos, vertices[indices[i + 1]].pos, vertices[indices[i + 2]].pos };
+            std::ranges::rotate(triangle, std::ranges::min_element(triangle, [](const glm::vec3& a, const glm::vec3& b)
+            {
+                return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+            }));
+            result.insert({ triangle[0].x, triangle[0].y, triangle[0].z, triangle[1].x, triangle[1].y, triangle[1].z,
+                            triangle[2].x, triangle[2].y, triangle[2].z });
+        }
+        return result;
+    }
+} // anonymous namespace
+
+TEST_CASE("Cache analysis counts vertex shader invocations", "[optimize]")
+{
+    const std::vector<uint32_t> strip { 0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5 };
+    const OttOptimize::CacheStats shared = OttOptimize::analyzeCache(strip, 16);
+    REQUIRE(shared.triangles == 4);
+    REQUIRE(shared.vertices  == 6);
+    REQUIRE(shared.misses    == 6);
+    REQUIRE(shared.atvr()    == 1.0);
+
+    // Vertex 0 falls out of a three entry cache before it comes back.
+    const std::vector<uint32_t> revisit { 0, 1, 2, 3, 4, 5, 0, 4, 5 };
+    REQUIRE(OttOptimize::analyzeCache(revisit, 3).misses == 7);
+    REQUIRE(OttOptimize::analyzeCache(revisit, 16).misses == 6);
+    REQUIRE(OttOptimize::analyzeCache(std::vector<uint32_t>{}, 16).acmr() == 0.0);
+}
+
+TEST_CASE("Vertex cache order keeps every triangle and its winding", "[optimize]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    shuffledGrid(100, vertices, indices);
+    const std::vector<uint32_t> original = indices;
+
+    const OttOptimize::CacheStats before = OttOptimize::analyzeCache(indices, 16);
+    OttOptimize::optimizeVertexCache(indices);
+    const OttOptimize::CacheStats after = OttOptimize::analyzeCache(indices, 16);
+    REQUIRE(before.acmr() > 2.0);
+    REQUIRE(after.acmr() < 0.8);
+    REQUIRE(after.atvr() < 1.5);
+
+    std::multiset<std::array<uint32_t, 3>> expected, reordered;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        expected.insert({ original[i], original[i + 1], original[i + 2] });
+        reordered.insert({ indices[i], indices[i + 1], indices[i + 2] });
+    }
+    REQUIRE(reordered == expected);
+
+    // Indices far apart, as in a meshlet of a large range, and nothing to reorder.
+    std::vector<uint32_t> sparse { 1000000, 5, 70000, 5, 70000, 3000000 };
+    OttOptimize::optimizeVertexCache(sparse);
+    REQUIRE(std::ranges::count(sparse, 5u) == 2);
+    std::vector<uint32_t> single { 0, 1, 2 };
+    OttOptimize::optimizeVertexCache(single);
+    REQUIRE(single == std::vector<uint32_t>{ 0, 1, 2 });
+}
+
+TEST_CASE("Overdraw order stays within its cache budget", "[optimize]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    sphere(64, 128, vertices, indices);
+    OttOptimize::optimizeVertexCache(indices);
+    const std::vector<uint32_t> cacheOrder = indices;
+    const double acmr = OttOptimize::analyzeCache(indices, 16).acmr();
+
+    OttOptimize::optimizeOverdraw(vertices, indices, 1.05f, 16);
+    REQUIRE(indices != cacheOrder);
+    REQUIRE(OttOptimize::analyzeCache(indices, 16).acmr() <= acmr * 1.05 + 0.02);
+    REQUIRE(corners(vertices, indices, 0, indices.size()) == corners(vertices, cacheOrder, 0, cacheOrder.size()));
+
+    std::vector<uint32_t> unchanged = cacheOrder;
+    OttOptimize::optimizeOverdraw(vertices, unchanged, 0.0f, 16);
+    REQUIRE(unchanged == cacheOrder);
+}
+
+TEST_CASE("Mesh optimization renumbers vertices in order of first use", "[optimize]")
+{
+    OttModel::MeshData mesh;
+    shuffledGrid(40, mesh.vertices, mesh.indices);
+    const uint32_t gridIndices = static_cast<uint32_t>(mesh.indices.size());
+    for (size_t i = 0; i < gridIndices; i += 3)
+    {
+        mesh.edges.push_back(mesh.indices[i]);
+        mesh.edges.push_back(mesh.indices[i + 1]);
+    }
+
+    // An instance of the grid, a coarser level made of its first triangles, and a second object.
+    const OttModel::modelObject grid {
+        .startIndex  = 0,
+        .startVertex = 0,
+        .startEdge   = 0,
+        .indexCount  = gridIndices,
+        .edgeCount   = static_cast<uint32_t>(mesh.edges.size()),
+        .textureID   = 0,
+        .pushColorID = glm::vec3(0.0f),
+    };
+    mesh.objects.push_back(grid);
+    mesh.objects.push_back(grid);
+    mesh.objects[0].lods[0] = { .startIndex = gridIndices, .indexCount = 300, .error = 0.0f };
+    mesh.objects[0].lodCount = 1;
+    mesh.objects[1].lods = mesh.objects[0].lods;
+    mesh.objects[1].lodCount = 1;
+    mesh.indices.insert(mesh.indices.end(), mesh.indices.begin(), mesh.indices.begin() + 300);
+
+    OttModel::modelObject ball = grid;
+    ball.startIndex  = static_cast<uint32_t>(mesh.indices.size());
+    ball.startVertex = static_cast<uint32_t>(mesh.vertices.size());
+    ball.startEdge   = static_cast<uint32_t>(mesh.edges.size());
+    ball.edgeCount   = 0;
+    std::vector<OttModel::Vertex> ballVertices;
+    std::vector<uint32_t> ballIndices;
+    sphere(16, 32, ballVertices, ballIndices);
+    mesh.vertices.insert(mesh.vertices.end(), ballVertices.begin(), ballVertices.end());
+    mesh.indices.insert(mesh.indices.end(), ballIndices.begin(), ballIndices.end());
+    ball.indexCount = static_cast<uint32_t>(ballIndices.size());
+    mesh.objects.push_back(ball);
+    const OttModel::MeshData original = mesh;
+
+    const OttOptimize::OptimizeStats stats = OttOptimize::optimize(mesh);
+    REQUIRE(stats.ranges == 3);
+    REQUIRE(stats.after.acmr() < stats.before.acmr());
+    REQUIRE(stats.remapped > 0);
+    REQUIRE(mesh.vertices.size() == original.vertices.size());
+
+    // Every range draws the same faces, on the same side, and the edges join the same points.
+    for (const auto& [start, count, vertex] : { std::array{ 0u, gridIndices, 0u }, std::array{ gridIndices, 300u, 0u },
+                                                std::array{ ball.startIndex, ball.indexCount, ball.startVertex } })
+    {
+        std::vector<OttModel::Vertex> before(original.vertices.begin() + vertex, original.vertices.end());
+        std::vector<OttModel::Vertex> after(mesh.vertices.begin() + vertex, mesh.vertices.end());
+        REQUIRE(corners(after, mesh.indices, start, count) == corners(before, original.indices, start, count));
+    }
+    std::multiset<std::pair<float, float>> edgesBefore, edgesAfter;
+    for (size_t i = 0; i < mesh.edges.size(); i++)
+    {
+        edgesBefore.emplace(original.vertices[original.edges[i]].pos.x, original.vertices[original.edges[i]].pos.y);
+        edgesAfter.emplace(mesh.vertices[mesh.edges[i]].pos.x, mesh.vertices[mesh.edges[i]].pos.y);
+    }
+    REQUIRE(edgesAfter == edgesBefore);
+
+    // The full range reads the grid's vertices front to back.
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < gridIndices; i++)
+    {
+        REQUIRE(mesh.indices[i] <= next);
+        next = std::max(next, mesh.indices[i] + 1);
+    }
+}
+
+TEST_CASE("Vertex cache optimization of a large shuffled grid", "[.][benchmark]")
+{
+    OttModel::MeshData mesh;
+    shuffledGrid(1000, mesh.vertices, mesh.indices);
+    mesh.objects.push_back({ .indexCount = static_cast<uint32_t>(mesh.indices.size()) });
+    const OttOptimize::OptimizeStats stats = OttOptimize::optimize(mesh);
+    REQUIRE(stats.after.acmr() < stats.before.acmr());
+    WARN("ACMR " << stats.before.acmr() << " -> " << stats.after.acmr() << ", ATVR " << stats.before.atvr() << " -> "
+         << stats.after.atvr() << " for " << stats.after.triangles << " triangles in " << stats.seconds << "s");
+}
@@ -0,0 +1,129 @@
+#include <loader.h>
+#include <model.h>
+
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    float maxAxisError(const glm::vec3& a, const glm::vec3& b)
+    {
+        return std::max(std::abs(a.x - b.x), std::max(std::abs(a.y - b.y), std::abs(a.z - b.z)));
+    }
+} // anonymous namespace
+
+TEST_CASE("Packed vertices round trip within their quantization steps", "[packedvertex]")
+{
+    REQUIRE(sizeof(OttModel::PackedVertex) == 20);
+    REQUIRE(OttModel::vertexStride(OttModel::VertexFormat::Packed) == 20);
+    REQUIRE(OttModel::vertexStride(OttModel::VertexFormat::Float) == sizeof(OttModel::Vertex));
+
+    const glm::vec3 offset(-12.0f, 3.0f, 100.0f);
+    const glm::vec3 scale(40.0f, 0.5f, 7.0f);
+    std::mt19937 random(17);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f), signedUnit(-1.0f, 1.0f), uv(-2.0f, 4.0f);
+    float positionError = 0.0f, normalAngle = 0.0f, uvError = 0.0f;
+    for (int i = 0; i < 10000; i++)
+    {
+        glm::vec3 normal(signedUnit(random), signedUnit(random), signedUnit(random));
+        if (glm::length(normal) < 0.01f)
+            continue;
+        const OttModel::Vertex vertex {
+            .pos      = offset + scale * glm::vec3(unit(random), unit(random), unit(random)),
+            .color    = glm::vec3(unit(random), unit(random), unit(random)),
+            .texCoord = glm::vec2(uv(random), uv(random)),
+            .normal   = glm::normalize(normal),
+        };
+        const OttModel::Vertex decoded = OttModel::unpackVertex(OttModel::packVertex(vertex, offset, scale), offset, scale);
+        positionError = std::max(positionError, maxAxisError(decoded.pos, vertex.pos) / 40.0f);
+        normalAngle   = std::max(normalAngle, std::acos(std::min(1.0f, glm::dot(decoded.normal, vertex.normal))));
+        uvError       = std::max(uvError, std::max(std::abs(decoded.texCoord.x - vertex.texCoord.x),
+                                                   std::abs(decoded.texCoord.y - vertex.texCoord.y)));
+        REQUIRE(maxAxisError(decoded.color, vertex.color) <= 0.5f / 255.0f + 1e-6f);
+    }
+    // Half a step of the box's longest side, under 0.06 degrees of normal (float acos near 1
+    // included), half a half float ulp at 4.
+    REQUIRE(positionError <= 0.5f / 65535.0f + 1e-6f);
+    REQUIRE(normalAngle < 0.001f);
+    REQUIRE(uvError <= 0.002f);
+
+    // Flat boxes and zero normals stay well defined.
+    const OttModel::Vertex flat { .pos = glm::vec3(1.0f, 2.0f, 3.0f), .normal = glm::vec3(0.0f) };
+    const OttModel::Vertex decoded = OttModel::unpackVertex(OttModel::packVertex(flat, flat.pos, glm::vec3(0.0f)), flat.pos, glm::vec3(0.0f));
+    REQUIRE(decoded.pos == flat.pos);
+    REQUIRE(decoded.normal == glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+TEST_CASE("Quantization boxes follow the vertex ranges", "[packedvertex]")
+{
+    OttModel::MeshData mesh;
+    for (int i = 0; i < 4; i++)
+        mesh.vertices.push_back({ .pos = glm::vec3(float(i), 0.0f, -float(i)) });
+    for (int i = 0; i < 3; i++)
+        mesh.vertices.push_back({ .pos = glm::vec3(100.0f, 100.0f + float(i), 100.0f) });
+    // Two instances of the first range, listed after the second range.
+    mesh.objects.push_back({ .startVertex = 4 });
+    mesh.objects.push_back({ .startVertex = 0 });
+    mesh.objects.push_back({ .startVertex = 0 });
+
+    OttModel::quantize(mesh);
+    REQUIRE(mesh.objects[0].quantOffset == glm::vec3(100.0f, 100.0f, 100.0f));
+    REQUIRE(mesh.objects[0].quantScale  == glm::vec3(0.0f, 2.0f, 0.0f));
+    REQUIRE(mesh.objects[1].quantOffset == glm::vec3(0.0f, 0.0f, -3.0f));
+    REQUIRE(mesh.objects[1].quantScale  == glm::vec3(3.0f, 0.0f, 3.0f));
+    REQUIRE(mesh.objects[2].quantOffset == mesh.objects[1].quantOffset);
+
+    std::vector<OttModel::PackedVertex> packed(mesh.vertices.size());
+    OttModel::packVertices(mesh, packed);
+    for (size_t v = 0; v < mesh.vertices.size(); v++)
+    {
+        const OttModel::modelObject& object = mesh.objects[v < 4 ? 1 : 0];
+        REQUIRE(maxAxisError(OttModel::unpackVertex(packed[v], object.quantOffset, object.quantScale).pos, mesh.vertices[v].pos) < 1e-4f);
+    }
+}
+
+TEST_CASE("Vertex streams split every format after its position", "[packedvertex]")
+{
+    // Position only passes fetch 12 bytes per float vertex and 8 per packed one.
+    REQUIRE(OttModel::positionStride(OttModel::VertexFormat::Float)  == 12);
+    REQUIRE(OttModel::positionStride(OttModel::VertexFormat::Packed) == 8);
+
+    auto requireStreams = [](const OttModel::VertexFormat format, const auto& bindings, const auto& attributes)
+    {
+        REQUIRE(bindings[0].stride == OttModel::positionStride(format));
+        REQUIRE(bindings[1].stride == OttModel::attributeStride(format));
+        REQUIRE(attributes[0].binding == 0);
+        REQUIRE(attributes[0].offset  == 0);
+        for (size_t a = 1; a < attributes.size(); a++)
+        {
+            REQUIRE(attributes[a].location == a);
+            REQUIRE(attributes[a].binding  == 1);
+            REQUIRE(attributes[a].offset   <  bindings[1].stride);
+        }
+    };
+    requireStreams(OttModel::VertexFormat::Float, OttModel::Vertex::getBindingDescriptions(), OttModel::Vertex::getAttributeDescriptions());
+    requireStreams(OttModel::VertexFormat::Packed, OttModel::PackedVertex::getBindingDescriptions(),
+                   OttModel::PackedVertex::getAttributeDescriptions());
+}
+
+TEST_CASE("Packed vertex memory of viking_room.obj", "[.][benchmark]")
+{
+    OttModel::MeshData mesh;
+    REQUIRE(OttLoader::loadMesh(std::filesystem::path(OTT_SOURCE_RESOURCE_DIR) / "models" / "viking_room.obj", mesh));
+    OttModel::quantize(mesh);
+    std::vector<OttModel::PackedVertex> packed(mesh.vertices.size());
+    OttModel::packVertices(mesh, packed);
+
+    // A single object, so one box spans every vertex.
+    REQUIRE(mesh.objects.size() == 1);
+    const OttModel::modelObject& object = mesh.objects.front();
+    float positionError = 0.0f;
+    for (size_t v = 0; v < mesh.vertices.size(); v++)
+        positionError = std::max(positionError, maxAxisError(OttModel::unpackVertex(packed[v], object.quantOffset, object.quantScale).pos, mesh.vertices[v].pos));
+    WARN(mesh.vertices.size() << " vertices: " << mesh.vertices.size() * sizeof(OttModel::Vertex) << " bytes as float, "
+         << packed.size() * sizeof(OttModel::PackedVertex) << " packed, largest position error " << positionError);
+}
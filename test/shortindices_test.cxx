@@ -0,0 +1,84 @@
+#include <model.h>
+
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // Indices of range, read from whichever pool the object draws from.
+    std::vector<uint32_t> rangeOf(const OttModel::MeshData& mesh, const bool short_indices, const uint32_t start, const uint32_t count)
+    {
+        std::vector<uint32_t> result;
+        for (uint32_t i = start; i < start + count; i++)
+            result.push_back(short_indices ? mesh.shortIndices[i] : mesh.indices[i]);
+        return result;
+    }
+} // anonymous namespace
+
+TEST_CASE("Small objects move to 16-bit indices", "[shortindices]")
+{
+    OttModel::MeshData mesh;
+    // A large range first, a small one with a simplified level, and an instance of the small one.
+    for (uint32_t i = 0; i < 300; i++)
+        mesh.indices.push_back(i % 3 == 0 ? 70000 + i : i);
+    for (uint32_t i = 0; i < 30; i++)
+        mesh.indices.push_back(i);
+    mesh.indices.insert(mesh.indices.end(), { 0, 1, 2 });
+    for (uint32_t i = 0; i < 60; i++)
+        mesh.indices.push_back(100000 - i);
+
+    mesh.objects.push_back({ .startIndex = 0, .indexCount = 300 });
+    OttModel::modelObject small { .startIndex = 300, .startVertex = 80000, .indexCount = 30 };
+    small.lods[0]  = { .startIndex = 330, .indexCount = 3, .error = 0.1f };
+    small.lodCount = 1;
+    mesh.objects.push_back(small);
+    mesh.objects.push_back(small);
+    mesh.objects.push_back({ .startIndex = 333, .indexCount = 60, .meshletCount = 1 });
+    mesh.meshlets.push_back({ .startIndex = 363, .indexCount = 30 });
+    const OttModel::MeshData original = mesh;
+
+    OttModel::splitShortIndices(mesh);
+    REQUIRE(mesh.shortIndices.size() == 33);
+    REQUIRE(mesh.indices.size() == 360);
+    REQUIRE(!mesh.objects[0].shortIndices);
+    REQUIRE(mesh.objects[1].shortIndices);
+    REQUIRE(mesh.objects[2].shortIndices);
+    REQUIRE(!mesh.objects[3].shortIndices);
+    REQUIRE(mesh.objects[2].startIndex == mesh.objects[1].startIndex);
+
+    // Every range still reads the same indices.
+    for (size_t o = 0; o < mesh.objects.size(); o++)
+    {
+        const OttModel::modelObject& before = original.objects[o];
+        const OttModel::modelObject& after  = mesh.objects[o];
+        REQUIRE(rangeOf(mesh, after.shortIndices, after.startIndex, after.indexCount) ==
+                rangeOf(original, false, before.startIndex, before.indexCount));
+        for (uint32_t level = 0; level < after.lodCount; level++)
+        {
+            REQUIRE(rangeOf(mesh, after.shortIndices, after.lods[level].startIndex, after.lods[level].indexCount) ==
+                    rangeOf(original, false, before.lods[level].startIndex, before.lods[level].indexCount));
+        }
+    }
+    REQUIRE(mesh.meshlets[0].startIndex == 330);
+    REQUIRE(rangeOf(mesh, false, 330, 30) == rangeOf(original, false, 363, 30));
+}
+
+TEST_CASE("Objects sharing a range with a large one stay 32-bit", "[shortindices]")
+{
+    OttModel::MeshData mesh;
+    mesh.indices = { 0, 1, 2, 0, 2, 3, 0, 1, 70000 };
+    // Both draw the first six indices, the second also a level that needs 32 bits.
+    mesh.objects.push_back({ .startIndex = 0, .indexCount = 6 });
+    OttModel::modelObject coarse { .startIndex = 0, .indexCount = 6 };
+    coarse.lods[0]  = { .startIndex = 6, .indexCount = 3, .error = 0.0f };
+    coarse.lodCount = 1;
+    mesh.objects.push_back(coarse);
+
+    const OttModel::MeshData original = mesh;
+    OttModel::splitShortIndices(mesh);
+    REQUIRE(mesh.shortIndices.empty());
+    REQUIRE(!mesh.objects[0].shortIndices);
+    REQUIRE(!mesh.objects[1].shortIndices);
+    REQUIRE(mesh.indices == original.indices);
+}
@@ -0,0 +1,210 @@
+#include <model.h>
+#include <simplify.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    //----------------------------------------------------------------------------
+    /** Two triangles per cell over a (cells + 1)^2 vertex grid of unit cells, with its
+     *  heights from height(x, y) and its texture coordinates from the grid position. **/
+    OttModel::MeshData grid(const uint32_t cells_per_side, const std::function<float(float, float)>& height)
+    {
+        OttModel::MeshData mesh;
+        const uint32_t row = cells_per_side + 1;
+        for (uint32_t y = 0; y <= cells_per_side; y++)
+        {
+            for (uint32_t x = 0; x <= cells_per_side; x++)
+            {
+                const float fx = float(x), fy = float(y);
+                mesh.vertices.push_back({ .pos = glm::vec3(fx, fy, height(fx, fy)), .texCoord = glm::vec2(fx, fy) / float(cells_per_side) });
+            }
+        }
+        for (uint32_t y = 0; y < cells_per_side; y++)
+        {
+            for (uint32_t x = 0; x < cells_per_side; x++)
+            {
+                const uint32_t a = y * row + x, b = a + 1, c = a + row, d = c + 1;
+                mesh.indices.insert(mesh.indices.end(), { a, b, d, a, d, c });
+            }
+        }
+        mesh.objects.push_back({
+            .startIndex  = 0,
+            .startVertex = 0,
+            .startEdge   = 0,
+            .indexCount  = static_cast<uint32_t>(mesh.indices.size()),
+            .edgeCount   = 0,
+            .textureID   = 0,
+            .pushColorID = glm::vec3(0.0f),
+        });
+        return mesh;
+    }
+
+    float flat(float, float) { return 0.0f; }
+
+    // Area of the triangles projected onto the ground plane, signed by their winding.
+    double projectedArea(const std::vector<OttModel::Vertex>& vertices, const std::vector<uint32_t>& indices)
+    {
+        double area = 0.0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec3& a = vertices[indices[i]].pos;
+            const glm::vec3& b = vertices[indices[i + 1]].pos;
+            const glm::vec3& c = vertices[indices[i + 2]].pos;
+            area += 0.5 * (double(b.x - a.x) * double(c.y - a.y) - double(b.y - a.y) * double(c.x - a.x));
+        }
+        return area;
+    }
+} // anonymous namespace
+
+TEST_CASE("Simplification of a flat grid keeps its outline", "[simplify]")
+{
+    const OttModel::MeshData mesh = grid(32, flat);
+    const size_t target = mesh.indices.size() / 8;
+
+    float error = -1.0f;
+    const std::vector<uint32_t> simplified = OttSimplify::simplify(mesh.vertices, mesh.indices, target, 1e-3f, &error);
+    REQUIRE(simplified.size() <= target);
+    REQUIRE(simplified.size() % 3 == 0);
+    REQUIRE(error >= 0.0f);
+    REQUIRE(error <= 1e-3f);
+
+    // Every face keeps its winding and the boundary stays where it was, so no area is lost.
+    REQUIRE(std::abs(projectedArea(mesh.vertices, simplified) - 32.0 * 32.0) < 1e-6);
+    for (size_t i = 0; i < simplified.size(); i += 3)
+    {
+        const std::vector<uint32_t> face(simplified.begin() + static_cast<std::ptrdiff_t>(i), simplified.begin() + static_cast<std::ptrdiff_t>(i + 3));
+        REQUIRE(projectedArea(mesh.vertices, face) > 0.0);
+    }
+
+    // The corners can't slide anywhere.
+    for (const uint32_t corner : { 0u, 32u, 33u * 32u, 33u * 33u - 1u })
+        REQUIRE(std::ranges::find(simplified, corner) != simplified.end());
+
+    // Nothing to do below the target, and nothing is allowed without an error budget on a curved surface.
+    REQUIRE(OttSimplify::simplify(mesh.vertices, mesh.indices, mesh.indices.size(), 1.0f) == mesh.indices);
+    const OttModel::MeshData dome = grid(16, [](float x, float y) { return -0.05f * ((x - 8.0f) * (x - 8.0f) + (y - 8.0f) * (y - 8.0f)); });
+    REQUIRE(OttSimplify::simplify(dome.vertices, dome.indices, 0, 0.0f) == dome.indices);
+}
+
+TEST_CASE("Simplification stays within the error bound", "[simplify]")
+{
+    const OttModel::MeshData mesh = grid(48, [](float x, float y) { return std::sin(x * 0.2f) * std::cos(y * 0.15f); });
+
+    float previousError = 0.0f;
+    size_t previousSize = mesh.indices.size();
+    for (const float bound : { 0.01f, 0.05f, 0.2f })
+    {
+        float error = -1.0f;
+        const std::vector<uint32_t> simplified = OttSimplify::simplify(mesh.vertices, mesh.indices, 0, bound, &error);
+        REQUIRE(error <= bound);
+        REQUIRE(error >= previousError);
+        REQUIRE(simplified.size() < previousSize);
+        REQUIRE(!simplified.empty());
+        previousError = error;
+        previousSize  = simplified.size();
+    }
+}
+
+TEST_CASE("Simplification keeps texture seams", "[simplify]")
+{
+    // The right half of the grid gets its own copies of the vertices on the middle column,
+    // with different texture coordinates, as an unwrapped model would.
+    OttModel::MeshData mesh = grid(32, flat);
+    const uint32_t row = 33;
+    std::vector<uint32_t> copyOf(mesh.vertices.size(), UINT32_MAX);
+    for (uint32_t y = 0; y <= 32; y++)
+    {
+        OttModel::Vertex copy = mesh.vertices[y * row + 16];
+        copy.texCoord.x += 1.0f;
+        copyOf[y * row + 16] = static_cast<uint32_t>(mesh.vertices.size());
+        mesh.vertices.push_back(copy);
+    }
+    auto rightHalf = [&](const std::vector<uint32_t>& indices, const size_t i)
+    {
+        float x = 0.0f;
+        for (size_t k = 0; k < 3; k++)
+            x += mesh.vertices[indices[i + k]].pos.x;
+        return x > 3.0f * 16.0f;
+    };
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        if (!rightHalf(mesh.indices, i))
+            continue;
+        for (size_t k = 0; k < 3; k++)
+        {
+            if (copyOf[mesh.indices[i + k]] != UINT32_MAX)
+                mesh.indices[i + k] = copyOf[mesh.indices[i + k]];
+        }
+    }
+
+    const std::vector<uint32_t> simplified = OttSimplify::simplify(mesh.vertices, mesh.indices, mesh.indices.size() / 8, 1e-3f);
+    REQUIRE(simplified.size() < mesh.indices.size() / 4);
+
+    // Each side keeps its own copies, and the seam line stays straight.
+    std::vector<uint32_t> left, right;
+    for (size_t i = 0; i < simplified.size(); i += 3)
+    {
+        std::vector<uint32_t>& side = rightHalf(simplified, i) ? right : left;
+        side.insert(side.end(), simplified.begin() + static_cast<std::ptrdiff_t>(i), simplified.begin() + static_cast<std::ptrdiff_t>(i + 3));
+    }
+    for (const uint32_t index : left)
+        REQUIRE(mesh.vertices[index].texCoord.x <= 0.5f + 1e-6f);
+    for (const uint32_t index : right)
+        REQUIRE(mesh.vertices[index].texCoord.x >= 0.5f - 1e-6f);
+    REQUIRE(std::abs(projectedArea(mesh.vertices, left)  - 16.0 * 32.0) < 1e-6);
+    REQUIRE(std::abs(projectedArea(mesh.vertices, right) - 16.0 * 32.0) < 1e-6);
+}
+
+TEST_CASE("LOD chains are shared by instances and skip small ranges", "[simplify]")
+{
+    OttModel::MeshData mesh = grid(64, [](float x, float y) { return 0.02f * std::sin(x * 0.1f + y * 0.07f); });
+    mesh.objects.push_back(mesh.objects[0]);
+    mesh.objects[1].transform[3] = glm::vec4(100.0f, 0.0f, 0.0f, 1.0f);
+
+    // A second range of eight triangles.
+    OttModel::MeshData small = grid(2, flat);
+    small.objects[0].startIndex  = static_cast<uint32_t>(mesh.indices.size());
+    small.objects[0].startVertex = static_cast<uint32_t>(mesh.vertices.size());
+    mesh.vertices.insert(mesh.vertices.end(), small.vertices.begin(), small.vertices.end());
+    mesh.indices.insert(mesh.indices.end(), small.indices.begin(), small.indices.end());
+    mesh.objects.push_back(small.objects[0]);
+    const size_t fullIndices = mesh.indices.size();
+
+    const OttSimplify::LodOptions options { .levels = 3, .ratio = 0.25f, .minTriangles = 1024, .maxError = 0.05f };
+    const OttSimplify::LodStats stats = OttSimplify::buildLods(mesh, options);
+    REQUIRE(stats.ranges == 1);
+    REQUIRE(stats.fullTriangles == 64 * 64 * 2);
+    REQUIRE(stats.levels == mesh.objects[0].lodCount);
+    REQUIRE(mesh.objects[0].lodCount >= 2);
+
+    const OttModel::modelObject& object = mesh.objects[0];
+    REQUIRE(std::abs(object.boundingSphere.x - 32.0f) < 1e-3f);
+    REQUIRE(std::abs(object.boundingSphere.w - 32.0f * std::sqrt(2.0f)) < 1e-2f);
+    uint32_t previousCount = object.indexCount;
+    float    previousError = 0.0f;
+    size_t   total = fullIndices;
+    for (uint32_t level = 0; level < object.lodCount; level++)
+    {
+        const OttModel::LodRange& lod = object.lods[level];
+        REQUIRE(lod.startIndex == total);
+        REQUIRE(lod.indexCount < previousCount);
+        REQUIRE(lod.error >= previousError);
+        REQUIRE(lod.error <= options.maxError);
+        REQUIRE(mesh.objects[1].lods[level].startIndex == lod.startIndex);
+        for (uint32_t i = 0; i < lod.indexCount; i++)
+            REQUIRE(mesh.indices[lod.startIndex + i] < 65u * 65u);
+        previousCount = lod.indexCount;
+        previousError = lod.error;
+        total += lod.indexCount;
+    }
+    REQUIRE(mesh.indices.size() == total);
+    REQUIRE(mesh.objects[1].lodCount == object.lodCount);
+    REQUIRE(mesh.objects[2].lodCount == 0);
+    REQUIRE(std::abs(mesh.objects[2].boundingSphere.w - std::sqrt(2.0f)) < 1e-5f);
+}
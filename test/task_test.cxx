@@ -0,0 +1,240 @@
+#include <loader.h>
+#include <meshcache.h>
+#include <task.h>
+#include <threadpool.h>
+
+#include "fixtures.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    OttTask<int> answer()
+    {
+        co_return 42;
+    }
+
+    OttTask<int> failing()
+    {
+        throw std::runtime_error("boom");
+        co_return 0;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Writes count copies of a size x size grid, standing in for the separate discipline
+     *  models of one drop. **/
+    std::vector<std::filesystem::path> writeGridFiles(const size_t count, const uint32_t size)
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t>         indices;
+        OttTest::grid(size, vertices, indices);
+        std::string obj;
+        for (const auto& vertex : vertices)
+            obj += "v " + std::to_string(vertex.pos.x) + " " + std::to_string(vertex.pos.y) + " 0\n";
+        for (size_t i = 0; i < indices.size(); i += 3)
+            obj += "f " + std::to_string(indices[i] + 1) + " " + std::to_string(indices[i + 1] + 1) + " " + std::to_string(indices[i + 2] + 1) + "\n";
+
+        std::vector<std::filesystem::path> paths;
+        for (size_t i = 0; i < count; i++)
+            paths.push_back(OttTest::writeTempFile("drop_" + std::to_string(i) + ".obj", obj));
+        return paths;
+    }
+
+    //----------------------------------------------------------------------------
+    /** Stands in for the upload of a drop: copies the vertices and indices of every mesh
+     *  into one scene, returning the bytes copied. **/
+    size_t uploadScene(const std::vector<OttModel::MeshData>& meshes)
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t>         indices;
+        for (const auto& mesh : meshes)
+        {
+            vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+            indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+        }
+        return vertices.size() * sizeof(OttModel::Vertex) + indices.size() * sizeof(uint32_t);
+    }
+
+    //----------------------------------------------------------------------------
+    /** Pumps queue on this thread until done is set, like the main loop does. **/
+    void drainUntil(OttMainThreadQueue& queue, const std::atomic<bool>& done)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+        while (!done && std::chrono::steady_clock::now() < deadline)
+        {
+            queue.drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+} // anonymous namespace
+
+TEST_CASE("Tasks return values and rethrow at the await", "[task]")
+{
+    std::optional<int> value;
+    bool caught = false;
+    auto body = [&]() -> OttTask<void>
+    {
+        value = co_await answer();
+        try { co_await failing(); }
+        catch (const std::runtime_error&) { caught = true; }
+    };
+    OttAsync::spawn(body());
+
+    REQUIRE(value == 42);
+    REQUIRE(caught);
+}
+
+TEST_CASE("Tasks hop between the pool and the main thread queue", "[task]")
+{
+    OttMainThreadQueue queue;
+    std::atomic<bool> done = false;
+    std::thread::id workerThread, resumedThread;
+
+    auto body = [&]() -> OttTask<void>
+    {
+        co_await OttAsync::resumeOn(OttThreadPool::shared());
+        workerThread = std::this_thread::get_id();
+        co_await queue.schedule();
+        resumedThread = std::this_thread::get_id();
+        done = true;
+    };
+    OttAsync::spawn(body());
+    drainUntil(queue, done);
+
+    REQUIRE(done);
+    REQUIRE(workerThread != std::this_thread::get_id());
+    REQUIRE(resumedThread == std::this_thread::get_id());
+}
+
+TEST_CASE("whenAll runs tasks on the pool and keeps their order", "[task]")
+{
+    std::atomic<bool> done = false;
+    std::vector<int> results;
+    auto square = [](const int value) -> OttTask<int>
+    {
+        co_await OttAsync::resumeOn(OttThreadPool::shared());
+        co_return value * value;
+    };
+    auto body = [&]() -> OttTask<void>
+    {
+        std::vector<OttTask<int>> tasks;
+        for (int i = 0; i < 16; i++)
+            tasks.push_back(square(i));
+        results = co_await OttAsync::whenAll(std::move(tasks));
+        done = true;
+        done.notify_all();
+    };
+    OttAsync::spawn(body());
+    done.wait(false);
+
+    REQUIRE(results.size() == 16);
+    for (int i = 0; i < 16; i++)
+        REQUIRE(results[i] == i * i);
+}
+
+TEST_CASE("Asynchronous mesh loads report progress and honour cancellation", "[task][loader]")
+{
+    const auto source = std::filesystem::path(OTT_SOURCE_RESOURCE_DIR) / "models" / "defaultcube.obj";
+    OttMainThreadQueue queue;
+
+    SECTION("completed load")
+    {
+        std::filesystem::remove(OttMeshCache::cachePathFor(source));
+        std::atomic<bool> done = false;
+        OttLoader::LoadProgress progress;
+        std::optional<OttModel::MeshData> mesh;
+        auto body = [&]() -> OttTask<void>
+        {
+            mesh = co_await OttLoader::loadMeshAsync(source, {}, {}, &progress);
+            co_await queue.schedule();
+            done = true;
+        };
+        OttAsync::spawn(body());
+        drainUntil(queue, done);
+
+        REQUIRE(mesh.has_value());
+        REQUIRE_FALSE(mesh->indices.empty());
+        REQUIRE(progress.stage == OttLoader::LoadProgress::Stage::Edges);
+    }
+
+    SECTION("cancelled load")
+    {
+        std::atomic<bool> done = false;
+        std::stop_source stop;
+        stop.request_stop();
+        std::optional<OttModel::MeshData> mesh;
+        auto body = [&]() -> OttTask<void>
+        {
+            mesh = co_await OttLoader::loadMeshAsync(source, {}, stop.get_token());
+            co_await queue.schedule();
+            done = true;
+        };
+        OttAsync::spawn(body());
+        drainUntil(queue, done);
+
+        REQUIRE(done);
+        REQUIRE_FALSE(mesh.has_value());
+    }
+}
+
+TEST_CASE("Multi-file drop: one file at a time vs concurrent loads and one upload", "[.][benchmark]")
+{
+    for (const size_t count : { 1, 8, 32 })
+    {
+        const auto paths = writeGridFiles(count, 300);
+        auto clearCache = [&paths]()
+        {
+            for (const auto& path : paths)
+                std::filesystem::remove(OttMeshCache::cachePathFor(path));
+        };
+
+        // Every file loaded, then the whole scene uploaded again, as each drop used to.
+        clearCache();
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<OttModel::MeshData> scene;
+        size_t sequentialBytes = 0;
+        for (const auto& path : paths)
+        {
+            REQUIRE(OttLoader::loadMesh(path, scene.emplace_back()));
+            sequentialBytes += uploadScene(scene);
+        }
+        const double sequentialSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        clearCache();
+        std::atomic<bool> done = false;
+        std::vector<OttModel::MeshData> meshes;
+        size_t concurrentBytes = 0;
+        auto body = [&]() -> OttTask<void>
+        {
+            std::vector<OttTask<std::optional<OttModel::MeshData>>> loads;
+            for (const auto& path : paths)
+                loads.push_back(OttLoader::loadMeshAsync(path, {}));
+            for (auto& mesh : co_await OttAsync::whenAll(std::move(loads)))
+            {
+                if (mesh)
+                    meshes.push_back(std::move(*mesh));
+            }
+            concurrentBytes = uploadScene(meshes);
+            done = true;
+            done.notify_all();
+        };
+        start = std::chrono::high_resolution_clock::now();
+        OttAsync::spawn(body());
+        done.wait(false);
+        const double concurrentSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        REQUIRE(meshes.size() == count);
+        WARN(count << " files: one at a time " << sequentialSeconds << "s (" << sequentialBytes / (1024 * 1024)
+                   << " MB uploaded), concurrent " << concurrentSeconds << "s (" << concurrentBytes / (1024 * 1024)
+                   << " MB), speedup " << sequentialSeconds / concurrentSeconds << "x");
+    }
+}
@@ -0,0 +1,126 @@
+#include <loader.h>
+#include <meshcache.h>
+#include <topology.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "fixtures.h"
+
+TEST_CASE("A closed cube is manifold across its split vertices", "[topology]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::unitCube(true, vertices, indices);
+
+    OttTopology::AdjacencyStats stats;
+    const OttTopology::Adjacency adjacency = OttTopology::build(vertices, indices, &stats);
+    REQUIRE(stats.triangles == 12);
+    REQUIRE(stats.borderSides == 0);
+    REQUIRE(stats.nonManifoldSides == 0);
+    REQUIRE(stats.bytesPerTriangle() == 12.0);
+    REQUIRE(adjacency.positionCount == 8);
+
+    const std::span<const uint32_t> links = adjacency.links;
+    for (uint32_t side = 0; side < links.size(); side++)
+    {
+        REQUIRE(OttTopology::isManifold(links, side));
+        // The neighbour runs the same edge the other way.
+        const uint32_t other = links[side];
+        REQUIRE(adjacency.positions[other] == adjacency.positions[OttTopology::nextCorner(side)]);
+        REQUIRE(adjacency.positions[OttTopology::nextCorner(other)] == adjacency.positions[side]);
+        REQUIRE(OttTopology::neighbour(links, side) != side / 3);
+    }
+
+    // Walking around any corner visits every corner at its position once.
+    for (uint32_t corner = 0; corner < links.size(); corner++)
+    {
+        size_t steps = 0;
+        uint32_t around = corner;
+        do
+        {
+            REQUIRE(adjacency.positions[around] == adjacency.positions[corner]);
+            around = OttTopology::nextAround(links, around);
+            steps++;
+        } while (around != corner && steps <= links.size());
+        REQUIRE(steps == static_cast<size_t>(std::ranges::count(adjacency.positions, adjacency.positions[corner])));
+    }
+}
+
+TEST_CASE("Borders, fins and degenerate triangles", "[topology]")
+{
+    std::vector<OttModel::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    OttTest::grid(3, vertices, indices);
+    OttTopology::AdjacencyStats stats;
+    OttTopology::Adjacency adjacency = OttTopology::build(vertices, indices, &stats);
+    REQUIRE(stats.borderSides == 12);
+    for (uint32_t side = 0; side < adjacency.links.size(); side++)
+        REQUIRE((OttTopology::isBorder(adjacency.links, side) != OttTopology::isManifold(adjacency.links, side)));
+
+    // Three triangles on one edge, and a triangle without area.
+    vertices = { { .pos = glm::vec3(0.0f) }, { .pos = glm::vec3(1.0f, 0.0f, 0.0f) }, { .pos = glm::vec3(0.0f, 1.0f, 0.0f) },
+                 { .pos = glm::vec3(0.0f, 0.0f, 1.0f) }, { .pos = glm::vec3(0.0f, -1.0f, 0.0f) }, { .pos = glm::vec3(2.0f, 0.0f, 0.0f) } };
+    indices = { 0, 1, 2, 1, 0, 3, 0, 1, 4, 0, 1, 5 };
+    adjacency = OttTopology::build(vertices, indices, &stats);
+    REQUIRE(stats.nonManifoldSides == 3);
+    REQUIRE(stats.borderSides == 6);
+    REQUIRE(stats.degenerateTriangles == 1);
+    uint32_t side = 0, faces = 0;
+    do
+    {
+        REQUIRE(!OttTopology::isManifold(adjacency.links, side));
+        REQUIRE(OttTopology::neighbour(adjacency.links, side) == OttTopology::NONE);
+        side = adjacency.links[side];
+        faces++;
+    } while (side != 0);
+    REQUIRE(faces == 3);
+    for (uint32_t corner = 9; corner < 12; corner++)
+        REQUIRE(adjacency.links[corner] == OttTopology::NONE);
+}
+
+TEST_CASE("Objects keep the adjacency of their range", "[topology]")
+{
+    OttModel::MeshData mesh;
+    OttTest::grid(2, mesh.vertices, mesh.indices);
+    std::vector<uint32_t> cube;
+    OttTest::unitCube(true, mesh.vertices, cube);
+    mesh.indices.insert(mesh.indices.end(), cube.begin(), cube.end());
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = 0, .indexCount = 24 });
+    mesh.objects.push_back({ .startIndex = 24, .startVertex = 9, .indexCount = 36 });
+    mesh.objects.push_back({ .startIndex = 0, .startVertex = 0, .indexCount = 24 });
+
+    const OttTopology::AdjacencyStats stats = OttTopology::buildMeshAdjacency(mesh);
+    REQUIRE(stats.ranges == 2);
+    REQUIRE(stats.triangles == 20);
+    REQUIRE(stats.borderSides == 8);
+    REQUIRE(mesh.links.size() == 60);
+    REQUIRE(mesh.objects[2].firstLink == mesh.objects[0].firstLink);
+    REQUIRE(OttTopology::linksOf(mesh, mesh.objects[1]).size() == 36);
+    for (const uint32_t link : OttTopology::linksOf(mesh, mesh.objects[1]))
+        REQUIRE(link < 36);
+    REQUIRE(OttTopology::linksOf(mesh, OttModel::modelObject{}).empty());
+}
+
+TEST_CASE("loadMesh builds the adjacency on load and from the cache", "[topology]")
+{
+    const auto path = OttTest::writeTempFile("topology_cube.obj", OttTest::UNIT_CUBE_OBJ);
+    const OttLoader::LoadOptions options { .adjacency = true };
+    REQUIRE(options.fingerprint() == OttLoader::LoadOptions{}.fingerprint());
+    std::filesystem::remove(OttMeshCache::cachePathFor(path, options.fingerprint()));
+
+    OttModel::MeshData loaded, cached, plain;
+    REQUIRE(OttLoader::loadMesh(path, loaded, options));
+    REQUIRE(loaded.links.size() == 36);
+    REQUIRE(loaded.objects[0].firstLink == 0);
+    // The links are not cached, so the entry serves loads with and without them.
+    REQUIRE(OttMeshCache::read(path, plain, options.fingerprint()));
+    REQUIRE(plain.links.empty());
+    REQUIRE(plain.objects[0].firstLink == OttModel::NO_LINKS);
+    REQUIRE(OttLoader::loadMesh(path, cached, options));
+    REQUIRE(cached.links == loaded.links);
+    REQUIRE(cached.objects[0].firstLink == 0);
+}
@@ -0,0 +1,192 @@
+#include <objloader.h>
+#include <weld.h>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // The loop OttWeld::deduplicate replaced, kept as the reference output.
+    void referenceDeduplicate(const std::vector<OttModel::Vertex>& corners,
+                              std::vector<OttModel::Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::unordered_map<OttModel::Vertex, uint32_t> uniqueVertices{};
+        for (const auto& vertex : corners)
+        {
+            if (uniqueVertices.count(vertex) == 0)
+            {
+                uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+            }
+            indices.push_back(uniqueVertices[vertex]);
+        }
+    }
+
+    //----------------------------------------------------------------------------
+    /** Flat shaded grid: every position is shared by up to four quads with different normals,
+     *  the same shape CAD exports have. **/
+    std::vector<OttModel::Vertex> gridCorners(const size_t cells_per_side)
+    {
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<int> facing(0, 5);
+        std::vector<OttModel::Vertex> corners;
+        corners.reserve(cells_per_side * cells_per_side * 6);
+        for (size_t y = 0; y < cells_per_side; y++)
+        {
+            for (size_t x = 0; x < cells_per_side; x++)
+            {
+                glm::vec3 normal(0.0f);
+                normal[facing(rng) % 3] = 1.0f;
+                auto corner = [&](const size_t cx, const size_t cy)
+                {
+                    OttModel::Vertex v{};
+                    v.pos      = { static_cast<float>(cx), static_cast<float>(cy), 0.0f };
+                    v.color    = { 1.0f, 1.0f, 1.0f };
+                    v.texCoord = { static_cast<float>(cx) / cells_per_side, static_cast<float>(cy) / cells_per_side };
+                    v.normal   = normal;
+                    return v;
+                };
+                for (const auto& [cx, cy] : { std::pair{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y}, {x + 1, y + 1}, {x, y + 1} })
+                    corners.push_back(corner(cx, cy));
+            }
+        }
+        return corners;
+    }
+
+    std::vector<OttModel::Vertex> objCorners(const std::filesystem::path& path)
+    {
+        tinyobj::attrib_t attrib;
+        std::vector<tinyobj::shape_t> shapes;
+        std::vector<tinyobj::material_t> materials;
+        std::string warn, err;
+        REQUIRE(OttObj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path, path.parent_path()));
+
+        std::vector<OttModel::Vertex> corners;
+        for (const auto& shape : shapes)
+        {
+            for (const auto& index : shape.mesh.indices)
+            {
+                OttModel::Vertex v{};
+                v.pos   = { attrib.vertices[3 * index.vertex_index], attrib.vertices[3 * index.vertex_index + 1], attrib.vertices[3 * index.vertex_index + 2] };
+                v.color = { attrib.colors[3 * index.vertex_index], attrib.colors[3 * index.vertex_index + 1], attrib.colors[3 * index.vertex_index + 2] };
+                if (index.texcoord_index >= 0)
+                    v.texCoord = { attrib.texcoords[2 * index.texcoord_index], 1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
+                if (index.normal_index >= 0)
+                    v.normal = { attrib.normals[3 * index.normal_index], attrib.normals[3 * index.normal_index + 1], attrib.normals[3 * index.normal_index + 2] };
+                corners.push_back(v);
+            }
+        }
+        return corners;
+    }
+} // anonymous namespace
+
+TEST_CASE("OttWeld::deduplicate matches the unordered_map loop", "[weld]")
+{
+    auto corners = gridCorners(200);
+    // Signed zeros compare equal and must land on the same vertex.
+    corners[1].normal.z = -0.0f;
+    corners[7].normal.z = 0.0f;
+
+    std::vector<OttModel::Vertex> expectedVertices;
+    std::vector<uint32_t>         expectedIndices;
+    referenceDeduplicate(corners, expectedVertices, expectedIndices);
+
+    for (const size_t threshold : { OttWeld::PARALLEL_THRESHOLD, size_t(0) })
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t>         indices;
+        OttWeld::deduplicate(corners, vertices, indices, threshold);
+        REQUIRE(vertices == expectedVertices);
+        REQUIRE(indices  == expectedIndices);
+    }
+}
+
+TEST_CASE("OttWeld::weld merges near-duplicate positions", "[weld]")
+{
+    // Same grid once exact and once with every corner nudged by a few ulps, like CAD exports.
+    const auto exactCorners = gridCorners(200);
+    auto noisyCorners = exactCorners;
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> ulps(-4, 4);
+    for (auto& corner : noisyCorners)
+        for (int axis = 0; axis < 2; axis++)
+            for (int step = ulps(rng); step != 0; step += step > 0 ? -1 : 1)
+                corner.pos[axis] = std::nextafter(corner.pos[axis], step > 0 ? INFINITY : -INFINITY);
+
+    std::vector<OttModel::Vertex> exactVertices, vertices;
+    std::vector<uint32_t>         exactIndices,  indices;
+    OttWeld::deduplicate(exactCorners, exactVertices, exactIndices);
+    OttWeld::deduplicate(noisyCorners, vertices, indices);
+    REQUIRE(vertices.size() > exactVertices.size());
+
+    SECTION("SnapPositions only merges vertices with equal attributes")
+    {
+        const auto stats = OttWeld::weld(vertices, indices, { .epsilon = 1e-3f, .policy = OttWeld::WeldPolicy::SnapPositions });
+        REQUIRE(vertices.size() == exactVertices.size());
+        REQUIRE(stats.mergedVertices() == stats.inputVertices - exactVertices.size());
+        REQUIRE(stats.collapsedTriangles == 0);
+        REQUIRE(indices.size() == exactIndices.size());
+    }
+    SECTION("KeepFirst collapses every position to one vertex")
+    {
+        OttWeld::weld(vertices, indices, { .epsilon = 1e-3f, .policy = OttWeld::WeldPolicy::KeepFirst });
+        REQUIRE(vertices.size() == 201 * 201);
+        REQUIRE(indices.size() == exactIndices.size());
+    }
+    SECTION("Average keeps unit normals")
+    {
+        OttWeld::weld(vertices, indices, { .epsilon = 1e-3f, .policy = OttWeld::WeldPolicy::Average });
+        REQUIRE(vertices.size() == 201 * 201);
+        for (const auto& vertex : vertices)
+            REQUIRE(std::abs(glm::length(vertex.normal) - 1.0f) < 1e-5f);
+    }
+}
+
+TEST_CASE("OttWeld::weld removes collapsed triangles", "[weld]")
+{
+    std::vector<OttModel::Vertex> vertices(4);
+    vertices[1].pos = { 1.0f, 0.0f, 0.0f };
+    vertices[2].pos = { 0.0f, 1.0f, 0.0f };
+    vertices[3].pos = { 1.0f + 1e-7f, 0.0f, 0.0f };
+    std::vector<uint32_t> indices = { 0, 1, 2,  0, 1, 3 };
+
+    const auto stats = OttWeld::weld(vertices, indices, { .epsilon = 1e-5f, .policy = OttWeld::WeldPolicy::KeepFirst });
+    REQUIRE(stats.mergedVertices() == 1);
+    REQUIRE(stats.collapsedTriangles == 1);
+    REQUIRE(indices == std::vector<uint32_t>{ 0, 1, 2 });
+}
+
+TEST_CASE("OttWeld::deduplicate throughput", "[.][benchmark]")
+{
+    auto measure = [](const std::string& name, const std::vector<OttModel::Vertex>& corners, const bool with_reference)
+    {
+        std::vector<OttModel::Vertex> vertices;
+        std::vector<uint32_t>         indices;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        OttWeld::deduplicate(corners, vertices, indices);
+        const double weldSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        WARN(name << ": " << corners.size() << " corners, OttWeld " << static_cast<double>(corners.size()) / weldSeconds / 1e6 << " M/s");
+        if (!with_reference)
+            return;
+
+        std::vector<OttModel::Vertex> referenceVertices;
+        std::vector<uint32_t>         referenceIndices;
+        start = std::chrono::high_resolution_clock::now();
+        referenceDeduplicate(corners, referenceVertices, referenceIndices);
+        const double referenceSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        REQUIRE(indices == referenceIndices);
+        WARN(name << ": unordered_map " << static_cast<double>(corners.size()) / referenceSeconds / 1e6 << " M/s");
+    };
+
+    const std::filesystem::path models = std::filesystem::path(OTT_SOURCE_RESOURCE_DIR) / "models";
+    measure("sphere.obj",      objCorners(models / "sphere.obj"),      true);
+    measure("viking_room.obj", objCorners(models / "viking_room.obj"), true);
+    // ~50M indices. The node-based reference would need several GB on top, so it is skipped here.
+    measure("synthetic grid",  gridCorners(2887),                      false);
+}